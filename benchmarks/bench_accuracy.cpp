@@ -0,0 +1,495 @@
+// End-to-end accuracy vs throughput benchmark
+// Runs the full approximateCount pipeline over instances with known counts, for every configuration of a grid,
+// and records wall time, peak RSS and the estimate / exact ratio - the per-configuration summary marks the Pareto front
+//
+// Usage: bench_accuracy [--corpus <list file>] [--no-generated] [--trials 5,10] [--density 0.05,0.1] [--threshold 20,50]
+//                       [--threads 1,4] [--seed <n>] [--epsilon <e>] [--format json|csv] [--out <path>]
+//                       [--save <path>] [--baseline <path>] [--verbose]
+//
+// The corpus list has one instance per line: "<path to DIMACS file> <exact model count>" (# starts a comment)
+// --save writes the per-configuration summary; --baseline compares against one written earlier
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cnf/cnf_parser.h"
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "utils/logger.h"
+#include "utils/random_cnf_generator.h"
+#include "utils/timer.h"
+#include "config.h"
+
+using namespace std;
+
+struct Instance {
+    string name;
+    shared_ptr<CNFFormula> formula;
+    double log2Exact;
+};
+
+struct Configuration {
+    int trials;
+    double density;
+    int threshold;
+    int threads;
+
+    string key() const {
+        ostringstream out;
+        out << trials << "," << density << "," << threshold << "," << threads;
+        return out.str();
+    }
+};
+
+struct RunRecord {
+    string instance;
+    Configuration config;
+    double wallSeconds;
+    long peakRSSKilobytes;
+    int trialsRun;
+    double log2Estimate;
+    double log2Exact;
+    double log2Ratio;   // log2(estimate / exact)
+    bool withinTolerance;
+};
+
+struct ConfigSummary {
+    Configuration config;
+    double wallSeconds;            // over the whole corpus
+    long peakRSSKilobytes;         // largest of the runs
+    double meanAbsLog2Error;
+    double withinFraction;
+    bool pareto;                   // no other configuration is both faster and more accurate
+    bool hasBaseline;
+    double baselineWallSeconds;
+    double baselineMeanAbsLog2Error;
+
+    ConfigSummary() : wallSeconds(0), peakRSSKilobytes(0), meanAbsLog2Error(0), withinFraction(0), pareto(false),
+                      hasBaseline(false), baselineWallSeconds(0), baselineMeanAbsLog2Error(0) {}
+};
+
+//
+// Peak RSS
+//
+
+// start a new high-water mark - returns false if the kernel does not support it (the peak is then process-wide)
+bool resetPeakRSS() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    if (!clearRefs) {
+        return false;
+    }
+    clearRefs << "5";
+    return static_cast<bool>(clearRefs.flush());
+}
+
+long readPeakRSS() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return stol(line.substr(6));
+        }
+    }
+    return -1;
+}
+
+//
+// Corpus
+//
+
+vector<Instance> generatedCorpus() {
+    struct Spec {
+        const char* name;
+        KnownCountFamily family;
+        int components;
+        int size;
+        int freeVars;
+    };
+    // counts from 2^16 to 2^24 - above the cell threshold by enough XORs to exercise hashing, small enough to run the whole grid
+    const Spec specs[] = {
+        {"xor_chains_8x4", KnownCountFamily::XOR_CHAINS, 8, 4, 0},
+        {"xor_chains_4x5", KnownCountFamily::XOR_CHAINS, 4, 5, 2},
+        {"exactly_one_8x5", KnownCountFamily::EXACTLY_ONE, 8, 5, 2},
+        {"random_components_4x10", KnownCountFamily::RANDOM_COMPONENTS, 4, 10, 0},
+        {"mixed_6x5", KnownCountFamily::MIXED, 6, 5, 2},
+    };
+
+    vector<Instance> corpus;
+    uint64_t seed = 1;
+    for (const Spec& spec : specs) {
+        GeneratedInstance info;
+        Instance instance;
+        instance.name = spec.name;
+        instance.formula = RandomCNFGenerator::knownCount(spec.family, spec.components, spec.size, spec.freeVars, seed++, info);
+        instance.log2Exact = info.log2Count;
+        corpus.push_back(instance);
+    }
+    return corpus;
+}
+
+// log2 of a decimal count of any length
+double log2OfDecimal(const string& digits) {
+    if (digits.empty() || digits.find_first_not_of("0123456789") != string::npos) {
+        throw runtime_error("Invalid model count: " + digits);
+    }
+    size_t leading = min<size_t>(digits.size(), 17);
+    double mantissa = stod(digits.substr(0, leading));
+    if (mantissa == 0) {
+        return -INFINITY;
+    }
+    return log2(mantissa) + (digits.size() - leading) * log2(10.0);
+}
+
+vector<Instance> loadCorpus(const string& listPath) {
+    ifstream list(listPath);
+    if (!list) {
+        throw runtime_error("Cannot open corpus list: " + listPath);
+    }
+    vector<Instance> corpus;
+    string line;
+    while (getline(list, line)) {
+        istringstream fields(line);
+        string path, count;
+        if (!(fields >> path) || path[0] == '#') {
+            continue;
+        }
+        if (!(fields >> count)) {
+            throw runtime_error("Corpus entry without an exact count: " + path);
+        }
+        Instance instance;
+        instance.name = path;
+        instance.formula = shared_ptr<CNFFormula>(CNFParser::parseFile(path).release());
+        instance.log2Exact = log2OfDecimal(count);
+        corpus.push_back(instance);
+    }
+    return corpus;
+}
+
+//
+// Runs
+//
+
+RunRecord runOne(const Instance& instance, const Configuration& config, uint64_t seed, double epsilon, bool rssReset) {
+    CountingOptions options;
+    options.maxTrials = config.trials;
+    options.density = config.density;
+    options.threshold = config.threshold;
+    options.numThreads = config.threads;
+    options.seed = seed;
+    options.epsilon = epsilon;
+    options.earlyTermination = false;
+    options.exactFallback = false;   // the point is to measure the hashing pipeline
+
+    if (rssReset) {
+        resetPeakRSS();
+    }
+    Timer timer;
+    ApproximationResult result = ApproximateCounter::approximateCount(*instance.formula, options);
+
+    RunRecord record;
+    record.instance = instance.name;
+    record.config = config;
+    record.wallSeconds = timer.elapsedSeconds();
+    record.peakRSSKilobytes = readPeakRSS();
+    record.trialsRun = result.totalTrials;
+    record.log2Estimate = result.log2Estimate;
+    record.log2Exact = instance.log2Exact;
+    record.log2Ratio = result.log2Estimate - instance.log2Exact;
+    record.withinTolerance = isfinite(record.log2Ratio) && fabs(record.log2Ratio) <= log2(1.0 + epsilon);
+    return record;
+}
+
+vector<ConfigSummary> summarize(const vector<Configuration>& configs, const vector<RunRecord>& runs) {
+    vector<ConfigSummary> summaries;
+    for (const Configuration& config : configs) {
+        ConfigSummary summary;
+        summary.config = config;
+        int count = 0;
+        int within = 0;
+        for (const RunRecord& run : runs) {
+            if (run.config.key() != config.key()) {
+                continue;
+            }
+            count++;
+            summary.wallSeconds += run.wallSeconds;
+            summary.peakRSSKilobytes = max(summary.peakRSSKilobytes, run.peakRSSKilobytes);
+            // an unsatisfiable estimate of a satisfiable instance counts as the whole count missed
+            summary.meanAbsLog2Error += isfinite(run.log2Ratio) ? fabs(run.log2Ratio) : run.log2Exact;
+            within += run.withinTolerance ? 1 : 0;
+        }
+        if (count > 0) {
+            summary.meanAbsLog2Error /= count;
+            summary.withinFraction = static_cast<double>(within) / count;
+        }
+        summaries.push_back(summary);
+    }
+
+    for (ConfigSummary& summary : summaries) {
+        summary.pareto = true;
+        for (const ConfigSummary& other : summaries) {
+            bool noWorse = other.wallSeconds <= summary.wallSeconds && other.meanAbsLog2Error <= summary.meanAbsLog2Error;
+            bool better = other.wallSeconds < summary.wallSeconds || other.meanAbsLog2Error < summary.meanAbsLog2Error;
+            if (noWorse && better) {
+                summary.pareto = false;
+                break;
+            }
+        }
+    }
+    return summaries;
+}
+
+//
+// Baseline files - the per-configuration summary as CSV
+//
+
+const char* SUMMARY_HEADER = "trials,density,threshold,threads,wall_seconds,peak_rss_kb,mean_abs_log2_error,within_fraction,pareto";
+
+string formatSummaryCSV(const vector<ConfigSummary>& summaries) {
+    ostringstream out;
+    out << setprecision(6);
+    out << SUMMARY_HEADER << "\n";
+    for (const ConfigSummary& s : summaries) {
+        out << s.config.key() << "," << s.wallSeconds << "," << s.peakRSSKilobytes << "," << s.meanAbsLog2Error << ","
+            << s.withinFraction << "," << (s.pareto ? 1 : 0) << "\n";
+    }
+    return out.str();
+}
+
+void applyBaseline(const string& path, vector<ConfigSummary>& summaries) {
+    ifstream in(path);
+    if (!in) {
+        throw runtime_error("Cannot open baseline: " + path);
+    }
+    string line;
+    getline(in, line);  // header
+    while (getline(in, line)) {
+        vector<string> fields;
+        istringstream row(line);
+        string field;
+        while (getline(row, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 7) {
+            continue;
+        }
+        string key = fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3];
+        for (ConfigSummary& summary : summaries) {
+            if (summary.config.key() == key) {
+                summary.hasBaseline = true;
+                summary.baselineWallSeconds = stod(fields[4]);
+                summary.baselineMeanAbsLog2Error = stod(fields[6]);
+            }
+        }
+    }
+
+    for (const ConfigSummary& s : summaries) {
+        if (!s.hasBaseline) {
+            continue;
+        }
+        if (s.meanAbsLog2Error > s.baselineMeanAbsLog2Error + 0.25) {
+            LOG_WARNING("Configuration " << s.config.key() << ": error " << s.meanAbsLog2Error << " vs baseline " << s.baselineMeanAbsLog2Error);
+        }
+        if (s.wallSeconds > 1.2 * s.baselineWallSeconds) {
+            LOG_WARNING("Configuration " << s.config.key() << ": " << s.wallSeconds << " s vs baseline " << s.baselineWallSeconds << " s");
+        }
+    }
+}
+
+//
+// Output
+//
+
+string jsonNumber(double value) {
+    if (!isfinite(value)) {
+        return "null";
+    }
+    ostringstream out;
+    out << setprecision(6) << value;
+    return out.str();
+}
+
+string formatJSON(const vector<RunRecord>& runs, const vector<ConfigSummary>& summaries, uint64_t seed, double epsilon, bool rssReset) {
+    ostringstream out;
+    out << "{\"context\": {\"seed\": " << seed << ", \"epsilon\": " << epsilon << ", \"peak_rss_per_run\": " << (rssReset ? "true" : "false") << "},\n";
+    out << "\"runs\": [";
+    for (size_t i = 0; i < runs.size(); i++) {
+        const RunRecord& r = runs[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "{\"instance\": \"" << r.instance << "\", \"trials\": " << r.config.trials << ", \"density\": " << r.config.density
+            << ", \"threshold\": " << r.config.threshold << ", \"threads\": " << r.config.threads
+            << ", \"wall_seconds\": " << jsonNumber(r.wallSeconds) << ", \"peak_rss_kb\": " << r.peakRSSKilobytes
+            << ", \"trials_run\": " << r.trialsRun << ", \"log2_estimate\": " << jsonNumber(r.log2Estimate)
+            << ", \"log2_exact\": " << jsonNumber(r.log2Exact) << ", \"log2_ratio\": " << jsonNumber(r.log2Ratio)
+            << ", \"within_tolerance\": " << (r.withinTolerance ? "true" : "false") << "}";
+    }
+    out << "\n],\n\"configurations\": [";
+    for (size_t i = 0; i < summaries.size(); i++) {
+        const ConfigSummary& s = summaries[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "{\"trials\": " << s.config.trials << ", \"density\": " << s.config.density << ", \"threshold\": " << s.config.threshold
+            << ", \"threads\": " << s.config.threads << ", \"wall_seconds\": " << jsonNumber(s.wallSeconds)
+            << ", \"peak_rss_kb\": " << s.peakRSSKilobytes << ", \"mean_abs_log2_error\": " << jsonNumber(s.meanAbsLog2Error)
+            << ", \"within_fraction\": " << jsonNumber(s.withinFraction) << ", \"pareto\": " << (s.pareto ? "true" : "false");
+        if (s.hasBaseline) {
+            out << ", \"baseline_wall_seconds\": " << jsonNumber(s.baselineWallSeconds)
+                << ", \"baseline_mean_abs_log2_error\": " << jsonNumber(s.baselineMeanAbsLog2Error);
+        }
+        out << "}";
+    }
+    out << "\n]}";
+    return out.str();
+}
+
+string formatRunsCSV(const vector<RunRecord>& runs) {
+    ostringstream out;
+    out << setprecision(6);
+    out << "instance,trials,density,threshold,threads,wall_seconds,peak_rss_kb,trials_run,log2_estimate,log2_exact,log2_ratio,within_tolerance\n";
+    for (const RunRecord& r : runs) {
+        out << r.instance << "," << r.config.key() << "," << r.wallSeconds << "," << r.peakRSSKilobytes << "," << r.trialsRun << ","
+            << r.log2Estimate << "," << r.log2Exact << "," << r.log2Ratio << "," << (r.withinTolerance ? 1 : 0) << "\n";
+    }
+    return out.str();
+}
+
+template <typename T>
+vector<T> parseList(const string& text) {
+    vector<T> values;
+    istringstream in(text);
+    string item;
+    while (getline(in, item, ',')) {
+        istringstream parse(item);
+        T value;
+        if (!(parse >> value)) {
+            throw runtime_error("Invalid list value: " + item);
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> trialsList = {5, 10};
+    vector<double> densityList = {0.05, 0.1};
+    vector<int> thresholdList = {20, 50};
+    vector<int> threadsList = {1};
+    string corpusPath;
+    bool generated = true;
+    uint64_t seed = 1;
+    double epsilon = DEFAULT_EPSILON;
+    string format = "json";
+    string outPath = "-";
+    string savePath;
+    string baselinePath;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string flag = argv[i];
+            if (flag == "--no-generated") {
+                generated = false;
+                continue;
+            }
+            if (flag == "--verbose") {
+                Logger::setLevel(LogLevel::INFO);  // one line per run
+                continue;
+            }
+            if (i + 1 >= argc) {
+                cerr << "Missing value for " << flag << endl;
+                return 1;
+            }
+            string value = argv[++i];
+            if (flag == "--corpus") {
+                corpusPath = value;
+            } else if (flag == "--trials") {
+                trialsList = parseList<int>(value);
+            } else if (flag == "--density") {
+                densityList = parseList<double>(value);
+            } else if (flag == "--threshold") {
+                thresholdList = parseList<int>(value);
+            } else if (flag == "--threads") {
+                threadsList = parseList<int>(value);
+            } else if (flag == "--seed") {
+                seed = stoull(value);
+            } else if (flag == "--epsilon") {
+                epsilon = stod(value);
+            } else if (flag == "--format") {
+                format = value;
+            } else if (flag == "--out") {
+                outPath = value;
+            } else if (flag == "--save") {
+                savePath = value;
+            } else if (flag == "--baseline") {
+                baselinePath = value;
+            } else {
+                cerr << "Unknown option " << flag << endl;
+                return 1;
+            }
+        }
+        if (format != "json" && format != "csv") {
+            cerr << "Unknown format " << format << " (expected json or csv)" << endl;
+            return 1;
+        }
+
+        vector<Instance> corpus;
+        if (generated) {
+            corpus = generatedCorpus();
+        }
+        if (!corpusPath.empty()) {
+            vector<Instance> onDisk = loadCorpus(corpusPath);
+            corpus.insert(corpus.end(), onDisk.begin(), onDisk.end());
+        }
+        if (corpus.empty()) {
+            cerr << "Empty corpus" << endl;
+            return 1;
+        }
+
+        vector<Configuration> configs;
+        for (int trials : trialsList) {
+            for (double density : densityList) {
+                for (int threshold : thresholdList) {
+                    for (int threads : threadsList) {
+                        configs.push_back({trials, density, threshold, threads});
+                    }
+                }
+            }
+        }
+
+        bool rssReset = resetPeakRSS();
+        if (!rssReset) {
+            LOG_WARNING("Cannot reset the peak RSS - peak_rss_kb is the process-wide peak");
+        }
+
+        vector<RunRecord> runs;
+        for (const Configuration& config : configs) {
+            for (const Instance& instance : corpus) {
+                runs.push_back(runOne(instance, config, seed, epsilon, rssReset));
+                LOG_INFO(instance.name << " [" << config.key() << "]: log2 ratio " << runs.back().log2Ratio << " in " << runs.back().wallSeconds << " s");
+            }
+        }
+
+        vector<ConfigSummary> summaries = summarize(configs, runs);
+        if (!baselinePath.empty()) {
+            applyBaseline(baselinePath, summaries);
+        }
+        if (!savePath.empty() && !Logger::writeJSON(savePath, formatSummaryCSV(summaries))) {
+            cerr << "Could not write " << savePath << endl;
+            return 1;
+        }
+
+        string output = (format == "json") ? formatJSON(runs, summaries, seed, epsilon, rssReset) : formatRunsCSV(runs) + "\n" + formatSummaryCSV(summaries);
+        if (!Logger::writeJSON(outPath, output)) {
+            cerr << "Could not write " << outPath << endl;
+            return 1;
+        }
+    } catch (const exception& e) {
+        cerr << "Benchmark failed: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,338 @@
+// Microbenchmarks for the solver kernels
+// Each kernel is timed per call on generated inputs of several sizes; results are written as JSON or CSV
+//
+// Usage: bench_kernels [--format json|csv] [--filter <substring>] [--min-time <seconds>] [--out <path>]
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cnf/cnf_parser.h"
+#include "cnf/cnf_structure.h"
+#include "cnf/clause_evaluation.h"
+#include "xor/xor_hash_generator.h"
+#include "solver/partial_assignment.h"
+#include "solver/cnf_simplifier.h"
+#include "solver/approximate_counter.h"
+#include "utils/logger.h"
+#include "utils/random_cnf_generator.h"
+#include "utils/timer.h"
+
+using namespace std;
+
+// keep the optimizer from dropping a result
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct BenchmarkResult {
+    string name;
+    int size;             // the benchmark's size parameter (variables or clauses - see the name)
+    uint64_t iterations;
+    double medianNanos;
+    double meanNanos;
+    double minNanos;
+    double itemsPerSecond;  // size parameter processed per second, at the median
+};
+
+struct BenchmarkOptions {
+    string filter;
+    double minSeconds;
+    uint64_t minIterations;
+    uint64_t maxIterations;
+
+    BenchmarkOptions() : minSeconds(0.25), minIterations(5), maxIterations(1000000) {}
+};
+
+// Runs one benchmark: setup (untimed) then run (timed) per iteration, until the time budget is used
+BenchmarkResult measure(const string& name, int size, const BenchmarkOptions& options, const function<void()>& setup, const function<void()>& run) {
+    // warm up caches and lazily initialized state
+    setup();
+    run();
+
+    vector<uint64_t> samples;
+    uint64_t totalNanos = 0;
+    Timer budget;
+    while (samples.size() < options.minIterations || (budget.elapsedSeconds() < options.minSeconds && samples.size() < options.maxIterations)) {
+        setup();
+        Timer timer;
+        run();
+        uint64_t nanos = timer.elapsedNanos();
+        samples.push_back(nanos);
+        totalNanos += nanos;
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.size = size;
+    result.iterations = samples.size();
+    result.meanNanos = static_cast<double>(totalNanos) / samples.size();
+    sort(samples.begin(), samples.end());
+    result.medianNanos = samples[samples.size() / 2];
+    result.minNanos = samples.front();
+    result.itemsPerSecond = (result.medianNanos > 0) ? size * 1e9 / result.medianNanos : 0.0;
+    return result;
+}
+
+string toDimacs(const CNFFormula& formula) {
+    ostringstream out;
+    out << "p cnf " << formula.numVariables << " " << formula.clauses.size() << "\n";
+    for (const auto& clause : formula.clauses) {
+        for (Literal lit : clause.literals) {
+            out << lit << " ";
+        }
+        out << "0\n";
+    }
+    return out.str();
+}
+
+// The benchmarks - a friend of the classes whose kernels are private
+class KernelBenchmarks {
+public:
+    explicit KernelBenchmarks(const BenchmarkOptions& o) : options(o) {}
+
+    void runAll() {
+        for (int clauses : {1000, 10000, 100000}) {
+            parseString(clauses);
+        }
+        for (int vars : {100, 1000, 10000}) {
+            generateXORFamily(vars);
+        }
+        for (int vars : {100, 1000, 10000}) {
+            sampleXORFamily(vars);
+        }
+        for (int vars : {100, 1000, 10000}) {
+            gaussianElimination(vars);
+        }
+        for (int vars : {1000, 10000, 100000}) {
+            applyAssignment(vars);
+        }
+        for (int vars : {1000, 10000, 50000}) {
+            propagate(vars);
+        }
+        for (int vars : {16, 32, 64}) {
+            countSolutions(vars);
+        }
+    }
+
+    const vector<BenchmarkResult>& results() const { return collected; }
+
+private:
+    bool selected(const string& name) const {
+        return options.filter.empty() || name.find(options.filter) != string::npos;
+    }
+
+    void add(const string& name, int size, const function<void()>& setup, const function<void()>& run) {
+        collected.push_back(measure(name, size, options, setup, run));
+        LOG_INFO(name << "/" << size << ": " << collected.back().medianNanos << " ns");
+    }
+
+    // DIMACS text of random 3-SAT at ratio 4.26 - size is the number of clauses
+    void parseString(int numClauses) {
+        if (!selected("parse_string")) {
+            return;
+        }
+        int numVars = max(3, static_cast<int>(numClauses / 4.26));
+        string text = toDimacs(*RandomCNFGenerator::randomKSAT(numVars, 3, static_cast<double>(numClauses) / numVars, 1));
+        add("parse_string", numClauses, [] {}, [&] {
+            auto formula = CNFParser::parseString(text);
+            keep(formula);
+        });
+    }
+
+    // a family of 32 XORs of density 0.1 - size is the number of variables
+    void generateXORFamily(int numVars) {
+        if (!selected("generate_xor_family")) {
+            return;
+        }
+        XORHashGenerator::setSeed(1);
+        add("generate_xor_family", numVars, [] {}, [&] {
+            auto xors = XORHashGenerator::generateXORFamily(numVars, 32, 0.1);
+            keep(xors);
+        });
+    }
+
+    // the same family drawn from per-variable probabilities - 0.1 on average, spread over [0.001, 0.2)
+    // size is the number of variables
+    void sampleXORFamily(int numVars) {
+        if (!selected("sample_xor_family")) {
+            return;
+        }
+        vector<double> probabilities(numVars);
+        for (int v = 0; v < numVars; v++) {
+            probabilities[v] = 0.001 + 0.198 * (v % 100) / 99;
+        }
+        VariableSampler sampler(probabilities);
+        mt19937 rng(1);
+        vector<XORConstraint> xors;
+        vector<XORConstraint> spare;
+        add("sample_xor_family", numVars, [] {}, [&] {
+            XORHashGenerator::generateXORFamily(sampler, 32, rng, xors, spare);
+            keep(xors);
+        });
+    }
+
+    // elimination of 32 XOR rows of density 0.1 - size is the number of variables (columns)
+    void gaussianElimination(int numVars) {
+        if (!selected("gaussian_elimination")) {
+            return;
+        }
+        XORHashGenerator::setSeed(2);
+        auto xors = XORHashGenerator::generateXORFamily(numVars, 32, 0.1);
+        EliminationBuffers buffers;
+        XORSolutionResult solution;
+        add("gaussian_elimination", numVars, [&] {
+            // the kernel works in place, so every call gets a fresh matrix
+            buffers.reset(xors.size(), numVars);
+            for (size_t r = 0; r < xors.size(); r++) {
+                for (int var : xors[r].variables) {
+                    buffers.row(r)[(var - 1) / 64] |= 1ULL << ((var - 1) % 64);
+                }
+                buffers.rhs[r] = xors[r].value ? 1 : 0;
+            }
+        }, [&] {
+            PartialAssignment::gaussianElimination(buffers, xors.size(), numVars, solution);
+            keep(solution);
+        });
+    }
+
+    // a quarter of the variables of planted 3-SAT at ratio 4.26 fixed to their planted values - size is the number of variables
+    // (following the planted assignment keeps the simplifier from stopping at the first falsified clause)
+    void applyAssignment(int numVars) {
+        if (!selected("apply_assignment")) {
+            return;
+        }
+        CNFFormula formula;
+        FormulaSink sink(formula);
+        GeneratedInstance info = RandomCNFGenerator::plantedKSAT(sink, numVars, 3, 4.26, 3);
+        unordered_map<int, int> assignment;
+        for (int var = 1; var <= numVars; var += 4) {
+            assignment[var] = info.planted[var - 1];
+        }
+        add("apply_assignment", numVars, [] {}, [&] {
+            auto result = CNFSimplifier::applyAssignment(formula, assignment);
+            keep(result);
+        });
+    }
+
+    // unit propagation after 1% of the variables of planted 3-SAT at ratio 4.0 are decided - size is the number of variables
+    void propagate(int numVars) {
+        if (!selected("propagate")) {
+            return;
+        }
+        CNFFormula formula;
+        FormulaSink sink(formula);
+        GeneratedInstance info = RandomCNFGenerator::plantedKSAT(sink, numVars, 3, 4.0, 4);
+
+        // decisions follow the planted assignment so the propagation does not stop at a conflict
+        vector<int> decided(numVars, -1);
+        FastRandom rng(4);
+        for (int i = 0; i < max(1, numVars / 100); i++) {
+            int var = static_cast<int>(rng.below(numVars));
+            decided[var] = info.planted[var];
+        }
+        ApproximateCounter::CDCLSolver initial;
+        ApproximateCounter::loadFormula(initial, formula, decided);
+        
+        ApproximateCounter::CDCLSolver solver;
+        add("propagate", numVars, [&] {
+            solver = initial;
+        }, [&] {
+            int conflictClause = -1;
+            bool ok = ApproximateCounter::propagate(solver, conflictClause);
+            keep(ok);
+        });
+    }
+
+    // bounded counting of a random 3-SAT cell at ratio 2.0 with the default cell bound - size is the number of variables
+    void countSolutions(int numVars) {
+        if (!selected("count_solutions")) {
+            return;
+        }
+        auto formula = RandomCNFGenerator::plantedKSAT(numVars, 3, 2.0, 5);
+        int maxCount = 82;
+        add("count_solutions", numVars, [] {}, [&] {
+            uint64_t count = ApproximateCounter::countSolutions(*formula, maxCount);
+            keep(count);
+        });
+    }
+
+    BenchmarkOptions options;
+    vector<BenchmarkResult> collected;
+};
+
+string formatJSON(const vector<BenchmarkResult>& results) {
+    ostringstream out;
+    out << fixed << setprecision(1);
+    out << "{\"context\": {\"evaluation_kernel\": \"" << ClauseEvaluator::kernelName(ClauseEvaluator::detectKernel()) << "\"";
+#ifdef AMC_ENABLE_STATS
+    out << ", \"stats_enabled\": true";
+#else
+    out << ", \"stats_enabled\": false";
+#endif
+    out << "}, \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "{\"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"iterations\": " << r.iterations
+            << ", \"median_ns\": " << r.medianNanos << ", \"mean_ns\": " << r.meanNanos << ", \"min_ns\": " << r.minNanos
+            << ", \"items_per_second\": " << r.itemsPerSecond << "}";
+    }
+    out << "\n]}";
+    return out.str();
+}
+
+string formatCSV(const vector<BenchmarkResult>& results) {
+    ostringstream out;
+    out << fixed << setprecision(1);
+    out << "name,size,iterations,median_ns,mean_ns,min_ns,items_per_second\n";
+    for (const auto& r : results) {
+        out << r.name << "," << r.size << "," << r.iterations << "," << r.medianNanos << "," << r.meanNanos << "," << r.minNanos << "," << r.itemsPerSecond << "\n";
+    }
+    return out.str();
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    string format = "json";
+    string outPath = "-";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--format") {
+            format = argv[i + 1];
+        } else if (flag == "--filter") {
+            options.filter = argv[i + 1];
+        } else if (flag == "--min-time") {
+            options.minSeconds = stod(argv[i + 1]);
+        } else if (flag == "--out") {
+            outPath = argv[i + 1];
+        } else {
+            cerr << "Unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    if (format != "json" && format != "csv") {
+        cerr << "Unknown format " << format << " (expected json or csv)" << endl;
+        return 1;
+    }
+
+    try {
+        KernelBenchmarks benchmarks(options);
+        benchmarks.runAll();
+        string output = (format == "json") ? formatJSON(benchmarks.results()) : formatCSV(benchmarks.results());
+        if (!Logger::writeJSON(outPath, output)) {
+            cerr << "Could not write " << outPath << endl;
+            return 1;
+        }
+    } catch (const exception& e) {
+        cerr << "Benchmark failed: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Header file for batch clause evaluation on the CPU
+// Bit-sliced evaluation of many complete assignments at once, with a SIMD kernel picked at runtime
+
+#ifndef CLAUSE_EVALUATION_H
+#define CLAUSE_EVALUATION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "cnf/cnf_structure.h"
+
+// Block of complete assignments stored bit-sliced
+// Bit j of word w of variable v is the value of v in assignment (64 * w + j)
+struct AssignmentBatch {
+    int numVariables;
+    int numAssignments;
+    int numWords;
+    std::vector<uint64_t> bits;  // numVariables rows of numWords words
+
+    AssignmentBatch() : numVariables(0), numAssignments(0), numWords(0) {}
+    AssignmentBatch(int vars, int assignments) :
+        numVariables(vars),
+        numAssignments(assignments),
+        numWords((assignments + 63) / 64),
+        bits(static_cast<size_t>(vars) * ((assignments + 63) / 64), 0) {}
+
+    // store assignment at position index - same layout as Clause::isSatisfied (0-indexed, 1 = true)
+    void setAssignment(int index, const std::vector<int>& assignment);
+
+    // set a single (1-indexed) variable of the assignment at position index
+    void setValue(int index, int var, bool value);
+    bool getValue(int index, int var) const;
+
+    uint64_t* variableWords(int var) { return bits.data() + static_cast<size_t>(var - 1) * numWords; }
+    const uint64_t* variableWords(int var) const { return bits.data() + static_cast<size_t>(var - 1) * numWords; }
+};
+
+// Clauses flattened for the kernels - literal code is 2 * (variable - 1) + negated
+struct FlatClauses {
+    std::vector<uint32_t> literalCodes;
+    std::vector<uint32_t> clauseStarts;  // numClauses + 1 offsets into literalCodes
+    bool hasEmptyClause;
+    int maxVariable;  // largest variable of any literal - the kernels read that many variable rows
+
+    FlatClauses() : hasEmptyClause(false), maxVariable(0) {}
+
+    size_t numClauses() const { return clauseStarts.empty() ? 0 : clauseStarts.size() - 1; }
+};
+
+enum class EvaluationKernel {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+class ClauseEvaluator {
+public:
+    // flatten the clauses of a formula once so they can be evaluated against many batches
+    static FlatClauses flatten(const CNFFormula& formula);
+
+    // best kernel supported by this CPU (checked once)
+    static EvaluationKernel detectKernel();
+    static const char* kernelName(EvaluationKernel kernel);
+
+    // evaluate a batch against the formula - bit i of the result is set if assignment i satisfies every clause
+    // literals of variables past batch.numVariables are false, as in Clause::isSatisfied with a short assignment
+    static std::vector<uint64_t> evaluate(const FlatClauses& clauses, const AssignmentBatch& batch);
+    static std::vector<uint64_t> evaluate(const FlatClauses& clauses, const AssignmentBatch& batch, EvaluationKernel kernel);
+
+    // clear bit i of satisfied unless assignment i has (XOR of the 1-indexed variables) == value
+    // one XOR per variable and word - 64 assignments at a time, variables past batch.numVariables count as false
+    static void filterParity(const std::vector<int>& variables, bool value, const AssignmentBatch& batch, uint64_t* satisfied);
+
+    // raw kernel entry point - variable row v starts at variableWords + v * stride, numWords words are evaluated
+    // the caller provides clauses.maxVariable rows, nothing is checked here
+    static void evaluateWords(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t numWords, uint64_t* satisfied, EvaluationKernel kernel);
+
+private:
+    // drop the literals of variables past numVariables (for batches shorter than the formula)
+    static FlatClauses restrict(const FlatClauses& clauses, int numVariables);
+
+    static void evaluateScalar(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t begin, size_t end, uint64_t* satisfied);
+    static size_t evaluateAVX2(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t numWords, uint64_t* satisfied);
+    static size_t evaluateAVX512(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t numWords, uint64_t* satisfied);
+};
+
+#endif // CLAUSE_EVALUATION_H
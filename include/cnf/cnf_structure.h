@@ -3,6 +3,7 @@
 #ifndef CNF_STRUCTURE_H
 #define CNF_STRUCTURE_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <unordered_set>
@@ -12,6 +13,8 @@
 // Literals - positive integer for variable, negative integer for NOT variable
 using Literal = int;
 
+struct AssignmentBatch;
+
 // Clause is OR of literals
 class Clause {
 public:
@@ -49,6 +52,10 @@ public:
     // Check if formula is satisfied by an assignment
     bool isSatisfied(const std::vector<int>& assignment) const;
     
+    // Check a whole batch of complete assignments at once (see cnf/clause_evaluation.h)
+    // Bit i of the result is set if assignment i satisfies the formula
+    std::vector<uint64_t> isSatisfiedBatch(const AssignmentBatch& batch) const;
+    
     size_t getNumClauses() const { return clauses.size(); }
     int getNumVariables() const { return numVariables; }
     void clear();
@@ -0,0 +1,48 @@
+// Header file for variable renumbering
+// Generated instances number their variables in no useful order, so the solver's per-variable arrays
+// (assignment, levels, activity scores, watch lists) are touched all over memory.
+// A Cuthill-McKee ordering of the variable interaction graph gives variables that share clauses nearby ids.
+
+#ifndef VARIABLE_ORDER_H
+#define VARIABLE_ORDER_H
+
+#include <vector>
+#include "cnf/cnf_structure.h"
+
+// Permutation of the variables 1..n - renumbering keeps the number of models, so counts need no mapping back
+class VariableOrder {
+public:
+    VariableOrder() = default;
+
+    // identity on numVariables variables
+    static VariableOrder identity(int numVariables);
+
+    // Cuthill-McKee over the clause incidence: each component is entered at a variable of lowest degree
+    // (number of clause occurrences), and the unnumbered variables of the clauses of each visited variable
+    // are numbered next, lowest degree first. Variables in no clause keep their relative order at the end.
+    static VariableOrder cuthillMcKee(const CNFFormula& formula);
+
+    int numVariables() const { return newIds.empty() ? 0 : static_cast<int>(newIds.size()) - 1; }
+
+    // id of the original variable var in the renumbered formula, and back
+    int renumbered(int var) const { return newIds[var]; }
+    int original(int var) const { return oldIds[var]; }
+
+    Literal renumberLiteral(Literal lit) const { return (lit > 0) ? newIds[lit] : -newIds[-lit]; }
+    Literal originalLiteral(Literal lit) const { return (lit > 0) ? oldIds[lit] : -oldIds[-lit]; }
+
+    // the formula over the new ids, clauses in the same order
+    CNFFormula apply(const CNFFormula& formula) const;
+
+    // a model of the renumbered formula as a model of the original (assignment[var - 1] for each variable)
+    std::vector<int> originalAssignment(const std::vector<int>& assignment) const;
+
+    // (largest - smallest variable) of each clause, summed over the clauses - what the ordering lowers
+    static long clauseSpan(const CNFFormula& formula);
+
+private:
+    std::vector<int> newIds;    // by original variable, index 0 unused
+    std::vector<int> oldIds;    // by new variable, index 0 unused
+};
+
+#endif // VARIABLE_ORDER_H
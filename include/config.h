@@ -1,2 +1,87 @@
 // Global configuration constants, thresholds, and parameters
 // Defines solver settings, GPU configurations, and approximation parameters
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+//
+// Exact counting
+//
+
+// a formula (or cell) is handed to the exact component-caching counter when it has at most this many
+// constrained variables and clauses
+constexpr int EXACT_COUNT_MAX_VARIABLES = 256;
+constexpr int EXACT_COUNT_MAX_CLAUSES = 4096;
+
+// number of branching decisions the exact counter may make before giving up
+constexpr int EXACT_COUNT_MAX_DECISIONS = 200000;
+
+// the component cache is cleared once it holds this many entries
+constexpr int EXACT_COUNT_MAX_CACHE_ENTRIES = 1 << 20;
+
+//
+// Preprocessing
+//
+
+// edges of the binary implication graph walked by failed literal probing, over all probed literals
+constexpr long PROBE_MAX_STEPS = 1L << 24;
+
+//
+// Learned clause sharing
+//
+
+// clauses learned from the formula alone are shared between the SAT calls of a run - the pool takes at most
+// max(SHARED_CLAUSES_MIN_CAPACITY, number of formula clauses) of them, so importing at most doubles a call's setup
+constexpr int SHARED_CLAUSES_MIN_CAPACITY = 1024;
+constexpr int SHARED_CLAUSES_MAX_CAPACITY = 1 << 16;
+
+// longer learned clauses are kept to the call that learned them
+constexpr int SHARED_CLAUSE_MAX_LITERALS = 8;
+
+//
+// Truth-table counting
+//
+
+// cells with at most this many constrained variables are counted by evaluating every assignment bit-parallel
+constexpr int TRUTH_TABLE_MAX_VARIABLES = 24;
+
+//
+// Approximation guarantees
+//
+
+// default tolerance and confidence: the estimate is within a factor (1 + epsilon) of the true count with probability 1 - delta
+constexpr double DEFAULT_EPSILON = 0.8;
+constexpr double DEFAULT_DELTA = 0.2;
+
+// never stop early before this many successful trials
+constexpr int MIN_TRIALS_BEFORE_STOPPING = 3;
+
+// a cell of a nested hash family with at most this many times (threshold + 10) models has them enumerated
+// once the search needs a finer cell - the finer cells are then counted by filtering instead of solving
+constexpr int NESTED_REUSE_FACTOR = 4;
+
+//
+// Count server
+//
+
+// parsed formulas kept by the server - whichever limit is reached first evicts the least recently used
+constexpr int SERVER_CACHE_MAX_ENTRIES = 256;
+constexpr long SERVER_CACHE_MAX_LITERALS = 64L << 20;
+
+// inline DIMACS larger than this is refused
+constexpr long SERVER_MAX_REQUEST_BYTES = 256L << 20;
+
+//
+// Sharded counting
+//
+
+// how often coordinator and workers look at the shared work queue directory
+constexpr int SHARD_POLL_MILLISECONDS = 50;
+
+// a worker touches the claim of the trial it is running this often
+constexpr double SHARD_HEARTBEAT_SECONDS = 30.0;
+
+// a claim not touched for this long (several heartbeats) is put back in the queue (its worker is presumed dead)
+constexpr double SHARD_RECLAIM_SECONDS = 600.0;
+
+#endif // CONFIG_H
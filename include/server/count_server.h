@@ -0,0 +1,104 @@
+// Header file for the count server
+// Long-running daemon answering count requests over a Unix domain socket
+//
+// Protocol - one request per line, any number of requests per connection:
+//   COUNT id=<id> path=<file> [parameters]
+//   COUNT id=<id> bytes=<n> [parameters]      followed by n bytes of DIMACS text
+//   STATS
+// parameters: trials=<n> density=<p> threshold=<n> epsilon=<e> delta=<d> seed=<n> timeout=<s> trial_timeout=<s>
+//             max_conflicts=<n> exact=0|1 nested=0|1
+//
+// Every COUNT is answered by one JSON line {"id": ..., "cached": ..., "result": {...}} as soon as it finishes -
+// answers to pipelined requests arrive in completion order. A malformed request is answered by {"id": ..., "error": ...}
+
+#ifndef COUNT_SERVER_H
+#define COUNT_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "server/formula_cache.h"
+#include "solver/approximate_counter.h"
+#include "utils/cancellation.h"
+#include "utils/thread_pool.h"
+#include "config.h"
+
+struct ServerOptions {
+    std::string socketPath;
+    int numThreads;             // workers shared by all connections, 0 = one per hardware thread
+    size_t cacheEntries;
+    size_t cacheLiterals;
+    CountingOptions defaults;   // parameters a request does not set
+
+    ServerOptions() :
+        numThreads(0),
+        cacheEntries(SERVER_CACHE_MAX_ENTRIES),
+        cacheLiterals(SERVER_CACHE_MAX_LITERALS) {}
+};
+
+class CountServer {
+public:
+    explicit CountServer(const ServerOptions& options);
+
+    // stops, cancels the counts in flight (their answers are partial), waits for them, then removes the socket file
+    ~CountServer();
+
+    CountServer(const CountServer&) = delete;
+    CountServer& operator=(const CountServer&) = delete;
+
+    // bind and listen - throws runtime_error if the socket cannot be set up
+    void start();
+
+    // accept connections until stop() is called
+    void run();
+
+    // only sets a flag - safe to call from a signal handler
+    void stop() { stopping.store(true); }
+
+    FormulaCacheStats cacheStats() const { return cache.stats(); }
+
+private:
+    struct Connection;
+
+    void serveConnection(std::shared_ptr<Connection> connection);
+
+    // queue the count - blocks while every worker already has a request (backpressure on the client)
+    void submitCount(std::shared_ptr<Connection> connection, const std::string& header, std::string body, bool inlineBody);
+
+    // parse, look up the cache and count - the answer line
+    std::string answerCount(const std::string& header, const std::string& body, bool inlineBody);
+
+    std::string answerStats() const;
+
+    ServerOptions options;
+    FormulaCache cache;
+    std::atomic<bool> stopping;
+    CancellationToken shutdownToken;  // parent of every request's run
+    int listenFd;
+
+    // one reader thread per client - joined once its connection has closed
+    struct ConnectionThread {
+        std::thread thread;
+        std::shared_ptr<Connection> connection;
+    };
+    void reapConnections(bool all);
+
+    std::mutex connectionsMutex;
+    std::vector<ConnectionThread> connectionThreads;
+
+    std::mutex slotMutex;
+    std::condition_variable slotFree;
+    int activeRequests;
+    std::atomic<uint64_t> requestsServed;
+
+    // request handlers run on their own threads and only coordinate - the trials of every request run on pool,
+    // and a handler waiting for its trials never picks up another client's count
+    ThreadPool pool;
+    ThreadPool requests;    // last - destroyed first, while the pool and everything its tasks use still exist
+};
+
+#endif // COUNT_SERVER_H
@@ -0,0 +1,81 @@
+// Header file for the formula cache of the count server
+// Parsed and preprocessed formulas, keyed by their DIMACS text (found by its hash) and evicted least recently used first
+
+#ifndef FORMULA_CACHE_H
+#define FORMULA_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "solver/model_count.h"
+
+// A formula ready to count - shared read-only by every request for the same content
+struct CachedFormula {
+    uint64_t contentHash;
+    std::string dimacs;        // the text itself - a hit has to match it, not just its hash
+    std::shared_ptr<const CNFFormula> formula;
+    std::shared_ptr<const PreparedFormula> prepared;   // preprocessed and loaded - what the trials of every request start from
+    size_t literals;           // total clause length - what the cache budget is measured in
+    bool exactAttempted;       // the formula fits the exact counter's budget and it was run
+    bool exactCompleted;
+    ModelCount exactCount;     // valid if exactCompleted
+
+    CachedFormula() : contentHash(0), literals(0), exactAttempted(false), exactCompleted(false) {}
+};
+
+struct FormulaCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+    size_t literals;
+
+    FormulaCacheStats() : hits(0), misses(0), evictions(0), entries(0), literals(0) {}
+};
+
+class FormulaCache {
+public:
+    // the cache holds at most maxEntries formulas and maxLiterals literals in total
+    // (the most recent formula is always kept, even if it alone is over the budget)
+    // formulas are preprocessed as the counting options ask
+    // texts are looked up by hash, contentHash unless another function is given (tests pass weak ones to force collisions)
+    using HashFunction = uint64_t (*)(const std::string&);
+    FormulaCache(size_t maxEntries, size_t maxLiterals, const CountingOptions& counting = CountingOptions(),
+                 HashFunction hash = contentHash);
+
+    // Look up the formula for this DIMACS text, parsing and preprocessing it on a miss - throws on parse errors
+    // wasCached tells whether the formula came from the cache; a different text with the same hash replaces the entry
+    std::shared_ptr<const CachedFormula> get(const std::string& dimacs, bool& wasCached);
+
+    FormulaCacheStats stats() const;
+
+    // 64-bit FNV-1a of the text
+    static uint64_t contentHash(const std::string& text);
+
+private:
+    // parse, run the exact counter if the formula fits its budget and prepare it for the approximate counter
+    std::shared_ptr<const CachedFormula> prepare(const std::string& dimacs, uint64_t hash) const;
+
+    void evict();
+
+    using LRUList = std::list<std::shared_ptr<const CachedFormula>>;
+
+    // drop the entry from the list and the index
+    void remove(LRUList::iterator entry);
+
+    size_t maxEntries;
+    size_t maxLiterals;
+    CountingOptions counting;
+    HashFunction hashText;
+    LRUList order;    // most recently used first
+    std::unordered_map<uint64_t, LRUList::iterator> index;
+    FormulaCacheStats counters;
+    mutable std::mutex cacheMutex;
+};
+
+#endif // FORMULA_CACHE_H
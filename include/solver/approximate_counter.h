@@ -3,58 +3,266 @@
 #ifndef APPROXIMATE_COUNTER_H
 #define APPROXIMATE_COUNTER_H
 
+#include <algorithm>
 #include <vector>
 #include <memory>
+#include <string>
+#include <cmath>
+#include <unordered_set>
 #include "cnf/cnf_structure.h"
+#include "cnf/clause_evaluation.h"
 #include "xor/xor_hash_generator.h"
+#include "xor/ml_hash_interface.h"
+#include "solver/model_count.h"
+#include "solver/implication_graph.h"
+#include "solver/partial_assignment.h"
+#include "solver/cnf_simplifier.h"
+#include "solver/statistical_analysis.h"
+#include "utils/timer.h"
+#include "utils/cancellation.h"
+#include "config.h"
+
+class ThreadPool;
+class LearnedClausePool;
+class SolverSnapshot;
+class PreparedFormula;
+class TrialWorkspace;
 
 // Single counting trial result
+// The estimate is cellCount * 2^numXORs - kept in that form so it never saturates
 struct TrialResult {
     bool satisfiable;
-    uint64_t solutionCount;
+    uint64_t cellCount;
     int numXORs;
     int freeVariables;
     int assignedVariables;
+    bool aborted;        // a time or conflict budget ran out - the trial has no count and is left out of the estimate
+    PhaseStats stats;    // time and solver work spent in this trial
     
     TrialResult() : 
         satisfiable(false),
-        solutionCount(0),
+        cellCount(0),
         numXORs(0),
         freeVariables(0),
-        assignedVariables(0) {}
+        assignedVariables(0),
+        aborted(false) {}
+    
+    ModelCount count() const { return ModelCount(cellCount, numXORs); }
 };
 
 // Final approximation result - using multiple aggregated trials
 struct ApproximationResult {
-    uint64_t estimatedCount;
+    uint64_t estimatedCount;    // saturates at UINT64_MAX - log2Estimate holds the full value
+    double log2Estimate;
     double averageCount;
     int successfulTrials;
     int totalTrials;
-    std::vector<uint64_t> trialCounts;
+    int abortedTrials;    // trials cut short by a budget - counted in totalTrials, not in the estimate
+    std::vector<ModelCount> trialCounts;
+    bool exact;    // formula was small enough to be counted exactly - no trials were run
+    
+    ConfidenceInterval interval;    // for the median, in the log2 domain
+    bool earlyStopped;    // stopped before the trial budget because the interval was already within tolerance
+    bool timedOut;        // the run's time limit passed
+    bool cancelled;       // the caller's cancellation token was cancelled
+    bool partial;         // stopped by a budget before the trial budget was used - the estimate covers the trials that completed
+    PhaseStats stats;                    // whole run
+    std::vector<PhaseStats> trialStats;  // one entry per trial, in trial order
     
     ApproximationResult() : 
         estimatedCount(0), 
+        log2Estimate(-INFINITY),
         averageCount(0.0), 
         successfulTrials(0), 
-        totalTrials(0) {}
+        totalTrials(0),
+        abortedTrials(0),
+        exact(false),
+        earlyStopped(false),
+        timedOut(false),
+        cancelled(false),
+        partial(false) {}
+};
+
+// Parameters for an approximate count
+// How a trial draws the XORs for successive XOR counts
+enum class HashFamily {
+    INDEPENDENT,   // a fresh family for every XOR count tried
+    NESTED         // one sequence of XORs - m XORs are the first m, so the cell shrinks as XORs are added
+};
+
+struct CountingOptions {
+    double epsilon;          // tolerance - estimate within a factor (1 + epsilon)
+    double delta;            // confidence - guarantee holds with probability 1 - delta
+    int maxTrials;           // 0 = derived from delta
+    int threshold;           // cell size threshold, 0 = derived from epsilon
+    double density;          // XOR density
+    bool earlyTermination;   // stop once the median's confidence interval is within tolerance
+    bool exactFallback;      // count formulas within the exact counter's budget outright
+    bool probeFailedLiterals; // add the units failed literal probing finds on the binary implication graph
+    bool renumberVariables;  // give variables that share clauses nearby ids (Cuthill-McKee) before solving
+    HashFamily hashFamily;   // nested families let a trial binary search the XOR count
+    bool shareLearnedClauses; // clauses learned from the formula alone are passed on to later SAT calls and trials
+    uint64_t seed;           // trial i draws its XORs from stream (seed, i) - 0 = a seed from the shared generator
+    int numThreads;          // trials run at once - 1 = on the calling thread, 0 = one per hardware thread
+    ThreadPool* pool;        // shared pool to run the trials on instead of a pool of numThreads
+    double timeoutSeconds;        // the whole run - trials still running then are abandoned, 0 = no limit
+    double trialTimeoutSeconds;   // each trial - 0 = no limit
+    uint64_t maxConflictsPerSolve; // each SAT call - a trial whose solver gives up is abandoned, 0 = no limit
+    const CancellationToken* cancel;  // cancelling it stops the run like a timeout
+    std::string checkpointPath;   // completed trials are appended here and read back by a restarted run - empty = none
+    std::shared_ptr<const MLHashModel> hashModel;  // XOR variables drawn with the probabilities it predicts for the (preprocessed) formula instead of density - null = density
+    
+    CountingOptions() :
+        epsilon(DEFAULT_EPSILON),
+        delta(DEFAULT_DELTA),
+        maxTrials(0),
+        threshold(0),
+        density(0.1),
+        earlyTermination(true),
+        exactFallback(true),
+        probeFailedLiterals(true),
+        renumberVariables(false),
+        hashFamily(HashFamily::INDEPENDENT),
+        shareLearnedClauses(true),
+        seed(0),
+        numThreads(1),
+        pool(nullptr),
+        timeoutSeconds(0),
+        trialTimeoutSeconds(0),
+        maxConflictsPerSolve(0),
+        cancel(nullptr) {}
+};
+
+// Outcome of one SAT call
+enum class SolveStatus {
+    SATISFIABLE,
+    UNSATISFIABLE,
+    UNKNOWN       // a limit ran out first
+};
+
+// Limits of the SAT calls of a trial
+struct SolveLimits {
+    const CancellationToken* cancel;   // polled every few conflicts and decisions
+    uint64_t maxConflicts;             // per call, 0 = no limit
+    LearnedClausePool* sharedClauses;  // clauses learned from its formula are imported and exported - nullptr = none
+    const SolverSnapshot* snapshot;    // the trial's formula, loaded once - its cells clone it instead of loading from scratch
+    const VariableSampler* sampler;    // the trial draws its XORs from it instead of with one density - over the trial formula's variables
+    
+    SolveLimits() : cancel(nullptr), maxConflicts(0), sharedClauses(nullptr), snapshot(nullptr), sampler(nullptr) {}
 };
 
 class ApproximateCounter {
 public:
     // Run approximate counting with multiple trials
+    // Formulas that fit the exact counter's budget are counted outright instead
     static ApproximationResult approximateCount(const CNFFormula& formula, int numTrials = 10, int numXORs = 3, double density = 0.1);
+    
+    // Run approximate counting for an (epsilon, delta) guarantee
+    // Runs up to the required number of trials, stopping early once the median's confidence interval is within tolerance
+    // With a seed the result does not depend on the thread count - trials are seeded by index and consumed in index order
+    static ApproximationResult approximateCount(const CNFFormula& formula, const CountingOptions& options);
+    
+    // Same, for a formula prepared once - the preprocessing, snapshot and learned clause pool are the prepared ones,
+    // so the options' probeFailedLiterals, renumberVariables and shareLearnedClauses are not looked at
+    static ApproximationResult approximateCount(const PreparedFormula& prepared, const CountingOptions& options);
+    
+    // Preprocess the formula and build what its runs start from, for counting it more than once
+    static std::unique_ptr<PreparedFormula> prepare(const CNFFormula& formula, const CountingOptions& options);
         
+    // Failed literal probing and variable renumbering as the options ask - the count stays the same
+    // Returns false if there was nothing to do (result is left alone); unsatisfiable is set when probing finds no models
+    static bool preprocess(const CNFFormula& formula, const CountingOptions& options, CNFFormula& result, bool& unsatisfiable);
+    
     // Run trial with adaptive XOR count
     static TrialResult singleTrial(const CNFFormula& formula, double density, int threshold = 50);
     
-    // Aggregate results from multiple trials
-    static ApproximationResult aggregateResults(const std::vector<TrialResult>& trials);
+    // Same, drawing the XORs from the given generator - the trial is abandoned (aborted) when a limit runs out
+    // startXORs > 0 starts the search for the XOR count there instead of at zero (the XORs drawn then differ,
+    // except with nested families - their XORs do not depend on the order the search tries XOR counts in)
+    static TrialResult singleTrial(const CNFFormula& formula, double density, int threshold, std::mt19937& rng,
+                                   const SolveLimits& limits = SolveLimits(), int startXORs = 0,
+                                   HashFamily family = HashFamily::INDEPENDENT);
+    
+    // Generator for trial trialIndex of a run with the given seed
+    static std::mt19937 trialGenerator(uint64_t seed, int trialIndex);
+    
+    // Result for a formula whose count is known exactly
+    static ApproximationResult exactResult(const ModelCount& count);
+    
+    // Aggregate results from multiple trials - the median's confidence interval is computed at confidence 1 - delta
+    static ApproximationResult aggregateResults(const std::vector<TrialResult>& trials, double delta = DEFAULT_DELTA);
+    
+    // Phase times and solver counters of a run as JSON: {"run": {...}, "trials": [{...}, ...]}
+    static std::string statsToJSON(const ApproximationResult& result);
+    
+    // SAT solver - values already set in assignment (0/1) are fixed
+    static bool solveSAT(const CNFFormula& formula, std::vector<int>& assignment, int varIndex);
+    static SolveStatus solveSAT(const CNFFormula& formula, std::vector<int>& assignment, const SolveLimits& limits);
     
 private:
+    // the kernel microbenchmarks (benchmarks/bench_kernels.cpp) time the private kernels directly
+    friend class KernelBenchmarks;
+    friend class SolverSnapshot;
+    friend class TrialWorkspace;
+    
+    // body of approximateCount once the formula is preprocessed - prepared is nullptr for a formula counted only once
+    static ApproximationResult countPreprocessed(const CNFFormula& formula, const PreparedFormula* prepared, const CountingOptions& options,
+                                                 const PhaseStats& runStart);
+    
+    // body of singleTrial - singleTrial wraps it to record the trial's stats
+    // every step works in the thread's workspace
+    static TrialResult runTrial(const CNFFormula& formula, double density, int threshold, std::mt19937& rng, const SolveLimits& limits,
+                                TrialWorkspace& workspace);
+    static TrialResult runHintedTrial(const CNFFormula& formula, double density, int threshold, std::mt19937& rng, const SolveLimits& limits,
+                                      int startXORs, TrialWorkspace& workspace);
+    
+    // with a nested family the cell count only falls as XORs are added, so the XOR count is searched by
+    // galloping from startXORs and then bisecting - each count is probed at most once
+    static TrialResult runNestedTrial(const CNFFormula& formula, double density, int threshold, std::mt19937& rng, const SolveLimits& limits,
+                                      int startXORs, TrialWorkspace& workspace);
+    
+    // numXORs fresh XORs into the workspace - from limits.sampler when there is one
+    static void drawXORs(int numVariables, int numXORs, double density, std::mt19937& rng, const SolveLimits& limits,
+                         TrialWorkspace& workspace);
+    
+    // one step of the XOR search - the cell cut out by numXORs fresh XORs and its model count (capped a little above the threshold)
+    struct CellProbe {
+        uint64_t cellCount;     // 0 if the cell is empty
+        int freeVariables;
+        int assignedVariables;
+        bool interrupted;       // a limit ran out
+        
+        CellProbe() : cellCount(0), freeVariables(0), assignedVariables(0), interrupted(false) {}
+    };
+    static CellProbe probeCell(const CNFFormula& formula, int numXORs, double density, int threshold, std::mt19937& rng, const SolveLimits& limits,
+                               TrialWorkspace& workspace);
+    
+    // the cell cut out by the given XORs - with simplified, the cell as a formula is copied there
+    static CellProbe probeCell(const CNFFormula& formula, const std::vector<XORConstraint>& xors, int threshold, const SolveLimits& limits,
+                               TrialWorkspace& workspace, CNFFormula* simplified = nullptr);
+    
+    // a probed cell of a nested family - a finer cell is a subset, so once the models of this one are known
+    // the finer cell's count is the number of them that satisfy the extra XORs
+    struct NestedCell {
+        CellProbe probe;
+        CNFFormula simplified;      // the cell as a formula - dropped once the models have been enumerated
+        AssignmentBatch models;     // bit-sliced over the trial formula's variables
+        bool modelsKnown;
+        bool enumerated;            // enumeration was attempted (it gives up on too many models)
+        
+        NestedCell() : modelsKnown(false), enumerated(false) {}
+    };
+    
+    // models of the cell (at most maxModels of them) - enumerated on the first call, false if there are more
+    static bool cellModels(NestedCell& cell, int numVariables, size_t maxModels, const SolveLimits& limits);
+    
+    // the models of a finer nested cell: the coarser cell's models that satisfy the XORs it lacks
+    static AssignmentBatch filterModels(const AssignmentBatch& models, const std::vector<XORConstraint>& extraXORs);
+    
     struct CDCLAssignment {
         int value;           // -1 = unassigned, 0 = false, 1 = true
         int decisionLevel;   // Which level was this assigned at
-        int antecedent;
+        int antecedent;      // clause index, -1 = decision or unit, <= -2 = binary clause (see CDCLSolver::binaryReason)
     };
     
     struct WatchedLiterals {
@@ -76,11 +284,19 @@ private:
         double increment = 1.0;
         
         void init(int numVars) {
-            scores.resize(numVars, 0.0);
+            scores.assign(numVars, 0.0);
+            increment = 1.0;
         }
         
         void bump(int var) {
             scores[var] += increment;
+            // rescale before the scores overflow
+            if (scores[var] > 1e100) {
+                for (double& score : scores) {
+                    score *= 1e-100;
+                }
+                increment *= 1e-100;
+            }
         }
         
         void decayAll() {
@@ -100,26 +316,240 @@ private:
         }
     };
     
+    // Long clauses stored back to back - clause c is literals[starts[c]] up to literals[starts[c + 1]]
+    struct ClauseArena {
+        std::vector<Literal> literals;
+        std::vector<uint32_t> starts;
+        
+        ClauseArena() : starts(1, 0) {}
+        
+        size_t size() const { return starts.size() - 1; }
+        const Literal* clause(size_t c) const { return literals.data() + starts[c]; }
+        int clauseSize(size_t c) const { return starts[c + 1] - starts[c]; }
+        void add(const Literal* lits, size_t count) {
+            literals.insert(literals.end(), lits, lits + count);
+            starts.push_back(literals.size());
+        }
+    };
+    
+    // State of one CDCL search
+    // Clause literals are never reordered - the solver keeps the positions of the two watched literals instead,
+    // so the loaded formula's clauses and binary implications can be shared by every solver cloned from it
+    // Binary clauses of the formula and learned ones live in implication graphs only - no watches, no arena entry
+    struct CDCLSolver {
+        int numVars;
+        std::shared_ptr<const ClauseArena> formulaClauses;     // clauses of three or more literals of the loaded formula
+        ClauseArena addedClauses;           // clauses added since (cell constraints, blocking clauses) and learned ones
+        size_t numFormulaClauses;           // added clause i is clause numFormulaClauses + i
+        std::vector<int> watched;           // by clause, two positions - the literals it is watched on
+        std::shared_ptr<const ImplicationGraph> formulaBinaries;
+        ImplicationGraph addedBinaries;     // learned binary clauses
+        std::vector<CDCLAssignment> assignment;
+        std::vector<int> trail;             // assigned variables in assignment order
+        std::vector<size_t> trailLevels;    // trail position where each decision level starts
+        size_t binaryHead;                  // trail entries before this one have had their binary implications propagated
+        size_t propagationHead;             // trail entries before this one have been propagated through the long clauses
+        Literal binaryConflict[2];          // the binary clause propagate() found falsified (conflictClause = BINARY_CONFLICT)
+        Literal binaryReason[2];            // scratch for conflict analysis - a binary antecedent as a clause
+        std::vector<int> savedPhase;        // last value of each variable - reused when it is decided again
+        std::vector<char> seen;             // scratch marks for conflict analysis
+        WatchedLiterals watches;
+        VSIDSScores vsids;
+        // kept while limits.sharedClauses is set - whether a clause depends on anything but the pool's formula
+        // (XOR encodings, blocking clauses, fixed values), and so may not be shared
+        std::vector<char> clauseTainted;              // by long clause index
+        std::shared_ptr<const std::unordered_set<uint64_t>> formulaTaintedBinaries;  // by binaryKey
+        ImplicationGraph taintedAddedBinaries;        // the tainted ones among addedBinaries
+        std::vector<char> rootTainted;                // by variable - the reason of a level 0 assignment
+        bool rootConflict;                  // unsatisfiable before any decision (empty clause or conflicting units)
+        SolveLimits limits;
+        uint64_t totalConflicts;            // this call, across restarts
+        uint64_t totalDecisions;
+        std::vector<Literal> learnedClause; // scratch for conflict analysis
+        
+        CDCLSolver() :
+            numVars(0),
+            formulaClauses(std::make_shared<ClauseArena>()),
+            numFormulaClauses(0),
+            formulaBinaries(std::make_shared<ImplicationGraph>()),
+            binaryHead(0),
+            propagationHead(0),
+            formulaTaintedBinaries(std::make_shared<std::unordered_set<uint64_t>>()),
+            rootConflict(false),
+            totalConflicts(0),
+            totalDecisions(0) {}
+        
+        static constexpr int BINARY_CONFLICT = -2;
+        
+        // antecedent of a literal implied by the binary clause (implied OR other) - other is the clause's false literal
+        static int binaryAntecedent(Literal other) { return -2 - ImplicationGraph::index(other); }
+        static Literal binaryAntecedentLiteral(int antecedent) {
+            int index = -2 - antecedent;
+            return (index % 2 == 0) ? index / 2 + 1 : -(index / 2 + 1);
+        }
+        
+        size_t numClauses() const { return numFormulaClauses + addedClauses.size(); }
+        const Literal* clauseLiterals(size_t c) const {
+            return (c < numFormulaClauses) ? formulaClauses->clause(c) : addedClauses.clause(c - numFormulaClauses);
+        }
+        int clauseSize(size_t c) const {
+            return (c < numFormulaClauses) ? formulaClauses->clauseSize(c) : addedClauses.clauseSize(c - numFormulaClauses);
+        }
+        
+        int decisionLevel() const { return trailLevels.size() - 1; }
+        
+        bool tracksTaint() const { return limits.sharedClauses != nullptr; }
+        
+        static uint64_t binaryKey(Literal a, Literal b) {
+            uint64_t x = ImplicationGraph::index(a);
+            uint64_t y = ImplicationGraph::index(b);
+            return (x < y) ? (x << 32 | y) : (y << 32 | x);
+        }
+        bool binaryTainted(Literal a, Literal b) const {
+            if (formulaTaintedBinaries->count(binaryKey(a, b)) != 0) {
+                return true;
+            }
+            if (std::max(abs(a), abs(b)) > taintedAddedBinaries.numVariables()) {
+                return false;
+            }
+            const std::vector<Literal>& implied = taintedAddedBinaries.implied(-a);
+            return std::find(implied.begin(), implied.end(), b) != implied.end();
+        }
+        
+        // 1 = true, 0 = false, -1 = unassigned
+        int literalValue(Literal lit) const {
+            int value = assignment[abs(lit) - 1].value;
+            return (value == -1 || lit > 0) ? value : 1 - value;
+        }
+    };
+    
     // Count solutions in simplified CNF up to maxCount (bounded enumeration)
+    // Any value above maxCount only means the cell is too big - UINT64_MAX stands for "at least 2^64"
+    // Small cells are counted exactly instead - by truth table below TRUTH_TABLE_MAX_VARIABLES, otherwise by the component-caching counter
     static uint64_t countSolutions(const CNFFormula& simplified, int maxCount);
     
-    // Find next solution different from current assignment
-    static bool findNextSolution(const CNFFormula& formula, std::vector<int>& assignment);
-    
-    // SAT solver
-    static bool solveSAT(const CNFFormula& formula, std::vector<int>& assignment, int varIndex);
+    // Same under limits - interrupted is set if a limit ran out and the count is incomplete
+    // When simplified is the cell cut out of the formula of limits.snapshot by xorSolution, the SAT calls start
+    // from a clone of the snapshot with the XOR solution added instead of loading the simplified formula
+    static uint64_t countSolutions(const CNFFormula& simplified, int maxCount, const SolveLimits& limits, bool& interrupted);
+    static uint64_t countSolutions(const CNFFormula& simplified, int maxCount, const SolveLimits& limits, bool& interrupted,
+                                   const XORSolutionResult* xorSolution, TrialWorkspace& workspace);
     
     // CDCL Helper Methods
-    static bool cdclSolve(const CNFFormula& formula, std::vector<CDCLAssignment>& assignment, std::vector<Clause>& learnedClauses, WatchedLiterals& watches, VSIDSScores& vsids, int& conflicts, int& restartThreshold);
+    // set up the solver for a formula - fixed values (0/1, -1 = free) are asserted at level 0
+    // with limits.sharedClauses set, the pool's clauses are added as learned ones
+    static void loadFormula(CDCLSolver& solver, const CNFFormula& formula, const std::vector<int>& fixed);
+    
+    // set up the solver for a cell of the snapshot's formula - a copy of the snapshot (sharing its clauses)
+    // with the XOR solution's values asserted at level 0 and its remaining rows encoded over the same
+    // auxiliary variables CNFSimplifier::applyXORSolution would add
+    // (into the workspace's solver) - returns false, leaving the solver alone, if that does not give cell's variables
+    static bool loadCell(TrialWorkspace& workspace, const SolverSnapshot& snapshot, const XORSolutionResult& xorSolution,
+                         const CNFFormula& cell, const SolveLimits& limits);
+    
+    // solver = base, keeping the storage solver already has: watch and implication lists of variables base does not have
+    // are emptied rather than freed, so the next cell's auxiliary variables find them allocated
+    static void copySolver(CDCLSolver& solver, const CDCLSolver& base);
+    
+    // clauses of the shared pool, added as learned ones
+    static void importSharedClauses(CDCLSolver& solver);
+    
+    // add variables after the existing ones
+    static void addVariables(CDCLSolver& solver, int count);
+    
+    // add a clause at level 0 - sets rootConflict if it is already falsified, assigns it if it is unit
+    // lits is sorted and its duplicates dropped in place
+    static void addClause(CDCLSolver& solver, std::vector<Literal>& lits, bool tainted);
     
-    static bool propagate(const CNFFormula& formula, const std::vector<Clause>& learnedClauses, std::vector<CDCLAssignment>& assignment, WatchedLiterals& watches, int currentLevel, int& conflictClause);
+    // one SAT call on the loaded solver - it can be called again after backtracking to level 0 and adding clauses
+    static SolveStatus solve(CDCLSolver& solver);
     
-    static void analyzeConflict(const CNFFormula& formula, const std::vector<Clause>& learnedClauses, const std::vector<CDCLAssignment>& assignment, int conflictClause, Clause& learnedClause, int& backtrackLevel, VSIDSScores& vsids);
+    static SolveStatus cdclSolve(CDCLSolver& solver, int& conflicts, int& restartThreshold);
     
-    static void initWatches(const CNFFormula& formula, const std::vector<Clause>& learnedClauses, WatchedLiterals& watches, int numVars);
+    // returns false on conflict, with the conflicting clause in conflictClause
+    static bool propagate(CDCLSolver& solver, int& conflictClause);
     
-    static bool updateWatch(const CNFFormula& formula, const std::vector<Clause>& learnedClauses, int clauseIdx, Literal falseLit, std::vector<CDCLAssignment>& assignment, WatchedLiterals& watches, int currentLevel, int& conflictClause);
+    // tainted is set if the learned clause was resolved from a tainted clause or level 0 assignment
+    static void analyzeConflict(CDCLSolver& solver, int conflictClause, std::vector<Literal>& learnedClause, int& backtrackLevel, bool& tainted);
+    
+    // watch the clause on its first two literals that are not false (false ones if there are fewer)
+    // at level 0 - a clause left unit is asserted, one left false sets rootConflict
+    static void watchClause(CDCLSolver& solver, int clauseIdx);
+    static void attachClause(CDCLSolver& solver, int clauseIdx);
+    static void assign(CDCLSolver& solver, Literal lit, int antecedent);
+    static void backtrack(CDCLSolver& solver, int level);
+};
+
+// The solver state of a formula after loading and propagating at level 0, built once for a run
+// Every cell clones it: the clauses and binary implications are shared, only the per-variable state,
+// watch lists and trail are copied - the cell's own values and XOR rows come on top
+class SolverSnapshot {
+public:
+    // with the pool, the snapshot tracks taint as the run's SAT calls do - the formula has to be the pool's
+    explicit SolverSnapshot(const CNFFormula& formula, LearnedClausePool* sharedClauses = nullptr);
+    
+    int numVariables() const { return base.numVars; }
+    bool unsatisfiable() const { return base.rootConflict; }
+    
+    // whether this is the snapshot of that formula object (not just an equal one)
+    bool builtFrom(const CNFFormula& formula) const { return source == &formula; }
+    
+private:
+    friend class ApproximateCounter;
+    ApproximateCounter::CDCLSolver base;
+    const CNFFormula* source;
 };
 
+// A formula preprocessed, with its snapshot and learned clause pool, shared read-only by any number of runs
+// The pool stays with it - clauses a run learns from the formula alone hold in the cells of every later run too
+class PreparedFormula {
+public:
+    ~PreparedFormula();
+    
+    PreparedFormula(const PreparedFormula&) = delete;
+    PreparedFormula& operator=(const PreparedFormula&) = delete;
+    
+    const CNFFormula& formula() const { return preprocessed; }
+    
+    // probing found no models - there is no snapshot
+    bool unsatisfiable() const { return snapshot == nullptr; }
+    
+private:
+    friend class ApproximateCounter;
+    PreparedFormula();
+    
+    CNFFormula preprocessed;
+    std::unique_ptr<LearnedClausePool> sharedClauses;   // nullptr unless the options share learned clauses
+    std::unique_ptr<SolverSnapshot> snapshot;           // of preprocessed, tracking taint for sharedClauses
+};
+
+// Buffers of the XOR search, reused by every step of every trial run on one thread
+// Once they have grown to what the steps need, a step whose cell goes to the CDCL solver cloned from a
+// SolverSnapshot allocates nothing - the XORs, the elimination matrix, the cell and the solver are overwritten in place
+class TrialWorkspace {
+public:
+    TrialWorkspace() {}
+    
+    TrialWorkspace(const TrialWorkspace&) = delete;
+    TrialWorkspace& operator=(const TrialWorkspace&) = delete;
+    
+    // workspace of the calling thread - singleTrial runs in it
+    static TrialWorkspace& local();
+    
+private:
+    friend class ApproximateCounter;
+    std::vector<XORConstraint> xors;
+    std::vector<XORConstraint> spareXORs;
+    XORSolutionResult xorSolution;
+    EliminationBuffers elimination;
+    SimplificationResult cell;
+    SimplificationBuffers simplification;
+    ApproximateCounter::CDCLSolver solver;
+    CNFFormula rows;                    // the XOR rows loadCell encodes
+    std::vector<Clause> spareRows;
+    std::vector<char> inClause;         // by variable - countSolutions' scratch
+    std::vector<int> constrained;
+    std::vector<Literal> blocking;
+};
 
 #endif // APPROXIMATE_COUNTER_H
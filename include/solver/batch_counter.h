@@ -0,0 +1,47 @@
+// Header file for batch counting
+// Counts many CNF files on one shared thread pool - the trials of every file go to the same workers
+
+#ifndef BATCH_COUNTER_H
+#define BATCH_COUNTER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "solver/approximate_counter.h"
+
+class ThreadPool;
+
+// Outcome of counting one file
+struct BatchResult {
+    size_t index;            // position of the file in the batch
+    std::string path;
+    bool ok;                 // false if the file could not be read or counted - see error
+    std::string error;
+    int numVariables;
+    size_t numClauses;
+    double seconds;          // parse and count
+    ApproximationResult result;
+
+    BatchResult() : index(0), ok(false), numVariables(0), numClauses(0), seconds(0.0) {}
+};
+
+class BatchCounter {
+public:
+    using ResultCallback = std::function<void(const BatchResult&)>;
+
+    // Count every file - onResult is called once per file as soon as it finishes (completion order, never concurrently)
+    // At most one file per worker is in progress, so memory stays bounded for any batch size
+    // Returns the number of files that failed
+    static int run(const std::vector<std::string>& paths, const CountingOptions& options, ThreadPool& pool, const ResultCallback& onResult);
+
+    // Parse and count one file - errors are reported in the result, not thrown
+    static BatchResult countFile(size_t index, const std::string& path, const CountingOptions& options);
+
+    // Output formats - one line per result
+    static std::string toText(const BatchResult& result);
+    static std::string toJSON(const BatchResult& result);
+    static std::string csvHeader();
+    static std::string toCSV(const BatchResult& result);
+};
+
+#endif // BATCH_COUNTER_H
@@ -15,12 +15,20 @@ struct SimplificationResult {
     bool isTriviallyTrue;
     int clausesRemoved;
     int literalsRemoved;
+    int auxiliaryVariables;    // variables added after the original ones to encode XOR constraints
     
     SimplificationResult() : 
         isUnsatisfiable(false), 
         isTriviallyTrue(false), 
         clausesRemoved(0), 
-        literalsRemoved(0) {}
+        literalsRemoved(0),
+        auxiliaryVariables(0) {}
+};
+
+// Working storage of applyXORSolution - kept by the caller, so cell after cell stops allocating
+struct SimplificationBuffers {
+    std::vector<int> values;        // by variable - 0/1 fixed by the XOR solution, -1 free
+    std::vector<Clause> spare;      // clauses no longer needed, kept with their storage
 };
 
 class CNFSimplifier {
@@ -29,8 +37,22 @@ public:
     static SimplificationResult applyAssignment(const CNFFormula& formula, const std::unordered_map<int, int>& assignment);
     
     // Apply XOR solution result to simplify CNF
+    // The result is the cell: its models are exactly the models of the formula that satisfy the XORs
+    // Fixed variables are kept as unit clauses (so they are not counted as free) and the remaining reduced rows
+    // are encoded as clauses over auxiliary variables, each of which is determined by the original ones
     static SimplificationResult applyXORSolution(const CNFFormula& formula, const XORSolutionResult& xorSolution);
     
+    // Same, into result - the clauses of result.simplified are overwritten, keeping their storage
+    static void applyXORSolution(const CNFFormula& formula, const XORSolutionResult& xorSolution, SimplificationResult& result,
+                                 SimplificationBuffers& buffers);
+    
+    // Append clauses for x1 XOR ... XOR xk = value, chaining through fresh variables (formula.numVariables grows)
+    // Returns the number of variables added
+    static int encodeXOR(CNFFormula& formula, const XORConstraint& constraint);
+    
+    // Same, taking the clauses it appends from spare when it can
+    static int encodeXOR(CNFFormula& formula, const XORConstraint& constraint, std::vector<Clause>& spare);
+    
     // Check if a literal is satisfied by the assignment
     static bool isLiteralSatisfied(Literal lit, const std::unordered_map<int, int>& assignment);
     
@@ -0,0 +1,83 @@
+// Header file for exact model counting
+
+#ifndef EXACT_COUNTER_H
+#define EXACT_COUNTER_H
+
+#include <cstdint>
+#include <vector>
+#include "cnf/cnf_structure.h"
+#include "solver/model_count.h"
+#include "utils/cancellation.h"
+#include "config.h"
+
+// Result of an exact count
+struct ExactCountResult {
+    bool completed;       // false if the decision budget ran out or the count does not fit in 64 bits
+    bool overflow;        // the count over the constrained variables is known to be at least 2^64
+    bool exceeded;        // given up because a component has more than maxModels models
+    uint64_t count;       // models over the variables that appear in some clause
+    int freeVariables;    // variables in no clause - each doubles the count
+    uint64_t decisions;
+    uint64_t cacheHits;
+    uint64_t components;  // number of independent components counted
+
+    ExactCountResult() :
+        completed(false),
+        overflow(false),
+        exceeded(false),
+        count(0),
+        freeVariables(0),
+        decisions(0),
+        cacheHits(0),
+        components(0) {}
+    
+    ModelCount modelCount() const { return ModelCount(count, freeVariables); }
+};
+
+// DPLL-style exact counter with component decomposition and component caching (in the spirit of sharpSAT)
+// After each decision and unit propagation the remaining clauses are split into variable-disjoint components
+// Each component is counted on its own and the counts are multiplied
+// Component counts are cached by (variables, clauses), so a component that shows up again in another branch is not recounted
+class ExactCounter {
+public:
+    // check if the formula is small enough to be handed to the exact counter
+    static bool fitsBudget(const CNFFormula& formula, int maxVariables = EXACT_COUNT_MAX_VARIABLES, int maxClauses = EXACT_COUNT_MAX_CLAUSES);
+
+    // count all models of the formula over its numVariables variables
+    // variables that do not appear in any clause are reported as freeVariables rather than multiplied in
+    // the count is abandoned (completed = false) once cancel is cancelled
+    // it is also given up (exceeded = true) once some component has more than maxModels models - callers that only
+    // need to know whether the count is small stop there instead of counting a large formula to the end
+    // (the formula then has more than maxModels models, unless another component of the same branch has none)
+    static ExactCountResult count(const CNFFormula& formula, uint64_t maxDecisions = EXACT_COUNT_MAX_DECISIONS, const CancellationToken* cancel = nullptr,
+                                  uint64_t maxModels = UINT64_MAX);
+
+    // every model of the formula restricted to variables 1..projectVars (assignment[var - 1], 0/1), by plain DPLL
+    // the variables above projectVars must be determined by the ones below (as the auxiliaries of an XOR encoding are)
+    // returns false if there are more than maxModels models or the decision budget ran out - models is then incomplete
+    static bool enumerate(const CNFFormula& formula, int projectVars, size_t maxModels, std::vector<std::vector<int>>& models,
+                          uint64_t maxDecisions = EXACT_COUNT_MAX_DECISIONS, const CancellationToken* cancel = nullptr);
+
+private:
+    struct SearchState;
+
+    // count the models of a component (sorted variables, sorted clause indices) under the current assignment
+    static uint64_t countComponent(SearchState& state, const std::vector<int>& vars, const std::vector<int>& clauses);
+
+    // split the unassigned variables and unsatisfied clauses of a component into sub-components and multiply their counts
+    static uint64_t countResidual(SearchState& state, const std::vector<int>& vars, const std::vector<int>& clauses);
+
+    // clauses without duplicate literals and tautologies, units propagated - false if that already gives a conflict
+    static bool load(SearchState& state, const CNFFormula& formula);
+
+    // DPLL below the current assignment - false once the model limit or the budget is exceeded
+    static bool enumerateFrom(SearchState& state, int projectVars, size_t maxModels, std::vector<std::vector<int>>& models);
+
+    // assign a variable and unit propagate - returns false on conflict
+    static bool assignAndPropagate(SearchState& state, int var, int value);
+
+    // undo all assignments made after the trail reached the given size
+    static void undoTo(SearchState& state, size_t trailSize);
+};
+
+#endif // EXACT_COUNTER_H
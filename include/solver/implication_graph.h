@@ -0,0 +1,87 @@
+// Header file for the binary implication graph
+// A binary clause (a OR b) is kept as the two implications -a -> b and -b -> a instead of as a clause:
+// the CDCL solver propagates them straight from these lists, preprocessing walks them to probe literals
+
+#ifndef IMPLICATION_GRAPH_H
+#define IMPLICATION_GRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "cnf/cnf_structure.h"
+#include "config.h"
+
+// Result of failed literal probing
+struct ProbeResult {
+    std::vector<Literal> units;    // literals every model satisfies - adding them as unit clauses keeps the count
+    int failedLiterals;            // probed literals that implied a contradiction
+    bool unsatisfiable;            // some literal and its negation both failed
+    bool exhausted;                // the step budget ran out before every literal was probed
+
+    ProbeResult() : failedLiterals(0), unsatisfiable(false), exhausted(false) {}
+};
+
+class ImplicationGraph {
+public:
+    ImplicationGraph() : numVars(0) {}
+
+    // graph of the formula's binary clauses (after dropping duplicate literals) - longer clauses are ignored
+    static ImplicationGraph fromFormula(const CNFFormula& formula);
+
+    void init(int numVariables) {
+        numVars = numVariables;
+        edges.assign(2 * numVariables, {});
+    }
+
+    // room for count more variables after the existing ones
+    void addVariables(int count) {
+        numVars += count;
+        if (edges.size() < 2 * static_cast<size_t>(numVars)) {
+            edges.resize(2 * numVars);
+        }
+    }
+
+    // copy of other that keeps this graph's storage - lists past other's variables are emptied, not freed
+    void assignKeepingStorage(const ImplicationGraph& other) {
+        numVars = other.numVars;
+        if (edges.size() < other.edges.size()) {
+            edges.resize(other.edges.size());
+        }
+        std::copy(other.edges.begin(), other.edges.end(), edges.begin());
+        for (size_t i = other.edges.size(); i < edges.size(); i++) {
+            edges[i].clear();
+        }
+    }
+
+    void addClause(Literal a, Literal b) {
+        edges[index(-a)].push_back(b);
+        edges[index(-b)].push_back(a);
+    }
+
+    // literals that have to be true once lit is true
+    const std::vector<Literal>& implied(Literal lit) const { return edges[index(lit)]; }
+
+    int numVariables() const { return numVars; }
+    size_t numEdges() const;
+
+    // positive literal of variable v -> 2v, negative -> 2v + 1
+    static int index(Literal lit) { return (lit > 0) ? 2 * (lit - 1) : 2 * (-lit - 1) + 1; }
+
+    // Failed literal probing: a literal whose implications contain a complementary pair cannot be true,
+    // so its negation (and everything that implies) holds in every model
+    // maxSteps bounds the edges walked over all probes
+    ProbeResult probeFailedLiterals(uint64_t maxSteps = PROBE_MAX_STEPS) const;
+
+    // formula plus the units probing found - the same models, so the same count
+    static CNFFormula withProbedUnits(const CNFFormula& formula, const ProbeResult& probe);
+
+private:
+    // literals reachable from lit (lit included) into reached, marking them in mark with stamp
+    // false on a contradiction - a literal and its negation reached, or a literal whose negation is already forced
+    bool reach(Literal lit, const std::vector<char>& forced, std::vector<Literal>& reached, std::vector<uint32_t>& mark, uint32_t stamp, uint64_t& steps) const;
+
+    int numVars;
+    std::vector<std::vector<Literal>> edges;    // by index(lit): literals implied by lit
+};
+
+#endif // IMPLICATION_GRAPH_H
@@ -0,0 +1,61 @@
+// Header file for the shared pool of learned clauses
+// A clause the solver learns from clauses of the run's formula alone holds in every cell of every trial,
+// so it is published here and imported by the SAT calls that follow instead of being learned again.
+// Clauses that depend on XOR encodings, blocking clauses or fixed values are not - the solver keeps those to itself.
+
+#ifndef LEARNED_CLAUSE_POOL_H
+#define LEARNED_CLAUSE_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "cnf/cnf_structure.h"
+#include "config.h"
+
+// Append-only and bounded - once full, further clauses are dropped
+// Adding and reading are lock-free: a writer reserves a slot with one atomic increment and publishes it
+// by storing the clause size last, so a reader sees either a complete clause or an empty slot
+class LearnedClausePool {
+public:
+    // capacity 0 = max(SHARED_CLAUSES_MIN_CAPACITY, number of clauses), up to SHARED_CLAUSES_MAX_CAPACITY
+    explicit LearnedClausePool(const CNFFormula& formula, size_t capacity = 0);
+
+    LearnedClausePool(const LearnedClausePool&) = delete;
+    LearnedClausePool& operator=(const LearnedClausePool&) = delete;
+
+    int numVariables() const { return formulaVariables; }
+    size_t capacity() const { return slotCount; }
+
+    // whether the literals (sorted, no duplicates) are a clause of the formula - read-only, safe from any thread
+    bool isFormulaClause(const std::vector<Literal>& sortedLits) const;
+
+    // publish a clause implied by the formula - false if it is too long or the pool is full
+    bool add(const Literal* lits, size_t size);
+
+    // slots handed out so far - a slot below this may still be being written
+    size_t size() const;
+
+    // the clause in slot index (below size()) - false if its writer has not finished yet
+    bool get(size_t index, std::vector<Literal>& lits) const;
+
+private:
+    struct Slot {
+        std::atomic<int> size;    // 0 until the literals are written
+        Literal literals[SHARED_CLAUSE_MAX_LITERALS];
+
+        Slot() : size(0) {}
+    };
+
+    struct ClauseHash {
+        size_t operator()(const std::vector<Literal>& lits) const;
+    };
+
+    int formulaVariables;
+    std::unordered_set<std::vector<Literal>, ClauseHash> formulaClauses;
+    size_t slotCount;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> reserved;    // may run past slotCount once the pool is full
+};
+
+#endif // LEARNED_CLAUSE_POOL_H
@@ -0,0 +1,33 @@
+// Header file for model count representation
+
+#ifndef MODEL_COUNT_H
+#define MODEL_COUNT_H
+
+#include <cstdint>
+#include <string>
+
+// Model count kept as cellCount * 2^exponent so counts above 2^64 stay exact
+// (a hashing trial naturally produces this form: the models in its cell times 2^numXORs)
+struct ModelCount {
+    uint64_t cellCount;
+    int exponent;
+    
+    ModelCount() : cellCount(0), exponent(0) {}
+    ModelCount(uint64_t cell, int exp) : cellCount(cell), exponent(exp) {}
+    
+    bool isZero() const { return cellCount == 0; }
+    
+    // log2 of the count (-infinity for zero)
+    double log2() const;
+    
+    // the count as a plain integer, or UINT64_MAX if it does not fit
+    uint64_t saturated() const;
+    
+    // exact decimal if the count fits in 64 bits, otherwise "<cell>*2^<exponent>"
+    std::string toString() const;
+    
+    // format a count given only as log2 - decimal below 2^64, otherwise "2^<log2>"
+    static std::string formatLog2(double log2Count);
+};
+
+#endif // MODEL_COUNT_H
@@ -3,8 +3,9 @@
 #ifndef PARTIAL_ASSIGNMENT_H
 #define PARTIAL_ASSIGNMENT_H
 
+#include <cstdint>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 #include "xor/xor_hash_generator.h"
 
 // Value of a variable in the partial assignment
@@ -17,21 +18,43 @@ enum AssignmentValue {
 // Result of solving XOR constraints
 struct XORSolutionResult {
     bool satisfiable;
-    std::unordered_map<int, int> assignment;
+    std::vector<std::pair<int, int>> assignment;   // (variable, value) fixed by a reduced row on their own - by variable
+    std::vector<XORConstraint> constraints;        // reduced rows that still tie a pivot to free variables
     std::vector<int> freeVariables;
     
     XORSolutionResult() : satisfiable(true) {}
 };
 
+// Working storage of the elimination - kept by the caller, so solving system after system stops allocating
+struct EliminationBuffers {
+    std::vector<uint64_t> matrix;      // row r is words [r * rowWords, (r + 1) * rowWords) - bit c is variable c + 1
+    std::vector<int> rhs;
+    std::vector<int> pivotColumn;      // by row, -1 = no pivot
+    std::vector<char> pivoted;         // by column
+    std::vector<XORConstraint> spare;  // reduced rows no longer needed, kept with their storage
+    int rowWords;
+    
+    EliminationBuffers() : rowWords(0) {}
+    
+    // zeroed rows of numVariables columns
+    void reset(int numRows, int numVariables);
+    uint64_t* row(int r) { return matrix.data() + static_cast<size_t>(r) * rowWords; }
+};
+
 class PartialAssignment {
 public:
     // Solve a system of XOR constraints using Gaussian elimination
     // Returns a partial assignment or indicates unsatisfiability
     static XORSolutionResult solveXORSystem(const std::vector<XORConstraint>& xors, int numVariables);
+    
+    // Same, into result - its vectors and the buffers keep their storage from one call to the next
+    static void solveXORSystem(const std::vector<XORConstraint>& xors, int numVariables, XORSolutionResult& result, EliminationBuffers& buffers);
 
 private:
-    // Gaussian elimination for XOR constraints
-    static XORSolutionResult gaussianElimination(std::vector<std::vector<int>>& matrix, std::vector<int>& rhs, int numVariables);
+    friend class KernelBenchmarks;
+    
+    // Gaussian elimination over the rows in buffers (bit-packed, 64 columns a word) - they are reduced in place
+    static void gaussianElimination(EliminationBuffers& buffers, int numRows, int numVariables, XORSolutionResult& result);
 };
 
 #endif // PARTIAL_ASSIGNMENT_H
@@ -0,0 +1,44 @@
+// Header file for sharded counting
+// A coordinator spreads the trials of one run over worker processes through a shared directory -
+// workers may run on other hosts, anything that sees the same filesystem can take part
+//
+// Directory layout:
+//   formula.cnf                 copy of the formula
+//   job                         seed, formula fingerprint and trial parameters - written last, workers wait for it
+//   queue/trial-<index>         trial descriptors: "index <i> xors <hint>"
+//   claimed/trial-<index>.<worker>   a descriptor a worker took - claiming is a rename, so exactly one worker wins;
+//                               the worker touches it every heartbeat while the trial runs
+//   results/trial-<index>       the trial's record (TrialCheckpoint format)
+//   done                        the coordinator has what it needs - workers exit
+//
+// Trial i draws its XORs from stream (seed, i) and starts its XOR search at the hint, so a trial computed twice
+// (its worker was presumed dead and the trial was handed out again) gives the same record. A worker is presumed dead
+// once its claim has gone reclaimSeconds without a heartbeat, so a trial may run for any length of time.
+// The coordinator runs trial 0 from zero XORs on its own and hands out the rest with the XOR count it settled on -
+// with a seed the result does not depend on the number of workers or on which worker ran what.
+
+#ifndef SHARDED_COUNTER_H
+#define SHARDED_COUNTER_H
+
+#include <string>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "utils/cancellation.h"
+#include "config.h"
+
+class ShardedCounter {
+public:
+    // Count the formula read from formulaPath with trials run by workers on directory
+    // The directory must not hold a job yet - it is left in place (with the done marker) for inspection
+    // options.timeoutSeconds and options.cancel stop the run with the trials finished so far
+    static ApproximationResult coordinate(const CNFFormula& formula, const std::string& formulaPath, const std::string& directory,
+                                          const CountingOptions& options, double reclaimSeconds = SHARD_RECLAIM_SECONDS);
+
+    // Take trials from the queue in directory until the coordinator is done or cancel is cancelled
+    // Waits for the job if the coordinator has not written it yet - returns the number of trials run
+    // heartbeatSeconds has to be well below the coordinator's reclaimSeconds
+    static int work(const std::string& directory, const CancellationToken* cancel = nullptr,
+                    double heartbeatSeconds = SHARD_HEARTBEAT_SECONDS);
+};
+
+#endif // SHARDED_COUNTER_H
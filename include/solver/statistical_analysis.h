@@ -1,2 +1,43 @@
 // Header file for statistical analysis
 // Function declarations for computing statistics on counting results
+
+#ifndef STATISTICAL_ANALYSIS_H
+#define STATISTICAL_ANALYSIS_H
+
+#include <vector>
+
+// Distribution-free confidence interval for the median of the trial estimates (log2 domain)
+struct ConfidenceInterval {
+    bool valid;           // false if there are too few samples to reach the requested confidence
+    double log2Lower;
+    double log2Upper;
+    double confidence;    // actual coverage of the interval (at least 1 - delta when valid)
+    
+    ConfidenceInterval() : 
+        valid(false), 
+        log2Lower(0.0), 
+        log2Upper(0.0), 
+        confidence(0.0) {}
+};
+
+class StatisticalAnalysis {
+public:
+    // number of trials needed for an (epsilon, delta) guarantee: ceil(17 * log2(3 / delta)) as in ApproxMC - 0 < delta < 1
+    static int requiredIterations(double delta);
+    
+    // cell size threshold for tolerance epsilon: 1 + 9.84 * (1 + epsilon / (1 + epsilon)) * (1 + 1 / epsilon)^2 as in ApproxMC - epsilon > 0
+    static int cellThreshold(double epsilon);
+    
+    // confidence interval for the median from order statistics - [x_(k), x_(n-k+1)] with the largest k
+    // such that P(Binomial(n, 1/2) < k) <= delta / 2
+    static ConfidenceInterval medianConfidenceInterval(std::vector<double> log2Counts, double delta);
+    
+    // check if the whole interval lies within a factor (1 + epsilon) of the median
+    static bool withinTolerance(const ConfidenceInterval& interval, double log2Median, double epsilon);
+    
+private:
+    // P(Binomial(n, 1/2) <= k)
+    static double binomialCDF(int n, int k);
+};
+
+#endif // STATISTICAL_ANALYSIS_H
@@ -0,0 +1,56 @@
+// Header file for trial checkpoints
+// A counting run appends every completed trial to a file - a restarted run reads them back and skips them
+//
+// Format - text, one record per line:
+//   amc-checkpoint 1 seed=<seed> formula=<hash> density=<p> threshold=<n> [nested=1] [densities=<hash>]
+//   trial <index> <satisfiable> <cellCount> <numXORs> <freeVariables> <assignedVariables>
+// (densities= fingerprints per-variable XOR probabilities, when the trials used them instead of density)
+// (the sharded counter's workers report trials in the same record format, an aborted one as "trial <index> aborted")
+// The index is the trial's RNG stream (see ApproximateCounter::trialGenerator), so a trial read back
+// is the trial the resumed run would have computed. A last line cut short by a crash is ignored.
+
+#ifndef TRIAL_CHECKPOINT_H
+#define TRIAL_CHECKPOINT_H
+
+#include <fstream>
+#include <map>
+#include <string>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+
+class TrialCheckpoint {
+public:
+    // open or create the checkpoint - seed 0 takes the seed recorded in an existing file (a new file draws one)
+    // throws runtime_error if the file belongs to another formula or other parameters
+    // densitiesHash is densitiesHash() of the per-variable probabilities, 0 = none
+    TrialCheckpoint(const std::string& path, const CNFFormula& formula, double density, int threshold, uint64_t seed,
+                    HashFamily family = HashFamily::INDEPENDENT, uint64_t densitiesHash = 0);
+
+    uint64_t seed() const { return runSeed; }
+
+    // the trial recorded for this stream by an earlier run, if any - safe to call from the trial threads
+    bool recorded(int index, TrialResult& trial) const;
+    size_t recordedCount() const { return resumed.size(); }
+
+    // append a completed trial - flushed before returning, aborted and resumed trials are not written again
+    // (called by the thread consuming the trials only) - false if the file could not be written
+    bool append(int index, const TrialResult& trial);
+
+    // one record without the newline / parse one - false if the line is not a record
+    static std::string formatRecord(int index, const TrialResult& trial);
+    static bool parseRecord(const std::string& line, int& index, TrialResult& trial);
+
+    // fingerprint of the clauses - a checkpoint is only resumed for the formula it was written for
+    static uint64_t formulaHash(const CNFFormula& formula);
+    
+    // fingerprint of per-variable XOR probabilities - never 0
+    static uint64_t densitiesHash(const std::vector<double>& probabilities);
+
+private:
+    std::string path;
+    uint64_t runSeed;
+    std::map<int, TrialResult> resumed;     // read at construction, never changed afterwards
+    std::ofstream out;
+};
+
+#endif // TRIAL_CHECKPOINT_H
@@ -0,0 +1,29 @@
+// Header file for truth-table model counting
+
+#ifndef TRUTH_TABLE_COUNTER_H
+#define TRUTH_TABLE_COUNTER_H
+
+#include <cstdint>
+#include <vector>
+#include "cnf/cnf_structure.h"
+#include "cnf/clause_evaluation.h"
+#include "solver/model_count.h"
+#include "config.h"
+
+// Brute-force counter for formulas with few constrained variables
+// The constrained variables are renumbered 0..k-1 and all 2^k assignments are evaluated bit-sliced:
+// bit j of word w stands for assignment (64 * w + j), so every clause is checked for 64 assignments with one OR per literal
+// (256/512 per instruction with the AVX2/AVX-512 kernels of ClauseEvaluator)
+// The surviving assignments are popcounted, and variables that appear in no clause go into the exponent of the count
+class TruthTableCounter {
+public:
+    // count the models of the formula over its numVariables variables
+    // returns false without counting if the formula has more than maxVariables constrained variables
+    static bool countModels(const CNFFormula& formula, ModelCount& count, int maxVariables = TRUTH_TABLE_MAX_VARIABLES);
+
+private:
+    // fill the variable rows for the chunk of words starting at firstWord
+    static void fillVariableWords(int numVariables, uint64_t firstWord, size_t chunkWords, std::vector<uint64_t>& variableWords);
+};
+
+#endif // TRUTH_TABLE_COUNTER_H
@@ -0,0 +1,50 @@
+// Header file for cooperative cancellation
+// Long-running loops poll a token and stop when it is cancelled or its deadline has passed
+
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+
+// Tokens form a chain: a token also counts as cancelled when its parent is
+// (a trial's token has the run's token as parent, the run's token the caller's)
+class CancellationToken {
+public:
+    explicit CancellationToken(const CancellationToken* parentToken = nullptr) :
+        parent(parentToken), cancelled(false), hasDeadline(false) {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    // safe from any thread
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    // not thread-safe - set the deadline before handing the token out
+    void setDeadline(double secondsFromNow) {
+        hasDeadline = true;
+        deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(secondsFromNow));
+    }
+
+    bool deadlinePassed() const {
+        return hasDeadline && std::chrono::steady_clock::now() >= deadline;
+    }
+
+    // cancelled, past its deadline, or its parent is
+    bool isCancelled() const {
+        for (const CancellationToken* token = this; token != nullptr; token = token->parent) {
+            if (token->cancelled.load(std::memory_order_relaxed) || token->deadlinePassed()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const CancellationToken* parent;
+    std::atomic<bool> cancelled;
+    bool hasDeadline;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+#endif // CANCELLATION_H
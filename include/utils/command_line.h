@@ -0,0 +1,51 @@
+// Header file for command line parsing
+// Flags of the counter binary - counting parameters, inputs and output format
+
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <string>
+#include <vector>
+#include "solver/approximate_counter.h"
+#include "config.h"
+
+enum class OutputFormat {
+    TEXT,   // human-readable report
+    JSON,   // one JSON object per instance and line
+    CSV     // header line, then one row per instance
+};
+
+struct CommandLineOptions {
+    std::vector<std::string> inputs;   // CNF files and directories (every *.cnf inside is counted)
+    std::string listPath;              // file with one CNF path per line, "-" = stdin
+    CountingOptions counting;
+    OutputFormat format;
+    std::string statsPath;             // --stats-json
+    std::string tracePath;             // --trace
+    std::string serveSocket;           // --serve - run the count server on this Unix socket instead
+    std::string coordinateDir;         // --coordinate - hand the trials of the single input to workers on this directory
+    std::string workDir;               // --work - run trials handed out on this directory instead
+    std::string hashModelPath;         // --hash-model - loaded into counting.hashModel by the caller
+    size_t cacheEntries;               // formulas the server keeps parsed
+    bool perf;                         // --perf
+    bool verbose;
+    bool help;
+
+    CommandLineOptions() : format(OutputFormat::TEXT), cacheEntries(SERVER_CACHE_MAX_ENTRIES), perf(false), verbose(false), help(false) {}
+
+    // no inputs given - the CNF path is read interactively
+    bool interactive() const { return inputs.empty() && listPath.empty() && serveSocket.empty() && workDir.empty(); }
+};
+
+class CommandLine {
+public:
+    // Parse argv - throws runtime_error on unknown flags and invalid values
+    static CommandLineOptions parse(int argc, char* argv[]);
+
+    // Expand the inputs into the CNF files to count, in the order given (directories sorted by name)
+    static std::vector<std::string> collectInputs(const CommandLineOptions& options);
+
+    static std::string usage(const std::string& program);
+};
+
+#endif // COMMAND_LINE_H
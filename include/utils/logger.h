@@ -1,2 +1,49 @@
 // Header file for logging utilities
 // Logging levels, macros, and function declarations
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <string>
+#include <sstream>
+
+enum class LogLevel {
+    DEBUG = 0,
+    INFO = 1,
+    WARNING = 2,
+    ERROR = 3,
+    NONE = 4
+};
+
+class Logger {
+public:
+    // messages below this level are dropped (default WARNING)
+    static void setLevel(LogLevel level);
+    static LogLevel getLevel();
+    static bool isEnabled(LogLevel level) { return level >= getLevel(); }
+    
+    // write one line to stderr - safe to call from several threads
+    static void log(LogLevel level, const std::string& message);
+    
+    // write a JSON document to a file (or stdout for "-") - returns false if the file cannot be written
+    static bool writeJSON(const std::string& path, const std::string& json);
+    
+    static const char* levelName(LogLevel level);
+};
+
+// stream-style logging: LOG_INFO("parsed " << n << " clauses") - the message is only built if the level is enabled
+#define AMC_LOG(level, message) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            std::ostringstream amcLogStream; \
+            amcLogStream << message; \
+            Logger::log(level, amcLogStream.str()); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(message) AMC_LOG(LogLevel::DEBUG, message)
+#define LOG_INFO(message) AMC_LOG(LogLevel::INFO, message)
+#define LOG_WARNING(message) AMC_LOG(LogLevel::WARNING, message)
+#define LOG_ERROR(message) AMC_LOG(LogLevel::ERROR, message)
+
+#endif // LOGGER_H
@@ -0,0 +1,54 @@
+// Header file for hardware performance counters
+// Opt-in per-thread counters (Linux perf_event_open) read around the coarse timed phases
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+enum class HardwareEvent {
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_READ_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    NUM_EVENTS
+};
+
+constexpr int NUM_HARDWARE_EVENTS = static_cast<int>(HardwareEvent::NUM_EVENTS);
+
+// One read of a thread's counter group
+// The group only counts while the kernel has it on the PMU - timeRunning falls behind timeEnabled when it is multiplexed
+struct HardwareSample {
+    uint64_t values[NUM_HARDWARE_EVENTS];
+    uint64_t timeEnabled;    // nanoseconds
+    uint64_t timeRunning;
+};
+
+// Counters are opened lazily per thread (user space only, so perf_event_paranoid <= 2 is enough)
+// If the kernel refuses them the profiler reports itself unavailable and phases fall back to timers only
+// Events the CPU does not support (common for cache events in VMs) read as 0
+class PerfCounters {
+public:
+    // turn profiling on - returns false and stays off if counters cannot be opened on this machine
+    static bool enable();
+    static void disable();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    
+    // read the calling thread's counters - returns false if they are unavailable on this thread
+    static bool read(HardwareSample& sample);
+    
+    // events between two samples, scaled up by enabled / running time if the group was multiplexed in between
+    static void difference(const HardwareSample& start, const HardwareSample& end, uint64_t counts[NUM_HARDWARE_EVENTS]);
+    
+    static const char* eventName(HardwareEvent event);
+    
+private:
+    struct ThreadCounters;
+    static ThreadCounters& local();
+    
+    static std::atomic<bool> enabled;
+};
+
+#endif // PERF_COUNTERS_H
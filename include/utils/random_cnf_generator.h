@@ -1,2 +1,147 @@
 // Header file for random CNF generation
 // Function declarations for creating test CNF instances
+
+#ifndef RANDOM_CNF_GENERATOR_H
+#define RANDOM_CNF_GENERATOR_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cnf/cnf_structure.h"
+#include "solver/model_count.h"
+
+// Small fast generator (xoshiro256**, seeded through splitmix64)
+// The sequence depends only on (seed, stream), so an instance is identical on every platform and build
+class FastRandom {
+public:
+    explicit FastRandom(uint64_t seed, uint64_t stream = 0);
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // uniform in [0, bound) without modulo bias (Lemire's multiply-shift with rejection)
+    uint64_t below(uint64_t bound) {
+        __uint128_t product = static_cast<__uint128_t>(next()) * bound;
+        uint64_t low = static_cast<uint64_t>(product);
+        if (low < bound) {
+            uint64_t threshold = (0 - bound) % bound;
+            while (low < threshold) {
+                product = static_cast<__uint128_t>(next()) * bound;
+                low = static_cast<uint64_t>(product);
+            }
+        }
+        return static_cast<uint64_t>(product >> 64);
+    }
+
+    bool coin() { return next() >> 63; }
+
+    // uniform in [0, 1)
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state[4];
+};
+
+// Destination for generated clauses - lets the generators stream without building the formula first
+class ClauseSink {
+public:
+    virtual ~ClauseSink() = default;
+
+    // called once before the first clause with the final sizes
+    virtual void begin(int numVariables, uint64_t numClauses) = 0;
+    virtual void addClause(const Literal* literals, int size) = 0;
+};
+
+// Appends to a CNFFormula (variablesSeen is not filled in - it only matters to the parser's checks)
+class FormulaSink : public ClauseSink {
+public:
+    explicit FormulaSink(CNFFormula& f) : formula(f) {}
+
+    void begin(int numVariables, uint64_t numClauses) override;
+    void addClause(const Literal* literals, int size) override;
+
+private:
+    CNFFormula& formula;
+};
+
+// Writes DIMACS text through a large buffer with hand-rolled integer formatting
+class DimacsFileSink : public ClauseSink {
+public:
+    // throws runtime_error if the file cannot be opened
+    explicit DimacsFileSink(const std::string& path);
+    ~DimacsFileSink() override;
+
+    void begin(int numVariables, uint64_t numClauses) override;
+    void addClause(const Literal* literals, int size) override;
+
+    // flush and close - throws runtime_error if writing failed
+    void close();
+
+private:
+    void flush();
+    void writeInt(long long value);
+
+    std::ofstream file;
+    std::vector<char> buffer;
+    size_t used;
+};
+
+// Families of instances whose model count is known exactly
+enum class KnownCountFamily {
+    XOR_CHAINS,         // parity constraints over a chain of variables (Tseitin encoded) - 2^(m-1) models each
+    EXACTLY_ONE,        // exactly one of m variables (pairwise encoding) - m models each
+    RANDOM_COMPONENTS,  // small random 3-CNF components counted by enumeration when generated
+    MIXED               // components drawn from all three families in turn
+};
+
+// What was generated
+struct GeneratedInstance {
+    int numVariables;
+    uint64_t numClauses;
+    bool countKnown;
+    ModelCount count;             // exact model count if countKnown and it fits cellCount * 2^exponent
+    double log2Count;             // log2 of the model count if countKnown (always set, even when count saturates)
+    std::vector<int> planted;     // satisfying assignment for planted instances (0-indexed, 1 = true)
+
+    GeneratedInstance() : numVariables(0), numClauses(0), countKnown(false), log2Count(0.0) {}
+};
+
+class RandomCNFGenerator {
+public:
+    // uniform random k-SAT: round(ratio * numVariables) clauses of k distinct variables with random signs
+    static GeneratedInstance randomKSAT(ClauseSink& sink, int numVariables, int k, double ratio, uint64_t seed);
+
+    // random k-SAT restricted to clauses satisfied by a hidden assignment (guaranteed satisfiable)
+    static GeneratedInstance plantedKSAT(ClauseSink& sink, int numVariables, int k, double ratio, uint64_t seed);
+
+    // variable-disjoint components of the given family plus freeVariables unconstrained variables
+    // variables are shuffled so components are not contiguous ranges
+    static GeneratedInstance knownCount(ClauseSink& sink, KnownCountFamily family, int numComponents, int componentSize, int freeVariables, uint64_t seed);
+
+    // convenience wrappers building a formula in memory
+    static std::unique_ptr<CNFFormula> randomKSAT(int numVariables, int k, double ratio, uint64_t seed);
+    static std::unique_ptr<CNFFormula> plantedKSAT(int numVariables, int k, double ratio, uint64_t seed);
+    static std::unique_ptr<CNFFormula> knownCount(KnownCountFamily family, int numComponents, int componentSize, int freeVariables, uint64_t seed, GeneratedInstance& info);
+
+    // components of RANDOM_COMPONENTS are counted by enumeration, so they are limited to this many variables
+    static constexpr int MAX_RANDOM_COMPONENT_SIZE = 20;
+
+private:
+    // pick k distinct variables (1-indexed) with random signs into literals
+    static void randomClause(FastRandom& rng, int numVariables, int k, Literal* literals);
+};
+
+#endif // RANDOM_CNF_GENERATOR_H
@@ -0,0 +1,36 @@
+// Header file for reusing the storage of vectors of vectors
+// A vector of clauses or XOR rows frees the literals of every element it drops when it shrinks - these helpers park
+// dropped elements in a spare list instead and hand them out again when it grows, so after a warm-up a buffer
+// refilled over and over (one step of the XOR search after another) stops allocating
+
+#ifndef REUSABLE_STORAGE_H
+#define REUSABLE_STORAGE_H
+
+#include <utility>
+#include <vector>
+
+// items gets size elements - new ones come from spare when there are any (with whatever they held), dropped ones go to it
+template <typename T>
+void resizeReusing(std::vector<T>& items, size_t size, std::vector<T>& spare) {
+    while (items.size() > size) {
+        spare.push_back(std::move(items.back()));
+        items.pop_back();
+    }
+    while (items.size() < size) {
+        if (spare.empty()) {
+            items.emplace_back();
+        } else {
+            items.push_back(std::move(spare.back()));
+            spare.pop_back();
+        }
+    }
+}
+
+// one more element at the end of items, taken from spare when there is one - the caller clears what it needs to
+template <typename T>
+T& appendReusing(std::vector<T>& items, std::vector<T>& spare) {
+    resizeReusing(items, items.size() + 1, spare);
+    return items.back();
+}
+
+#endif // REUSABLE_STORAGE_H
@@ -0,0 +1,95 @@
+// Header file for the worker thread pool
+// Fixed set of threads running queued tasks - trials of one or many formulas share it
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // numThreads <= 0 uses every hardware thread
+    explicit ThreadPool(int numThreads);
+
+    // finishes the queued tasks, then joins the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    // tasks of one run share a group - a thread waiting in await only helps with its own group,
+    // so it never ends up running another run's work (a whole other count) on its stack
+    static constexpr uint64_t NO_GROUP = 0;
+    uint64_t newGroup() { return nextGroup.fetch_add(1, std::memory_order_relaxed); }
+
+    // queue a task - the future holds its result (or the exception it threw)
+    template <typename F>
+    auto submit(F&& task, uint64_t group = NO_GROUP) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); }, group);
+        return future;
+    }
+
+    // run one queued task of the group on the calling thread - returns false if none was queued
+    bool runPendingTask(uint64_t group);
+
+    // wait for a result, running queued tasks of the group meanwhile
+    // (so a task may wait for tasks it submitted without tying up its worker - no deadlock on a full pool)
+    // sleeps until the result is ready or a task of the group is queued, NO_GROUP only waits
+    template <typename T>
+    T await(std::future<T>& future, uint64_t group = NO_GROUP) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                progress.wait(lock, [&]() { return isReady(future) || (group != NO_GROUP && hasTask(group)); });
+            }
+            if (isReady(future)) {
+                return future.get();
+            }
+            runPendingTask(group);
+        }
+    }
+
+    static int hardwareThreads();
+
+private:
+    struct QueuedTask {
+        std::function<void()> run;
+        uint64_t group;
+    };
+
+    template <typename T>
+    static bool isReady(const std::future<T>& future) {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // callers hold queueMutex
+    bool hasTask(uint64_t group) const;
+
+    void enqueue(std::function<void()> task, uint64_t group);
+    void runTask(QueuedTask& task);
+    void workerLoop(int index);
+
+    std::vector<std::thread> workers;
+    std::deque<QueuedTask> tasks;
+    std::mutex queueMutex;
+    std::condition_variable available;    // workers - a task was queued or the pool is stopping
+    std::condition_variable progress;     // await - a task was queued or has finished
+    std::atomic<uint64_t> nextGroup;
+    bool stopping;
+};
+
+#endif // THREAD_POOL_H
@@ -1,2 +1,153 @@
 // Performance timing utilities
 // High-resolution timer for benchmarking and performance analysis
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "utils/perf_counters.h"
+
+// Instrumentation is on by default - build with -DAMC_DISABLE_STATS to compile every
+// AMC_TIME_PHASE / AMC_COUNT site down to nothing
+#ifndef AMC_DISABLE_STATS
+#define AMC_ENABLE_STATS 1
+#endif
+
+// Pipeline phases that get timed
+// Times are inclusive: SAT_SOLVING and EXACT_COUNTING run inside CELL_COUNTING
+// SAT_SOLVING is timed once per solver call - propagation alone is too hot to time, see Counter::PROPAGATIONS
+enum class Phase {
+    PARSE,
+    HASH_GENERATION,
+    GAUSSIAN_ELIMINATION,
+    SIMPLIFICATION,
+    CELL_COUNTING,
+    EXACT_COUNTING,
+    SAT_SOLVING,
+    NUM_PHASES
+};
+
+// Solver events that get counted
+enum class Counter {
+    SOLVER_CALLS,
+    PROPAGATIONS,
+    CONFLICTS,
+    DECISIONS,
+    RESTARTS,
+    MODELS_ENUMERATED,
+    TRUTH_TABLE_CELLS,
+    EXACT_CELLS,
+    BINARY_PROPAGATIONS,    // literals implied through the binary implication lists
+    FAILED_LITERALS,
+    REUSED_CELLS,           // cells of a nested family counted by filtering the models of a coarser cell
+    SHARED_CLAUSES_EXPORTED,    // learned clauses published to the run's clause pool
+    SHARED_CLAUSES_IMPORTED,    // pool clauses loaded into a SAT call
+    NUM_COUNTERS
+};
+
+constexpr int NUM_PHASES = static_cast<int>(Phase::NUM_PHASES);
+constexpr int NUM_COUNTERS = static_cast<int>(Counter::NUM_COUNTERS);
+
+// Phases long enough that reading the hardware counters at both ends does not show up in them
+// (one read is a system call) - one elimination per XOR system, one SAT call, one cell
+// Hashing, simplification and the exact counter are only timed
+constexpr bool readsHardwareCounters(Phase p) {
+    return p == Phase::PARSE || p == Phase::GAUSSIAN_ELIMINATION || p == Phase::CELL_COUNTING || p == Phase::SAT_SOLVING;
+}
+
+// Simple wall-clock timer
+class Timer {
+public:
+    Timer() : startTime(std::chrono::steady_clock::now()) {}
+    
+    void reset() { startTime = std::chrono::steady_clock::now(); }
+    
+    uint64_t elapsedNanos() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    double elapsedSeconds() const { return elapsedNanos() * 1e-9; }
+    
+private:
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// Accumulated phase times and counters
+struct PhaseStats {
+    uint64_t phaseNanos[NUM_PHASES];
+    uint64_t phaseCalls[NUM_PHASES];
+    uint64_t counters[NUM_COUNTERS];
+    uint64_t hardware[NUM_PHASES][NUM_HARDWARE_EVENTS];    // only filled while PerfCounters is enabled, for readsHardwareCounters phases
+    
+    PhaseStats() { clear(); }
+    
+    void clear();
+    void merge(const PhaseStats& other);
+    
+    // stats accumulated since an earlier snapshot of the same accumulator
+    PhaseStats since(const PhaseStats& earlier) const;
+    
+    uint64_t counter(Counter c) const { return counters[static_cast<int>(c)]; }
+    double seconds(Phase p) const { return phaseNanos[static_cast<int>(p)] * 1e-9; }
+    uint64_t hardwareCount(Phase p, HardwareEvent e) const { return hardware[static_cast<int>(p)][static_cast<int>(e)]; }
+    
+    // {"phases": {"parse": {"seconds": ..., "calls": ...}, ...}, "counters": {"conflicts": ..., ...}}
+    // phases with hardware counts also get the raw counts, "ipc" and misses per 1000 instructions
+    std::string toJSON() const;
+};
+
+class Stats {
+public:
+    // accumulator of the calling thread - every timer and counter on this thread adds to it
+    static PhaseStats& local();
+    
+    static const char* phaseName(Phase phase);
+    static const char* counterName(Counter counter);
+};
+
+// Adds the lifetime of the object to a phase of the calling thread's accumulator
+// While PerfCounters is enabled the hardware counters of a coarse phase are read at both ends as well
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(Phase p) : 
+        phase(p), 
+        profiling(readsHardwareCounters(p) && PerfCounters::isEnabled() && PerfCounters::read(start)) {}
+    
+    ~ScopedPhaseTimer() {
+        PhaseStats& stats = Stats::local();
+        int p = static_cast<int>(phase);
+        stats.phaseNanos[p] += timer.elapsedNanos();
+        stats.phaseCalls[p]++;
+        
+        HardwareSample end;
+        if (profiling && PerfCounters::read(end)) {
+            uint64_t counts[NUM_HARDWARE_EVENTS];
+            PerfCounters::difference(start, end, counts);
+            for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+                stats.hardware[p][e] += counts[e];
+            }
+        }
+    }
+    
+private:
+    Phase phase;
+    Timer timer;
+    bool profiling;
+    HardwareSample start;
+};
+
+#define AMC_STATS_CONCAT_INNER(a, b) a##b
+#define AMC_STATS_CONCAT(a, b) AMC_STATS_CONCAT_INNER(a, b)
+
+#ifdef AMC_ENABLE_STATS
+#define AMC_TIME_PHASE(phase) ScopedPhaseTimer AMC_STATS_CONCAT(amcPhaseTimer, __LINE__)(phase)
+#define AMC_COUNT(counter) (Stats::local().counters[static_cast<int>(counter)]++)
+#define AMC_COUNT_N(counter, n) (Stats::local().counters[static_cast<int>(counter)] += (n))
+#else
+#define AMC_TIME_PHASE(phase) ((void)0)
+#define AMC_COUNT(counter) ((void)0)
+#define AMC_COUNT_N(counter, n) ((void)0)
+#endif
+
+#endif // TIMER_H
@@ -0,0 +1,95 @@
+// Header file for trace-event recording
+// Optional Chrome / Perfetto trace of trials and solver phases with one track per thread
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "utils/timer.h"
+
+// Complete span ("X") or instant ("i") event
+// Names, categories and argument names must be string literals - only the pointers are stored
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    const char* argName;   // nullptr if the event has no argument
+    int64_t arg;
+    uint64_t startNanos;   // since the trace epoch
+    uint64_t durationNanos;
+    char type;
+};
+
+// Every thread appends to its own chunked buffer with no locking - a chunk's size is published with a
+// release store so the buffers can be read (and written out) at any time, even while threads still record
+// Buffers are registered once per thread and kept after the thread exits so its events are still flushed
+class TraceRecorder {
+public:
+    static void enable();
+    static void disable();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // label for the calling thread's track - set it once when the thread starts, before it records
+    static void setThreadName(const std::string& name);
+
+    // nanoseconds since the trace epoch (first use of the recorder)
+    static uint64_t now();
+
+    static void recordSpan(const char* name, const char* category, uint64_t startNanos, uint64_t durationNanos, const char* argName = nullptr, int64_t arg = 0);
+    static void recordInstant(const char* name, const char* category, const char* argName = nullptr, int64_t arg = 0);
+
+    // number of events recorded on all threads so far
+    static size_t eventCount();
+
+    // {"traceEvents": [...], "displayTimeUnit": "ms"} - loadable by chrome://tracing and ui.perfetto.dev
+    static std::string toJSON();
+    static bool writeJSON(const std::string& path);
+
+private:
+    struct Chunk;
+    struct ThreadBuffer;
+    static ThreadBuffer& local();
+
+    static std::atomic<bool> enabled;
+    static std::atomic<ThreadBuffer*> buffers;   // registry - lock-free push-only list
+};
+
+// Records its lifetime as a span on the calling thread's track (nothing if tracing is off when it is created)
+class ScopedTraceSpan {
+public:
+    ScopedTraceSpan(const char* n, const char* c, const char* a = nullptr, int64_t v = 0) :
+        name(n),
+        category(c),
+        argName(a),
+        arg(v),
+        active(TraceRecorder::isEnabled()),
+        start(active ? TraceRecorder::now() : 0) {}
+
+    ~ScopedTraceSpan() {
+        if (active) {
+            TraceRecorder::recordSpan(name, category, start, TraceRecorder::now() - start, argName, arg);
+        }
+    }
+
+private:
+    const char* name;
+    const char* category;
+    const char* argName;
+    int64_t arg;
+    bool active;
+    uint64_t start;
+};
+
+// Tracing sites compile away together with the other instrumentation under -DAMC_DISABLE_STATS
+#ifdef AMC_ENABLE_STATS
+#define AMC_TRACE_SPAN(name, category) ScopedTraceSpan AMC_STATS_CONCAT(amcTraceSpan, __LINE__)(name, category)
+#define AMC_TRACE_SPAN_ARG(name, category, argName, arg) ScopedTraceSpan AMC_STATS_CONCAT(amcTraceSpan, __LINE__)(name, category, argName, arg)
+#define AMC_TRACE_INSTANT(name, category) do { if (TraceRecorder::isEnabled()) TraceRecorder::recordInstant(name, category); } while (0)
+#else
+#define AMC_TRACE_SPAN(name, category) ((void)0)
+#define AMC_TRACE_SPAN_ARG(name, category, argName, arg) ((void)0)
+#define AMC_TRACE_INSTANT(name, category) ((void)0)
+#endif
+
+#endif // TRACE_H
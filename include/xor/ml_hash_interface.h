@@ -1,2 +1,59 @@
 // Header file for ML hash interface
-// Function declarations for communicating with the Python ML model
+// Runs the trained hash model in process: per-variable XOR inclusion probabilities for a formula,
+// predicted from weights exported by ml_model/ (see model_utils.export_model) - no Python at runtime
+//
+// Format - text, whitespace separated, '#' starts a comment line:
+//   amc-hash-model 1 features=<n>
+//   normalize <n means> <n scales>         (optional - each feature becomes (x - mean) / scale)
+//   layer <inputs> <outputs> <relu|sigmoid|identity>
+//   <outputs rows of: inputs weights, then the bias>
+//   ... more layers - the first takes the n features, each next one the outputs of the one before,
+//   the last has a single output: the variable's inclusion probability (clamped to [0, 1])
+// n has to be MLHashModel::NUM_FEATURES - a model trained on other features is refused
+
+#ifndef ML_HASH_INTERFACE_H
+#define ML_HASH_INTERFACE_H
+
+#include <string>
+#include <vector>
+#include "cnf/cnf_structure.h"
+
+class MLHashModel {
+public:
+    // features of variable v, in variableFeatures order:
+    //   log(1 + occurrences), fraction of occurrences that are positive, fraction in binary clauses,
+    //   mean 1 / clause length over its occurrences, log(1 + other literals of its clauses),
+    //   occurrences / most occurrences of any variable, log(1 + variables), log(1 + clauses / variables)
+    static constexpr int NUM_FEATURES = 8;
+
+    // load exported weights - throws runtime_error if the file cannot be read or is not a valid model
+    explicit MLHashModel(const std::string& path);
+
+    // features of every variable from one pass over the clauses - row v - 1 holds variable v (row-major)
+    static std::vector<double> variableFeatures(const CNFFormula& formula);
+
+    // the model over count rows of features at once - one probability per row
+    std::vector<double> predict(const std::vector<double>& features, int count) const;
+
+    // inclusion probability of each variable - entry v - 1 for variable v
+    std::vector<double> predictDensities(const CNFFormula& formula) const;
+
+    size_t numLayers() const { return layers.size(); }
+
+private:
+    enum class Activation { RELU, SIGMOID, IDENTITY };
+
+    struct Layer {
+        int inputs;
+        int outputs;
+        Activation activation;
+        std::vector<double> weights;    // outputs rows of inputs weights
+        std::vector<double> bias;
+    };
+
+    std::vector<double> mean;
+    std::vector<double> scale;
+    std::vector<Layer> layers;
+};
+
+#endif // ML_HASH_INTERFACE_H
@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <random>
+#include <cstdint>
 
 // An XOR constraint is: x1 XOR x2 XOR ... XOR xn = bool_value
 // We represent it as a set of integers (DIMACS 1-indexed) XORed together equal to a boolean value
@@ -19,20 +20,73 @@ struct XORConstraint {
     bool empty() const { return variables.empty(); }
 };
 
+// Per-variable inclusion probabilities, prepared once for drawing XORs in time proportional to their expected length
+// Variables are bucketed by probability - bucket k holds those with p in (2^-(k+1), 2^-k]. A draw walks each bucket
+// with geometric skips at rate 2^-k and keeps a variable it lands on with probability p / 2^-k (at least 1/2), so every
+// variable is in with exactly its own probability, for about twice the expected length in work plus one skip per bucket
+// Never changed after construction - one sampler serves every trial and thread of a run
+class VariableSampler {
+public:
+    // probabilities[v - 1] for variable v - clamped to [0, 1]
+    explicit VariableSampler(const std::vector<double>& probabilities);
+    
+    int numVariables() const { return variableCount; }
+    
+    // expected number of variables in an XOR
+    double expectedLength() const { return expected; }
+    
+    // the variables of one XOR, ascending
+    void sample(std::mt19937& generator, std::vector<int>& variables) const;
+    
+private:
+    // the last bucket takes every probability below its rate too
+    static constexpr int MAX_BUCKETS = 48;
+    
+    struct Bucket {
+        double rate;              // 2^-k
+        double logMiss;           // log(1 - rate), for the geometric skips
+        std::vector<int> variables;
+        std::vector<double> keep; // p / rate, by position in variables
+    };
+    
+    int variableCount;
+    double expected;
+    std::vector<Bucket> buckets;  // non-empty ones only
+};
+
 class XORHashGenerator {
 public:
     // Generate a single sparse XOR constraint
     // numVariables: total number of variables in the formula
     // density: probability that each variable appears in the XOR
-    //     NOTE: this is set as a default value for now - I will use ML to improve on this in the future by predicting individual variable inclusion probabilities
+    //     (per-variable probabilities, e.g. predicted by MLHashModel, go through a VariableSampler instead)
     static XORConstraint generateSparseXOR(int numVariables, double density = 0.1);
     
     // Generate multiple XOR constraints
     static std::vector<XORConstraint> generateXORFamily(int numVariables, int numXORs, double density = 0.1);
     
+    // Same, drawing from a caller-owned generator - trials running in parallel each own one
+    static XORConstraint generateSparseXOR(int numVariables, double density, std::mt19937& generator);
+    static std::vector<XORConstraint> generateXORFamily(int numVariables, int numXORs, double density, std::mt19937& generator);
+    
+    // Same XORs, written over existing ones - constraint and the entries of xors keep their storage,
+    // entries xors gains or drops come from or go to spare (see utils/reusable_storage.h)
+    static void generateSparseXOR(int numVariables, double density, std::mt19937& generator, XORConstraint& constraint);
+    static void generateXORFamily(int numVariables, int numXORs, double density, std::mt19937& generator,
+                                  std::vector<XORConstraint>& xors, std::vector<XORConstraint>& spare);
+    
+    // Same, each variable in with its own probability from the sampler instead of one density for all
+    static XORConstraint generateSparseXOR(const VariableSampler& sampler, std::mt19937& generator);
+    static void generateSparseXOR(const VariableSampler& sampler, std::mt19937& generator, XORConstraint& constraint);
+    static void generateXORFamily(const VariableSampler& sampler, int numXORs, std::mt19937& generator,
+                                  std::vector<XORConstraint>& xors, std::vector<XORConstraint>& spare);
+    
     // Set random seed for reproducibility
     static void setSeed(unsigned int seed);
     
+    // Next value of the shared generator - a seed for runs that were not given one
+    static uint64_t drawSeed();
+    
 private:
     static std::mt19937 rng;
 };
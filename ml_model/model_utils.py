@@ -1,2 +1,23 @@
 # Utility functions for ML model
 # Data preprocessing, feature engineering, and model helpers
+
+# features per variable the C++ side computes (MLHashModel::variableFeatures), in the same order
+NUM_FEATURES = 8
+
+
+def export_model(path, layers, mean=None, scale=None):
+    """Write a trained model in the text format MLHashModel loads (see include/xor/ml_hash_interface.h).
+
+    layers: (weights, bias, activation) per layer, first to last - weights is a list of rows, one per output,
+    activation one of "relu", "sigmoid", "identity"; the last layer has a single output.
+    mean, scale: per-feature normalization applied before the first layer, or None.
+    """
+    with open(path, "w") as out:
+        out.write("amc-hash-model 1 features=%d\n" % NUM_FEATURES)
+        if mean is not None:
+            out.write("normalize %s %s\n" % (" ".join(repr(float(m)) for m in mean),
+                                             " ".join(repr(float(s)) for s in scale)))
+        for weights, bias, activation in layers:
+            out.write("layer %d %d %s\n" % (len(weights[0]), len(weights), activation))
+            for row, b in zip(weights, bias):
+                out.write(" ".join(repr(float(w)) for w in row) + " " + repr(float(b)) + "\n")
@@ -0,0 +1,245 @@
+// Source file for batch clause evaluation on the CPU
+
+#include "cnf/clause_evaluation.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLAUSE_EVALUATION_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+//
+// AssignmentBatch IMPLEMENTATION
+//
+
+void AssignmentBatch::setAssignment(int index, const vector<int>& assignment) {
+    for (int var = 1; var <= numVariables; var++) {
+        bool value = var <= static_cast<int>(assignment.size()) && assignment[var - 1] == 1;
+        setValue(index, var, value);
+    }
+}
+
+void AssignmentBatch::setValue(int index, int var, bool value) {
+    uint64_t& word = variableWords(var)[index / 64];
+    uint64_t bit = 1ULL << (index % 64);
+    word = value ? (word | bit) : (word & ~bit);
+}
+
+bool AssignmentBatch::getValue(int index, int var) const {
+    return (variableWords(var)[index / 64] >> (index % 64)) & 1;
+}
+
+
+//
+// ClauseEvaluator IMPLEMENTATION
+//
+
+FlatClauses ClauseEvaluator::flatten(const CNFFormula& formula) {
+    FlatClauses flat;
+    flat.clauseStarts.reserve(formula.clauses.size() + 1);
+    for (const auto& clause : formula.clauses) {
+        if (clause.empty()) {
+            flat.hasEmptyClause = true;
+        }
+        flat.clauseStarts.push_back(flat.literalCodes.size());
+        for (Literal lit : clause.literals) {
+            flat.literalCodes.push_back(2 * (abs(lit) - 1) + (lit < 0 ? 1 : 0));
+            flat.maxVariable = max(flat.maxVariable, abs(lit));
+        }
+    }
+    flat.clauseStarts.push_back(flat.literalCodes.size());
+    return flat;
+}
+
+FlatClauses ClauseEvaluator::restrict(const FlatClauses& clauses, int numVariables) {
+    FlatClauses restricted;
+    restricted.hasEmptyClause = clauses.hasEmptyClause;
+    restricted.clauseStarts.reserve(clauses.clauseStarts.size());
+    for (size_t c = 0; c < clauses.numClauses(); c++) {
+        size_t start = restricted.literalCodes.size();
+        restricted.clauseStarts.push_back(start);
+        for (uint32_t i = clauses.clauseStarts[c]; i < clauses.clauseStarts[c + 1]; i++) {
+            uint32_t code = clauses.literalCodes[i];
+            if (static_cast<int>(code >> 1) < numVariables) {
+                restricted.literalCodes.push_back(code);
+            }
+        }
+        // a clause with only missing variables cannot be satisfied
+        if (restricted.literalCodes.size() == start) {
+            restricted.hasEmptyClause = true;
+        }
+    }
+    restricted.clauseStarts.push_back(restricted.literalCodes.size());
+    restricted.maxVariable = min(clauses.maxVariable, numVariables);
+    return restricted;
+}
+
+EvaluationKernel ClauseEvaluator::detectKernel() {
+#ifdef CLAUSE_EVALUATION_X86
+    static const EvaluationKernel kernel = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return EvaluationKernel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return EvaluationKernel::AVX2;
+        }
+        return EvaluationKernel::SCALAR;
+    }();
+    return kernel;
+#else
+    return EvaluationKernel::SCALAR;
+#endif
+}
+
+const char* ClauseEvaluator::kernelName(EvaluationKernel kernel) {
+    switch (kernel) {
+        case EvaluationKernel::AVX512: return "avx512";
+        case EvaluationKernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+vector<uint64_t> ClauseEvaluator::evaluate(const FlatClauses& clauses, const AssignmentBatch& batch) {
+    return evaluate(clauses, batch, detectKernel());
+}
+
+vector<uint64_t> ClauseEvaluator::evaluate(const FlatClauses& clauses, const AssignmentBatch& batch, EvaluationKernel kernel) {
+    if (clauses.maxVariable > batch.numVariables) {
+        return evaluate(restrict(clauses, batch.numVariables), batch, kernel);
+    }
+
+    vector<uint64_t> satisfied(batch.numWords, 0);
+    if (clauses.hasEmptyClause || batch.numWords == 0) {
+        return satisfied;
+    }
+    evaluateWords(clauses, batch.bits.data(), batch.numWords, batch.numWords, satisfied.data(), kernel);
+
+    // clear the bits past the last assignment
+    int tail = batch.numAssignments % 64;
+    if (tail != 0) {
+        satisfied.back() &= (1ULL << tail) - 1;
+    }
+    return satisfied;
+}
+
+void ClauseEvaluator::filterParity(const vector<int>& variables, bool value, const AssignmentBatch& batch, uint64_t* satisfied) {
+    for (int w = 0; w < batch.numWords; w++) {
+        uint64_t parity = 0;
+        for (int var : variables) {
+            if (var > batch.numVariables) {
+                continue;
+            }
+            parity ^= batch.variableWords(var)[w];
+        }
+        satisfied[w] &= value ? parity : ~parity;
+    }
+}
+
+void ClauseEvaluator::evaluateWords(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t numWords, uint64_t* satisfied, EvaluationKernel kernel) {
+    // a kernel may be asked for even if this CPU cannot run it - fall back to what is available
+    if (kernel > detectKernel()) {
+        kernel = detectKernel();
+    }
+
+    size_t processed = 0;
+    if (kernel == EvaluationKernel::AVX512) {
+        processed = evaluateAVX512(clauses, variableWords, stride, numWords, satisfied);
+    } else if (kernel == EvaluationKernel::AVX2) {
+        processed = evaluateAVX2(clauses, variableWords, stride, numWords, satisfied);
+    }
+
+    // remaining words (or everything for the scalar kernel)
+    evaluateScalar(clauses, variableWords, stride, processed, numWords, satisfied);
+}
+
+void ClauseEvaluator::evaluateScalar(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t begin, size_t end, uint64_t* satisfied) {
+    const uint32_t* codes = clauses.literalCodes.data();
+    const uint32_t* starts = clauses.clauseStarts.data();
+    size_t numClauses = clauses.numClauses();
+
+    for (size_t w = begin; w < end; w++) {
+        uint64_t sat = ~0ULL;
+        for (size_t c = 0; c < numClauses && sat != 0; c++) {
+            uint64_t clauseWord = 0;
+            for (uint32_t i = starts[c]; i < starts[c + 1]; i++) {
+                uint32_t code = codes[i];
+                uint64_t negMask = 0ULL - (code & 1);
+                clauseWord |= variableWords[(code >> 1) * stride + w] ^ negMask;
+            }
+            sat &= clauseWord;
+        }
+        satisfied[w] = sat;
+    }
+}
+
+#ifdef CLAUSE_EVALUATION_X86
+
+__attribute__((target("avx2")))
+size_t ClauseEvaluator::evaluateAVX2(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t numWords, uint64_t* satisfied) {
+    const uint32_t* codes = clauses.literalCodes.data();
+    const uint32_t* starts = clauses.clauseStarts.data();
+    size_t numClauses = clauses.numClauses();
+    size_t processed = numWords - numWords % 4;
+
+    for (size_t w = 0; w < processed; w += 4) {
+        __m256i sat = _mm256_set1_epi64x(-1);
+        for (size_t c = 0; c < numClauses; c++) {
+            __m256i clauseWord = _mm256_setzero_si256();
+            for (uint32_t i = starts[c]; i < starts[c + 1]; i++) {
+                uint32_t code = codes[i];
+                __m256i negMask = _mm256_set1_epi64x(-static_cast<int64_t>(code & 1));
+                __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(variableWords + (code >> 1) * stride + w));
+                clauseWord = _mm256_or_si256(clauseWord, _mm256_xor_si256(words, negMask));
+            }
+            sat = _mm256_and_si256(sat, clauseWord);
+            if (_mm256_testz_si256(sat, sat)) {
+                break;
+            }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(satisfied + w), sat);
+    }
+    return processed;
+}
+
+__attribute__((target("avx512f")))
+size_t ClauseEvaluator::evaluateAVX512(const FlatClauses& clauses, const uint64_t* variableWords, size_t stride, size_t numWords, uint64_t* satisfied) {
+    const uint32_t* codes = clauses.literalCodes.data();
+    const uint32_t* starts = clauses.clauseStarts.data();
+    size_t numClauses = clauses.numClauses();
+    size_t processed = numWords - numWords % 8;
+
+    for (size_t w = 0; w < processed; w += 8) {
+        __m512i sat = _mm512_set1_epi64(-1);
+        for (size_t c = 0; c < numClauses; c++) {
+            __m512i clauseWord = _mm512_setzero_si512();
+            for (uint32_t i = starts[c]; i < starts[c + 1]; i++) {
+                uint32_t code = codes[i];
+                __m512i negMask = _mm512_set1_epi64(-static_cast<int64_t>(code & 1));
+                __m512i words = _mm512_loadu_si512(variableWords + (code >> 1) * stride + w);
+                clauseWord = _mm512_or_si512(clauseWord, _mm512_xor_si512(words, negMask));
+            }
+            sat = _mm512_and_si512(sat, clauseWord);
+            if (_mm512_test_epi64_mask(sat, sat) == 0) {
+                break;
+            }
+        }
+        _mm512_storeu_si512(satisfied + w, sat);
+    }
+    return processed;
+}
+
+#else
+
+size_t ClauseEvaluator::evaluateAVX2(const FlatClauses&, const uint64_t*, size_t, size_t, uint64_t*) {
+    return 0;
+}
+
+size_t ClauseEvaluator::evaluateAVX512(const FlatClauses&, const uint64_t*, size_t, size_t, uint64_t*) {
+    return 0;
+}
+
+#endif
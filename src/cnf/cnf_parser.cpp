@@ -1,6 +1,7 @@
 // Source file for CNFParser class implementation
 
 #include "cnf/cnf_parser.h"
+#include "utils/timer.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -37,6 +38,7 @@ unique_ptr<CNFFormula> CNFParser::parseFile(const std::string& filename) {
 }
 
 unique_ptr<CNFFormula> CNFParser::parseString(const std::string& content) {
+    AMC_TIME_PHASE(Phase::PARSE);
     auto formula = make_unique<CNFFormula>();
     istringstream stream(content);
     string line;
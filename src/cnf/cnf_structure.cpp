@@ -1,6 +1,7 @@
 // Source file for CNF formula and clause structure implementation
 
 #include "cnf/cnf_structure.h"
+#include "cnf/clause_evaluation.h"
 #include <algorithm>
 #include <cmath>
 
@@ -73,6 +74,10 @@ bool CNFFormula::isSatisfied(const std::vector<int>& assignment) const {
     return true;
 }
 
+vector<uint64_t> CNFFormula::isSatisfiedBatch(const AssignmentBatch& batch) const {
+    return ClauseEvaluator::evaluate(ClauseEvaluator::flatten(*this), batch);
+}
+
 // STL containers have clear() method that deallocates memory, so we can just call that and reset counts
 void CNFFormula::clear() {
     clauses.clear();
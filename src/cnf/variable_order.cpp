@@ -0,0 +1,141 @@
+// Source file for variable renumbering
+
+#include "cnf/variable_order.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+VariableOrder VariableOrder::identity(int numVariables) {
+    VariableOrder order;
+    order.newIds.resize(numVariables + 1);
+    order.oldIds.resize(numVariables + 1);
+    for (int var = 0; var <= numVariables; var++) {
+        order.newIds[var] = var;
+        order.oldIds[var] = var;
+    }
+    return order;
+}
+
+VariableOrder VariableOrder::cuthillMcKee(const CNFFormula& formula) {
+    int n = formula.numVariables;
+    VariableOrder order = identity(n);
+
+    // clauses each variable occurs in, as a CSR (offsets into one flat array)
+    vector<int> degree(n + 1, 0);
+    for (const auto& clause : formula.clauses) {
+        for (Literal lit : clause.literals) {
+            degree[abs(lit)]++;
+        }
+    }
+    vector<int> offsets(n + 2, 0);
+    for (int var = 1; var <= n; var++) {
+        offsets[var + 1] = offsets[var] + degree[var];
+    }
+    vector<int> occurrences(offsets[n + 1]);
+    vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t c = 0; c < formula.clauses.size(); c++) {
+        for (Literal lit : formula.clauses[c].literals) {
+            occurrences[fill[abs(lit)]++] = static_cast<int>(c);
+        }
+    }
+
+    // component entry points - lowest degree first, ties by id so the order is deterministic
+    vector<int> byDegree;
+    for (int var = 1; var <= n; var++) {
+        if (degree[var] > 0) {
+            byDegree.push_back(var);
+        }
+    }
+    auto lowerDegree = [&degree](int a, int b) {
+        return (degree[a] != degree[b]) ? degree[a] < degree[b] : a < b;
+    };
+    stable_sort(byDegree.begin(), byDegree.end(), lowerDegree);
+
+    vector<char> numbered(n + 1, 0);
+    vector<char> clauseDone(formula.clauses.size(), 0);
+    vector<int> queue;    // variables in their new order - doubles as the BFS queue
+    queue.reserve(n);
+    vector<int> neighbours;
+    for (int start : byDegree) {
+        if (numbered[start]) {
+            continue;
+        }
+        numbered[start] = 1;
+        queue.push_back(start);
+        for (size_t next = queue.size() - 1; next < queue.size(); next++) {
+            int var = queue[next];
+            neighbours.clear();
+            // each clause is expanded once, from its first numbered variable - keeps the pass linear in the formula size
+            for (int i = offsets[var]; i < offsets[var + 1]; i++) {
+                int c = occurrences[i];
+                if (clauseDone[c]) {
+                    continue;
+                }
+                clauseDone[c] = 1;
+                for (Literal lit : formula.clauses[c].literals) {
+                    int other = abs(lit);
+                    if (!numbered[other]) {
+                        numbered[other] = 1;
+                        neighbours.push_back(other);
+                    }
+                }
+            }
+            sort(neighbours.begin(), neighbours.end(), lowerDegree);
+            queue.insert(queue.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+    for (int var = 1; var <= n; var++) {
+        if (!numbered[var]) {
+            queue.push_back(var);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        order.oldIds[i + 1] = queue[i];
+        order.newIds[queue[i]] = i + 1;
+    }
+    return order;
+}
+
+CNFFormula VariableOrder::apply(const CNFFormula& formula) const {
+    CNFFormula result(formula.numVariables, formula.numClauses);
+    result.clauses.reserve(formula.clauses.size());
+    for (const auto& clause : formula.clauses) {
+        Clause renamed;
+        renamed.literals.reserve(clause.size());
+        for (Literal lit : clause.literals) {
+            renamed.addLiteral(renumberLiteral(lit));
+        }
+        result.addClause(renamed);
+    }
+    for (int var : formula.variablesSeen) {
+        result.variablesSeen.insert(newIds[var]);
+    }
+    return result;
+}
+
+vector<int> VariableOrder::originalAssignment(const vector<int>& assignment) const {
+    vector<int> result(assignment.size());
+    for (size_t i = 0; i < assignment.size(); i++) {
+        result[oldIds[i + 1] - 1] = assignment[i];
+    }
+    return result;
+}
+
+long VariableOrder::clauseSpan(const CNFFormula& formula) {
+    long total = 0;
+    for (const auto& clause : formula.clauses) {
+        if (clause.empty()) {
+            continue;
+        }
+        int lowest = abs(clause.literals[0]);
+        int highest = lowest;
+        for (Literal lit : clause.literals) {
+            lowest = min(lowest, abs(lit));
+            highest = max(highest, abs(lit));
+        }
+        total += highest - lowest;
+    }
+    return total;
+}
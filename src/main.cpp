@@ -1,96 +1,217 @@
 // Main entry point for the program
+//
+// count one file:        amc [options] formula.cnf
+// count many files:      amc [options] dir/ a.cnf b.cnf ...   or   amc [options] --list paths.txt
+// count server:          amc [options] --serve /tmp/amc.sock
+// sharded run:           amc [options] --coordinate /shared/job formula.cnf   plus   amc --work /shared/job   per worker
+// interactive:           amc            (the CNF path is read from stdin)
+// see --help for the options
 
+#include <csignal>
 #include <iostream>
 #include <string>
 #include <memory>
 
 #include "cnf/cnf_parser.h"
 #include "cnf/cnf_structure.h"
-#include "xor/xor_hash_generator.h"
-#include "solver/partial_assignment.h"
-#include "solver/cnf_simplifier.h"
+#include "server/count_server.h"
 #include "solver/approximate_counter.h"
+#include "solver/batch_counter.h"
+#include "solver/sharded_counter.h"
+#include "utils/cancellation.h"
+#include "utils/command_line.h"
+#include "utils/logger.h"
+#include "utils/timer.h"
+#include "utils/perf_counters.h"
+#include "utils/thread_pool.h"
+#include "utils/trace.h"
 
 using namespace std;
 
+// Detailed report of a single formula
+int countOne(const string& filename, const CommandLineOptions& options) {
+    // Phase 1: Parse CNF file
+    cout << "=== Phase 1: Parsing CNF ===" << endl;
+    auto formula = CNFParser::parseFile(filename);
+    cout << "Successfully parsed CNF file!" << endl;
+    cout << "  Variables: " << formula->getNumVariables() << endl;
+    cout << "  Clauses: " << formula->getNumClauses() << endl << endl;
+    
+    // Phase 2: Approximate Model Counting with Multiple Trials
+    cout << "=== Phase 2: Approximate Model Counting ===" << endl;
+    const CountingOptions& countingOptions = options.counting;
+    auto countResult = options.coordinateDir.empty()
+        ? ApproximateCounter::approximateCount(*formula, countingOptions)
+        : ShardedCounter::coordinate(*formula, filename, options.coordinateDir, countingOptions);
+    if (!options.statsPath.empty() && !Logger::writeJSON(options.statsPath, ApproximateCounter::statsToJSON(countResult))) {
+        LOG_WARNING("could not write stats to " << options.statsPath);
+    }
+
+    // counts past 2^64 are only available in the log domain
+    string estimate = (countResult.estimatedCount != UINT64_MAX) ? to_string(countResult.estimatedCount) : ModelCount::formatLog2(countResult.log2Estimate);
+    
+    cout << "Approximate Count Results:" << endl;
+    if (countResult.exact) {
+        cout << "  Exact Solutions: " << estimate << endl;
+        return 0;
+    }
+    cout << "  Estimated Solutions: " << estimate << endl;
+    cout << "  Average Solutions (successful trials): " << countResult.averageCount << endl;
+    cout << "  Successful Trials: " << countResult.successfulTrials << "/" << countResult.totalTrials;
+    if (countResult.earlyStopped) {
+        cout << " (stopped early - within tolerance " << countingOptions.epsilon << ")";
+    }
+    if (countResult.timedOut) {
+        cout << " (time limit of " << countingOptions.timeoutSeconds << " s reached)";
+    }
+    if (countResult.abortedTrials > 0) {
+        cout << " (" << countResult.abortedTrials << " trials aborted by their budget)";
+    }
+    cout << endl;
+    if (countResult.interval.valid) {
+        cout << "  " << 100.0 * countResult.interval.confidence << "% Confidence Interval: ["
+             << ModelCount::formatLog2(countResult.interval.log2Lower) << ", "
+             << ModelCount::formatLog2(countResult.interval.log2Upper) << "]" << endl;
+    }
+    cout << "  Trial Counts: ";
+    for (size_t i = 0; i < countResult.trialCounts.size(); i++) {
+        cout << countResult.trialCounts[i].toString();
+        if (i < countResult.trialCounts.size() - 1) {
+            cout << ", ";
+        }
+    }
+    cout << endl;
+    return 0;
+}
+
+// One line per formula, streamed as the formulas finish - all trials share one pool
+int countBatch(const vector<string>& files, const CommandLineOptions& options) {
+    if (!options.statsPath.empty()) {
+        LOG_WARNING("--stats-json is only written for a single input in text format");
+    }
+    CountingOptions counting = options.counting;
+    if (!counting.checkpointPath.empty()) {
+        LOG_WARNING("--checkpoint is only used for a single input in text format");
+        counting.checkpointPath.clear();
+    }
+    ThreadPool pool(counting.numThreads);
+    LOG_INFO("counting " << files.size() << " files on " << pool.size() << " threads");
+    
+    if (options.format == OutputFormat::CSV) {
+        cout << BatchCounter::csvHeader() << endl;
+    }
+    int failures = BatchCounter::run(files, counting, pool, [&](const BatchResult& result) {
+        switch (options.format) {
+            case OutputFormat::JSON: cout << BatchCounter::toJSON(result) << endl; break;
+            case OutputFormat::CSV: cout << BatchCounter::toCSV(result) << endl; break;
+            default: cout << BatchCounter::toText(result) << endl; break;
+        }
+    });
+    return (failures == 0) ? 0 : 1;
+}
+
+// stopped by SIGINT / SIGTERM
+CountServer* runningServer = nullptr;
+CancellationToken workerStop;
+
+void stopServer(int) {
+    if (runningServer != nullptr) {
+        runningServer->stop();
+    }
+}
+
+void stopWorker(int) {
+    workerStop.cancel();
+}
+
+// the trial being run when stopped goes back in the queue
+int work(const CommandLineOptions& options) {
+    signal(SIGINT, stopWorker);
+    signal(SIGTERM, stopWorker);
+    ShardedCounter::work(options.workDir, &workerStop);
+    return 0;
+}
+
+int serve(const CommandLineOptions& options) {
+    ServerOptions serverOptions;
+    serverOptions.socketPath = options.serveSocket;
+    serverOptions.numThreads = options.counting.numThreads;
+    serverOptions.cacheEntries = options.cacheEntries;
+    serverOptions.defaults = options.counting;
+    
+    CountServer server(serverOptions);
+    server.start();
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    server.run();
+    runningServer = nullptr;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    cout << "GPU-Accelerated Approximate #SAT Solver" << endl << endl;
+    CommandLineOptions options;
+    try {
+        options = CommandLine::parse(argc, argv);
+    } catch (const std::exception& e) {
+        cerr << e.what() << endl << endl << CommandLine::usage(argv[0]);
+        return 2;
+    }
+    if (options.help) {
+        cout << CommandLine::usage(argv[0]);
+        return 0;
+    }
+    if (options.verbose) {
+        Logger::setLevel(LogLevel::INFO);
+    }
+    if (!options.tracePath.empty()) {
+        TraceRecorder::enable();
+        TraceRecorder::setThreadName("main");
+    }
+    if (options.perf && !PerfCounters::enable()) {
+        LOG_WARNING("hardware counters are unavailable (perf_event_open failed) - reporting timers only");
+    }
 
-    string filename;
-    cout << "Please enter the CNF file path: ";
-    cin >> filename;
+    if (options.interactive()) {
+        cout << "GPU-Accelerated Approximate #SAT Solver" << endl << endl;
+        string filename;
+        cout << "Please enter the CNF file path: ";
+        cin >> filename;
+        options.inputs.push_back(filename);
+    }
     
+    int status = 0;
     try {
-        // Phase 1: Parse CNF file
-        cout << "=== Phase 1: Parsing CNF ===" << endl;
-        auto formula = CNFParser::parseFile(filename);
-        cout << "Successfully parsed CNF file!" << endl;
-        cout << "  Variables: " << formula->getNumVariables() << endl;
-        cout << "  Clauses: " << formula->getNumClauses() << endl << endl;
-        
-        // Phase 2: Generate XOR constraints and solve
-        cout << "=== Phase 2: XOR Hash Generation ===" << endl;
-        int numXORs = 3;
-        double density = 0.1;
-        int numVariables = formula->getNumVariables();
-        
-        auto xors = XORHashGenerator::generateXORFamily(numVariables, numXORs, density);
-        cout << "Generated " << xors.size() << " XOR constraints with density " << density << endl;
-        
-        cout << "Solving XOR system using Gaussian elimination..." << endl;
-        auto solution = PartialAssignment::solveXORSystem(xors, numVariables);
-        
-        if (solution.satisfiable) {
-            cout << "  XOR system is satisfiable" << endl;
-            cout << "  Assigned: " << solution.assignment.size() << " variables" << endl;
-            cout << "  Free: " << solution.freeVariables.size() << " variables" << endl << endl;
-        } else {
-            cout << "  XOR system is unsatisfiable - no solutions exist" << endl;
-            return 0;
+        if (!options.hashModelPath.empty()) {
+            options.counting.hashModel = make_shared<MLHashModel>(options.hashModelPath);
         }
-        
-        // Phase 3: Apply XOR solution to simplify CNF
-        cout << "=== Phase 3: CNF Simplification ===" << endl;
-        cout << "Applying partial assignment to CNF..." << endl;
-        auto simplificationResult = CNFSimplifier::applyXORSolution(*formula, solution);
-        cout << endl;
-        
-        if (simplificationResult.isUnsatisfiable) {
-            cout << "  Formula is UNSATISFIABLE with this XOR configuration" << endl;
-        } else if (simplificationResult.isTriviallyTrue) {
-            cout << "  Formula is SATISFIABLE (trivially true after simplification)" << endl;
-        } else {
-            cout << "  Simplified CNF:" << endl;
-            cout << "    Original: " << formula->getNumClauses() << " clauses" << endl;
-            cout << "    Simplified: " << simplificationResult.simplified.getNumClauses() << " clauses" << endl;
-            double reductionPercent = 100.0 * simplificationResult.clausesRemoved / formula->getNumClauses();
-            cout << "    Reduction: " << reductionPercent << "%" << endl;
+        if (!options.serveSocket.empty()) {
+            return serve(options);
         }
-        
-        // Phase 4: Approximate Model Counting with Multiple Trials
-        cout << "=== Phase 4: Approximate Model Counting ===" << endl;
-        
-        int numTrials = 10;
-        int trialsXORs = 3;
-        double trialsDensity = 0.1;
-        
-        auto countResult = ApproximateCounter::approximateCount(*formula, numTrials, trialsXORs, trialsDensity);
-
-        cout << "Approximate Count Results:" << endl;
-        cout << "  Estimated Solutions: " << countResult.estimatedCount << endl;
-        cout << "  Average Solutions (successful trials): " << countResult.averageCount << endl;
-        cout << "  Successful Trials: " << countResult.successfulTrials << "/" << countResult.totalTrials << endl;
-        cout << "  Trial Counts: ";
-        for (size_t i = 0; i < countResult.trialCounts.size(); i++) {
-            cout << countResult.trialCounts[i];
-            if (i < countResult.trialCounts.size() - 1) {
-                cout << ", ";
-            }
+        if (!options.workDir.empty()) {
+            return work(options);
+        }
+        vector<string> files = CommandLine::collectInputs(options);
+        if (files.empty()) {
+            cerr << "No CNF files to count" << endl;
+            return 2;
+        }
+        if (!options.coordinateDir.empty() && files.size() != 1) {
+            cerr << "--coordinate counts exactly one formula" << endl;
+            return 2;
+        }
+        if (files.size() == 1 && (options.format == OutputFormat::TEXT || !options.coordinateDir.empty())) {
+            status = countOne(files[0], options);
+        } else {
+            status = countBatch(files, options);
         }
-        
-        return 0;
     } catch (const std::exception& e) {
         cerr << "Something went wrong: " << e.what() << endl;
-        return -1;
+        status = -1;
+    }
+
+    if (!options.tracePath.empty() && !TraceRecorder::writeJSON(options.tracePath)) {
+        LOG_WARNING("could not write trace to " << options.tracePath);
     }
+    return status;
 }
@@ -0,0 +1,389 @@
+// Source file for the count server
+
+#include "server/count_server.h"
+#include "solver/batch_counter.h"
+#include "utils/logger.h"
+#include "utils/timer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// One client - the reader thread owns the reads, answers are written by the workers
+struct CountServer::Connection {
+    int fd;
+    string buffer;               // bytes read but not consumed yet
+    mutex writeMutex;
+    mutex pendingMutex;
+    condition_variable pendingDone;
+    int pending;                 // answers still owed
+    atomic<bool> closed;
+
+    explicit Connection(int f) : fd(f), pending(0), closed(false) {}
+
+    // next line without the newline - false at end of stream
+    bool readLine(string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n');
+            if (newline != string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return true;
+            }
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+
+    bool readBytes(size_t count, string& bytes) {
+        while (buffer.size() < count) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        bytes = buffer.substr(0, count);
+        buffer.erase(0, count);
+        return true;
+    }
+
+    bool fill() {
+        char chunk[65536];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, received);
+        return true;
+    }
+
+    // one answer line - a client that went away is not an error
+    void writeLine(const string& line) {
+        lock_guard<mutex> lock(writeMutex);
+        string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t written = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) {
+                return;
+            }
+            sent += written;
+        }
+    }
+};
+
+namespace {
+
+void writeEscaped(ostringstream& out, const string& text) {
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            out << '\\' << ch;
+        } else if (ch == '\n') {
+            out << "\\n";
+        } else {
+            out << ch;
+        }
+    }
+}
+
+string errorLine(const string& id, const string& message) {
+    ostringstream out;
+    out << "{\"id\": \"";
+    writeEscaped(out, id);
+    out << "\", \"error\": \"";
+    writeEscaped(out, message);
+    out << "\"}";
+    return out.str();
+}
+
+// "COUNT id=1 trials=5 ..." -> {COUNT: "", id: "1", trials: "5", ...}
+unordered_map<string, string> parseFields(const string& header) {
+    unordered_map<string, string> fields;
+    istringstream in(header);
+    string token;
+    while (in >> token) {
+        size_t equals = token.find('=');
+        if (equals == string::npos) {
+            fields[token] = "";
+        } else {
+            fields[token.substr(0, equals)] = token.substr(equals + 1);
+        }
+    }
+    return fields;
+}
+
+template <typename T>
+T parseValue(const string& key, const string& value) {
+    istringstream in(value);
+    T result;
+    if (!(in >> result) || !in.eof()) {
+        throw runtime_error("invalid value for " + key + ": " + value);
+    }
+    return result;
+}
+
+void applyParameters(const unordered_map<string, string>& fields, CountingOptions& options) {
+    for (const auto& field : fields) {
+        const string& key = field.first;
+        const string& value = field.second;
+        if (key == "COUNT" || key == "id" || key == "path" || key == "bytes") {
+            continue;
+        } else if (key == "trials") {
+            options.maxTrials = parseValue<int>(key, value);
+        } else if (key == "density") {
+            options.density = parseValue<double>(key, value);
+        } else if (key == "threshold") {
+            options.threshold = parseValue<int>(key, value);
+        } else if (key == "epsilon") {
+            options.epsilon = parseValue<double>(key, value);
+            if (!(options.epsilon > 0)) {
+                throw runtime_error("epsilon must be positive");
+            }
+        } else if (key == "delta") {
+            options.delta = parseValue<double>(key, value);
+            if (!(options.delta > 0 && options.delta < 1)) {
+                throw runtime_error("delta must be in (0, 1)");
+            }
+        } else if (key == "seed") {
+            options.seed = parseValue<uint64_t>(key, value);
+        } else if (key == "timeout") {
+            options.timeoutSeconds = parseValue<double>(key, value);
+        } else if (key == "trial_timeout") {
+            options.trialTimeoutSeconds = parseValue<double>(key, value);
+        } else if (key == "max_conflicts") {
+            options.maxConflictsPerSolve = parseValue<uint64_t>(key, value);
+        } else if (key == "exact") {
+            options.exactFallback = parseValue<int>(key, value) != 0;
+        } else if (key == "nested") {
+            options.hashFamily = (parseValue<int>(key, value) != 0) ? HashFamily::NESTED : HashFamily::INDEPENDENT;
+        } else {
+            throw runtime_error("unknown parameter " + key);
+        }
+    }
+}
+
+}
+
+CountServer::CountServer(const ServerOptions& o) :
+    options(o),
+    cache(o.cacheEntries, o.cacheLiterals, o.defaults),
+    stopping(false),
+    listenFd(-1),
+    activeRequests(0),
+    requestsServed(0),
+    pool(o.numThreads),
+    requests(pool.size()) {}
+
+CountServer::~CountServer() {
+    stop();
+    shutdownToken.cancel();
+    reapConnections(true);
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+    }
+}
+
+void CountServer::start() {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.empty() || options.socketPath.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Invalid socket path: " + options.socketPath);
+    }
+    strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw runtime_error("Cannot create socket");
+    }
+    // a socket file left behind by an earlier server
+    unlink(options.socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, 64) != 0) {
+        close(listenFd);
+        listenFd = -1;
+        throw runtime_error("Cannot listen on " + options.socketPath);
+    }
+    LOG_INFO("listening on " << options.socketPath << " with " << pool.size() << " workers");
+}
+
+void CountServer::run() {
+    if (listenFd < 0) {
+        start();
+    }
+    while (!stopping.load()) {
+        // wake up regularly to notice stop()
+        pollfd waiting = {listenFd, POLLIN, 0};
+        if (poll(&waiting, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        reapConnections(false);
+        auto connection = make_shared<Connection>(fd);
+        lock_guard<mutex> lock(connectionsMutex);
+        connectionThreads.push_back({thread(&CountServer::serveConnection, this, connection), connection});
+    }
+}
+
+void CountServer::reapConnections(bool all) {
+    lock_guard<mutex> lock(connectionsMutex);
+    for (auto it = connectionThreads.begin(); it != connectionThreads.end();) {
+        if (all && !it->connection->closed.load()) {
+            // wake the reader - the connection then drains its answers and closes
+            shutdown(it->connection->fd, SHUT_RD);
+        }
+        if (all || it->connection->closed.load()) {
+            it->thread.join();
+            it = connectionThreads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CountServer::serveConnection(shared_ptr<Connection> connection) {
+    string line;
+    while (!stopping.load() && connection->readLine(line)) {
+        if (line.empty()) {
+            continue;
+        }
+        auto fields = parseFields(line);
+        if (fields.count("STATS")) {
+            connection->writeLine(answerStats());
+            continue;
+        }
+        if (!fields.count("COUNT")) {
+            connection->writeLine(errorLine(fields["id"], "unknown request: " + line));
+            continue;
+        }
+
+        if (!fields.count("bytes")) {
+            submitCount(connection, line, "", false);
+            continue;
+        }
+        long bytes = -1;
+        try {
+            bytes = parseValue<long>("bytes", fields["bytes"]);
+        } catch (const exception&) {
+        }
+        if (bytes < 0 || bytes > SERVER_MAX_REQUEST_BYTES) {
+            // the body cannot be skipped reliably - give up on this client
+            connection->writeLine(errorLine(fields["id"], "invalid bytes=" + fields["bytes"]));
+            break;
+        }
+        string body;
+        if (!connection->readBytes(bytes, body)) {
+            break;
+        }
+        submitCount(connection, line, move(body), true);
+    }
+
+    // answers still being computed go out before the connection closes
+    unique_lock<mutex> lock(connection->pendingMutex);
+    connection->pendingDone.wait(lock, [&]() { return connection->pending == 0; });
+    close(connection->fd);
+    connection->closed.store(true);
+}
+
+void CountServer::submitCount(shared_ptr<Connection> connection, const string& header, string body, bool inlineBody) {
+    {
+        unique_lock<mutex> lock(slotMutex);
+        slotFree.wait(lock, [&]() { return activeRequests < pool.size(); });
+        activeRequests++;
+    }
+    {
+        lock_guard<mutex> lock(connection->pendingMutex);
+        connection->pending++;
+    }
+
+    requests.submit([this, connection, header, body = move(body), inlineBody]() {
+        connection->writeLine(answerCount(header, body, inlineBody));
+        requestsServed++;
+        {
+            lock_guard<mutex> lock(slotMutex);
+            activeRequests--;
+        }
+        slotFree.notify_one();
+        {
+            lock_guard<mutex> lock(connection->pendingMutex);
+            connection->pending--;
+        }
+        connection->pendingDone.notify_all();
+    });
+}
+
+string CountServer::answerCount(const string& header, const string& body, bool inlineBody) {
+    auto fields = parseFields(header);
+    string id = fields["id"];
+    Timer timer;
+    try {
+        CountingOptions counting = options.defaults;
+        applyParameters(fields, counting);
+        counting.pool = &pool;
+        counting.cancel = &shutdownToken;
+
+        string dimacs;
+        string path = inlineBody ? "<inline>" : fields["path"];
+        if (inlineBody) {
+            dimacs = body;
+        } else {
+            if (path.empty()) {
+                throw runtime_error("COUNT needs path=<file> or bytes=<n>");
+            }
+            ifstream file(path, ios::binary);
+            if (!file.is_open()) {
+                throw runtime_error("cannot open " + path);
+            }
+            dimacs.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        }
+
+        bool cached = false;
+        shared_ptr<const CachedFormula> entry = cache.get(dimacs, cached);
+
+        BatchResult batchResult;
+        batchResult.index = requestsServed.load();
+        batchResult.path = path;
+        batchResult.numVariables = entry->formula->getNumVariables();
+        batchResult.numClauses = entry->formula->getNumClauses();
+        if (counting.exactFallback && entry->exactCompleted) {
+            batchResult.result = ApproximateCounter::exactResult(entry->exactCount);
+        } else {
+            // the cache already ran the exact counter - it did not finish, so do not try again
+            counting.exactFallback = counting.exactFallback && !entry->exactAttempted;
+            batchResult.result = ApproximateCounter::approximateCount(*entry->prepared, counting);
+        }
+        batchResult.ok = true;
+        batchResult.seconds = timer.elapsedSeconds();
+
+        ostringstream out;
+        out << "{\"id\": \"";
+        writeEscaped(out, id);
+        out << "\", \"cached\": " << (cached ? "true" : "false") << ", \"result\": " << BatchCounter::toJSON(batchResult) << "}";
+        return out.str();
+    } catch (const exception& e) {
+        return errorLine(id, e.what());
+    }
+}
+
+string CountServer::answerStats() const {
+    FormulaCacheStats stats = cache.stats();
+    ostringstream out;
+    out << "{\"requests\": " << requestsServed.load() << ", \"workers\": " << pool.size()
+        << ", \"cache\": {\"entries\": " << stats.entries << ", \"literals\": " << stats.literals << ", \"hits\": " << stats.hits
+        << ", \"misses\": " << stats.misses << ", \"evictions\": " << stats.evictions << "}}";
+    return out.str();
+}
@@ -0,0 +1,98 @@
+// Source file for the formula cache of the count server
+
+#include "server/formula_cache.h"
+#include "cnf/cnf_parser.h"
+#include "solver/exact_counter.h"
+
+using namespace std;
+
+FormulaCache::FormulaCache(size_t entries, size_t literals, const CountingOptions& options, HashFunction hash) :
+    maxEntries(entries), maxLiterals(literals), counting(options), hashText(hash) {}
+
+uint64_t FormulaCache::contentHash(const string& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char ch : text) {
+        hash ^= ch;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+shared_ptr<const CachedFormula> FormulaCache::get(const string& dimacs, bool& wasCached) {
+    uint64_t hash = hashText(dimacs);
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto found = index.find(hash);
+        if (found != index.end() && (*found->second)->dimacs == dimacs) {
+            // move to the front
+            order.splice(order.begin(), order, found->second);
+            counters.hits++;
+            wasCached = true;
+            return *found->second;
+        }
+        counters.misses++;
+    }
+
+    // parse outside the lock - two requests for the same new formula may both prepare it, the first one is kept
+    shared_ptr<const CachedFormula> prepared = prepare(dimacs, hash);
+    wasCached = false;
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto found = index.find(hash);
+    if (found != index.end()) {
+        if ((*found->second)->dimacs == dimacs) {
+            order.splice(order.begin(), order, found->second);
+            return *found->second;
+        }
+        // another text with the same hash - the newer one takes its place
+        remove(found->second);
+        counters.evictions++;
+    }
+    order.push_front(prepared);
+    index[hash] = order.begin();
+    counters.literals += prepared->literals;
+    evict();
+    return prepared;
+}
+
+shared_ptr<const CachedFormula> FormulaCache::prepare(const string& dimacs, uint64_t hash) const {
+    auto entry = make_shared<CachedFormula>();
+    entry->contentHash = hash;
+    entry->dimacs = dimacs;
+    entry->formula = shared_ptr<const CNFFormula>(CNFParser::parseString(dimacs).release());
+    for (const auto& clause : entry->formula->clauses) {
+        entry->literals += clause.size();
+    }
+
+    // formulas the exact counter can take are counted once here instead of once per request
+    if (ExactCounter::fitsBudget(*entry->formula)) {
+        ExactCountResult exact = ExactCounter::count(*entry->formula);
+        entry->exactAttempted = true;
+        entry->exactCompleted = exact.completed;
+        entry->exactCount = exact.modelCount();
+    }
+
+    // probing, renumbering and loading the solver are done once too
+    entry->prepared = ApproximateCounter::prepare(*entry->formula, counting);
+    return entry;
+}
+
+void FormulaCache::evict() {
+    while (order.size() > 1 && (order.size() > maxEntries || counters.literals > maxLiterals)) {
+        remove(prev(order.end()));
+        counters.evictions++;
+    }
+}
+
+void FormulaCache::remove(LRUList::iterator entry) {
+    counters.literals -= (*entry)->literals;
+    index.erase((*entry)->contentHash);
+    order.erase(entry);
+}
+
+FormulaCacheStats FormulaCache::stats() const {
+    lock_guard<mutex> lock(cacheMutex);
+    FormulaCacheStats result = counters;
+    result.entries = order.size();
+    return result;
+}
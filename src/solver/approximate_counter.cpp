@@ -3,42 +3,336 @@
 #include "solver/approximate_counter.h"
 #include "solver/partial_assignment.h"
 #include "solver/cnf_simplifier.h"
+#include "solver/exact_counter.h"
+#include "solver/truth_table_counter.h"
+#include "solver/trial_checkpoint.h"
+#include "solver/learned_clause_pool.h"
+#include "cnf/variable_order.h"
+#include "utils/logger.h"
+#include "utils/timer.h"
+#include "utils/trace.h"
+#include "utils/thread_pool.h"
+#include "utils/reusable_storage.h"
 #include <iostream>
 #include <algorithm>
-#include <numeric>
+#include <cassert>
 #include <cmath>
+#include <future>
+#include <map>
+#include <memory>
 
 using namespace std;
 
+// units the binary clauses imply are added up front - the models, and so every cell count, stay the same
+// renumbering only renames variables, so the count needs no mapping back
+bool ApproximateCounter::preprocess(const CNFFormula& formula, const CountingOptions& options, CNFFormula& result, bool& unsatisfiable) {
+    unsatisfiable = false;
+    bool changed = false;
+    if (options.probeFailedLiterals) {
+        ProbeResult probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals();
+        if (probe.unsatisfiable) {
+            unsatisfiable = true;
+            return false;
+        }
+        if (!probe.units.empty()) {
+            LOG_INFO("probing fixed " << probe.units.size() << " literals (" << probe.failedLiterals << " failed)");
+            result = ImplicationGraph::withProbedUnits(formula, probe);
+            changed = true;
+        }
+    }
+    if (options.renumberVariables) {
+        const CNFFormula& current = changed ? result : formula;
+        VariableOrder order = VariableOrder::cuthillMcKee(current);
+        CNFFormula renumbered = order.apply(current);
+        LOG_INFO("renumbering variables: clause span " << VariableOrder::clauseSpan(current) << " -> " << VariableOrder::clauseSpan(renumbered));
+        result = move(renumbered);
+        changed = true;
+    }
+    return changed;
+}
+
 // run multiple trials of approximate counting and aggregate results
 ApproximationResult ApproximateCounter::approximateCount(const CNFFormula& formula, int numTrials, int numXORs, double density) {
+    CountingOptions options;
+    options.maxTrials = numTrials;
+    options.threshold = 50;
+    options.density = density;
+    options.earlyTermination = false;
+    return approximateCount(formula, options);
+}
+
+// run trials until the (epsilon, delta) budget is used up or the estimate is already tight enough
+ApproximationResult ApproximateCounter::approximateCount(const CNFFormula& input, const CountingOptions& options) {
+    PhaseStats runStart = Stats::local();
+    
+    CNFFormula preprocessed;
+    bool unsatisfiable = false;
+    bool changed = preprocess(input, options, preprocessed, unsatisfiable);
+    if (unsatisfiable) {
+        ApproximationResult result = exactResult(ModelCount());
+        result.stats = Stats::local().since(runStart);
+        return result;
+    }
+    return countPreprocessed(changed ? preprocessed : input, nullptr, options, runStart);
+}
+
+// the preprocessing was done by prepare - only the trials are left
+ApproximationResult ApproximateCounter::approximateCount(const PreparedFormula& prepared, const CountingOptions& options) {
+    PhaseStats runStart = Stats::local();
+    if (prepared.unsatisfiable()) {
+        ApproximationResult result = exactResult(ModelCount());
+        result.stats = Stats::local().since(runStart);
+        return result;
+    }
+    return countPreprocessed(prepared.formula(), &prepared, options, runStart);
+}
+
+unique_ptr<PreparedFormula> ApproximateCounter::prepare(const CNFFormula& formula, const CountingOptions& options) {
+    unique_ptr<PreparedFormula> prepared(new PreparedFormula());
+    bool unsatisfiable = false;
+    if (!preprocess(formula, options, prepared->preprocessed, unsatisfiable)) {
+        prepared->preprocessed = formula;
+    }
+    if (unsatisfiable) {
+        return prepared;
+    }
+    if (options.shareLearnedClauses) {
+        prepared->sharedClauses.reset(new LearnedClausePool(prepared->preprocessed));
+    }
+    prepared->snapshot.reset(new SolverSnapshot(prepared->preprocessed, prepared->sharedClauses.get()));
+    return prepared;
+}
+
+ApproximationResult ApproximateCounter::countPreprocessed(const CNFFormula& formula, const PreparedFormula* prepared, const CountingOptions& options,
+                                                          const PhaseStats& runStart) {
+    // cancelled by the caller, by the run's deadline, or below once the run no longer needs the trials in flight
+    CancellationToken runToken(options.cancel);
+    if (options.timeoutSeconds > 0) {
+        runToken.setDeadline(options.timeoutSeconds);
+    }
+    
+    // small formulas are counted outright
+    if (options.exactFallback && ExactCounter::fitsBudget(formula)) {
+        ExactCountResult exactCount = ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, &runToken);
+        if (exactCount.completed) {
+            ApproximationResult result = exactResult(exactCount.modelCount());
+            result.stats = Stats::local().since(runStart);
+            return result;
+        }
+    }
+    
+    int maxTrials = (options.maxTrials > 0) ? options.maxTrials : StatisticalAnalysis::requiredIterations(options.delta);
+    int threshold = (options.threshold > 0) ? options.threshold : StatisticalAnalysis::cellThreshold(options.epsilon);
+    
+    // per-variable probabilities are predicted once, for the formula the trials hash - every trial shares the sampler
+    unique_ptr<VariableSampler> sampler;
+    uint64_t densitiesHash = 0;
+    if (options.hashModel) {
+        vector<double> densities = options.hashModel->predictDensities(formula);
+        densitiesHash = TrialCheckpoint::densitiesHash(densities);
+        sampler.reset(new VariableSampler(densities));
+        LOG_INFO("hash model: " << sampler->expectedLength() << " variables per XOR expected");
+    }
+    
+    // a restarted run takes the seed from its checkpoint and replays the trials recorded there
+    // the fingerprint is taken after preprocessing - renumbered variables draw other XORs, so the trials would differ
+    unique_ptr<TrialCheckpoint> checkpoint;
+    if (!options.checkpointPath.empty()) {
+        checkpoint.reset(new TrialCheckpoint(options.checkpointPath, formula, options.density, threshold, options.seed, options.hashFamily,
+                                             densitiesHash));
+    }
+    uint64_t seed = checkpoint ? checkpoint->seed() : (options.seed != 0) ? options.seed : XORHashGenerator::drawSeed();
+    bool writeCheckpoint = (checkpoint != nullptr);
+    
+    // work done on this thread before the trials - the trials bring their own stats
+    PhaseStats setupStats = Stats::local().since(runStart);
+    
+    // every cell is the formula plus constraints, so what the SAT calls learn from the formula alone is passed on
+    // the solver state for the formula is built once - each cell's solver starts as a copy of it
+    // a prepared formula brings both along
+    unique_ptr<LearnedClausePool> sharedClauses;
+    unique_ptr<SolverSnapshot> snapshot;
+    LearnedClausePool* clausePool;
+    const SolverSnapshot* base;
+    if (prepared != nullptr) {
+        clausePool = prepared->sharedClauses.get();
+        base = prepared->snapshot.get();
+    } else {
+        if (options.shareLearnedClauses) {
+            sharedClauses.reset(new LearnedClausePool(formula));
+        }
+        clausePool = sharedClauses.get();
+        snapshot.reset(new SolverSnapshot(formula, clausePool));
+        base = snapshot.get();
+    }
+    
+    // trials recorded by an earlier run are replayed, the others get a token of their own for the per-trial deadline
+    const TrialCheckpoint* resumed = checkpoint.get();
+    const VariableSampler* variableSampler = sampler.get();
+    auto runIndexed = [&formula, &options, &runToken, resumed, clausePool, base, variableSampler, threshold, seed](int index) {
+        TrialResult trial;
+        if (resumed != nullptr && resumed->recorded(index, trial)) {
+            return trial;
+        }
+        mt19937 rng = trialGenerator(seed, index);
+        CancellationToken trialToken(&runToken);
+        if (options.trialTimeoutSeconds > 0) {
+            trialToken.setDeadline(options.trialTimeoutSeconds);
+        }
+        SolveLimits limits;
+        limits.cancel = &trialToken;
+        limits.maxConflicts = options.maxConflictsPerSolve;
+        limits.sharedClauses = clausePool;
+        limits.snapshot = base;
+        limits.sampler = variableSampler;
+        return singleTrial(formula, options.density, threshold, rng, limits, 0, options.hashFamily);
+    };
+    
+    // trials run on the shared pool, on a pool of our own, or right here
+    ThreadPool* pool = options.pool;
+    unique_ptr<ThreadPool> ownPool;
+    if (pool == nullptr && options.numThreads != 1) {
+        ownPool.reset(new ThreadPool(options.numThreads));
+        pool = ownPool.get();
+    }
+    
+    // at most one trial per worker is in flight ahead of the one being consumed,
+    // so an early stop wastes little work and the trials stay in index order
+    // while waiting this thread only helps with the trials of this run
+    vector<future<TrialResult>> pending;
+    int submitted = 0;
+    int window = (pool != nullptr) ? pool->size() : 0;
+    uint64_t group = (pool != nullptr) ? pool->newGroup() : ThreadPool::NO_GROUP;
+    auto submitNext = [&]() {
+        int index = submitted++;
+        pending.push_back(pool->submit([runIndexed, index]() { return runIndexed(index); }, group));
+    };
+    while (pool != nullptr && submitted < maxTrials && submitted < window) {
+        submitNext();
+    }
+    
     vector<TrialResult> trials;
-    trials.reserve(numTrials);
+    trials.reserve(maxTrials);
+    int successful = 0;
+    bool stopped = false;
+    bool interrupted = false;
     
-    for (int i = 0; i < numTrials; i++) {
-        TrialResult trial = singleTrial(formula, density, 50);
+    for (int i = 0; i < maxTrials && !stopped && !interrupted; i++) {
+        TrialResult trial;
+        if (pool != nullptr) {
+            trial = pool->await(pending[i], group);
+            if (submitted < maxTrials) {
+                submitNext();
+            }
+        } else {
+            trial = runIndexed(i);
+        }
         trials.push_back(trial);
+        if (writeCheckpoint && !checkpoint->append(i, trial)) {
+            LOG_WARNING("cannot write checkpoint " << options.checkpointPath << " - continuing without");
+            writeCheckpoint = false;
+        }
+        if (trial.satisfiable) {
+            successful++;
+        }
+        
+        // stop as soon as the median is pinned down to within the tolerance
+        if (options.earlyTermination && successful >= MIN_TRIALS_BEFORE_STOPPING && i + 1 < maxTrials) {
+            ApproximationResult partial = aggregateResults(trials, options.delta);
+            stopped = StatisticalAnalysis::withinTolerance(partial.interval, partial.log2Estimate, options.epsilon);
+        }
+        
+        // past the deadline or cancelled - the trials already finished have to do
+        if (!stopped && i + 1 < maxTrials) {
+            interrupted = runToken.isCancelled();
+        }
+    }
+    
+    // trials still in flight hold references to the formula - abort them and let them return
+    bool callerCancelled = options.cancel != nullptr && options.cancel->isCancelled();
+    bool deadlinePassed = runToken.deadlinePassed();
+    runToken.cancel();
+    for (size_t i = trials.size(); i < pending.size(); i++) {
+        pool->await(pending[i], group);
     }
     
-    return aggregateResults(trials);
+    ApproximationResult result = aggregateResults(trials, options.delta);
+    result.earlyStopped = stopped;
+    result.timedOut = interrupted && deadlinePassed;
+    result.cancelled = interrupted && callerCancelled;
+    result.partial = interrupted || result.abortedTrials > 0;
+    result.stats.merge(setupStats);
+    return result;
+}
+
+// a count known exactly - the interval collapses to the count itself
+ApproximationResult ApproximateCounter::exactResult(const ModelCount& count) {
+    ApproximationResult result;
+    result.exact = true;
+    result.estimatedCount = count.saturated();
+    result.log2Estimate = count.log2();
+    result.averageCount = exp2(result.log2Estimate);
+    result.interval.valid = true;
+    result.interval.log2Lower = result.log2Estimate;
+    result.interval.log2Upper = result.log2Estimate;
+    result.interval.confidence = 1.0;
+    return result;
 }
 
 // run a single trial with adaptive XOR count
 TrialResult ApproximateCounter::singleTrial(const CNFFormula& formula, double density, int threshold) {
+    mt19937 rng = trialGenerator(XORHashGenerator::drawSeed(), 0);
+    return singleTrial(formula, density, threshold, rng);
+}
+
+TrialResult ApproximateCounter::singleTrial(const CNFFormula& formula, double density, int threshold, mt19937& rng, const SolveLimits& limits,
+                                            int startXORs, HashFamily family) {
+    AMC_TRACE_SPAN("trial", "trial");
+    // cells are cloned from the snapshot, so it has to be this formula's
+    assert(limits.snapshot == nullptr || limits.snapshot->builtFrom(formula));
+    PhaseStats trialStart = Stats::local();
+    TrialWorkspace& workspace = TrialWorkspace::local();
+    TrialResult result;
+    if (family == HashFamily::NESTED) {
+        result = runNestedTrial(formula, density, threshold, rng, limits, startXORs, workspace);
+    } else if (startXORs > 0) {
+        result = runHintedTrial(formula, density, threshold, rng, limits, startXORs, workspace);
+    } else {
+        result = runTrial(formula, density, threshold, rng, limits, workspace);
+    }
+    result.stats = Stats::local().since(trialStart);
+    return result;
+}
+
+// independent stream per trial - the seed sequence mixes the seed and the index
+mt19937 ApproximateCounter::trialGenerator(uint64_t seed, int trialIndex) {
+    seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), static_cast<uint32_t>(trialIndex)};
+    return mt19937(sequence);
+}
+
+TrialResult ApproximateCounter::runTrial(const CNFFormula& formula, double density, int threshold, mt19937& rng, const SolveLimits& limits,
+                                         TrialWorkspace& workspace) {
     TrialResult result;
     int numVariables = formula.getNumVariables();
     int numXORs = 0;
+    bool interrupted = false;
     
     // add XORs until solution space is small enough
     while (numXORs < numVariables) {
-        auto xors = XORHashGenerator::generateXORFamily(numVariables, numXORs, density);
-        auto xorSolution = PartialAssignment::solveXORSystem(xors, numVariables);
+        AMC_TRACE_SPAN_ARG("xor_step", "trial", "xors", numXORs);
+        if (limits.cancel != nullptr && limits.cancel->isCancelled()) {
+            result.aborted = true;
+            return result;
+        }
+        drawXORs(numVariables, numXORs, density, rng, limits, workspace);
+        const XORSolutionResult& xorSolution = workspace.xorSolution;
+        PartialAssignment::solveXORSystem(workspace.xors, numVariables, workspace.xorSolution, workspace.elimination);
         
         if (!xorSolution.satisfiable) {
             // too many XORs
             if (numXORs == 0) {
                 result.satisfiable = false;
-                result.solutionCount = 0;
+                result.cellCount = 0;
                 result.numXORs = 0;
                 return result;
             }
@@ -46,12 +340,13 @@ TrialResult ApproximateCounter::singleTrial(const CNFFormula& formula, double de
             break;
         }
         
-        auto simplified = CNFSimplifier::applyXORSolution(formula, xorSolution);
+        const SimplificationResult& simplified = workspace.cell;
+        CNFSimplifier::applyXORSolution(formula, xorSolution, workspace.cell, workspace.simplification);
         
         if (simplified.isUnsatisfiable) {
             if (numXORs == 0) {
                 result.satisfiable = false;
-                result.solutionCount = 0;
+                result.cellCount = 0;
                 result.numXORs = 0;
                 return result;
             }
@@ -59,12 +354,16 @@ TrialResult ApproximateCounter::singleTrial(const CNFFormula& formula, double de
             break;
         }
         
-        uint64_t cellCount = countSolutions(simplified.simplified, threshold + 10);
+        uint64_t cellCount = countSolutions(simplified.simplified, threshold + 10, limits, interrupted, &xorSolution, workspace);
+        if (interrupted) {
+            result.aborted = true;
+            return result;
+        }
         
         if (cellCount == 0) {
             if (numXORs == 0) {
                 result.satisfiable = false;
-                result.solutionCount = 0;
+                result.cellCount = 0;
                 result.numXORs = 0;
                 return result;
             }
@@ -78,13 +377,8 @@ TrialResult ApproximateCounter::singleTrial(const CNFFormula& formula, double de
             result.freeVariables = xorSolution.freeVariables.size();
             result.assignedVariables = xorSolution.assignment.size();
             
-            // scale up get estimate based on number of XORs added
-            uint64_t scaleFactor = (numXORs < 64) ? (1ULL << numXORs) : UINT64_MAX;
-            if (cellCount > UINT64_MAX / scaleFactor) {
-                result.solutionCount = UINT64_MAX;
-            } else {
-                result.solutionCount = cellCount * scaleFactor;
-            }
+            // the estimate is cellCount * 2^numXORs - kept unscaled so it cannot saturate
+            result.cellCount = cellCount;
             return result;
         }
         
@@ -93,37 +387,288 @@ TrialResult ApproximateCounter::singleTrial(const CNFFormula& formula, double de
     }
     
     // if we exit loop without returning, we have found a good number of XORs to get a small cell count, so do final count and return result
-    auto xors = XORHashGenerator::generateXORFamily(numVariables, numXORs, density);
-    auto xorSolution = PartialAssignment::solveXORSystem(xors, numVariables);
-    auto simplified = CNFSimplifier::applyXORSolution(formula, xorSolution);
+    drawXORs(numVariables, numXORs, density, rng, limits, workspace);
+    const XORSolutionResult& xorSolution = workspace.xorSolution;
+    PartialAssignment::solveXORSystem(workspace.xors, numVariables, workspace.xorSolution, workspace.elimination);
+    const SimplificationResult& simplified = workspace.cell;
+    CNFSimplifier::applyXORSolution(formula, xorSolution, workspace.cell, workspace.simplification);
     
     result.numXORs = numXORs;
     result.freeVariables = xorSolution.freeVariables.size();
     result.assignedVariables = xorSolution.assignment.size();
     
-    uint64_t cellCount = countSolutions(simplified.simplified, threshold + 10);
-    uint64_t scaleFactor = (numXORs < 64) ? (1ULL << numXORs) : UINT64_MAX;
+    uint64_t cellCount = countSolutions(simplified.simplified, threshold + 10, limits, interrupted, &xorSolution, workspace);
+    if (interrupted) {
+        result.aborted = true;
+        return result;
+    }
     
     result.satisfiable = (cellCount > 0);
-    if (cellCount > UINT64_MAX / scaleFactor) {
-        result.solutionCount = UINT64_MAX;
+    result.cellCount = cellCount;
+    
+    return result;
+}
+
+// search from a hint (typically the XOR count an earlier trial settled on) instead of from zero XORs:
+// take XORs away while the coarser cell is still small enough, add them while the cell is too big
+TrialResult ApproximateCounter::runHintedTrial(const CNFFormula& formula, double density, int threshold, mt19937& rng, const SolveLimits& limits,
+                                               int startXORs, TrialWorkspace& workspace) {
+    TrialResult result;
+    int numXORs = min(startXORs, formula.getNumVariables());
+    CellProbe cell = probeCell(formula, numXORs, density, threshold, rng, limits, workspace);
+    
+    if (cell.cellCount > static_cast<uint64_t>(threshold)) {
+        while (!cell.interrupted && cell.cellCount > static_cast<uint64_t>(threshold) && numXORs < formula.getNumVariables()) {
+            CellProbe next = probeCell(formula, numXORs + 1, density, threshold, rng, limits, workspace);
+            if (next.cellCount == 0 && !next.interrupted) {
+                break;  // one XOR too many - keep the last non-empty cell
+            }
+            numXORs++;
+            cell = next;
+        }
     } else {
-        result.solutionCount = cellCount * scaleFactor;
+        while (!cell.interrupted && numXORs > 0) {
+            CellProbe next = probeCell(formula, numXORs - 1, density, threshold, rng, limits, workspace);
+            if (next.interrupted) {
+                cell = next;
+                break;
+            }
+            if (next.cellCount > static_cast<uint64_t>(threshold)) {
+                if (cell.cellCount == 0) {
+                    // one XOR too many, as in the plain search - settle for the coarser cell
+                    numXORs--;
+                    cell = next;
+                }
+                break;
+            }
+            if (next.cellCount == 0 && cell.cellCount > 0) {
+                break;
+            }
+            numXORs--;
+            cell = next;
+        }
+    }
+    
+    if (cell.interrupted) {
+        result.aborted = true;
+        return result;
+    }
+    result.satisfiable = (cell.cellCount > 0);
+    result.cellCount = cell.cellCount;
+    result.numXORs = numXORs;
+    result.freeVariables = cell.freeVariables;
+    result.assignedVariables = cell.assignedVariables;
+    return result;
+}
+
+// the m-XOR hash is the first m XORs of one sequence (prefix slicing, as in ApproxMC), so cells are nested:
+// too big at m means too big below m, empty at m means empty above m
+TrialResult ApproximateCounter::runNestedTrial(const CNFFormula& formula, double density, int threshold, mt19937& rng, const SolveLimits& limits,
+                                               int startXORs, TrialWorkspace& workspace) {
+    int numVariables = formula.getNumVariables();
+    uint64_t limit = static_cast<uint64_t>(threshold);
+    size_t reuseLimit = static_cast<size_t>(threshold + 10) * NESTED_REUSE_FACTOR;
+    
+    // XORs are drawn in sequence order as the search first needs them - the sequence does not depend on the search
+    vector<XORConstraint> sequence;
+    map<int, NestedCell> cells;
+    bool interrupted = false;
+    auto cellAt = [&](int numXORs) -> const CellProbe& {
+        auto found = cells.find(numXORs);
+        if (found != cells.end()) {
+            return found->second.probe;
+        }
+        while ((int)sequence.size() < numXORs) {
+            sequence.push_back((limits.sampler != nullptr) ? XORHashGenerator::generateSparseXOR(*limits.sampler, rng)
+                                                           : XORHashGenerator::generateSparseXOR(numVariables, density, rng));
+        }
+        vector<XORConstraint> prefix(sequence.begin(), sequence.begin() + numXORs);
+        
+        // the finest coarser cell probed so far - empty or with few enough models, it settles this one without solving
+        NestedCell& cell = cells[numXORs];
+        auto coarser = cells.find(numXORs);
+        NestedCell* source = (coarser != cells.begin()) ? &prev(coarser)->second : nullptr;
+        int sourceXORs = (source != nullptr) ? prev(coarser)->first : 0;
+        if (source != nullptr && source->probe.cellCount == 0) {
+            AMC_COUNT(Counter::REUSED_CELLS);
+        } else if (source != nullptr && source->probe.cellCount <= reuseLimit && cellModels(*source, numVariables, reuseLimit, limits)) {
+            AMC_COUNT(Counter::REUSED_CELLS);
+            auto xorSolution = PartialAssignment::solveXORSystem(prefix, numVariables);
+            if (xorSolution.satisfiable) {
+                vector<XORConstraint> extra(prefix.begin() + sourceXORs, prefix.end());
+                cell.models = filterModels(source->models, extra);
+                cell.modelsKnown = true;
+                cell.enumerated = true;
+                cell.probe.cellCount = cell.models.numAssignments;
+                cell.probe.freeVariables = xorSolution.freeVariables.size();
+                cell.probe.assignedVariables = xorSolution.assignment.size();
+            }
+        } else {
+            cell.probe = probeCell(formula, prefix, threshold, limits, workspace, &cell.simplified);
+        }
+        interrupted = interrupted || cell.probe.interrupted;
+        return cell.probe;
+    };
+    auto small = [&](int numXORs) { return cellAt(numXORs).cellCount <= limit; };
+    
+    // smallest XOR count whose cell is small enough lies in (tooBig, smallEnough]
+    int tooBig = -1;
+    int smallEnough = numVariables + 1;
+    int start = min(max(startXORs, 0), numVariables);
+    if (small(start)) {
+        smallEnough = start;
+        for (int step = 1; !interrupted && tooBig < 0 && smallEnough > 0; step *= 2) {
+            int next = max(smallEnough - step, 0);
+            if (small(next)) {
+                smallEnough = next;
+            } else {
+                tooBig = next;
+            }
+        }
+    } else {
+        tooBig = start;
+        for (int step = 1; !interrupted && smallEnough > numVariables && tooBig < numVariables; step *= 2) {
+            int next = min(tooBig + step, numVariables);
+            if (small(next)) {
+                smallEnough = next;
+            } else {
+                tooBig = next;
+            }
+        }
+    }
+    while (!interrupted && smallEnough - tooBig > 1 && smallEnough <= numVariables) {
+        int middle = tooBig + (smallEnough - tooBig) / 2;
+        if (small(middle)) {
+            smallEnough = middle;
+        } else {
+            tooBig = middle;
+        }
     }
     
+    TrialResult result;
+    if (interrupted) {
+        result.aborted = true;
+        return result;
+    }
+    // every cell too big - settle for the finest; an empty cell falls back to the coarser one, as the plain search does
+    int numXORs = min(smallEnough, numVariables);
+    if (cellAt(numXORs).cellCount == 0 && numXORs > 0 && tooBig == numXORs - 1) {
+        numXORs = tooBig;
+    }
+    const CellProbe& cell = cellAt(numXORs);
+    result.satisfiable = (cell.cellCount > 0);
+    result.cellCount = cell.cellCount;
+    result.numXORs = numXORs;
+    result.freeVariables = cell.freeVariables;
+    result.assignedVariables = cell.assignedVariables;
     return result;
 }
 
+ApproximateCounter::CellProbe ApproximateCounter::probeCell(const CNFFormula& formula, int numXORs, double density, int threshold, mt19937& rng, const SolveLimits& limits,
+                                                            TrialWorkspace& workspace) {
+    if (limits.cancel != nullptr && limits.cancel->isCancelled()) {
+        CellProbe probe;
+        probe.interrupted = true;
+        return probe;
+    }
+    drawXORs(formula.getNumVariables(), numXORs, density, rng, limits, workspace);
+    return probeCell(formula, workspace.xors, threshold, limits, workspace);
+}
+
+void ApproximateCounter::drawXORs(int numVariables, int numXORs, double density, mt19937& rng, const SolveLimits& limits,
+                                  TrialWorkspace& workspace) {
+    if (limits.sampler != nullptr) {
+        XORHashGenerator::generateXORFamily(*limits.sampler, numXORs, rng, workspace.xors, workspace.spareXORs);
+    } else {
+        XORHashGenerator::generateXORFamily(numVariables, numXORs, density, rng, workspace.xors, workspace.spareXORs);
+    }
+}
+
+ApproximateCounter::CellProbe ApproximateCounter::probeCell(const CNFFormula& formula, const vector<XORConstraint>& xors, int threshold, const SolveLimits& limits,
+                                                            TrialWorkspace& workspace, CNFFormula* simplifiedOut) {
+    AMC_TRACE_SPAN_ARG("xor_step", "trial", "xors", xors.size());
+    CellProbe probe;
+    if (limits.cancel != nullptr && limits.cancel->isCancelled()) {
+        probe.interrupted = true;
+        return probe;
+    }
+    const XORSolutionResult& xorSolution = workspace.xorSolution;
+    PartialAssignment::solveXORSystem(xors, formula.getNumVariables(), workspace.xorSolution, workspace.elimination);
+    if (!xorSolution.satisfiable) {
+        return probe;
+    }
+    const SimplificationResult& simplified = workspace.cell;
+    CNFSimplifier::applyXORSolution(formula, xorSolution, workspace.cell, workspace.simplification);
+    if (simplified.isUnsatisfiable) {
+        return probe;
+    }
+    probe.freeVariables = xorSolution.freeVariables.size();
+    probe.assignedVariables = xorSolution.assignment.size();
+    probe.cellCount = countSolutions(simplified.simplified, threshold + 10, limits, probe.interrupted, &xorSolution, workspace);
+    if (simplifiedOut != nullptr) {
+        // a copy - the workspace keeps its own for the next cell
+        *simplifiedOut = simplified.simplified;
+    }
+    return probe;
+}
+
+bool ApproximateCounter::cellModels(NestedCell& cell, int numVariables, size_t maxModels, const SolveLimits& limits) {
+    if (!cell.enumerated) {
+        cell.enumerated = true;
+        vector<vector<int>> models;
+        cell.modelsKnown = ExactCounter::enumerate(cell.simplified, numVariables, maxModels, models, EXACT_COUNT_MAX_DECISIONS, limits.cancel);
+        if (cell.modelsKnown) {
+            cell.models = AssignmentBatch(numVariables, models.size());
+            for (size_t i = 0; i < models.size(); i++) {
+                cell.models.setAssignment(i, models[i]);
+            }
+        }
+        cell.simplified = CNFFormula();
+    }
+    return cell.modelsKnown;
+}
+
+AssignmentBatch ApproximateCounter::filterModels(const AssignmentBatch& models, const vector<XORConstraint>& extraXORs) {
+    vector<uint64_t> satisfied(models.numWords, ~0ULL);
+    int tail = models.numAssignments % 64;
+    if (tail != 0) {
+        satisfied.back() = (1ULL << tail) - 1;
+    }
+    for (const auto& constraint : extraXORs) {
+        ClauseEvaluator::filterParity(constraint.variables, constraint.value, models, satisfied.data());
+    }
+    
+    int count = 0;
+    for (uint64_t word : satisfied) {
+        count += __builtin_popcountll(word);
+    }
+    AssignmentBatch kept(models.numVariables, count);
+    int next = 0;
+    for (int i = 0; i < models.numAssignments; i++) {
+        if ((satisfied[i / 64] >> (i % 64)) & 1) {
+            for (int var = 1; var <= models.numVariables; var++) {
+                kept.setValue(next, var, models.getValue(i, var));
+            }
+            next++;
+        }
+    }
+    return kept;
+}
+
 // aggregate results from multiple trials to get final approximation
-ApproximationResult ApproximateCounter::aggregateResults(const vector<TrialResult>& trials) {
+ApproximationResult ApproximateCounter::aggregateResults(const vector<TrialResult>& trials, double delta) {
     ApproximationResult result;
     result.totalTrials = trials.size();
     
     // get counts from successful trials
     for (const auto& trial : trials) {
-        if (trial.satisfiable) {
+        result.trialStats.push_back(trial.stats);
+        result.stats.merge(trial.stats);
+        if (trial.aborted) {
+            result.abortedTrials++;
+        } else if (trial.satisfiable) {
             result.successfulTrials++;
-            result.trialCounts.push_back(trial.solutionCount);
+            result.trialCounts.push_back(trial.count());
         }
     }
     
@@ -135,180 +680,601 @@ ApproximationResult ApproximateCounter::aggregateResults(const vector<TrialResul
     }
     
     // median used - more robust to outliers than mean
-    vector<uint64_t> sortedCounts = result.trialCounts;
-    sort(sortedCounts.begin(), sortedCounts.end());
+    // (compared in the log domain, so counts beyond 2^64 keep their order)
+    vector<ModelCount> sortedCounts = result.trialCounts;
+    sort(sortedCounts.begin(), sortedCounts.end(), [](const ModelCount& a, const ModelCount& b) {
+        return a.log2() < b.log2();
+    });
     
     size_t medianIndex = sortedCounts.size() / 2;
     if (sortedCounts.size() % 2 == 0) {
-        result.estimatedCount = (sortedCounts[medianIndex - 1] + sortedCounts[medianIndex]) / 2;
+        const ModelCount& lower = sortedCounts[medianIndex - 1];
+        const ModelCount& upper = sortedCounts[medianIndex];
+        if (upper.saturated() != UINT64_MAX) {
+            // both fit - midpoint computed without overflowing the sum
+            uint64_t a = lower.saturated();
+            uint64_t b = upper.saturated();
+            result.estimatedCount = a / 2 + b / 2 + (a % 2 + b % 2) / 2;
+            result.log2Estimate = (result.estimatedCount == 0) ? -INFINITY : log2(static_cast<double>(result.estimatedCount));
+        } else {
+            // log2((2^a + 2^b) / 2) with b >= a
+            double a = lower.log2();
+            double b = upper.log2();
+            result.log2Estimate = b + log2(1.0 + exp2(a - b)) - 1.0;
+            result.estimatedCount = UINT64_MAX;
+        }
     } else {
-        result.estimatedCount = sortedCounts[medianIndex];
+        result.estimatedCount = sortedCounts[medianIndex].saturated();
+        result.log2Estimate = sortedCounts[medianIndex].log2();
     }
     
-    // get average
-    uint64_t sum = accumulate(result.trialCounts.begin(), result.trialCounts.end(), 0ULL);
-    result.averageCount = static_cast<double>(sum) / result.trialCounts.size();
+    // get average (as a double so large counts do not overflow)
+    double sum = 0.0;
+    for (const auto& count : result.trialCounts) {
+        sum += exp2(count.log2());
+    }
+    result.averageCount = sum / result.trialCounts.size();
+    
+    // confidence interval for the median
+    vector<double> log2Counts;
+    for (const auto& count : result.trialCounts) {
+        log2Counts.push_back(count.log2());
+    }
+    result.interval = StatisticalAnalysis::medianConfidenceInterval(log2Counts, delta);
     
     return result;
 }
 
+string ApproximateCounter::statsToJSON(const ApproximationResult& result) {
+    string json = "{\"run\": " + result.stats.toJSON() + ", \"trials\": [";
+    for (size_t i = 0; i < result.trialStats.size(); i++) {
+        if (i > 0) {
+            json += ", ";
+        }
+        json += result.trialStats[i].toJSON();
+    }
+    json += "]}";
+    return json;
+}
+
 // count solutions in simplified CNF up to maxCount
 uint64_t ApproximateCounter::countSolutions(const CNFFormula& formula, int maxCount) {
+    bool interrupted = false;
+    return countSolutions(formula, maxCount, SolveLimits(), interrupted);
+}
+
+uint64_t ApproximateCounter::countSolutions(const CNFFormula& formula, int maxCount, const SolveLimits& limits, bool& interrupted) {
+    TrialWorkspace workspace;
+    return countSolutions(formula, maxCount, limits, interrupted, nullptr, workspace);
+}
+
+uint64_t ApproximateCounter::countSolutions(const CNFFormula& formula, int maxCount, const SolveLimits& limits, bool& interrupted,
+                                            const XORSolutionResult* xorSolution, TrialWorkspace& workspace) {
+    interrupted = false;
+    AMC_TIME_PHASE(Phase::CELL_COUNTING);
+    AMC_TRACE_SPAN_ARG("count_solutions", "solver", "clauses", formula.getNumClauses());
+    
     if (formula.clauses.empty()) {
         // empty formula is always true
         if (formula.numVariables >= 64) return UINT64_MAX;
         return 1ULL << formula.numVariables;
     }
     
-    uint64_t count = 0;
-    vector<int> assignment(formula.numVariables, -1);
+    // the variables that appear in some clause - models are enumerated over these, every other variable doubles each of them
+    vector<char>& inClause = workspace.inClause;
+    vector<int>& constrained = workspace.constrained;
+    inClause.assign(formula.numVariables, 0);
+    for (const auto& clause : formula.clauses) {
+        for (Literal lit : clause.literals) {
+            inClause[abs(lit) - 1] = 1;
+        }
+    }
+    constrained.clear();
+    for (int i = 0; i < formula.numVariables; i++) {
+        if (inClause[i]) {
+            constrained.push_back(i);
+        }
+    }
+    int numConstrained = constrained.size();
     
-    // make sure there is at least one solution
-    if (!solveSAT(formula, assignment, 0)) {
-        return 0;  // UNSAT
+    // cells with few constrained variables are counted by evaluating every assignment
+    // (the counters are only tried when the cell fits their limits - checking that is all they would do otherwise)
+    ModelCount tableCount;
+    if (numConstrained <= TRUTH_TABLE_MAX_VARIABLES && TruthTableCounter::countModels(formula, tableCount)) {
+        AMC_COUNT(Counter::TRUTH_TABLE_CELLS);
+        return tableCount.saturated();
     }
     
-    count = 1;
+    int freeVariables = formula.numVariables - numConstrained;
     
-    while (count < maxCount) {
-        if (!findNextSolution(formula, assignment)) {
-            break;
+    // small cells are counted exactly in one pass instead of one solve per model (the test of ExactCounter::fitsBudget)
+    // the counter gives up as soon as the cell is seen to be too big - a large cell would otherwise use up its whole
+    // decision budget, only for the models to be enumerated up to maxCount after all
+    if (numConstrained <= EXACT_COUNT_MAX_VARIABLES && formula.getNumClauses() <= EXACT_COUNT_MAX_CLAUSES) {
+        uint64_t maxModels = static_cast<uint64_t>(maxCount) >> min(freeVariables, 63);
+        ExactCountResult exactResult = ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, limits.cancel, maxModels);
+        if (exactResult.completed) {
+            AMC_COUNT(Counter::EXACT_CELLS);
+            return exactResult.modelCount().saturated();
+        }
+        if (exactResult.overflow) {
+            return UINT64_MAX;
+        }
+        if (limits.cancel != nullptr && limits.cancel->isCancelled()) {
+            interrupted = true;
+            return 0;
         }
-        count++;
     }
     
-    return count;
-}
-
-// find next solution different from current assignment by adding blocking clause and solving again
-bool ApproximateCounter::findNextSolution(const CNFFormula& formula, vector<int>& assignment) {
-    // keep flipping variables until we find a new solution or exhaust all possibilities -> to be changed in the future
-    for (int i = formula.numVariables - 1; i >= 0; i--) {
-        int originalValue = assignment[i];
-        
-        // flip variable to block current solution
-        assignment[i] = 1 - originalValue;
-        vector<int> newAssignment = assignment;
-        if (solveSAT(formula, newAssignment, i + 1)) {
-            assignment = newAssignment;
-            return true;
+    if (freeVariables >= 64) {
+        return UINT64_MAX;
+    }
+    uint64_t modelsPerSolution = 1ULL << freeVariables;
+    
+    // one solver for the whole cell - each model found is blocked by a clause over the constrained variables
+    // and the search goes on from level 0, keeping what it learned
+    CDCLSolver& solver = workspace.solver;
+    bool loaded = xorSolution != nullptr && limits.snapshot != nullptr && loadCell(workspace, *limits.snapshot, *xorSolution, formula, limits);
+    if (!loaded) {
+        // no snapshot, or not the one of this cell's formula
+        solver = CDCLSolver();
+        solver.limits = limits;
+        loadFormula(solver, formula, vector<int>());
+    }
+    
+    uint64_t count = 0;
+    uint64_t solutions = 0;
+    vector<Literal>& blocking = workspace.blocking;
+    while (count < static_cast<uint64_t>(maxCount)) {
+        SolveStatus status = solve(solver);
+        if (status == SolveStatus::UNKNOWN) {
+            interrupted = true;
+            break;
+        }
+        if (status == SolveStatus::UNSATISFIABLE) {
+            break;
         }
+        solutions++;
+        count = (count > UINT64_MAX - modelsPerSolution) ? UINT64_MAX : count + modelsPerSolution;
         
-        // restore original value and try next variable
-        assignment[i] = originalValue;
+        blocking.clear();
+        for (int var : constrained) {
+            blocking.push_back(solver.assignment[var].value == 1 ? -(var + 1) : (var + 1));
+        }
+        backtrack(solver, 0);
+        addClause(solver, blocking, true);
     }
+    AMC_COUNT_N(Counter::MODELS_ENUMERATED, solutions);
     
-    return false;
+    return count;
 }
 
 // cdcl sat solver
+// values already set in assignment (0/1) are fixed at level 0 - on success assignment holds a full model
 bool ApproximateCounter::solveSAT(const CNFFormula& formula, vector<int>& assignment, int varIndex) {
+    return solveSAT(formula, assignment, SolveLimits()) == SolveStatus::SATISFIABLE;
+}
+
+// UNKNOWN if a limit ran out - assignment then holds whatever was assigned when the search stopped
+SolveStatus ApproximateCounter::solveSAT(const CNFFormula& formula, vector<int>& assignment, const SolveLimits& limits) {
     // Ensure assignment vector is properly sized
     if (assignment.size() < formula.numVariables) {
         assignment.resize(formula.numVariables, -1);
     }
     
-    vector<CDCLAssignment> cdclAssignment(formula.numVariables);
+    CDCLSolver solver;
+    solver.limits = limits;
+    loadFormula(solver, formula, assignment);
+    
+    SolveStatus result = solve(solver);
+    
     for (int i = 0; i < formula.numVariables; i++) {
-        cdclAssignment[i].value = assignment[i];
-        cdclAssignment[i].decisionLevel = (assignment[i] != -1) ? 0 : -1;
-        cdclAssignment[i].antecedent = -1;
+        assignment[i] = solver.assignment[i].value;
     }
     
-    vector<Clause> learnedClauses;
-    WatchedLiterals watches;
-    watches.init(formula.numVariables, formula.clauses.size());
+    return result;
+}
+
+void ApproximateCounter::loadFormula(CDCLSolver& solver, const CNFFormula& formula, const vector<int>& fixed) {
+    int numVars = formula.numVariables;
+    solver.numVars = numVars;
+    solver.assignment.assign(numVars, {-1, -1, -1});
+    solver.trail.clear();
+    solver.trail.reserve(numVars);
+    solver.trailLevels.assign(1, 0);
+    solver.propagationHead = 0;
+    solver.savedPhase.assign(numVars, 1);
+    solver.seen.assign(numVars, 0);
+    solver.watches.watches.assign(2 * numVars, {});
+    solver.addedBinaries.init(numVars);
+    solver.taintedAddedBinaries.init(numVars);
+    solver.binaryHead = 0;
+    solver.vsids.init(numVars);
+    solver.addedClauses = ClauseArena();
+    solver.clauseTainted.clear();
+    solver.clauseTainted.reserve(formula.clauses.size());
+    bool trackTaint = solver.tracksTaint();
+    solver.rootTainted.assign(trackTaint ? numVars : 0, 1);
+    solver.rootConflict = false;
+    solver.totalConflicts = 0;
+    solver.totalDecisions = 0;
     
-    VSIDSScores vsids;
-    vsids.init(formula.numVariables);
+    // values given by the caller are level 0 facts
+    for (int i = 0; i < numVars && i < static_cast<int>(fixed.size()); i++) {
+        if (fixed[i] != -1) {
+            assign(solver, fixed[i] == 1 ? i + 1 : -(i + 1), -1);
+        }
+    }
     
-    initWatches(formula, learnedClauses, watches, formula.numVariables);
+    // only clauses of the pool's formula itself are untainted - not the ones the XORs shortened
+    shared_ptr<ClauseArena> clauses = make_shared<ClauseArena>();
+    shared_ptr<ImplicationGraph> binaries = make_shared<ImplicationGraph>();
+    binaries->init(numVars);
+    shared_ptr<unordered_set<uint64_t>> taintedBinaries = make_shared<unordered_set<uint64_t>>();
+    vector<Literal> units;
+    vector<char> unitTainted;
+    for (const auto& clause : formula.clauses) {
+        // drop duplicate literals and tautologies
+        vector<Literal> lits = clause.literals;
+        sort(lits.begin(), lits.end());
+        lits.erase(unique(lits.begin(), lits.end()), lits.end());
+        bool tautology = false;
+        for (Literal lit : lits) {
+            tautology |= binary_search(lits.begin(), lits.end(), -lit);
+        }
+        if (tautology) {
+            continue;
+        }
+        bool tainted = trackTaint && !solver.limits.sharedClauses->isFormulaClause(lits);
+        
+        if (lits.empty()) {
+            solver.rootConflict = true;
+        } else if (lits.size() == 1) {
+            units.push_back(lits[0]);
+            unitTainted.push_back(tainted);
+        } else if (lits.size() == 2) {
+            // fixed values that falsify one side are picked up by the first propagation, which starts over the whole trail
+            binaries->addClause(lits[0], lits[1]);
+            if (tainted) {
+                taintedBinaries->insert(CDCLSolver::binaryKey(lits[0], lits[1]));
+            }
+        } else {
+            clauses->add(lits.data(), lits.size());
+            solver.clauseTainted.push_back(tainted);
+        }
+    }
+    solver.formulaClauses = clauses;
+    solver.formulaBinaries = binaries;
+    solver.formulaTaintedBinaries = taintedBinaries;
+    solver.numFormulaClauses = clauses->size();
+    solver.watched.assign(2 * solver.numFormulaClauses, 0);
     
+    for (size_t i = 0; i < units.size(); i++) {
+        Literal lit = units[i];
+        int value = solver.literalValue(lit);
+        if (value == 0) {
+            solver.rootConflict = true;
+        } else if (value == -1) {
+            assign(solver, lit, -1);
+            if (trackTaint) {
+                solver.rootTainted[abs(lit) - 1] = unitTainted[i];
+            }
+        }
+    }
+    
+    // the units have to be in before the watches are chosen - a clause whose second watch is false
+    // would otherwise be taken for unit while a literal further on is still free
+    for (size_t c = 0; c < solver.numFormulaClauses; c++) {
+        watchClause(solver, c);
+    }
+    
+    importSharedClauses(solver);
+}
+
+// the snapshot's clauses and binary implications are shared, everything else is copied
+bool ApproximateCounter::loadCell(TrialWorkspace& workspace, const SolverSnapshot& snapshot, const XORSolutionResult& xorSolution,
+                                  const CNFFormula& cell, const SolveLimits& limits) {
+    // the remaining rows, numbering their auxiliary variables as applyXORSolution does
+    CNFFormula& rows = workspace.rows;
+    rows.numVariables = snapshot.numVariables();
+    resizeReusing(rows.clauses, 0, workspace.spareRows);
+    for (const auto& constraint : xorSolution.constraints) {
+        CNFSimplifier::encodeXOR(rows, constraint, workspace.spareRows);
+    }
+    // not a cell cut out of the snapshot's formula by this solution
+    if (rows.numVariables != cell.numVariables) {
+        return false;
+    }
+    
+    CDCLSolver& solver = workspace.solver;
+    copySolver(solver, snapshot.base);
+    solver.limits = limits;
+    solver.totalConflicts = 0;
+    solver.totalDecisions = 0;
+    // the taint of the snapshot's clauses is only known for the pool it was built with
+    if (limits.sharedClauses != snapshot.base.limits.sharedClauses) {
+        solver.limits.sharedClauses = nullptr;
+    }
+    if (solver.rootConflict) {
+        return true;
+    }
+    
+    // the values the XORs fix, as applyXORSolution pins them
+    for (const auto& entry : xorSolution.assignment) {
+        Literal lit = (entry.second == 1) ? entry.first : -entry.first;
+        int value = solver.literalValue(lit);
+        if (value == 0) {
+            solver.rootConflict = true;
+            return true;
+        }
+        if (value == -1) {
+            assign(solver, lit, -1);
+        }
+    }
+    
+    addVariables(solver, rows.numVariables - solver.numVars);
+    for (auto& clause : rows.clauses) {
+        addClause(solver, clause.literals, true);
+    }
+    
+    importSharedClauses(solver);
+    return true;
+}
+
+void ApproximateCounter::copySolver(CDCLSolver& solver, const CDCLSolver& base) {
+    solver.numVars = base.numVars;
+    solver.formulaClauses = base.formulaClauses;
+    solver.addedClauses = base.addedClauses;
+    solver.numFormulaClauses = base.numFormulaClauses;
+    solver.watched = base.watched;
+    solver.formulaBinaries = base.formulaBinaries;
+    solver.addedBinaries.assignKeepingStorage(base.addedBinaries);
+    solver.assignment = base.assignment;
+    solver.trail = base.trail;
+    solver.trailLevels = base.trailLevels;
+    solver.binaryHead = base.binaryHead;
+    solver.propagationHead = base.propagationHead;
+    solver.savedPhase = base.savedPhase;
+    solver.seen = base.seen;
+    vector<vector<int>>& watches = solver.watches.watches;
+    const vector<vector<int>>& baseWatches = base.watches.watches;
+    if (watches.size() < baseWatches.size()) {
+        watches.resize(baseWatches.size());
+    }
+    copy(baseWatches.begin(), baseWatches.end(), watches.begin());
+    for (size_t i = baseWatches.size(); i < watches.size(); i++) {
+        watches[i].clear();
+    }
+    solver.vsids = base.vsids;
+    solver.clauseTainted = base.clauseTainted;
+    solver.formulaTaintedBinaries = base.formulaTaintedBinaries;
+    solver.taintedAddedBinaries.assignKeepingStorage(base.taintedAddedBinaries);
+    solver.rootTainted = base.rootTainted;
+    solver.rootConflict = base.rootConflict;
+    solver.limits = base.limits;
+    solver.totalConflicts = base.totalConflicts;
+    solver.totalDecisions = base.totalDecisions;
+}
+
+// clauses learned from the formula by earlier calls - they hold in this formula too, as it only adds constraints
+void ApproximateCounter::importSharedClauses(CDCLSolver& solver) {
+    if (!solver.tracksTaint() || solver.limits.sharedClauses->numVariables() > solver.numVars) {
+        return;
+    }
+    const LearnedClausePool& pool = *solver.limits.sharedClauses;
+    size_t available = pool.size();
+    uint64_t imported = 0;
+    vector<Literal>& lits = solver.learnedClause;    // not analysing a conflict at level 0
+    for (size_t i = 0; i < available; i++) {
+        if (pool.get(i, lits)) {
+            addClause(solver, lits, false);
+            imported++;
+        }
+    }
+    AMC_COUNT_N(Counter::SHARED_CLAUSES_IMPORTED, imported);
+}
+
+void ApproximateCounter::addVariables(CDCLSolver& solver, int count) {
+    solver.numVars += count;
+    solver.assignment.resize(solver.numVars, {-1, -1, -1});
+    solver.savedPhase.resize(solver.numVars, 1);
+    solver.seen.resize(solver.numVars, 0);
+    // watch lists past numVars may be left from an earlier cell (copySolver empties them) - they are only ever added to
+    if (solver.watches.watches.size() < 2 * static_cast<size_t>(solver.numVars)) {
+        solver.watches.watches.resize(2 * solver.numVars);
+    }
+    solver.addedBinaries.addVariables(count);
+    solver.taintedAddedBinaries.addVariables(count);
+    solver.vsids.scores.resize(solver.numVars, 0.0);
+    if (solver.tracksTaint()) {
+        solver.rootTainted.resize(solver.numVars, 1);
+    }
+}
+
+// clauses of two literals go to the arena too - the formula's implication graph is shared and stays as it is
+void ApproximateCounter::addClause(CDCLSolver& solver, vector<Literal>& lits, bool tainted) {
+    sort(lits.begin(), lits.end());
+    lits.erase(unique(lits.begin(), lits.end()), lits.end());
+    for (Literal lit : lits) {
+        if (binary_search(lits.begin(), lits.end(), -lit)) {
+            return;
+        }
+    }
+    
+    if (lits.empty()) {
+        solver.rootConflict = true;
+    } else if (lits.size() == 1) {
+        int value = solver.literalValue(lits[0]);
+        if (value == 0) {
+            solver.rootConflict = true;
+        } else if (value == -1) {
+            assign(solver, lits[0], -1);
+            if (solver.tracksTaint()) {
+                solver.rootTainted[abs(lits[0]) - 1] = tainted;
+            }
+        }
+    } else {
+        solver.addedClauses.add(lits.data(), lits.size());
+        solver.clauseTainted.push_back(tainted);
+        solver.watched.push_back(0);
+        solver.watched.push_back(1);
+        watchClause(solver, solver.numClauses() - 1);
+    }
+}
+
+// a fresh count of conflicts and restarts for every call - the limits are per call
+SolveStatus ApproximateCounter::solve(CDCLSolver& solver) {
+    AMC_TIME_PHASE(Phase::SAT_SOLVING);
+    AMC_COUNT(Counter::SOLVER_CALLS);
+    solver.totalConflicts = 0;
+    solver.totalDecisions = 0;
     int conflicts = 0;
     int restartThreshold = 100;
+    return cdclSolve(solver, conflicts, restartThreshold);
+}
+
+// a clause with fewer than two literals that are not false is unit or falsified - at level 0 that is
+// asserted (or recorded as rootConflict) here, propagation would only see it once one of its watches is assigned again
+void ApproximateCounter::watchClause(CDCLSolver& solver, int clauseIdx) {
+    const Literal* lits = solver.clauseLiterals(clauseIdx);
+    int size = solver.clauseSize(clauseIdx);
+    int* watched = &solver.watched[2 * clauseIdx];
+    int found = 0;
+    for (int k = 0; k < size && found < 2; k++) {
+        if (solver.literalValue(lits[k]) != 0) {
+            watched[found++] = k;
+        }
+    }
+    // fewer than two - fill up with false literals
+    for (int k = 0; k < size && found < 2; k++) {
+        if (solver.literalValue(lits[k]) == 0 && (found == 0 || watched[0] != k)) {
+            watched[found++] = k;
+        }
+    }
+    attachClause(solver, clauseIdx);
     
-    bool result = cdclSolve(formula, cdclAssignment, learnedClauses, watches, vsids, conflicts, restartThreshold);
-    
-    for (int i = 0; i < formula.numVariables; i++) {
-        assignment[i] = cdclAssignment[i].value;
+    int first = solver.literalValue(lits[watched[0]]);
+    if (solver.literalValue(lits[watched[1]]) != 0 || first == 1) {
+        return;
+    }
+    if (first == 0) {
+        solver.rootConflict = true;
+    } else {
+        assign(solver, lits[watched[0]], clauseIdx);
     }
+}
+
+void ApproximateCounter::attachClause(CDCLSolver& solver, int clauseIdx) {
+    const Literal* lits = solver.clauseLiterals(clauseIdx);
+    const int* watched = &solver.watched[2 * clauseIdx];
+    solver.watches.watches[solver.watches.litToIndex(lits[watched[0]], solver.numVars)].push_back(clauseIdx);
+    solver.watches.watches[solver.watches.litToIndex(lits[watched[1]], solver.numVars)].push_back(clauseIdx);
+}
+
+void ApproximateCounter::assign(CDCLSolver& solver, Literal lit, int antecedent) {
+    int var = abs(lit) - 1;
+    solver.assignment[var].value = (lit > 0) ? 1 : 0;
+    solver.assignment[var].decisionLevel = solver.decisionLevel();
+    solver.assignment[var].antecedent = antecedent;
+    solver.trail.push_back(var);
     
-    return result;
+    // a level 0 assignment is as tainted as its reason and the other level 0 literals in it
+    // (one without a reason counts as tainted - the caller clears it for a unit clause that is not)
+    if (solver.tracksTaint() && solver.decisionLevel() == 0) {
+        bool tainted = true;
+        if (antecedent >= 0) {
+            tainted = solver.clauseTainted[antecedent];
+            const Literal* lits = solver.clauseLiterals(antecedent);
+            for (int k = 0; k < solver.clauseSize(antecedent); k++) {
+                tainted = tainted || (lits[k] != lit && solver.rootTainted[abs(lits[k]) - 1]);
+            }
+        } else if (antecedent < -1) {
+            Literal other = CDCLSolver::binaryAntecedentLiteral(antecedent);
+            tainted = solver.binaryTainted(lit, other) || solver.rootTainted[abs(other) - 1];
+        }
+        solver.rootTainted[var] = tainted;
+    }
 }
 
-bool ApproximateCounter::cdclSolve(const CNFFormula& formula, vector<CDCLAssignment>& assignment, vector<Clause>& learnedClauses, WatchedLiterals& watches, VSIDSScores& vsids, int& conflicts, int& restartThreshold) {
-    int decisionLevel = 0;
-    vector<int> trail;        // stack of assigned variables in order of assignment
-    vector<int> trailLevels;  // index in trail where each decision level starts
-    trailLevels.push_back(0);
+void ApproximateCounter::backtrack(CDCLSolver& solver, int level) {
+    if (solver.decisionLevel() <= level) {
+        return;
+    }
+    size_t levelStart = solver.trailLevels[level + 1];
+    for (size_t i = levelStart; i < solver.trail.size(); i++) {
+        int var = solver.trail[i];
+        solver.savedPhase[var] = solver.assignment[var].value;
+        solver.assignment[var] = {-1, -1, -1};
+    }
+    solver.trail.resize(levelStart);
+    solver.trailLevels.resize(level + 1);
+    solver.binaryHead = min(solver.binaryHead, levelStart);
+    solver.propagationHead = min(solver.propagationHead, levelStart);
+}
+
+SolveStatus ApproximateCounter::cdclSolve(CDCLSolver& solver, int& conflicts, int& restartThreshold) {
+    if (solver.rootConflict) {
+        return SolveStatus::UNSATISFIABLE;
+    }
     
+    vector<Literal>& learnedClause = solver.learnedClause;
     while (true) {
         // 1. Propagation
         int conflictClause = -1;
-        if (!propagate(formula, learnedClauses, assignment, watches, decisionLevel, conflictClause)) {
+        if (!propagate(solver, conflictClause)) {
             // Conflict occurred
-            if (decisionLevel == 0) {
-                return false;  // UNSAT at root level
+            conflicts++;
+            solver.totalConflicts++;
+            AMC_COUNT(Counter::CONFLICTS);
+            if (solver.decisionLevel() == 0) {
+                return SolveStatus::UNSATISFIABLE;  // UNSAT at root level
+            }
+            if (solver.limits.maxConflicts > 0 && solver.totalConflicts > solver.limits.maxConflicts) {
+                return SolveStatus::UNKNOWN;
+            }
+            // polled, not checked on every conflict - reading the clock would show up in the profile
+            if (solver.limits.cancel != nullptr && (solver.totalConflicts & 63) == 0 && solver.limits.cancel->isCancelled()) {
+                return SolveStatus::UNKNOWN;
             }
             
-            // analyze conflict and learn clause
-            Clause learnedClause;
+            // analyze conflict and learn clause - learnedClause[0] is the literal it asserts
             int backtrackLevel = 0;
-            analyzeConflict(formula, learnedClauses, assignment, conflictClause, learnedClause, backtrackLevel, vsids);
+            bool learnedTainted = false;
+            analyzeConflict(solver, conflictClause, learnedClause, backtrackLevel, learnedTainted);
+            backtrack(solver, backtrackLevel);
             
-            // backtrack to appropriate level BEFORE adding learned clause
-            while (decisionLevel > backtrackLevel) {
-                int levelStart = trailLevels[decisionLevel];
-                for (int i = trail.size() - 1; i >= levelStart; i--) {
-                    assignment[trail[i]].value = -1;
-                    assignment[trail[i]].decisionLevel = -1;
-                    assignment[trail[i]].antecedent = -1;
+            if (learnedClause.size() == 1) {
+                assign(solver, learnedClause[0], -1);
+                if (solver.tracksTaint()) {
+                    solver.rootTainted[abs(learnedClause[0]) - 1] = learnedTainted;
                 }
-                trail.resize(levelStart);
-                trailLevels.pop_back();
-                decisionLevel--;
-            }
-            
-            // Now add and propagate the learned clause
-            learnedClauses.push_back(learnedClause);
-            int learnedIdx = formula.clauses.size() + learnedClauses.size() - 1;
-            
-            // Set up watches for learned clause
-            if (learnedClause.literals.size() >= 2) {
-                int lit0 = learnedClause.literals[0];
-                int lit1 = learnedClause.literals[1];
-                int idx0 = watches.litToIndex(lit0, formula.numVariables);
-                int idx1 = watches.litToIndex(lit1, formula.numVariables);
-                watches.watches[idx0].push_back(learnedIdx);
-                watches.watches[idx1].push_back(learnedIdx);
-            } else if (learnedClause.literals.size() == 1) {
-                // Unit clause - propagate immediately
-                Literal lit = learnedClause.literals[0];
-                int var = abs(lit) - 1;
-                if (var >= 0 && var < formula.numVariables && assignment[var].value == -1) {
-                    assignment[var].value = (lit > 0) ? 1 : 0;
-                    assignment[var].decisionLevel = decisionLevel;
-                    assignment[var].antecedent = learnedIdx;
-                    trail.push_back(var);
+            } else if (learnedClause.size() == 2) {
+                solver.addedBinaries.addClause(learnedClause[0], learnedClause[1]);
+                if (solver.tracksTaint() && learnedTainted) {
+                    solver.taintedAddedBinaries.addClause(learnedClause[0], learnedClause[1]);
                 }
+                assign(solver, learnedClause[0], CDCLSolver::binaryAntecedent(learnedClause[1]));
+            } else {
+                // watched on the asserting literal and the one of the level backtracked to
+                solver.addedClauses.add(learnedClause.data(), learnedClause.size());
+                solver.clauseTainted.push_back(learnedTainted);
+                solver.watched.push_back(0);
+                solver.watched.push_back(1);
+                int learnedIdx = solver.numClauses() - 1;
+                attachClause(solver, learnedIdx);
+                assign(solver, learnedClause[0], learnedIdx);
             }
-            
-            conflicts++;
-            vsids.decayAll();
+            // learned from the formula alone - every later call of the run can use it
+            if (solver.tracksTaint() && !learnedTainted && solver.limits.sharedClauses->add(learnedClause.data(), learnedClause.size())) {
+                AMC_COUNT(Counter::SHARED_CLAUSES_EXPORTED);
+            }
+            solver.vsids.decayAll();
             
             // restart if too many conflicts
             if (conflicts >= restartThreshold) {
-                for (int i = 0; i < formula.numVariables; i++) {
-                    if (assignment[i].decisionLevel > 0) {
-                        assignment[i].value = -1;
-                        assignment[i].decisionLevel = -1;
-                        assignment[i].antecedent = -1;
-                    }
-                }
-                trail.clear();
-                trailLevels.clear();
-                trailLevels.push_back(0);
-                decisionLevel = 0;
+                AMC_COUNT(Counter::RESTARTS);
+                AMC_TRACE_INSTANT("restart", "solver");
+                backtrack(solver, 0);
                 conflicts = 0;
                 restartThreshold = (int)(restartThreshold * 1.5);
             }
@@ -316,313 +1282,222 @@ bool ApproximateCounter::cdclSolve(const CNFFormula& formula, vector<CDCLAssignm
             continue;
         }
         
-        // 2. Check if all variables assigned
-        int unassignedVar = -1;
-        for (int i = 0; i < formula.numVariables; i++) {
-            if (assignment[i].value == -1) {
-                unassignedVar = i;
-                break;
-            }
-        }
-        
-        // all variables assigned and no conflict -> SAT
-        if (unassignedVar == -1) {
-            return true;
-        }
-        
-        // 3. Decision - pick unassigned variable with highest VSIDS score
-        int decisionVar = vsids.selectUnassigned(assignment);
+        // 2. Decision - pick unassigned variable with highest VSIDS score
+        // (none left and no conflict -> SAT)
+        int decisionVar = solver.vsids.selectUnassigned(solver.assignment);
         if (decisionVar == -1) {
-            return true;
+            return SolveStatus::SATISFIABLE;
         }
         
-        int decisionValue = 1;
-        decisionLevel++;
-        trailLevels.push_back(trail.size());
-        
-        assignment[decisionVar].value = decisionValue;
-        assignment[decisionVar].decisionLevel = decisionLevel;
-        assignment[decisionVar].antecedent = -1;
-        trail.push_back(decisionVar);
+        solver.totalDecisions++;
+        if (solver.limits.cancel != nullptr && (solver.totalDecisions & 1023) == 0 && solver.limits.cancel->isCancelled()) {
+            return SolveStatus::UNKNOWN;
+        }
+        AMC_COUNT(Counter::DECISIONS);
+        solver.trailLevels.push_back(solver.trail.size());
+        assign(solver, solver.savedPhase[decisionVar] == 1 ? decisionVar + 1 : -(decisionVar + 1), -1);
     }
 }
 
-// propagate to deduce new assignments
-bool ApproximateCounter::propagate(const CNFFormula& formula, const vector<Clause>& learnedClauses, vector<CDCLAssignment>& assignment, WatchedLiterals& watches, int currentLevel, int& conflictClause) {
-    vector<int> propagationQueue;
+// propagate every assignment on the trail that has not been propagated yet
+// binary implications go first - every pending one is done before the next long-clause watch list is visited
+bool ApproximateCounter::propagate(CDCLSolver& solver, int& conflictClause) {
+#ifdef AMC_ENABLE_STATS
+    size_t start = solver.propagationHead;
+#endif
+    uint64_t binaryImplied = 0;
+    conflictClause = -1;
     
-    // find all assigned variables at or below current level that haven't been propagated
-    // (assignments at current level definitely need propagation)
-    for (int i = 0; i < formula.numVariables; i++) {
-        if (assignment[i].value != -1 && assignment[i].decisionLevel == currentLevel) {
-            propagationQueue.push_back(i);
-        }
-    }
-    
-    // If queue is empty (e.g., after backtracking), check for unit clauses
-    if (propagationQueue.empty()) {
-        // Scan all clauses for unit clauses
-        auto checkForUnitClauses = [&](const vector<Clause>& clauses, int offset) {
-            for (size_t ci = 0; ci < clauses.size(); ci++) {
-                const Clause& clause = clauses[ci];
-                int unassignedLit = 0;
-                int unassignedCount = 0;
-                bool satisfied = false;
-                
-                for (Literal lit : clause.literals) {
-                    int var = abs(lit) - 1;
-                    if (var < 0 || var >= formula.numVariables) continue;
-                    
-                    if (assignment[var].value == -1) {
-                        unassignedLit = lit;
-                        unassignedCount++;
-                    } else {
-                        bool litVal = (lit > 0) ? (assignment[var].value == 1) : (assignment[var].value == 0);
-                        if (litVal) {
-                            satisfied = true;
-                            break;
-                        }
-                    }
+    while (conflictClause == -1) {
+        if (solver.binaryHead < solver.trail.size()) {
+            int var = solver.trail[solver.binaryHead++];
+            Literal trueLit = (solver.assignment[var].value == 1) ? (var + 1) : (-(var + 1));
+            // the formula's binaries (auxiliary variables of a cell have none), then the ones added since
+            const ImplicationGraph* graphs[] = {var < solver.formulaBinaries->numVariables() ? solver.formulaBinaries.get() : nullptr,
+                                                &solver.addedBinaries};
+            for (const ImplicationGraph* graph : graphs) {
+                if (graph == nullptr || conflictClause != -1) {
+                    continue;
                 }
-                
-                if (!satisfied && unassignedCount == 1 && unassignedLit != 0) {
-                    // Found unit clause - assign it
-                    int var = abs(unassignedLit) - 1;
-                    if (var >= 0 && var < formula.numVariables) {
-                        assignment[var].value = (unassignedLit > 0) ? 1 : 0;
-                        assignment[var].decisionLevel = currentLevel;
-                        assignment[var].antecedent = offset + ci;
-                        propagationQueue.push_back(var);
+                for (Literal implied : graph->implied(trueLit)) {
+                    int value = solver.literalValue(implied);
+                    if (value == 1) {
+                        continue;
+                    }
+                    if (value == 0) {
+                        solver.binaryConflict[0] = implied;
+                        solver.binaryConflict[1] = -trueLit;
+                        conflictClause = CDCLSolver::BINARY_CONFLICT;
+                        break;
                     }
-                } else if (!satisfied && unassignedCount == 0) {
-                    // Conflict
-                    conflictClause = offset + ci;
-                    return false;
+                    assign(solver, implied, CDCLSolver::binaryAntecedent(-trueLit));
+                    binaryImplied++;
                 }
             }
-            return true;
-        };
-        
-        if (!checkForUnitClauses(formula.clauses, 0)) return false;
-        if (!checkForUnitClauses(learnedClauses, formula.clauses.size())) return false;
-    }
-    
-    size_t queuePos = 0;
-    while (queuePos < propagationQueue.size()) {
-        int var = propagationQueue[queuePos++];
-        
-        // Bounds check
-        if (var < 0 || var >= assignment.size() || var >= formula.numVariables) {
             continue;
         }
-        
-        int value = assignment[var].value;
+        if (solver.propagationHead >= solver.trail.size()) {
+            break;
+        }
+        int var = solver.trail[solver.propagationHead++];
         
         // get the literal that is now false due to this assignment
-        Literal falseLit = (value == 1) ? (-(var + 1)) : (var + 1);
-        int watchIdx = watches.litToIndex(falseLit, formula.numVariables);
+        Literal falseLit = (solver.assignment[var].value == 1) ? (-(var + 1)) : (var + 1);
+        vector<int>& watchList = solver.watches.watches[solver.watches.litToIndex(falseLit, solver.numVars)];
         
-        // check clauses with this literal
-        auto& watchList = watches.watches[watchIdx];
+        // clauses that found a new watch are dropped from this list (kept entries are compacted to the front)
+        size_t kept = 0;
         size_t i = 0;
-        while (i < watchList.size()) {
+        for (; i < watchList.size(); i++) {
             int clauseIdx = watchList[i];
+            // the literals may be shared with other solvers - the watched positions are this solver's own
+            const Literal* lits = solver.clauseLiterals(clauseIdx);
+            int size = solver.clauseSize(clauseIdx);
+            int* watched = &solver.watched[2 * clauseIdx];
             
-            // update watch and check for conflict or propagation
-            if (!updateWatch(formula, learnedClauses, clauseIdx, falseLit, assignment, watches, currentLevel, conflictClause)) {
-                if (conflictClause != -1) {
-                    return false;  // Conflict
-                }
-                // add to queue to propagate
-                for (int j = 0; j < formula.numVariables; j++) {
-                    if (assignment[j].value != -1 && assignment[j].decisionLevel == currentLevel && 
-                        assignment[j].antecedent == clauseIdx) {
-                        bool alreadyInQueue = false;
-                        for (int k = queuePos; k < propagationQueue.size(); k++) {
-                            if (propagationQueue[k] == j) {
-                                alreadyInQueue = true;
-                                break;
-                            }
-                        }
-                        if (!alreadyInQueue) {
-                            propagationQueue.push_back(j);
-                        }
-                    }
+            // keep the false literal in watched[1]
+            if (lits[watched[0]] == falseLit) {
+                swap(watched[0], watched[1]);
+            }
+            
+            // already satisfied by the other watch
+            if (solver.literalValue(lits[watched[0]]) == 1) {
+                watchList[kept++] = clauseIdx;
+                continue;
+            }
+            
+            // look for a literal that is not false to watch instead
+            bool moved = false;
+            for (int k = 0; k < size; k++) {
+                if (k != watched[0] && k != watched[1] && solver.literalValue(lits[k]) != 0) {
+                    watched[1] = k;
+                    solver.watches.watches[solver.watches.litToIndex(lits[k], solver.numVars)].push_back(clauseIdx);
+                    moved = true;
+                    break;
                 }
             }
+            if (moved) {
+                continue;
+            }
             
-            // check if watch was removed
-            if (i < watchList.size() && watchList[i] == clauseIdx) {
+            // clause is unit or conflicting
+            watchList[kept++] = clauseIdx;
+            if (solver.literalValue(lits[watched[0]]) == 0) {
+                conflictClause = clauseIdx;
                 i++;
+                break;
             }
+            assign(solver, lits[watched[0]], clauseIdx);
+        }
+        
+        // keep the watches not visited because of a conflict
+        for (; i < watchList.size(); i++) {
+            watchList[kept++] = watchList[i];
         }
+        watchList.resize(kept);
     }
     
-    return true;
+    AMC_COUNT_N(Counter::PROPAGATIONS, solver.propagationHead - start);
+    AMC_COUNT_N(Counter::BINARY_PROPAGATIONS, binaryImplied);
+    return conflictClause == -1;
 }
 
-bool ApproximateCounter::updateWatch(const CNFFormula& formula, const vector<Clause>& learnedClauses, int clauseIdx, Literal falseLit, vector<CDCLAssignment>& assignment, WatchedLiterals& watches, int currentLevel, int& conflictClause) {
-    // get clause
-    const Clause* clause = nullptr;
-    if (clauseIdx < formula.clauses.size()) {
-        clause = &formula.clauses[clauseIdx];
-    } else {
-        clause = &learnedClauses[clauseIdx - formula.clauses.size()];
-    }
+// first-UIP conflict analysis - resolve the conflict clause with antecedents until one literal of the current level is left
+// tainted collects the taint of every clause resolved with and of every level 0 literal left out
+void ApproximateCounter::analyzeConflict(CDCLSolver& solver, int conflictClause, vector<Literal>& learnedClause, int& backtrackLevel, bool& tainted) {
+    int currentLevel = solver.decisionLevel();
+    bool trackTaint = solver.tracksTaint();
+    tainted = false;
+    learnedClause.assign(1, 0);  // slot for the asserting literal
     
-    // find the two watched literals
-    Literal watch1 = 0, watch2 = 0;
-    int watch1Pos = -1, watch2Pos = -1;
+    int pathCount = 0;
+    int uipVar = -1;
+    int trailIdx = solver.trail.size() - 1;
+    int clauseIdx = conflictClause;
     
-    for (size_t i = 0; i < clause->literals.size(); i++) {
-        Literal lit = clause->literals[i];
-        int var = abs(lit) - 1;
-        
-        if (var >= formula.numVariables) continue;
-        
-        // check if this literal is watched
-        int litIdx = watches.litToIndex(lit, formula.numVariables);
-        bool isWatched = false;
-        for (int cidx : watches.watches[litIdx]) {
-            if (cidx == clauseIdx) {
-                isWatched = true;
-                break;
-            }
+    do {
+        // the clause to resolve with - binary ones are rebuilt from the implication that used them
+        const Literal* lits;
+        size_t size;
+        if (clauseIdx >= 0) {
+            lits = solver.clauseLiterals(clauseIdx);
+            size = solver.clauseSize(clauseIdx);
+        } else if (uipVar == -1) {
+            lits = solver.binaryConflict;
+            size = 2;
+        } else {
+            solver.binaryReason[0] = (solver.assignment[uipVar].value == 1) ? (uipVar + 1) : -(uipVar + 1);
+            solver.binaryReason[1] = CDCLSolver::binaryAntecedentLiteral(clauseIdx);
+            lits = solver.binaryReason;
+            size = 2;
         }
-        
-        if (isWatched) {
-            if (watch1 == 0) {
-                watch1 = lit;
-                watch1Pos = i;
+        if (trackTaint && !tainted) {
+            tainted = (clauseIdx >= 0) ? solver.clauseTainted[clauseIdx] : solver.binaryTainted(lits[0], lits[1]);
+        }
+        // the literal the antecedent implied is already resolved on
+        for (size_t j = 0; j < size; j++) {
+            int var = abs(lits[j]) - 1;
+            if (var == uipVar) {
+                continue;
+            }
+            if (solver.assignment[var].decisionLevel == 0) {
+                tainted = tainted || (trackTaint && solver.rootTainted[var]);
+                continue;
+            }
+            if (solver.seen[var]) {
+                continue;
+            }
+            solver.seen[var] = 1;
+            solver.vsids.bump(var);
+            if (solver.assignment[var].decisionLevel >= currentLevel) {
+                pathCount++;
             } else {
-                watch2 = lit;
-                watch2Pos = i;
-                break;
+                learnedClause.push_back(lits[j]);
             }
         }
-    }
-    
-    if (watch1 != falseLit && watch2 != falseLit) {
-        return true;
-    }
-    
-    // find a new watch
-    for (size_t i = 0; i < clause->literals.size(); i++) {
-        if (i == watch1Pos || i == watch2Pos) continue;
-        
-        Literal lit = clause->literals[i];
-        int var = abs(lit) - 1;
-        if (var < 0 || var >= formula.numVariables || var >= assignment.size()) continue;
         
-        // check if this literal is not false
-        bool isUnassigned = (assignment[var].value == -1);
-        bool isSatisfied = false;
-        if (!isUnassigned) {
-            isSatisfied = (lit > 0) ? (assignment[var].value == 1) : (assignment[var].value == 0);
-        }
-        
-        if (isUnassigned || isSatisfied) {
-            // found a new watch -> remove old watch and add new watch
-            int oldIdx = watches.litToIndex(falseLit, formula.numVariables);
-            auto& oldList = watches.watches[oldIdx];
-            for (auto it = oldList.begin(); it != oldList.end(); ++it) {
-                if (*it == clauseIdx) {
-                    oldList.erase(it);
-                    break;
-                }
-            }
-            int newIdx = watches.litToIndex(lit, formula.numVariables);
-            watches.watches[newIdx].push_back(clauseIdx);
-            return true;
+        // next literal of the current level on the trail that is part of the resolvent
+        while (!solver.seen[solver.trail[trailIdx]]) {
+            trailIdx--;
         }
-    }
-    
-    // no new watch found, check if other watch is satisfied or if we have a conflict
-    Literal otherWatch = (watch1 == falseLit) ? watch2 : watch1;
-    int otherVar = abs(otherWatch) - 1;
+        uipVar = solver.trail[trailIdx--];
+        solver.seen[uipVar] = 0;
+        clauseIdx = solver.assignment[uipVar].antecedent;
+        pathCount--;
+    } while (pathCount > 0);
     
-    if (otherVar < 0 || otherVar >= formula.numVariables || otherVar >= assignment.size()) {
-        conflictClause = clauseIdx;
-        return false;
-    }
+    learnedClause[0] = (solver.assignment[uipVar].value == 1) ? -(uipVar + 1) : (uipVar + 1);
     
-    // Check if the other watch is satisfied
-    bool otherSatisfied = false;
-    if (assignment[otherVar].value != -1) {
-        otherSatisfied = (otherWatch > 0) ? (assignment[otherVar].value == 1) : (assignment[otherVar].value == 0);
+    // backtrack to the second highest level - its literal becomes the second watch
+    backtrackLevel = 0;
+    for (size_t j = 1; j < learnedClause.size(); j++) {
+        int level = solver.assignment[abs(learnedClause[j]) - 1].decisionLevel;
+        if (level > backtrackLevel) {
+            backtrackLevel = level;
+            swap(learnedClause[1], learnedClause[j]);
+        }
     }
     
-    if (assignment[otherVar].value == -1) {
-        // propagate
-        assignment[otherVar].value = (otherWatch > 0) ? 1 : 0;
-        assignment[otherVar].decisionLevel = currentLevel;
-        assignment[otherVar].antecedent = clauseIdx;
-        return false;
-    } else if (otherSatisfied) {
-        return true; // clause satisfied
-    } else {
-        conflictClause = clauseIdx;
-        return false; // conflict
+    for (size_t j = 1; j < learnedClause.size(); j++) {
+        solver.seen[abs(learnedClause[j]) - 1] = 0;
     }
 }
 
-void ApproximateCounter::analyzeConflict(const CNFFormula& formula, const vector<Clause>& learnedClauses, const vector<CDCLAssignment>& assignment, int conflictClause, Clause& learnedClause, int& backtrackLevel, VSIDSScores& vsids) {
-    const Clause* clause = nullptr;
-    if (conflictClause < formula.clauses.size()) {
-        clause = &formula.clauses[conflictClause];
-    } else {
-        clause = &learnedClauses[conflictClause - formula.clauses.size()];
-    }
-    
-    // find highest decision level in the conflict clause
-    int conflictLevel = 0;
-    for (Literal lit : clause->literals) {
-        int var = abs(lit) - 1;
-        if (var < formula.numVariables && assignment[var].decisionLevel > conflictLevel) {
-            conflictLevel = assignment[var].decisionLevel;
-        }
+// the formula loaded and propagated at level 0 - read-only from here on, so any number of threads can copy it
+SolverSnapshot::SolverSnapshot(const CNFFormula& formula, LearnedClausePool* sharedClauses) : source(&formula) {
+    base.limits.sharedClauses = sharedClauses;
+    ApproximateCounter::loadFormula(base, formula, vector<int>());
+    int conflictClause;
+    if (!base.rootConflict && !ApproximateCounter::propagate(base, conflictClause)) {
+        base.rootConflict = true;
     }
-    
-    // learn conflict
-    learnedClause.literals = clause->literals;
-    for (Literal lit : learnedClause.literals) {
-        int var = abs(lit) - 1;
-        if (var < formula.numVariables) {
-            vsids.bump(var);
-        }
-    }
-    
-    // find backtrack level
-    vector<int> levels;
-    for (Literal lit : learnedClause.literals) {
-        int var = abs(lit) - 1;
-        if (var < formula.numVariables) {
-            int level = assignment[var].decisionLevel;
-            if (level >= 0 && find(levels.begin(), levels.end(), level) == levels.end()) {
-                levels.push_back(level);
-            }
-        }
-    }
-    
-    sort(levels.begin(), levels.end());
-    backtrackLevel = (levels.size() > 1) ? levels[levels.size() - 2] : 0;
 }
 
-void ApproximateCounter::initWatches(const CNFFormula& formula, const vector<Clause>& learnedClauses, WatchedLiterals& watches, int numVars) {
-    // two watches per clause
-    for (size_t i = 0; i < formula.clauses.size(); i++) {
-        const Clause& clause = formula.clauses[i];
-        if (clause.literals.size() >= 2) {
-            Literal lit0 = clause.literals[0];
-            Literal lit1 = clause.literals[1];
-            int idx0 = watches.litToIndex(lit0, numVars);
-            int idx1 = watches.litToIndex(lit1, numVars);
-            watches.watches[idx0].push_back(i);
-            watches.watches[idx1].push_back(i);
-        } else if (clause.literals.size() == 1) {
-            Literal lit0 = clause.literals[0];
-            int idx0 = watches.litToIndex(lit0, numVars);
-            watches.watches[idx0].push_back(i);
-        }
-    }
+PreparedFormula::PreparedFormula() {}
+
+PreparedFormula::~PreparedFormula() {}
+
+TrialWorkspace& TrialWorkspace::local() {
+    thread_local TrialWorkspace workspace;
+    return workspace;
 }
@@ -0,0 +1,194 @@
+// Source file for batch counting
+
+#include "solver/batch_counter.h"
+#include "cnf/cnf_parser.h"
+#include "utils/logger.h"
+#include "utils/thread_pool.h"
+#include "utils/timer.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+void writeEscaped(ostringstream& out, const string& text) {
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            out << '\\';
+            out << ch;
+        } else if (ch == '\n') {
+            out << "\\n";
+        } else {
+            out << ch;
+        }
+    }
+}
+
+// log2 values as JSON - -infinity (no models) has no JSON literal
+string jsonLog2(double value) {
+    if (!isfinite(value)) {
+        return "null";
+    }
+    ostringstream out;
+    out << setprecision(10) << value;
+    return out.str();
+}
+
+// CSV field in quotes - embedded quotes are doubled
+string csvQuoted(const string& text) {
+    string quoted = "\"";
+    for (char ch : text) {
+        quoted += ch;
+        if (ch == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+string estimateString(const ApproximationResult& result) {
+    return (result.estimatedCount != UINT64_MAX) ? to_string(result.estimatedCount) : ModelCount::formatLog2(result.log2Estimate);
+}
+
+}
+
+int BatchCounter::run(const vector<string>& paths, const CountingOptions& options, ThreadPool& pool, const ResultCallback& onResult) {
+    CountingOptions shared = options;
+    shared.pool = &pool;
+
+    mutex resultMutex;
+    condition_variable finished;
+    size_t inFlight = 0;
+    int failures = 0;
+    size_t window = max(1, pool.size());
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        {
+            unique_lock<mutex> lock(resultMutex);
+            finished.wait(lock, [&]() { return inFlight < window; });
+            inFlight++;
+        }
+        pool.submit([&, i]() {
+            BatchResult result = countFile(i, paths[i], shared);
+            {
+                lock_guard<mutex> lock(resultMutex);
+                if (!result.ok) {
+                    failures++;
+                }
+                onResult(result);
+                inFlight--;
+            }
+            finished.notify_all();
+        });
+    }
+
+    unique_lock<mutex> lock(resultMutex);
+    finished.wait(lock, [&]() { return inFlight == 0; });
+    return failures;
+}
+
+BatchResult BatchCounter::countFile(size_t index, const string& path, const CountingOptions& options) {
+    BatchResult batchResult;
+    batchResult.index = index;
+    batchResult.path = path;
+    Timer timer;
+    try {
+        auto formula = CNFParser::parseFile(path);
+        batchResult.numVariables = formula->getNumVariables();
+        batchResult.numClauses = formula->getNumClauses();
+        batchResult.result = ApproximateCounter::approximateCount(*formula, options);
+        batchResult.ok = true;
+    } catch (const exception& e) {
+        batchResult.error = e.what();
+        LOG_WARNING(path << ": " << e.what());
+    }
+    batchResult.seconds = timer.elapsedSeconds();
+    LOG_INFO(path << " done in " << batchResult.seconds << " s");
+    return batchResult;
+}
+
+string BatchCounter::toText(const BatchResult& r) {
+    ostringstream out;
+    out << r.path << ": ";
+    if (!r.ok) {
+        out << "error - " << r.error;
+        return out.str();
+    }
+    const ApproximationResult& result = r.result;
+    out << estimateString(result);
+    if (result.exact) {
+        out << " (exact)";
+    } else {
+        out << " (log2 " << fixed << setprecision(3) << result.log2Estimate << ", " << result.successfulTrials << "/" << result.totalTrials << " trials";
+        if (result.earlyStopped) {
+            out << ", stopped early";
+        }
+        if (result.timedOut) {
+            out << ", timed out";
+        } else if (result.cancelled) {
+            out << ", cancelled";
+        }
+        if (result.abortedTrials > 0) {
+            out << ", " << result.abortedTrials << " aborted";
+        }
+        out << ")";
+    }
+    out << fixed << setprecision(3) << " in " << r.seconds << " s";
+    return out.str();
+}
+
+string BatchCounter::toJSON(const BatchResult& r) {
+    const ApproximationResult& result = r.result;
+    ostringstream out;
+    out << "{\"index\": " << r.index << ", \"file\": \"";
+    writeEscaped(out, r.path);
+    out << "\", \"ok\": " << (r.ok ? "true" : "false");
+    if (!r.ok) {
+        out << ", \"error\": \"";
+        writeEscaped(out, r.error);
+        out << "\"}";
+        return out.str();
+    }
+    out << ", \"variables\": " << r.numVariables << ", \"clauses\": " << r.numClauses
+        << ", \"estimate\": \"" << estimateString(result) << "\", \"log2_estimate\": " << jsonLog2(result.log2Estimate)
+        << ", \"exact\": " << (result.exact ? "true" : "false");
+    if (result.interval.valid) {
+        out << ", \"log2_lower\": " << jsonLog2(result.interval.log2Lower) << ", \"log2_upper\": " << jsonLog2(result.interval.log2Upper)
+            << ", \"confidence\": " << result.interval.confidence;
+    }
+    out << ", \"trials\": " << result.totalTrials << ", \"successful_trials\": " << result.successfulTrials
+        << ", \"early_stopped\": " << (result.earlyStopped ? "true" : "false")
+        << ", \"timed_out\": " << (result.timedOut ? "true" : "false")
+        << ", \"partial\": " << (result.partial ? "true" : "false") << ", \"aborted_trials\": " << result.abortedTrials
+        << ", \"seconds\": " << setprecision(6) << r.seconds << "}";
+    return out.str();
+}
+
+string BatchCounter::csvHeader() {
+    return "index,file,ok,variables,clauses,estimate,log2_estimate,exact,log2_lower,log2_upper,trials,successful_trials,early_stopped,timed_out,partial,aborted_trials,seconds,error";
+}
+
+string BatchCounter::toCSV(const BatchResult& r) {
+    const ApproximationResult& result = r.result;
+    ostringstream out;
+    out << r.index << "," << csvQuoted(r.path) << "," << (r.ok ? 1 : 0) << ",";
+    if (r.ok) {
+        out << r.numVariables << "," << r.numClauses << "," << estimateString(result) << "," << setprecision(10) << result.log2Estimate << ","
+            << (result.exact ? 1 : 0) << ",";
+        if (result.interval.valid) {
+            out << result.interval.log2Lower << "," << result.interval.log2Upper;
+        } else {
+            out << ",";
+        }
+        out << "," << result.totalTrials << "," << result.successfulTrials << "," << (result.earlyStopped ? 1 : 0) << ","
+            << (result.timedOut ? 1 : 0) << "," << (result.partial ? 1 : 0) << "," << result.abortedTrials << "," << setprecision(6) << r.seconds << ",";
+    } else {
+        out << ",,,,,,,,,,,,," << setprecision(6) << r.seconds << "," << csvQuoted(r.error);
+    }
+    return out.str();
+}
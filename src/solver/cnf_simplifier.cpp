@@ -1,6 +1,8 @@
 // Source file for CNF simplification
 
 #include "solver/cnf_simplifier.h"
+#include "utils/timer.h"
+#include "utils/reusable_storage.h"
 #include <iostream>
 #include <cmath>
 
@@ -48,6 +50,7 @@ bool CNFSimplifier::isLiteralFalsified(Literal lit, const unordered_map<int, int
 
 // apply partial assignment to CNF formula
 SimplificationResult CNFSimplifier::applyAssignment(const CNFFormula& formula, const unordered_map<int, int>& assignment) {
+    AMC_TIME_PHASE(Phase::SIMPLIFICATION);
     SimplificationResult result;
     result.simplified = CNFFormula(formula.numVariables, 0);
     
@@ -98,12 +101,121 @@ SimplificationResult CNFSimplifier::applyAssignment(const CNFFormula& formula, c
 
 // apply XOR solution to simplify CNF formula
 SimplificationResult CNFSimplifier::applyXORSolution(const CNFFormula& formula, const XORSolutionResult& xorSolution) {
+    SimplificationResult result;
+    SimplificationBuffers buffers;
+    applyXORSolution(formula, xorSolution, result, buffers);
+    return result;
+}
+
+void CNFSimplifier::applyXORSolution(const CNFFormula& formula, const XORSolutionResult& xorSolution, SimplificationResult& result,
+                                     SimplificationBuffers& buffers) {
+    AMC_TIME_PHASE(Phase::SIMPLIFICATION);
+    result.isUnsatisfiable = false;
+    result.isTriviallyTrue = false;
+    result.clausesRemoved = 0;
+    result.literalsRemoved = 0;
+    result.auxiliaryVariables = 0;
+    CNFFormula& simplified = result.simplified;
+    simplified.numVariables = formula.numVariables;
+    resizeReusing(simplified.clauses, 0, buffers.spare);
+    
     if (!xorSolution.satisfiable) {
-        SimplificationResult result;
         result.isUnsatisfiable = true; // XOR system is unsatisfiable, so formula is unsatisfiable
-        return result;
+        simplified.numClauses = 0;
+        return;
     }
     
-    // apply the XOR assignment to the CNF
-    return applyAssignment(formula, xorSolution.assignment);
+    // apply the XOR assignment to the CNF, as applyAssignment does
+    vector<int>& values = buffers.values;
+    values.assign(formula.numVariables + 1, -1);
+    for (const auto& entry : xorSolution.assignment) {
+        values[entry.first] = entry.second;
+    }
+    for (const auto& clause : formula.clauses) {
+        Clause& kept = appendReusing(simplified.clauses, buffers.spare);
+        kept.literals.clear();
+        bool clauseSatisfied = false;
+        for (Literal lit : clause.literals) {
+            int value = values[abs(lit)];
+            if (value == -1) {
+                kept.addLiteral(lit);
+            } else if ((value == 1) == (lit > 0)) {
+                clauseSatisfied = true;
+                break;
+            } else {
+                result.literalsRemoved++;
+            }
+        }
+        
+        if (clauseSatisfied) {
+            result.clausesRemoved++;
+            resizeReusing(simplified.clauses, simplified.clauses.size() - 1, buffers.spare);
+        } else if (kept.empty()) {
+            result.isUnsatisfiable = true; // empty clause is unsatisfiable
+            simplified.numClauses = simplified.clauses.size();
+            return;
+        }
+    }
+    
+    // fixed variables no longer appear in any clause - pin them so they are not counted twice
+    for (const auto& entry : xorSolution.assignment) {
+        Clause& unit = appendReusing(simplified.clauses, buffers.spare);
+        unit.literals.assign(1, entry.second == 1 ? entry.first : -entry.first);
+    }
+    
+    // rows that still involve free variables become part of the cell
+    for (const auto& constraint : xorSolution.constraints) {
+        result.auxiliaryVariables += encodeXOR(simplified, constraint, buffers.spare);
+    }
+    
+    simplified.numClauses = simplified.clauses.size();
+    result.isTriviallyTrue = simplified.clauses.empty();
+}
+
+int CNFSimplifier::encodeXOR(CNFFormula& formula, const XORConstraint& constraint) {
+    vector<Clause> spare;
+    return encodeXOR(formula, constraint, spare);
+}
+
+int CNFSimplifier::encodeXOR(CNFFormula& formula, const XORConstraint& constraint, vector<Clause>& spare) {
+    auto addClause = [&formula, &spare](initializer_list<Literal> literals) {
+        appendReusing(formula.clauses, spare).literals.assign(literals);
+    };
+    const vector<int>& vars = constraint.variables;
+    int k = vars.size();
+    if (k == 0) {
+        if (constraint.value) {
+            addClause({});  // 0 = 1
+        }
+        return 0;
+    }
+    if (k == 1) {
+        addClause({constraint.value ? vars[0] : -vars[0]});
+        return 0;
+    }
+    
+    // a(1) = x1 ^ x2, a(j) = a(j-1) ^ x(j+1), then a(k-2) ^ xk = value
+    int added = 0;
+    int last = vars[0];
+    for (int j = 1; j + 1 < k; j++) {
+        int x = last;
+        int y = vars[j];
+        int a = ++formula.numVariables;
+        added++;
+        addClause({-a, x, y});
+        addClause({-a, -x, -y});
+        addClause({a, -x, y});
+        addClause({a, x, -y});
+        last = a;
+    }
+    
+    int y = vars[k - 1];
+    if (constraint.value) {
+        addClause({last, y});
+        addClause({-last, -y});
+    } else {
+        addClause({last, -y});
+        addClause({-last, y});
+    }
+    return added;
 }
@@ -0,0 +1,487 @@
+// Source file for exact model counting
+
+#include "solver/exact_counter.h"
+#include "utils/timer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// hash for component cache keys
+struct ComponentKeyHash {
+    size_t operator()(const vector<int>& key) const {
+        uint64_t h = 1469598103934665603ULL;
+        for (int x : key) {
+            h ^= static_cast<uint32_t>(x);
+            h *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(h);
+    }
+};
+
+// saturating arithmetic - overflow is reported through the flag
+uint64_t addSaturating(uint64_t a, uint64_t b, bool& overflow) {
+    if (a > UINT64_MAX - b) {
+        overflow = true;
+        return UINT64_MAX;
+    }
+    return a + b;
+}
+
+uint64_t mulSaturating(uint64_t a, uint64_t b, bool& overflow) {
+    if (a != 0 && b > UINT64_MAX / a) {
+        overflow = true;
+        return UINT64_MAX;
+    }
+    return a * b;
+}
+
+// literal index: 2 * var for positive, 2 * var + 1 for negative (var is 0-indexed)
+int literalIndex(Literal lit) {
+    int var = abs(lit) - 1;
+    return (lit > 0) ? (2 * var) : (2 * var + 1);
+}
+
+}
+
+struct ExactCounter::SearchState {
+    int numVars;
+    vector<vector<Literal>> clauses;
+    vector<vector<int>> occurrences;   // clause indices per literal index
+    vector<int> value;                 // -1 = unassigned, 0 = false, 1 = true
+    vector<int> trail;
+
+    // scratch marks used while splitting components
+    vector<uint32_t> varMark;
+    vector<uint32_t> clauseMark;
+    uint32_t stamp;
+    vector<int> scores;
+
+    unordered_map<vector<int>, uint64_t, ComponentKeyHash> cache;
+    uint64_t decisions;
+    uint64_t maxDecisions;
+    uint64_t maxModels;
+    const CancellationToken* cancel;
+    uint64_t cacheHits;
+    uint64_t components;
+    bool aborted;
+    bool overflow;
+    bool exceeded;
+
+    SearchState() :
+        numVars(0),
+        stamp(0),
+        decisions(0),
+        maxDecisions(0),
+        maxModels(UINT64_MAX),
+        cancel(nullptr),
+        cacheHits(0),
+        components(0),
+        aborted(false),
+        overflow(false),
+        exceeded(false) {}
+
+    // give up once a count is above maxModels - returns true if it is
+    bool exceeds(uint64_t count) {
+        if (count > maxModels) {
+            aborted = true;
+            exceeded = true;
+        }
+        return exceeded;
+    }
+
+    // value of a literal under the current assignment (-1 if unassigned)
+    int literalValue(Literal lit) const {
+        int v = value[abs(lit) - 1];
+        if (v == -1) {
+            return -1;
+        }
+        return (lit > 0) ? v : 1 - v;
+    }
+
+    bool isSatisfied(int clauseIdx) const {
+        for (Literal lit : clauses[clauseIdx]) {
+            if (literalValue(lit) == 1) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+bool ExactCounter::fitsBudget(const CNFFormula& formula, int maxVariables, int maxClauses) {
+    if (static_cast<int>(formula.clauses.size()) > maxClauses) {
+        return false;
+    }
+    vector<bool> seen(formula.numVariables, false);
+    int constrained = 0;
+    for (const auto& clause : formula.clauses) {
+        for (Literal lit : clause.literals) {
+            int var = abs(lit) - 1;
+            if (!seen[var]) {
+                seen[var] = true;
+                if (++constrained > maxVariables) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool ExactCounter::load(SearchState& state, const CNFFormula& formula) {
+    state.numVars = formula.numVariables;
+    state.occurrences.resize(2 * state.numVars);
+    state.value.assign(state.numVars, -1);
+    state.varMark.assign(state.numVars, 0);
+    state.scores.assign(state.numVars, 0);
+
+    // normalize clauses - drop duplicate literals and tautologies
+    for (const auto& clause : formula.clauses) {
+        vector<Literal> lits = clause.literals;
+        sort(lits.begin(), lits.end(), [](Literal a, Literal b) {
+            return abs(a) != abs(b) ? abs(a) < abs(b) : a < b;
+        });
+        lits.erase(unique(lits.begin(), lits.end()), lits.end());
+
+        bool tautology = false;
+        for (size_t i = 1; i < lits.size(); i++) {
+            if (lits[i] == -lits[i - 1]) {
+                tautology = true;
+                break;
+            }
+        }
+        if (tautology) {
+            continue;
+        }
+
+        // empty clause - no models
+        if (lits.empty()) {
+            return false;
+        }
+
+        int idx = state.clauses.size();
+        for (Literal lit : lits) {
+            state.occurrences[literalIndex(lit)].push_back(idx);
+        }
+        state.clauses.push_back(move(lits));
+    }
+    state.clauseMark.assign(state.clauses.size(), 0);
+
+    // root level unit propagation
+    for (const auto& lits : state.clauses) {
+        if (lits.size() != 1) {
+            continue;
+        }
+        int litVal = state.literalValue(lits[0]);
+        if (litVal == 0) {
+            return false;
+        }
+        if (litVal == -1 && !assignAndPropagate(state, abs(lits[0]) - 1, lits[0] > 0 ? 1 : 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ExactCountResult ExactCounter::count(const CNFFormula& formula, uint64_t maxDecisions, const CancellationToken* cancel, uint64_t maxModels) {
+    AMC_TIME_PHASE(Phase::EXACT_COUNTING);
+    ExactCountResult result;
+    SearchState state;
+    state.maxDecisions = maxDecisions;
+    state.maxModels = maxModels;
+    state.cancel = cancel;
+    if (!load(state, formula)) {
+        result.completed = true;
+        return result;
+    }
+
+    // only variables that appear in some clause are searched - the rest are free
+    vector<int> vars;
+    for (int i = 0; i < state.numVars; i++) {
+        if (!state.occurrences[2 * i].empty() || !state.occurrences[2 * i + 1].empty()) {
+            vars.push_back(i);
+        }
+    }
+    result.freeVariables = state.numVars - vars.size();
+    vector<int> clauses(state.clauses.size());
+    for (size_t i = 0; i < clauses.size(); i++) {
+        clauses[i] = i;
+    }
+
+    uint64_t total = countResidual(state, vars, clauses);
+
+    // a zero count is exact even if some other component overflowed on the way
+    if (!state.aborted && total == 0) {
+        state.overflow = false;
+    }
+    result.completed = !state.aborted && !state.overflow;
+    result.overflow = !state.aborted && state.overflow;
+    result.exceeded = state.exceeded;
+    result.count = result.completed ? total : 0;
+    result.decisions = state.decisions;
+    result.cacheHits = state.cacheHits;
+    result.components = state.components;
+    return result;
+}
+
+bool ExactCounter::enumerate(const CNFFormula& formula, int projectVars, size_t maxModels, vector<vector<int>>& models,
+                             uint64_t maxDecisions, const CancellationToken* cancel) {
+    AMC_TIME_PHASE(Phase::EXACT_COUNTING);
+    models.clear();
+    SearchState state;
+    state.maxDecisions = maxDecisions;
+    state.cancel = cancel;
+    if (!load(state, formula)) {
+        return true;
+    }
+    return enumerateFrom(state, min(projectVars, state.numVars), maxModels, models);
+}
+
+bool ExactCounter::enumerateFrom(SearchState& state, int projectVars, size_t maxModels, vector<vector<int>>& models) {
+    // branch on the first unassigned variable of the first unsatisfied clause
+    int branchVar = -1;
+    for (size_t c = 0; c < state.clauses.size() && branchVar < 0; c++) {
+        if (state.isSatisfied(c)) {
+            continue;
+        }
+        for (Literal lit : state.clauses[c]) {
+            if (state.literalValue(lit) == -1) {
+                branchVar = abs(lit) - 1;
+                break;
+            }
+        }
+    }
+
+    // every clause satisfied - each unassigned projected variable takes either value
+    if (branchVar < 0) {
+        vector<int> open;
+        for (int var = 0; var < projectVars; var++) {
+            if (state.value[var] == -1) {
+                open.push_back(var);
+            }
+        }
+        if (open.size() >= 64 || models.size() + (1ULL << open.size()) > maxModels) {
+            return false;
+        }
+        vector<int> model(state.value.begin(), state.value.begin() + projectVars);
+        for (uint64_t bits = 0; bits < (1ULL << open.size()); bits++) {
+            for (size_t i = 0; i < open.size(); i++) {
+                model[open[i]] = (bits >> i) & 1;
+            }
+            models.push_back(model);
+        }
+        return true;
+    }
+
+    for (int value = 1; value >= 0; value--) {
+        if (++state.decisions > state.maxDecisions) {
+            return false;
+        }
+        if (state.cancel != nullptr && (state.decisions & 1023) == 0 && state.cancel->isCancelled()) {
+            return false;
+        }
+        size_t trailSize = state.trail.size();
+        bool complete = !assignAndPropagate(state, branchVar, value) || enumerateFrom(state, projectVars, maxModels, models);
+        undoTo(state, trailSize);
+        if (!complete) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t ExactCounter::countResidual(SearchState& state, const vector<int>& vars, const vector<int>& clauses) {
+    // mark the clauses of this component that are still unsatisfied
+    // (active = stamp, already taken by a sub-component = stamp + 1)
+    state.stamp += 2;
+    uint32_t active = state.stamp;
+    uint32_t taken = state.stamp + 1;
+    for (int c : clauses) {
+        if (!state.isSatisfied(c)) {
+            state.clauseMark[c] = active;
+        }
+    }
+
+    // split into variable-disjoint sub-components with a BFS over shared clauses
+    vector<pair<vector<int>, vector<int>>> subComponents;
+    int freeVars = 0;
+    for (int start : vars) {
+        if (state.value[start] != -1 || state.varMark[start] == active) {
+            continue;
+        }
+
+        vector<int> compVars;
+        vector<int> compClauses;
+        state.varMark[start] = active;
+        compVars.push_back(start);
+        for (size_t head = 0; head < compVars.size(); head++) {
+            int var = compVars[head];
+            for (int litIdx = 2 * var; litIdx <= 2 * var + 1; litIdx++) {
+                for (int c : state.occurrences[litIdx]) {
+                    if (state.clauseMark[c] != active) {
+                        continue;
+                    }
+                    state.clauseMark[c] = taken;
+                    compClauses.push_back(c);
+                    for (Literal lit : state.clauses[c]) {
+                        int other = abs(lit) - 1;
+                        if (state.value[other] == -1 && state.varMark[other] != active) {
+                            state.varMark[other] = active;
+                            compVars.push_back(other);
+                        }
+                    }
+                }
+            }
+        }
+
+        // a variable that is not in any unsatisfied clause can take either value
+        if (compClauses.empty()) {
+            freeVars++;
+            continue;
+        }
+
+        sort(compVars.begin(), compVars.end());
+        sort(compClauses.begin(), compClauses.end());
+        subComponents.emplace_back(move(compVars), move(compClauses));
+    }
+
+    // count each sub-component on its own and multiply
+    uint64_t total = 1;
+    for (const auto& comp : subComponents) {
+        state.components++;
+        uint64_t compCount = countComponent(state, comp.first, comp.second);
+        if (state.aborted || compCount == 0) {
+            return 0;
+        }
+        total = mulSaturating(total, compCount, state.overflow);
+    }
+
+    for (int i = 0; i < freeVars; i++) {
+        total = mulSaturating(total, 2, state.overflow);
+    }
+    if (state.exceeds(total)) {
+        return 0;
+    }
+    return total;
+}
+
+uint64_t ExactCounter::countComponent(SearchState& state, const vector<int>& vars, const vector<int>& clauses) {
+    // cache key: variables, separator, clause indices
+    // (the residual of every clause in a component is fully determined by which of its variables are still in the component)
+    vector<int> key;
+    key.reserve(vars.size() + clauses.size() + 1);
+    key.insert(key.end(), vars.begin(), vars.end());
+    key.push_back(-1);
+    key.insert(key.end(), clauses.begin(), clauses.end());
+
+    auto it = state.cache.find(key);
+    if (it != state.cache.end()) {
+        state.cacheHits++;
+        return it->second;
+    }
+
+    // branch on the variable with the most occurrences in the component
+    int branchVar = vars[0];
+    int bestScore = -1;
+    for (int c : clauses) {
+        for (Literal lit : state.clauses[c]) {
+            int var = abs(lit) - 1;
+            if (state.value[var] == -1) {
+                state.scores[var]++;
+            }
+        }
+    }
+    for (int var : vars) {
+        if (state.scores[var] > bestScore) {
+            bestScore = state.scores[var];
+            branchVar = var;
+        }
+        state.scores[var] = 0;
+    }
+
+    uint64_t total = 0;
+    for (int value = 1; value >= 0; value--) {
+        if (++state.decisions > state.maxDecisions) {
+            state.aborted = true;
+            return 0;
+        }
+        // the token is polled every 1024 decisions - reading the clock on every one would show up
+        if (state.cancel != nullptr && (state.decisions & 1023) == 0 && state.cancel->isCancelled()) {
+            state.aborted = true;
+            return 0;
+        }
+
+        size_t trailSize = state.trail.size();
+        uint64_t branchCount = 0;
+        if (assignAndPropagate(state, branchVar, value)) {
+            branchCount = countResidual(state, vars, clauses);
+        }
+        undoTo(state, trailSize);
+
+        if (state.aborted) {
+            return 0;
+        }
+        total = addSaturating(total, branchCount, state.overflow);
+        if (state.exceeds(total)) {
+            return 0;
+        }
+    }
+
+    if (static_cast<int>(state.cache.size()) >= EXACT_COUNT_MAX_CACHE_ENTRIES) {
+        state.cache.clear();
+    }
+    state.cache.emplace(move(key), total);
+    return total;
+}
+
+bool ExactCounter::assignAndPropagate(SearchState& state, int var, int value) {
+    state.value[var] = value;
+    state.trail.push_back(var);
+
+    for (size_t head = state.trail.size() - 1; head < state.trail.size(); head++) {
+        int assigned = state.trail[head];
+
+        // only clauses containing the literal that just became false can become unit or conflicting
+        Literal falseLit = (state.value[assigned] == 1) ? -(assigned + 1) : (assigned + 1);
+        for (int c : state.occurrences[literalIndex(falseLit)]) {
+            Literal unassignedLit = 0;
+            int unassignedCount = 0;
+            bool satisfied = false;
+            for (Literal lit : state.clauses[c]) {
+                int litVal = state.literalValue(lit);
+                if (litVal == 1) {
+                    satisfied = true;
+                    break;
+                }
+                if (litVal == -1) {
+                    unassignedLit = lit;
+                    unassignedCount++;
+                }
+            }
+
+            if (satisfied) {
+                continue;
+            }
+            if (unassignedCount == 0) {
+                return false;  // conflict
+            }
+            if (unassignedCount == 1) {
+                int unitVar = abs(unassignedLit) - 1;
+                state.value[unitVar] = (unassignedLit > 0) ? 1 : 0;
+                state.trail.push_back(unitVar);
+            }
+        }
+    }
+    return true;
+}
+
+void ExactCounter::undoTo(SearchState& state, size_t trailSize) {
+    while (state.trail.size() > trailSize) {
+        state.value[state.trail.back()] = -1;
+        state.trail.pop_back();
+    }
+}
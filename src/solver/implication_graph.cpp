@@ -0,0 +1,100 @@
+// Source file for the binary implication graph
+
+#include "solver/implication_graph.h"
+#include "utils/timer.h"
+#include <algorithm>
+
+using namespace std;
+
+ImplicationGraph ImplicationGraph::fromFormula(const CNFFormula& formula) {
+    ImplicationGraph graph;
+    graph.init(formula.numVariables);
+    for (const auto& clause : formula.clauses) {
+        vector<Literal> lits = clause.literals;
+        sort(lits.begin(), lits.end());
+        lits.erase(unique(lits.begin(), lits.end()), lits.end());
+        // (a OR -a) implies nothing
+        if (lits.size() == 2 && lits[0] != -lits[1]) {
+            graph.addClause(lits[0], lits[1]);
+        }
+    }
+    return graph;
+}
+
+size_t ImplicationGraph::numEdges() const {
+    size_t total = 0;
+    for (const auto& list : edges) {
+        total += list.size();
+    }
+    return total;
+}
+
+bool ImplicationGraph::reach(Literal lit, const vector<char>& forced, vector<Literal>& reached, vector<uint32_t>& mark, uint32_t stamp, uint64_t& steps) const {
+    reached.clear();
+    reached.push_back(lit);
+    mark[index(lit)] = stamp;
+    // reached doubles as the DFS stack - everything before next has been expanded
+    for (size_t next = 0; next < reached.size(); next++) {
+        Literal current = reached[next];
+        if (mark[index(-current)] == stamp || forced[index(-current)]) {
+            return false;
+        }
+        for (Literal target : edges[index(current)]) {
+            steps++;
+            if (mark[index(target)] != stamp) {
+                mark[index(target)] = stamp;
+                reached.push_back(target);
+            }
+        }
+    }
+    return true;
+}
+
+ProbeResult ImplicationGraph::probeFailedLiterals(uint64_t maxSteps) const {
+    ProbeResult result;
+    vector<char> forced(2 * numVars, 0);    // by index: literal known to hold in every model
+    vector<uint32_t> mark(2 * numVars, 0);
+    vector<Literal> reached;
+    uint32_t stamp = 0;
+    uint64_t steps = 0;
+
+    for (int var = 1; var <= numVars && !result.unsatisfiable; var++) {
+        for (Literal lit : {var, -var}) {
+            // a literal that implies nothing cannot fail
+            if (forced[index(lit)] || forced[index(-lit)] || edges[index(lit)].empty()) {
+                continue;
+            }
+            if (steps > maxSteps) {
+                result.exhausted = true;
+                return result;
+            }
+            if (reach(lit, forced, reached, mark, ++stamp, steps)) {
+                continue;
+            }
+
+            // lit is false in every model - so is everything that implies it, i.e. all that -lit implies holds
+            result.failedLiterals++;
+            AMC_COUNT(Counter::FAILED_LITERALS);
+            if (!reach(-lit, forced, reached, mark, ++stamp, steps)) {
+                result.unsatisfiable = true;
+                break;
+            }
+            for (Literal unit : reached) {
+                if (!forced[index(unit)]) {
+                    forced[index(unit)] = 1;
+                    result.units.push_back(unit);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+CNFFormula ImplicationGraph::withProbedUnits(const CNFFormula& formula, const ProbeResult& probe) {
+    CNFFormula result = formula;
+    for (Literal unit : probe.units) {
+        result.addClause({unit});
+    }
+    result.numClauses = result.clauses.size();
+    return result;
+}
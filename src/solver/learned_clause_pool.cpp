@@ -0,0 +1,68 @@
+// Source file for the shared pool of learned clauses
+
+#include "solver/learned_clause_pool.h"
+#include <algorithm>
+
+using namespace std;
+
+LearnedClausePool::LearnedClausePool(const CNFFormula& formula, size_t capacity) :
+    formulaVariables(formula.numVariables), reserved(0) {
+    // clauses as the solver loads them - sorted, duplicates dropped
+    formulaClauses.reserve(formula.clauses.size());
+    for (const auto& clause : formula.clauses) {
+        vector<Literal> lits = clause.literals;
+        sort(lits.begin(), lits.end());
+        lits.erase(unique(lits.begin(), lits.end()), lits.end());
+        formulaClauses.insert(move(lits));
+    }
+    if (capacity == 0) {
+        capacity = max(static_cast<size_t>(SHARED_CLAUSES_MIN_CAPACITY), formula.clauses.size());
+        capacity = min(capacity, static_cast<size_t>(SHARED_CLAUSES_MAX_CAPACITY));
+    }
+    slotCount = capacity;
+    slots.reset(new Slot[slotCount]);
+}
+
+size_t LearnedClausePool::ClauseHash::operator()(const vector<Literal>& lits) const {
+    uint64_t hash = 1469598103934665603ULL;
+    for (Literal lit : lits) {
+        hash = (hash ^ static_cast<uint32_t>(lit)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool LearnedClausePool::isFormulaClause(const vector<Literal>& sortedLits) const {
+    return formulaClauses.count(sortedLits) != 0;
+}
+
+bool LearnedClausePool::add(const Literal* lits, size_t size) {
+    if (size == 0 || size > SHARED_CLAUSE_MAX_LITERALS) {
+        return false;
+    }
+    // a full pool only ever gets fuller - skip the increment so the counter stays put
+    if (reserved.load(memory_order_relaxed) >= slotCount) {
+        return false;
+    }
+    size_t index = reserved.fetch_add(1, memory_order_relaxed);
+    if (index >= slotCount) {
+        return false;
+    }
+    Slot& slot = slots[index];
+    copy(lits, lits + size, slot.literals);
+    slot.size.store(static_cast<int>(size), memory_order_release);
+    return true;
+}
+
+size_t LearnedClausePool::size() const {
+    return min(reserved.load(memory_order_relaxed), slotCount);
+}
+
+bool LearnedClausePool::get(size_t index, vector<Literal>& lits) const {
+    const Slot& slot = slots[index];
+    int size = slot.size.load(memory_order_acquire);
+    if (size == 0) {
+        return false;
+    }
+    lits.assign(slot.literals, slot.literals + size);
+    return true;
+}
@@ -0,0 +1,44 @@
+// Source file for model count representation
+
+#include "solver/model_count.h"
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+double ModelCount::log2() const {
+    if (cellCount == 0) {
+        return -INFINITY;
+    }
+    return std::log2(static_cast<double>(cellCount)) + exponent;
+}
+
+uint64_t ModelCount::saturated() const {
+    if (cellCount == 0) {
+        return 0;
+    }
+    if (exponent >= 64 || cellCount > (UINT64_MAX >> exponent)) {
+        return UINT64_MAX;
+    }
+    return cellCount << exponent;
+}
+
+string ModelCount::toString() const {
+    if (saturated() != UINT64_MAX) {
+        return to_string(saturated());
+    }
+    return to_string(cellCount) + "*2^" + to_string(exponent);
+}
+
+string ModelCount::formatLog2(double log2Count) {
+    if (std::isinf(log2Count) && log2Count < 0) {
+        return "0";
+    }
+    if (log2Count < 63.0) {
+        return to_string(static_cast<uint64_t>(llround(exp2(log2Count))));
+    }
+    ostringstream out;
+    out << "2^" << fixed << setprecision(3) << log2Count;
+    return out.str();
+}
@@ -1,6 +1,8 @@
 // Source file for PartialAssignment class implementation
 
 #include "solver/partial_assignment.h"
+#include "utils/timer.h"
+#include "utils/reusable_storage.h"
 #include <iostream>
 #include <algorithm>
 #include <cassert>
@@ -8,54 +10,57 @@
 
 using namespace std;
 
+void EliminationBuffers::reset(int numRows, int numVariables) {
+    rowWords = (numVariables + 63) / 64;
+    matrix.assign(static_cast<size_t>(numRows) * rowWords, 0);
+    rhs.assign(numRows, 0);
+    pivotColumn.assign(numRows, -1);
+    pivoted.assign(numVariables, 0);
+}
+
 XORSolutionResult PartialAssignment::solveXORSystem(const vector<XORConstraint>& xors, int numVariables) {
-    // if there are no XOR constraints, this is trivially satisfiable and all variables are free
-    if (xors.empty()) {
-        XORSolutionResult result;
-        result.satisfiable = true;
-        for (int i = 1; i <= numVariables; i++) {
-            result.freeVariables.push_back(i);
-        }
-        return result;
-    }
+    XORSolutionResult result;
+    EliminationBuffers buffers;
+    solveXORSystem(xors, numVariables, result, buffers);
+    return result;
+}
+
+void PartialAssignment::solveXORSystem(const vector<XORConstraint>& xors, int numVariables, XORSolutionResult& result, EliminationBuffers& buffers) {
+    AMC_TIME_PHASE(Phase::GAUSSIAN_ELIMINATION);
     
     // build augmented matrix for Gaussian elimination
-    // rows are XOR constraints, columns are variables + RHS
-    vector<vector<int>> matrix;
-    vector<int> rhs;
-    for (const auto& xor_constraint : xors) {
-        vector<int> row(numVariables, 0);
-        for (int var : xor_constraint.variables) {
-            row[var - 1] = 1;
+    // rows are XOR constraints, columns are variables (the RHS is kept apart)
+    int numRows = xors.size();
+    buffers.reset(numRows, numVariables);
+    for (int r = 0; r < numRows; r++) {
+        uint64_t* row = buffers.row(r);
+        for (int var : xors[r].variables) {
+            row[(var - 1) / 64] ^= 1ULL << ((var - 1) % 64);
         }
-        matrix.push_back(row);
-        rhs.push_back(xor_constraint.value ? 1 : 0);
+        buffers.rhs[r] = xors[r].value ? 1 : 0;
     }
     
-    return gaussianElimination(matrix, rhs, numVariables);
+    gaussianElimination(buffers, numRows, numVariables, result);
 }
 
-XORSolutionResult PartialAssignment::gaussianElimination(vector<vector<int>>& matrix, vector<int>& rhs, int numVariables) {
-    XORSolutionResult result;
-
-    // if there are no rows (no constraints), this is trivially satisfiable
-    int numRows = matrix.size();
-    if (numRows == 0) {
-        result.satisfiable = true;
-        for (int i = 1; i <= numVariables; i++) {
-            result.freeVariables.push_back(i);
-        }
-        return result;
-    }
+void PartialAssignment::gaussianElimination(EliminationBuffers& buffers, int numRows, int numVariables, XORSolutionResult& result) {
+    result.satisfiable = true;
+    result.assignment.clear();
+    resizeReusing(result.constraints, 0, buffers.spare);
+    result.freeVariables.clear();
     
-    vector<int> pivot_col(numRows, -1); // get pivot rows for each column
+    int words = buffers.rowWords;
+    vector<int>& rhs = buffers.rhs;
+    vector<int>& pivot_col = buffers.pivotColumn; // get pivot rows for each column
     int current_row = 0;
     
     // 1. forward elimination to RREF
     for (int col = 0; col < numVariables && current_row < numRows; col++) {
+        int word = col / 64;
+        uint64_t bit = 1ULL << (col % 64);
         int pivot_row = -1;
         for (int row = current_row; row < numRows; row++) {
-            if (matrix[row][col] == 1) {
+            if (buffers.row(row)[word] & bit) {
                 pivot_row = row;
                 break;
             }
@@ -66,18 +71,21 @@ XORSolutionResult PartialAssignment::gaussianElimination(vector<vector<int>>& ma
         }
         
         // swap rows
+        uint64_t* pivot = buffers.row(current_row);
         if (pivot_row != current_row) {
-            swap(matrix[pivot_row], matrix[current_row]);
+            swap_ranges(pivot, pivot + words, buffers.row(pivot_row));
             swap(rhs[pivot_row], rhs[current_row]);
         }
         
         pivot_col[current_row] = col;
         
         // row reduction - eliminate other rows using xor
+        // (the pivot row has no bit left of col: pivot columns were eliminated, the others were zero below the pivots)
         for (int row = 0; row < numRows; row++) {
-            if (row != current_row && matrix[row][col] == 1) {
-                for (int c = 0; c < numVariables; c++) {
-                    matrix[row][c] ^= matrix[current_row][c];
+            uint64_t* target = buffers.row(row);
+            if (row != current_row && (target[word] & bit)) {
+                for (int w = word; w < words; w++) {
+                    target[w] ^= pivot[w];
                 }
                 rhs[row] ^= rhs[current_row];
             }
@@ -86,41 +94,39 @@ XORSolutionResult PartialAssignment::gaussianElimination(vector<vector<int>>& ma
         current_row++;
     }
     
-    // 2. find contradictions
-    for (int row = 0; row < numRows; row++) {
-        bool all_zero = true;
-        for (int col = 0; col < numVariables; col++) {
-            if (matrix[row][col] != 0) {
-                all_zero = false;
-                break;
-            }
-        }
-        
+    // 2. find contradictions - the rows without a pivot are all zero now
+    for (int row = current_row; row < numRows; row++) {
         // if all coeffs are 0 but rhs is 1, unsat
-        if (all_zero && rhs[row] == 1) {
+        if (rhs[row] == 1) {
             result.satisfiable = false;
-            return result;
+            return;
         }
     }
     
     // 3. get (partial) assignment and free variables
-    vector<bool> is_assigned(numVariables, false);
-    
-    for (int row = 0; row < numRows; row++) {
-        if (pivot_col[row] != -1) {
-            int var = pivot_col[row] + 1; // add 1 - variables are 1-indexed
-            result.assignment[var] = rhs[row];
-            is_assigned[pivot_col[row]] = true;
+    // a pivot is only fixed if its row has no other variable - otherwise pivot = rhs XOR (free variables in the row)
+    for (int row = 0; row < current_row; row++) {
+        XORConstraint& reduced = appendReusing(result.constraints, buffers.spare);
+        reduced.variables.clear();
+        reduced.value = rhs[row];
+        const uint64_t* bits = buffers.row(row);
+        for (int w = pivot_col[row] / 64; w < words; w++) {
+            for (uint64_t rest = bits[w]; rest != 0; rest &= rest - 1) {
+                reduced.variables.push_back(w * 64 + __builtin_ctzll(rest) + 1);  // add 1 - variables are 1-indexed
+            }
+        }
+        
+        if (reduced.size() == 1) {
+            result.assignment.push_back({reduced.variables[0], rhs[row]});
+            resizeReusing(result.constraints, result.constraints.size() - 1, buffers.spare);
         }
+        buffers.pivoted[pivot_col[row]] = 1;
     }
     
     // get free variables
     for (int i = 0; i < numVariables; i++) {
-        if (!is_assigned[i]) {
+        if (!buffers.pivoted[i]) {
             result.freeVariables.push_back(i + 1);  // 1-indexed
         }
     }
-    
-    result.satisfiable = true;
-    return result;
 }
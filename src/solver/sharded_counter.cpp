@@ -0,0 +1,406 @@
+// Source file for sharded counting
+
+#include "solver/sharded_counter.h"
+#include "solver/exact_counter.h"
+#include "solver/trial_checkpoint.h"
+#include "solver/learned_clause_pool.h"
+#include "cnf/cnf_parser.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include <unistd.h>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const JOB_MAGIC = "amc-job";
+
+// "trial-000042" - zero padded so the queue lists in index order
+string trialName(int index) {
+    ostringstream out;
+    out << "trial-" << setw(6) << setfill('0') << index;
+    return out.str();
+}
+
+// host and process - unique among the workers sharing the directory
+string workerId() {
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    return string(host) + "." + to_string(getpid());
+}
+
+string readFile(const fs::path& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// write to a hidden temporary, then rename - readers never see a half-written file
+void publish(const fs::path& path, const string& contents) {
+    fs::path temporary = path.parent_path() / ("." + path.filename().string() + "." + workerId() + ".tmp");
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        out << contents;
+        if (!out) {
+            throw runtime_error("Cannot write " + temporary.string());
+        }
+    }
+    fs::rename(temporary, path);
+}
+
+void sleepPoll() {
+    this_thread::sleep_for(chrono::milliseconds(SHARD_POLL_MILLISECONDS));
+}
+
+// "seed=1 formula=2 ..." -> {seed: "1", formula: "2", ...}
+unordered_map<string, string> parseFields(const string& line) {
+    unordered_map<string, string> fields;
+    istringstream in(line);
+    string token;
+    while (in >> token) {
+        size_t equals = token.find('=');
+        fields[token.substr(0, equals)] = (equals == string::npos) ? "" : token.substr(equals + 1);
+    }
+    return fields;
+}
+
+struct Job {
+    uint64_t seed;
+    uint64_t formulaHash;
+    double density;
+    int threshold;
+    double trialTimeoutSeconds;
+    uint64_t maxConflictsPerSolve;
+    bool probeFailedLiterals;
+    bool renumberVariables;
+    HashFamily hashFamily;
+};
+
+string jobLine(const Job& job) {
+    ostringstream out;
+    out << JOB_MAGIC << " version=1 seed=" << job.seed << " formula=" << job.formulaHash << " density=" << setprecision(17) << job.density
+        << " threshold=" << job.threshold << " trial_timeout=" << job.trialTimeoutSeconds << " max_conflicts=" << job.maxConflictsPerSolve
+        << " probe=" << (job.probeFailedLiterals ? 1 : 0) << " renumber=" << (job.renumberVariables ? 1 : 0)
+        << " nested=" << (job.hashFamily == HashFamily::NESTED ? 1 : 0) << "\n";
+    return out.str();
+}
+
+Job parseJob(const string& line) {
+    auto fields = parseFields(line);
+    if (!fields.count(JOB_MAGIC) || fields["version"] != "1") {
+        throw runtime_error("Not a sharded counting job: " + line);
+    }
+    try {
+        Job job;
+        job.seed = stoull(fields.at("seed"));
+        job.formulaHash = stoull(fields.at("formula"));
+        job.density = stod(fields.at("density"));
+        job.threshold = stoi(fields.at("threshold"));
+        job.trialTimeoutSeconds = stod(fields.at("trial_timeout"));
+        job.maxConflictsPerSolve = stoull(fields.at("max_conflicts"));
+        job.probeFailedLiterals = fields.at("probe") == "1";
+        job.renumberVariables = fields.at("renumber") == "1";
+        job.hashFamily = (fields.at("nested") == "1") ? HashFamily::NESTED : HashFamily::INDEPENDENT;
+        return job;
+    } catch (const logic_error&) {
+        throw runtime_error("Malformed sharded counting job: " + line);
+    }
+}
+
+// touches the claim every interval until destroyed - the coordinator takes the claim's age as the time since
+// its worker was last seen alive
+class ClaimHeartbeat {
+public:
+    ClaimHeartbeat(const fs::path& claim, double intervalSeconds) :
+        path(claim),
+        interval(intervalSeconds),
+        stopped(false),
+        beater([this]() { beat(); }) {}
+
+    ~ClaimHeartbeat() {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            stopped = true;
+        }
+        wake.notify_one();
+        beater.join();
+    }
+
+private:
+    void beat() {
+        unique_lock<mutex> lock(stateMutex);
+        while (!wake.wait_for(lock, interval, [this]() { return stopped; })) {
+            error_code error;
+            fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+        }
+    }
+
+    fs::path path;
+    chrono::duration<double> interval;
+    mutex stateMutex;
+    condition_variable wake;
+    bool stopped;
+    thread beater;
+};
+
+// put descriptors whose worker has not touched them for reclaimSeconds back in the queue
+void reclaimStale(const fs::path& directory, double reclaimSeconds) {
+    error_code error;
+    auto now = fs::file_time_type::clock::now();
+    for (const auto& entry : fs::directory_iterator(directory / "claimed", error)) {
+        string name = entry.path().filename().string();
+        auto modified = fs::last_write_time(entry.path(), error);
+        if (error || chrono::duration<double>(now - modified).count() < reclaimSeconds) {
+            continue;
+        }
+        string trial = name.substr(0, name.find('.'));
+        if (fs::exists(directory / "results" / trial)) {
+            continue;
+        }
+        fs::rename(entry.path(), directory / "queue" / trial, error);
+        if (!error) {
+            LOG_WARNING("no result for " << trial << " from worker " << name.substr(trial.size() + 1) << " - handing it out again");
+        }
+    }
+}
+
+}
+
+ApproximationResult ShardedCounter::coordinate(const CNFFormula& formula, const string& formulaPath, const string& dir,
+                                               const CountingOptions& options, double reclaimSeconds) {
+    // workers rebuild the run from the job file, which has no room for a model
+    if (options.hashModel) {
+        throw runtime_error("sharded counting does not support a hash model");
+    }
+    PhaseStats runStart = Stats::local();
+    CancellationToken runToken(options.cancel);
+    if (options.timeoutSeconds > 0) {
+        runToken.setDeadline(options.timeoutSeconds);
+    }
+
+    // small formulas are counted outright, as approximateCount does
+    if (options.exactFallback && ExactCounter::fitsBudget(formula)) {
+        ExactCountResult exactCount = ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, &runToken);
+        if (exactCount.completed) {
+            ApproximationResult result = ApproximateCounter::exactResult(exactCount.modelCount());
+            result.stats = Stats::local().since(runStart);
+            return result;
+        }
+    }
+
+    int maxTrials = (options.maxTrials > 0) ? options.maxTrials : StatisticalAnalysis::requiredIterations(options.delta);
+    Job job;
+    job.seed = (options.seed != 0) ? options.seed : XORHashGenerator::drawSeed();
+    job.formulaHash = TrialCheckpoint::formulaHash(formula);
+    job.density = options.density;
+    job.threshold = (options.threshold > 0) ? options.threshold : StatisticalAnalysis::cellThreshold(options.epsilon);
+    job.trialTimeoutSeconds = options.trialTimeoutSeconds;
+    job.maxConflictsPerSolve = options.maxConflictsPerSolve;
+    job.probeFailedLiterals = options.probeFailedLiterals;
+    job.renumberVariables = options.renumberVariables;
+    job.hashFamily = options.hashFamily;
+
+    fs::path directory(dir);
+    if (fs::exists(directory / "job")) {
+        throw runtime_error(dir + " already holds a job");
+    }
+    for (const char* sub : {"queue", "claimed", "results"}) {
+        fs::create_directories(directory / sub);
+    }
+    fs::copy_file(formulaPath, directory / "formula.cnf", fs::copy_options::overwrite_existing);
+    publish(directory / "job", jobLine(job));
+    LOG_INFO("sharded run in " << dir << ": " << maxTrials << " trials, seed " << job.seed);
+
+    auto enqueue = [&directory](int index, int hint) {
+        publish(directory / "queue" / trialName(index), "index " + to_string(index) + " xors " + to_string(hint) + "\n");
+    };
+    // the first trial alone - its XOR count is the hint for the others
+    enqueue(0, 0);
+
+    map<int, TrialResult> reported;
+    vector<TrialResult> trials;
+    int successful = 0;
+    bool stopped = false;
+    bool interrupted = false;
+    while ((int)trials.size() < maxTrials && !stopped) {
+        if (runToken.isCancelled()) {
+            interrupted = true;
+            break;
+        }
+
+        error_code error;
+        for (const auto& entry : fs::directory_iterator(directory / "results", error)) {
+            string name = entry.path().filename().string();
+            if (name[0] == '.' || name.compare(0, 6, "trial-") != 0) {
+                continue;
+            }
+            int index = stoi(name.substr(6));
+            if (index < (int)trials.size() || reported.count(index)) {
+                continue;
+            }
+            string record = readFile(entry.path());
+            int recordIndex = -1;
+            TrialResult trial;
+            if (!TrialCheckpoint::parseRecord(record, recordIndex, trial) || recordIndex != index) {
+                LOG_WARNING("ignoring malformed result " << entry.path().string());
+                continue;
+            }
+            reported[index] = trial;
+        }
+
+        // consumed in index order, as approximateCount does, so early stopping sees the same sequence
+        bool progress = false;
+        while (!stopped && reported.count(trials.size())) {
+            int i = trials.size();
+            TrialResult trial = reported[i];
+            reported.erase(i);
+            trials.push_back(trial);
+            progress = true;
+            if (trial.satisfiable) {
+                successful++;
+            }
+            if (i == 0) {
+                int hint = trial.satisfiable ? trial.numXORs : 0;
+                for (int index = 1; index < maxTrials; index++) {
+                    enqueue(index, hint);
+                }
+            }
+            if (options.earlyTermination && successful >= MIN_TRIALS_BEFORE_STOPPING && i + 1 < maxTrials) {
+                ApproximationResult partial = ApproximateCounter::aggregateResults(trials, options.delta);
+                stopped = StatisticalAnalysis::withinTolerance(partial.interval, partial.log2Estimate, options.epsilon);
+            }
+        }
+        if (!progress) {
+            if (reclaimSeconds > 0) {
+                reclaimStale(directory, reclaimSeconds);
+            }
+            sleepPoll();
+        }
+    }
+
+    // workers leave - descriptors nobody took are withdrawn
+    publish(directory / "done", to_string(trials.size()) + "\n");
+    error_code error;
+    for (const auto& entry : fs::directory_iterator(directory / "queue", error)) {
+        fs::remove(entry.path(), error);
+    }
+
+    ApproximationResult result = ApproximateCounter::aggregateResults(trials, options.delta);
+    result.earlyStopped = stopped;
+    result.timedOut = interrupted && runToken.deadlinePassed();
+    result.cancelled = interrupted && options.cancel != nullptr && options.cancel->isCancelled();
+    result.partial = interrupted || result.abortedTrials > 0;
+    result.stats.merge(Stats::local().since(runStart));
+    return result;
+}
+
+int ShardedCounter::work(const string& dir, const CancellationToken* cancel, double heartbeatSeconds) {
+    fs::path directory(dir);
+    auto finished = [&]() {
+        return fs::exists(directory / "done") || (cancel != nullptr && cancel->isCancelled());
+    };
+    while (!fs::exists(directory / "job")) {
+        if (finished()) {
+            return 0;
+        }
+        sleepPoll();
+    }
+
+    Job job = parseJob(readFile(directory / "job"));
+    auto formula = CNFParser::parseFile((directory / "formula.cnf").string());
+    if (TrialCheckpoint::formulaHash(*formula) != job.formulaHash) {
+        throw runtime_error("formula.cnf in " + dir + " does not match the job");
+    }
+    // as approximateCount does - the cells keep their counts
+    CountingOptions preprocessing;
+    preprocessing.probeFailedLiterals = job.probeFailedLiterals;
+    preprocessing.renumberVariables = job.renumberVariables;
+    CNFFormula preprocessed;
+    bool unsatisfiable = false;
+    if (ApproximateCounter::preprocess(*formula, preprocessing, preprocessed, unsatisfiable)) {
+        *formula = move(preprocessed);
+    }
+    // clauses learned from the formula are shared between the trials this worker runs
+    LearnedClausePool sharedClauses(*formula);
+    SolverSnapshot snapshot(*formula, &sharedClauses);
+    string id = workerId();
+    LOG_INFO("worker " << id << " joined " << dir);
+
+    int trialsRun = 0;
+    while (!finished()) {
+        vector<string> queued;
+        error_code error;
+        for (const auto& entry : fs::directory_iterator(directory / "queue", error)) {
+            string name = entry.path().filename().string();
+            if (name[0] != '.') {
+                queued.push_back(name);
+            }
+        }
+        sort(queued.begin(), queued.end());
+
+        bool claimed = false;
+        for (const string& name : queued) {
+            fs::path claim = directory / "claimed" / (name + "." + id);
+            fs::rename(directory / "queue" / name, claim, error);
+            if (error) {
+                continue;   // another worker was faster
+            }
+            claimed = true;
+            // the claim's age is how the coordinator tells a slow worker from a dead one - it starts now
+            fs::last_write_time(claim, fs::file_time_type::clock::now(), error);
+
+            // "index <i> xors <hint>"
+            istringstream descriptor(readFile(claim));
+            string indexKey, xorsKey;
+            int index = -1;
+            int hint = 0;
+            if (!(descriptor >> indexKey >> index >> xorsKey >> hint) || indexKey != "index" || xorsKey != "xors" || index < 0) {
+                LOG_WARNING("skipping malformed descriptor " << name);
+                continue;
+            }
+
+            CancellationToken trialToken(cancel);
+            if (job.trialTimeoutSeconds > 0) {
+                trialToken.setDeadline(job.trialTimeoutSeconds);
+            }
+            SolveLimits limits;
+            limits.cancel = &trialToken;
+            limits.maxConflicts = job.maxConflictsPerSolve;
+            limits.sharedClauses = &sharedClauses;
+            limits.snapshot = &snapshot;
+            mt19937 rng = ApproximateCounter::trialGenerator(job.seed, index);
+            TrialResult trial;
+            {
+                ClaimHeartbeat heartbeat(claim, heartbeatSeconds);
+                trial = ApproximateCounter::singleTrial(*formula, job.density, job.threshold, rng, limits, hint, job.hashFamily);
+            }
+
+            if (cancel != nullptr && cancel->isCancelled()) {
+                // stopped by our own shutdown, not by the trial's budget - let another worker redo it
+                fs::rename(claim, directory / "queue" / name, error);
+                break;
+            }
+            publish(directory / "results" / name, TrialCheckpoint::formatRecord(index, trial) + "\n");
+            fs::remove(claim, error);
+            trialsRun++;
+            break;
+        }
+        if (!claimed) {
+            sleepPoll();
+        }
+    }
+    LOG_INFO("worker " << id << " ran " << trialsRun << " trials");
+    return trialsRun;
+}
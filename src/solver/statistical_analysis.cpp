@@ -1,2 +1,71 @@
-// Implementation for statistical analysis
-// Computes confidence intervals, variance, and approximation quality metrics
+// Source file for statistical analysis
+// Implementation of statistical computations for result aggregation
+
+#include "solver/statistical_analysis.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+using namespace std;
+
+// both clamp to INT_MAX - a tiny delta or epsilon would otherwise overflow the conversion
+int StatisticalAnalysis::requiredIterations(double delta) {
+    assert(delta > 0 && delta < 1);
+    return static_cast<int>(min(ceil(17.0 * log2(3.0 / delta)), static_cast<double>(INT_MAX)));
+}
+
+int StatisticalAnalysis::cellThreshold(double epsilon) {
+    assert(epsilon > 0);
+    double base = 1.0 + 1.0 / epsilon;
+    return static_cast<int>(min(1.0 + 9.84 * (1.0 + epsilon / (1.0 + epsilon)) * base * base, static_cast<double>(INT_MAX)));
+}
+
+ConfidenceInterval StatisticalAnalysis::medianConfidenceInterval(vector<double> log2Counts, double delta) {
+    ConfidenceInterval interval;
+    int n = log2Counts.size();
+    if (n == 0) {
+        return interval;
+    }
+    
+    // largest k with P(Bin(n, 1/2) <= k - 1) <= delta / 2 - the interval then misses the median with probability at most delta
+    int k = 0;
+    while (k + 1 <= (n + 1) / 2 && binomialCDF(n, k) <= delta / 2.0) {
+        k++;
+    }
+    if (k == 0) {
+        return interval;
+    }
+    
+    sort(log2Counts.begin(), log2Counts.end());
+    interval.valid = true;
+    interval.log2Lower = log2Counts[k - 1];
+    interval.log2Upper = log2Counts[n - k];
+    interval.confidence = 1.0 - 2.0 * binomialCDF(n, k - 1);
+    return interval;
+}
+
+bool StatisticalAnalysis::withinTolerance(const ConfidenceInterval& interval, double log2Median, double epsilon) {
+    if (!interval.valid) {
+        return false;
+    }
+    double slack = log2(1.0 + epsilon);
+    return interval.log2Upper - log2Median <= slack && log2Median - interval.log2Lower <= slack;
+}
+
+double StatisticalAnalysis::binomialCDF(int n, int k) {
+    if (k < 0) {
+        return 0.0;
+    }
+    if (k >= n) {
+        return 1.0;
+    }
+    
+    // sum C(n, i) / 2^n in the log domain so large n does not underflow
+    double total = 0.0;
+    for (int i = 0; i <= k; i++) {
+        double logTerm = lgamma(n + 1.0) - lgamma(i + 1.0) - lgamma(n - i + 1.0) - n * log(2.0);
+        total += exp(logTerm);
+    }
+    return min(total, 1.0);
+}
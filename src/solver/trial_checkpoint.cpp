@@ -0,0 +1,218 @@
+// Source file for trial checkpoints
+
+#include "solver/trial_checkpoint.h"
+#include "xor/xor_hash_generator.h"
+#include "utils/logger.h"
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const char* const MAGIC = "amc-checkpoint";
+const int VERSION = 1;
+
+string headerLine(uint64_t seed, uint64_t formulaHash, double density, int threshold, HashFamily family, uint64_t densitiesHash) {
+    ostringstream out;
+    // density written with every digit so the value read back compares equal
+    out << MAGIC << " " << VERSION << " seed=" << seed << " formula=" << formulaHash
+        << " density=" << setprecision(17) << density << " threshold=" << threshold;
+    // absent in files written before nested families existed
+    if (family == HashFamily::NESTED) {
+        out << " nested=1";
+    }
+    if (densitiesHash != 0) {
+        out << " densities=" << densitiesHash;
+    }
+    return out.str();
+}
+
+// "seed=42" -> "42"
+string fieldValue(const string& token, const string& key) {
+    if (token.compare(0, key.size() + 1, key + "=") != 0) {
+        throw runtime_error("expected " + key + "=");
+    }
+    return token.substr(key.size() + 1);
+}
+
+}
+
+uint64_t TrialCheckpoint::formulaHash(const CNFFormula& formula) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](int64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= static_cast<uint8_t>(value >> (8 * i));
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix(formula.numVariables);
+    for (const auto& clause : formula.clauses) {
+        for (Literal lit : clause.literals) {
+            mix(lit);
+        }
+        mix(0);
+    }
+    return hash;
+}
+
+uint64_t TrialCheckpoint::densitiesHash(const vector<double>& probabilities) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (double p : probabilities) {
+        uint64_t bits = 0;
+        memcpy(&bits, &p, sizeof(bits));
+        for (int i = 0; i < 8; i++) {
+            hash ^= static_cast<uint8_t>(bits >> (8 * i));
+            hash *= 1099511628211ULL;
+        }
+    }
+    return (hash != 0) ? hash : 1;
+}
+
+TrialCheckpoint::TrialCheckpoint(const string& p, const CNFFormula& formula, double density, int threshold, uint64_t seed, HashFamily family,
+                                 uint64_t densitiesHash) :
+    path(p),
+    runSeed(seed) {
+    uint64_t hash = formulaHash(formula);
+
+    string contents;
+    {
+        ifstream in(path, ios::binary);
+        if (in.is_open()) {
+            contents.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        }
+    }
+
+    // a last line without its newline was cut short - drop it so appending starts on a fresh line
+    size_t complete = contents.rfind('\n');
+    complete = (complete == string::npos) ? 0 : complete + 1;
+    if (complete < contents.size()) {
+        LOG_WARNING("checkpoint " << path << ": ignoring an incomplete last record");
+        contents.resize(complete);
+        filesystem::resize_file(path, complete);
+    }
+
+    istringstream lines(contents);
+    string line;
+    bool haveHeader = false;
+    int lineNumber = 0;
+    while (getline(lines, line)) {
+        lineNumber++;
+        istringstream fields(line);
+        string kind;
+        fields >> kind;
+        try {
+            if (!haveHeader) {
+                int version = 0;
+                string seedField, formulaField, densityField, thresholdField;
+                if (kind != MAGIC || !(fields >> version >> seedField >> formulaField >> densityField >> thresholdField) || version != VERSION) {
+                    throw runtime_error("not a checkpoint file");
+                }
+                uint64_t fileSeed = stoull(fieldValue(seedField, "seed"));
+                if (stoull(fieldValue(formulaField, "formula")) != hash) {
+                    throw runtime_error("written for a different formula");
+                }
+                if (stod(fieldValue(densityField, "density")) != density || stoi(fieldValue(thresholdField, "threshold")) != threshold) {
+                    throw runtime_error("written with a different density or threshold");
+                }
+                // optional fields - absent in files written before they existed
+                bool fileNested = false;
+                uint64_t fileDensities = 0;
+                string field;
+                while (fields >> field) {
+                    if (field.compare(0, 7, "nested=") == 0) {
+                        fileNested = (fieldValue(field, "nested") == "1");
+                    } else {
+                        fileDensities = stoull(fieldValue(field, "densities"));
+                    }
+                }
+                if (fileNested != (family == HashFamily::NESTED)) {
+                    throw runtime_error("written with a different hash family");
+                }
+                if (fileDensities != densitiesHash) {
+                    throw runtime_error("written with different per-variable densities");
+                }
+                if (seed != 0 && seed != fileSeed) {
+                    throw runtime_error("written with seed " + to_string(fileSeed));
+                }
+                runSeed = fileSeed;
+                haveHeader = true;
+                continue;
+            }
+            int index = -1;
+            TrialResult trial;
+            if (!parseRecord(line, index, trial) || trial.aborted) {
+                throw runtime_error("malformed record");
+            }
+            resumed[index] = trial;
+        } catch (const logic_error&) {
+            // stoull / stod on a damaged field
+            throw runtime_error("Checkpoint " + path + " line " + to_string(lineNumber) + ": malformed field");
+        } catch (const runtime_error& e) {
+            throw runtime_error("Checkpoint " + path + " line " + to_string(lineNumber) + ": " + e.what());
+        }
+    }
+
+    out.open(path, ios::app);
+    if (!out.is_open()) {
+        throw runtime_error("Cannot write checkpoint " + path);
+    }
+    if (!haveHeader) {
+        if (runSeed == 0) {
+            runSeed = XORHashGenerator::drawSeed();
+        }
+        out << headerLine(runSeed, hash, density, threshold, family, densitiesHash) << "\n" << flush;
+    } else if (!resumed.empty()) {
+        LOG_INFO("checkpoint " << path << ": resuming with " << resumed.size() << " trials already done");
+    }
+}
+
+string TrialCheckpoint::formatRecord(int index, const TrialResult& trial) {
+    ostringstream out;
+    out << "trial " << index;
+    if (trial.aborted) {
+        out << " aborted";
+    } else {
+        out << " " << (trial.satisfiable ? 1 : 0) << " " << trial.cellCount << " " << trial.numXORs
+            << " " << trial.freeVariables << " " << trial.assignedVariables;
+    }
+    return out.str();
+}
+
+bool TrialCheckpoint::parseRecord(const string& line, int& index, TrialResult& trial) {
+    istringstream fields(line);
+    string kind, satisfiable;
+    if (!(fields >> kind >> index >> satisfiable) || kind != "trial" || index < 0) {
+        return false;
+    }
+    trial = TrialResult();
+    if (satisfiable == "aborted") {
+        trial.aborted = true;
+        return true;
+    }
+    if ((satisfiable != "0" && satisfiable != "1") || !(fields >> trial.cellCount >> trial.numXORs >> trial.freeVariables >> trial.assignedVariables)) {
+        return false;
+    }
+    trial.satisfiable = (satisfiable == "1");
+    return true;
+}
+
+bool TrialCheckpoint::recorded(int index, TrialResult& trial) const {
+    auto found = resumed.find(index);
+    if (found == resumed.end()) {
+        return false;
+    }
+    trial = found->second;
+    return true;
+}
+
+bool TrialCheckpoint::append(int index, const TrialResult& trial) {
+    if (trial.aborted || resumed.count(index)) {
+        return true;
+    }
+    out << formatRecord(index, trial) << "\n" << flush;
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,86 @@
+// Source file for truth-table model counting
+
+#include "solver/truth_table_counter.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// number of 64-assignment words evaluated per kernel call
+static const size_t CHUNK_WORDS = 64;
+
+// bit patterns of the 6 lowest variables within a 64-assignment word
+static const uint64_t LOW_VARIABLE_PATTERNS[6] = {
+    0xAAAAAAAAAAAAAAAAULL,
+    0xCCCCCCCCCCCCCCCCULL,
+    0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,
+    0xFFFF0000FFFF0000ULL,
+    0xFFFFFFFF00000000ULL
+};
+
+bool TruthTableCounter::countModels(const CNFFormula& formula, ModelCount& count, int maxVariables) {
+    // renumber the constrained variables 0..k-1 and flatten the clauses with the new numbering
+    vector<int> compact(formula.numVariables, -1);
+    int k = 0;
+    FlatClauses flat;
+    for (const auto& clause : formula.clauses) {
+        flat.clauseStarts.push_back(flat.literalCodes.size());
+        for (Literal lit : clause.literals) {
+            int var = abs(lit) - 1;
+            if (compact[var] == -1) {
+                if (k == maxVariables) {
+                    return false;
+                }
+                compact[var] = k++;
+            }
+            flat.literalCodes.push_back(2 * compact[var] + (lit < 0 ? 1 : 0));
+        }
+    }
+    flat.clauseStarts.push_back(flat.literalCodes.size());
+    flat.maxVariable = k;
+
+    // an empty clause can never be satisfied
+    for (const auto& clause : formula.clauses) {
+        if (clause.empty()) {
+            count = ModelCount();
+            return true;
+        }
+    }
+
+    // with fewer than 6 variables only the first 2^k bits of the single word are real assignments
+    uint64_t totalWords = (k > 6) ? (1ULL << (k - 6)) : 1;
+    uint64_t validMask = (k >= 6) ? ~0ULL : ((1ULL << (1 << k)) - 1);
+
+    EvaluationKernel kernel = ClauseEvaluator::detectKernel();
+    size_t chunkWords = min<uint64_t>(CHUNK_WORDS, totalWords);
+    vector<uint64_t> variableWords(static_cast<size_t>(k) * chunkWords);
+    vector<uint64_t> satisfied(chunkWords);
+
+    uint64_t constrainedCount = 0;
+    for (uint64_t firstWord = 0; firstWord < totalWords; firstWord += chunkWords) {
+        fillVariableWords(k, firstWord, chunkWords, variableWords);
+        ClauseEvaluator::evaluateWords(flat, variableWords.data(), chunkWords, chunkWords, satisfied.data(), kernel);
+        for (size_t w = 0; w < chunkWords; w++) {
+            constrainedCount += __builtin_popcountll(satisfied[w] & validMask);
+        }
+    }
+
+    // unconstrained variables double the count
+    count = ModelCount(constrainedCount, formula.numVariables - k);
+    return true;
+}
+
+void TruthTableCounter::fillVariableWords(int numVariables, uint64_t firstWord, size_t chunkWords, vector<uint64_t>& variableWords) {
+    for (int v = 0; v < numVariables; v++) {
+        uint64_t* row = variableWords.data() + static_cast<size_t>(v) * chunkWords;
+        for (size_t w = 0; w < chunkWords; w++) {
+            if (v < 6) {
+                row[w] = LOW_VARIABLE_PATTERNS[v];
+            } else {
+                // variables above the 6th are constant within a word
+                row[w] = (((firstWord + w) >> (v - 6)) & 1) ? ~0ULL : 0ULL;
+            }
+        }
+    }
+}
@@ -0,0 +1,233 @@
+// Source file for command line parsing
+
+#include "utils/command_line.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// value of a flag as a number - the whole string has to parse
+template <typename T>
+static T parseNumber(const string& flag, const string& value) {
+    istringstream in(value);
+    T result;
+    if (!(in >> result) || !in.eof()) {
+        throw runtime_error("Invalid value for " + flag + ": " + value);
+    }
+    return result;
+}
+
+CommandLineOptions CommandLine::parse(int argc, char* argv[]) {
+    CommandLineOptions options;
+    CountingOptions& counting = options.counting;
+
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+
+        // flags without a value
+        if (flag == "--help" || flag == "-h") {
+            options.help = true;
+            continue;
+        }
+        if (flag == "--perf") {
+            options.perf = true;
+            continue;
+        }
+        if (flag == "--verbose") {
+            options.verbose = true;
+            continue;
+        }
+        if (flag == "--no-early-stop") {
+            counting.earlyTermination = false;
+            continue;
+        }
+        if (flag == "--no-exact") {
+            counting.exactFallback = false;
+            continue;
+        }
+        if (flag == "--no-probe") {
+            counting.probeFailedLiterals = false;
+            continue;
+        }
+        if (flag == "--renumber") {
+            counting.renumberVariables = true;
+            continue;
+        }
+        if (flag == "--nested-hash") {
+            counting.hashFamily = HashFamily::NESTED;
+            continue;
+        }
+        if (flag == "--no-share-clauses") {
+            counting.shareLearnedClauses = false;
+            continue;
+        }
+        if (flag.compare(0, 2, "--") != 0) {
+            options.inputs.push_back(flag);
+            continue;
+        }
+
+        static const char* valueFlags[] = {"--trials", "--density", "--threshold", "--epsilon", "--delta", "--seed", "--threads",
+                                           "--timeout", "--trial-timeout", "--max-conflicts", "--format", "--list", "--stats-json",
+                                           "--checkpoint", "--trace", "--serve", "--cache-entries", "--coordinate", "--work",
+                                           "--hash-model"};
+        if (find(begin(valueFlags), end(valueFlags), flag) == end(valueFlags)) {
+            throw runtime_error("Unknown option " + flag);
+        }
+        if (i + 1 >= argc) {
+            throw runtime_error("Missing value for " + flag);
+        }
+        string value = argv[++i];
+        if (flag == "--trials") {
+            counting.maxTrials = parseNumber<int>(flag, value);
+        } else if (flag == "--density") {
+            counting.density = parseNumber<double>(flag, value);
+            if (counting.density <= 0 || counting.density > 1) {
+                throw runtime_error("--density must be in (0, 1]");
+            }
+        } else if (flag == "--threshold") {
+            counting.threshold = parseNumber<int>(flag, value);
+        } else if (flag == "--epsilon") {
+            counting.epsilon = parseNumber<double>(flag, value);
+            if (!(counting.epsilon > 0)) {
+                throw runtime_error("--epsilon must be positive");
+            }
+        } else if (flag == "--delta") {
+            counting.delta = parseNumber<double>(flag, value);
+            if (!(counting.delta > 0 && counting.delta < 1)) {
+                throw runtime_error("--delta must be in (0, 1)");
+            }
+        } else if (flag == "--seed") {
+            counting.seed = parseNumber<uint64_t>(flag, value);
+        } else if (flag == "--threads") {
+            counting.numThreads = parseNumber<int>(flag, value);
+        } else if (flag == "--timeout") {
+            counting.timeoutSeconds = parseNumber<double>(flag, value);
+        } else if (flag == "--trial-timeout") {
+            counting.trialTimeoutSeconds = parseNumber<double>(flag, value);
+        } else if (flag == "--max-conflicts") {
+            counting.maxConflictsPerSolve = parseNumber<uint64_t>(flag, value);
+        } else if (flag == "--format") {
+            if (value == "text") {
+                options.format = OutputFormat::TEXT;
+            } else if (value == "json") {
+                options.format = OutputFormat::JSON;
+            } else if (value == "csv") {
+                options.format = OutputFormat::CSV;
+            } else {
+                throw runtime_error("Unknown format " + value + " (expected text, json or csv)");
+            }
+        } else if (flag == "--list") {
+            options.listPath = value;
+        } else if (flag == "--checkpoint") {
+            counting.checkpointPath = value;
+        } else if (flag == "--stats-json") {
+            options.statsPath = value;
+        } else if (flag == "--trace") {
+            options.tracePath = value;
+        } else if (flag == "--serve") {
+            options.serveSocket = value;
+        } else if (flag == "--coordinate") {
+            options.coordinateDir = value;
+        } else if (flag == "--work") {
+            options.workDir = value;
+        } else if (flag == "--hash-model") {
+            options.hashModelPath = value;
+        } else if (flag == "--cache-entries") {
+            options.cacheEntries = parseNumber<size_t>(flag, value);
+        }
+    }
+
+    if (counting.maxTrials < 0 || counting.threshold < 0 || counting.numThreads < 0 || counting.timeoutSeconds < 0 || counting.trialTimeoutSeconds < 0) {
+        throw runtime_error("--trials, --threshold, --threads, --timeout and --trial-timeout must not be negative");
+    }
+    return options;
+}
+
+vector<string> CommandLine::collectInputs(const CommandLineOptions& options) {
+    namespace fs = std::filesystem;
+    vector<string> files;
+
+    for (const string& input : options.inputs) {
+        if (!fs::is_directory(input)) {
+            files.push_back(input);
+            continue;
+        }
+        vector<string> found;
+        for (const auto& entry : fs::directory_iterator(input)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".cnf") {
+                found.push_back(entry.path().string());
+            }
+        }
+        sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+
+    if (!options.listPath.empty()) {
+        ifstream listFile;
+        istream* list = &cin;
+        if (options.listPath != "-") {
+            listFile.open(options.listPath);
+            if (!listFile.is_open()) {
+                throw runtime_error("Cannot open list file: " + options.listPath);
+            }
+            list = &listFile;
+        }
+        string line;
+        while (getline(*list, line)) {
+            // trim, skip blank lines and comments
+            size_t start = line.find_first_not_of(" \t\r");
+            size_t end = line.find_last_not_of(" \t\r");
+            if (start == string::npos || line[start] == '#') {
+                continue;
+            }
+            files.push_back(line.substr(start, end - start + 1));
+        }
+    }
+    return files;
+}
+
+string CommandLine::usage(const string& program) {
+    ostringstream out;
+    out << "Usage: " << program << " [options] [file.cnf | directory ...]\n"
+        << "       " << program << " [options] --list <paths.txt | ->\n"
+        << "       " << program << " [options] --serve <socket path>\n"
+        << "       " << program << " [options] --coordinate <shared dir> file.cnf\n"
+        << "       " << program << " [options] --work <shared dir>\n"
+        << "Without inputs the CNF path is read from stdin.\n\n"
+        << "Counting:\n"
+        << "  --epsilon <e>       tolerance - estimate within a factor (1 + e) (default " << DEFAULT_EPSILON << ")\n"
+        << "  --delta <d>         confidence 1 - d (default " << DEFAULT_DELTA << ")\n"
+        << "  --trials <n>        trial budget (default: derived from delta)\n"
+        << "  --threshold <n>     cell size threshold (default: derived from epsilon)\n"
+        << "  --density <p>       XOR density (default 0.1)\n"
+        << "  --hash-model <path> per-variable XOR densities predicted by an exported hash model, instead of --density\n"
+        << "  --seed <n>          seed for reproducible runs (default: random)\n"
+        << "  --threads <n>       worker threads shared by all instances, 0 = all cores (default 1)\n"
+        << "  --timeout <s>       per instance - trials still running then are abandoned, the result is partial\n"
+        << "  --trial-timeout <s> per trial - a trial running longer is abandoned and left out of the estimate\n"
+        << "  --max-conflicts <n> per SAT call - a trial whose solver needs more is abandoned\n"
+        << "  --checkpoint <path> record finished trials - rerunning with the same path resumes (single input only)\n"
+        << "  --no-early-stop     run the whole trial budget\n"
+        << "  --no-exact          always count by hashing, even formulas the exact counter could take\n"
+        << "  --no-probe          skip failed literal probing before counting\n"
+        << "  --renumber          renumber variables for solver cache locality (Cuthill-McKee) before counting\n"
+        << "  --nested-hash       each XOR count adds to the XORs of the one before - the XOR count is binary searched\n"
+        << "  --no-share-clauses  keep each SAT call's learned clauses to itself\n\n"
+        << "Output:\n"
+        << "  --format <f>        text, json (one object per line) or csv (default text)\n"
+        << "  --stats-json <path> phase timers and solver counters (single input only)\n"
+        << "  --perf              add hardware counters to the coarse phase timers\n"
+        << "  --trace <path>      Chrome / Perfetto trace of trials and solver calls\n"
+        << "  --verbose           log progress to stderr\n\n"
+        << "Server:\n"
+        << "  --serve <path>      answer COUNT requests on a Unix socket (the counting options are the defaults)\n"
+        << "  --cache-entries <n> parsed formulas kept in memory (default " << SERVER_CACHE_MAX_ENTRIES << ")\n\n"
+        << "Sharded counting (processes on any hosts sharing the directory):\n"
+        << "  --coordinate <dir>  queue the trials of the single input on dir and merge the workers' results\n"
+        << "  --work <dir>        run queued trials until the coordinator is done\n";
+    return out.str();
+}
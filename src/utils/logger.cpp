@@ -1,2 +1,53 @@
-// Implementation for logging and debugging output
-// Provides structured logging for tracking solver progress and debugging
+// Source file for logging utilities
+// Implementation of logging functions with different severity levels
+
+#include "utils/logger.h"
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+static atomic<int> currentLevel(static_cast<int>(LogLevel::WARNING));
+static mutex outputMutex;
+
+void Logger::setLevel(LogLevel level) {
+    currentLevel.store(static_cast<int>(level));
+}
+
+LogLevel Logger::getLevel() {
+    return static_cast<LogLevel>(currentLevel.load());
+}
+
+void Logger::log(LogLevel level, const string& message) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    lock_guard<mutex> lock(outputMutex);
+    cerr << "[" << levelName(level) << "] " << message << endl;
+}
+
+bool Logger::writeJSON(const string& path, const string& json) {
+    if (path == "-") {
+        lock_guard<mutex> lock(outputMutex);
+        cout << json << endl;
+        return true;
+    }
+    ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << json << endl;
+    return file.good();
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "NONE";
+    }
+}
@@ -0,0 +1,177 @@
+// Source file for hardware performance counters
+
+#include "utils/perf_counters.h"
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_COUNTERS_LINUX 1
+#endif
+
+using namespace std;
+
+atomic<bool> PerfCounters::enabled(false);
+
+struct PerfCounters::ThreadCounters {
+    bool attempted;
+    bool available;
+    int leaderFd;
+    int fds[NUM_HARDWARE_EVENTS];
+    int groupIndex[NUM_HARDWARE_EVENTS];    // position of each event in a group read, -1 if not opened
+    int groupSize;
+    
+    ThreadCounters() : attempted(false), available(false), leaderFd(-1), groupSize(0) {
+        for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) {
+            fds[i] = -1;
+            groupIndex[i] = -1;
+        }
+    }
+    
+    ~ThreadCounters() {
+#ifdef PERF_COUNTERS_LINUX
+        for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) {
+            if (fds[i] != -1) {
+                close(fds[i]);
+            }
+        }
+#endif
+    }
+    
+    void open();
+};
+
+#ifdef PERF_COUNTERS_LINUX
+
+static int openEvent(uint32_t type, uint64_t config, int groupFd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (groupFd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+void PerfCounters::ThreadCounters::open() {
+    attempted = true;
+    
+    const uint32_t types[NUM_HARDWARE_EVENTS] = {
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE
+    };
+    const uint64_t configs[NUM_HARDWARE_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+    
+    // cycles lead the group - without it there is nothing worth reporting
+    leaderFd = openEvent(types[0], configs[0], -1);
+    if (leaderFd == -1) {
+        return;
+    }
+    fds[0] = leaderFd;
+    groupIndex[0] = groupSize++;
+    
+    for (int i = 1; i < NUM_HARDWARE_EVENTS; i++) {
+        fds[i] = openEvent(types[i], configs[i], leaderFd);
+        if (fds[i] != -1) {
+            groupIndex[i] = groupSize++;
+        }
+    }
+    
+    ioctl(leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    available = true;
+}
+
+#else
+
+void PerfCounters::ThreadCounters::open() {
+    attempted = true;
+}
+
+#endif
+
+PerfCounters::ThreadCounters& PerfCounters::local() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+bool PerfCounters::enable() {
+    ThreadCounters& counters = local();
+    if (!counters.attempted) {
+        counters.open();
+    }
+    enabled.store(counters.available, memory_order_relaxed);
+    return counters.available;
+}
+
+void PerfCounters::disable() {
+    enabled.store(false, memory_order_relaxed);
+}
+
+bool PerfCounters::read(HardwareSample& sample) {
+    ThreadCounters& counters = local();
+    if (!counters.attempted) {
+        counters.open();
+    }
+    if (!counters.available) {
+        return false;
+    }
+    
+#ifdef PERF_COUNTERS_LINUX
+    // group read layout: nr, time enabled, time running, then one value per opened event
+    uint64_t buffer[3 + NUM_HARDWARE_EVENTS];
+    ssize_t expected = sizeof(uint64_t) * (3 + counters.groupSize);
+    if (::read(counters.leaderFd, buffer, sizeof(buffer)) < expected) {
+        return false;
+    }
+    sample.timeEnabled = buffer[1];
+    sample.timeRunning = buffer[2];
+    for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) {
+        sample.values[i] = (counters.groupIndex[i] == -1) ? 0 : buffer[3 + counters.groupIndex[i]];
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::difference(const HardwareSample& start, const HardwareSample& end, uint64_t counts[NUM_HARDWARE_EVENTS]) {
+    uint64_t enabled = end.timeEnabled - start.timeEnabled;
+    uint64_t running = end.timeRunning - start.timeRunning;
+    for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) {
+        uint64_t raw = end.values[i] - start.values[i];
+        if (running == 0) {
+            // never on the PMU in between - nothing to scale from
+            counts[i] = 0;
+        } else if (running >= enabled) {
+            counts[i] = raw;
+        } else {
+            counts[i] = static_cast<uint64_t>(static_cast<double>(raw) * enabled / running);
+        }
+    }
+}
+
+const char* PerfCounters::eventName(HardwareEvent event) {
+    switch (event) {
+        case HardwareEvent::CYCLES: return "cycles";
+        case HardwareEvent::INSTRUCTIONS: return "instructions";
+        case HardwareEvent::L1D_READ_MISSES: return "l1d_read_misses";
+        case HardwareEvent::LLC_MISSES: return "llc_misses";
+        case HardwareEvent::BRANCH_MISSES: return "branch_misses";
+        default: return "unknown";
+    }
+}
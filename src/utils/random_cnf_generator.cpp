@@ -1,2 +1,401 @@
 // Implementation for generating random CNF formulas
 // Creates random Boolean formulas for stress testing the solver
+
+#include "utils/random_cnf_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t DIMACS_BUFFER_SIZE = 1 << 20;
+
+// clause/variable ratio of RANDOM_COMPONENTS components - below the 3-SAT threshold so most have models
+constexpr double RANDOM_COMPONENT_RATIO = 2.5;
+
+uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// number of clauses for round(ratio * numVariables), rejecting nonsense input
+uint64_t clauseCount(int numVariables, int k, double ratio) {
+    if (numVariables <= 0 || k <= 0 || k > numVariables) {
+        throw runtime_error("Random k-SAT needs 0 < k <= numVariables (k = " + to_string(k) + ", variables = " + to_string(numVariables) + ")");
+    }
+    if (!(ratio >= 0.0)) {
+        throw runtime_error("Clause/variable ratio must be non-negative");
+    }
+    return static_cast<uint64_t>(llround(ratio * numVariables));
+}
+
+// component being built for knownCount - local variables are 0-indexed, mapped through the shuffle when emitted
+struct Component {
+    KnownCountFamily family;
+    int size;           // variables in the family's own sense (chain length, group size, ...)
+    int numVariables;   // including auxiliary variables
+    uint64_t numClauses;
+};
+
+Component describeComponent(KnownCountFamily family, int size) {
+    Component comp;
+    comp.family = family;
+    comp.size = size;
+    comp.numVariables = size;
+    switch (family) {
+        case KnownCountFamily::XOR_CHAINS:
+            // x1 .. xm plus m - 2 chain variables: a1 = x1 ^ x2, a(j) = a(j-1) ^ x(j+1), a(m-2) ^ xm = parity
+            comp.numVariables = size + max(0, size - 2);
+            comp.numClauses = (size == 1) ? 1 : (size == 2) ? 2 : 4ULL * (size - 2) + 2;
+            break;
+        case KnownCountFamily::EXACTLY_ONE:
+            comp.numClauses = 1 + static_cast<uint64_t>(size) * (size - 1) / 2;
+            break;
+        default:
+            comp.numClauses = static_cast<uint64_t>(llround(RANDOM_COMPONENT_RATIO * size));
+            break;
+    }
+    return comp;
+}
+
+// models of a small clause list over numVariables <= 20 variables
+// clause c is satisfied by assignment bits iff (bits & pos[c]) | (~bits & neg[c]) is non-zero
+uint64_t countSmall(int numVariables, const vector<uint32_t>& pos, const vector<uint32_t>& neg) {
+    uint64_t count = 0;
+    for (uint32_t bits = 0; bits < (1U << numVariables); bits++) {
+        bool satisfied = true;
+        for (size_t c = 0; c < pos.size() && satisfied; c++) {
+            satisfied = ((bits & pos[c]) | (~bits & neg[c])) != 0;
+        }
+        count += satisfied;
+    }
+    return count;
+}
+
+}
+
+//
+// FastRandom IMPLEMENTATION
+//
+
+FastRandom::FastRandom(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < 4; i++) {
+        state[i] = splitmix64(x);
+    }
+}
+
+
+//
+// Sinks
+//
+
+void FormulaSink::begin(int numVariables, uint64_t numClauses) {
+    formula.numVariables = numVariables;
+    formula.numClauses = static_cast<int>(numClauses);
+    formula.clauses.reserve(formula.clauses.size() + numClauses);
+}
+
+void FormulaSink::addClause(const Literal* literals, int size) {
+    formula.clauses.emplace_back();
+    formula.clauses.back().literals.assign(literals, literals + size);
+}
+
+DimacsFileSink::DimacsFileSink(const string& path) : file(path, ios::binary), buffer(DIMACS_BUFFER_SIZE), used(0) {
+    if (!file.is_open()) {
+        throw runtime_error("Could not open " + path + " for writing");
+    }
+}
+
+DimacsFileSink::~DimacsFileSink() {
+    if (file.is_open()) {
+        flush();
+    }
+}
+
+void DimacsFileSink::begin(int numVariables, uint64_t numClauses) {
+    const char header[] = "p cnf ";
+    copy(header, header + sizeof(header) - 1, buffer.begin() + used);
+    used += sizeof(header) - 1;
+    writeInt(numVariables);
+    buffer[used++] = ' ';
+    writeInt(static_cast<long long>(numClauses));
+    buffer[used++] = '\n';
+}
+
+void DimacsFileSink::addClause(const Literal* literals, int size) {
+    // worst case 12 bytes per literal plus "0\n"
+    if (used + 12 * static_cast<size_t>(size) + 2 > buffer.size()) {
+        flush();
+        if (12 * static_cast<size_t>(size) + 2 > buffer.size()) {
+            buffer.resize(12 * static_cast<size_t>(size) + 2);
+        }
+    }
+    for (int i = 0; i < size; i++) {
+        writeInt(literals[i]);
+        buffer[used++] = ' ';
+    }
+    buffer[used++] = '0';
+    buffer[used++] = '\n';
+}
+
+void DimacsFileSink::close() {
+    flush();
+    file.close();
+    if (file.fail()) {
+        throw runtime_error("Writing the DIMACS file failed");
+    }
+}
+
+void DimacsFileSink::flush() {
+    file.write(buffer.data(), used);
+    used = 0;
+}
+
+void DimacsFileSink::writeInt(long long value) {
+    if (value < 0) {
+        buffer[used++] = '-';
+        value = -value;
+    }
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n > 0) {
+        buffer[used++] = digits[--n];
+    }
+}
+
+
+//
+// RandomCNFGenerator IMPLEMENTATION
+//
+
+void RandomCNFGenerator::randomClause(FastRandom& rng, int numVariables, int k, Literal* literals) {
+    for (int i = 0; i < k; i++) {
+        int var;
+        bool duplicate;
+        do {
+            var = static_cast<int>(rng.below(numVariables)) + 1;
+            duplicate = false;
+            for (int j = 0; j < i; j++) {
+                duplicate |= (abs(literals[j]) == var);
+            }
+        } while (duplicate);
+        literals[i] = rng.coin() ? var : -var;
+    }
+}
+
+GeneratedInstance RandomCNFGenerator::randomKSAT(ClauseSink& sink, int numVariables, int k, double ratio, uint64_t seed) {
+    GeneratedInstance info;
+    info.numVariables = numVariables;
+    info.numClauses = clauseCount(numVariables, k, ratio);
+
+    FastRandom rng(seed);
+    vector<Literal> literals(k);
+    sink.begin(numVariables, info.numClauses);
+    for (uint64_t c = 0; c < info.numClauses; c++) {
+        randomClause(rng, numVariables, k, literals.data());
+        sink.addClause(literals.data(), k);
+    }
+    return info;
+}
+
+GeneratedInstance RandomCNFGenerator::plantedKSAT(ClauseSink& sink, int numVariables, int k, double ratio, uint64_t seed) {
+    GeneratedInstance info;
+    info.numVariables = numVariables;
+    info.numClauses = clauseCount(numVariables, k, ratio);
+
+    FastRandom rng(seed);
+    info.planted.resize(numVariables);
+    for (int i = 0; i < numVariables; i++) {
+        info.planted[i] = rng.coin();
+    }
+
+    vector<Literal> literals(k);
+    sink.begin(numVariables, info.numClauses);
+    for (uint64_t c = 0; c < info.numClauses; c++) {
+        randomClause(rng, numVariables, k, literals.data());
+
+        // redraw the signs until the hidden assignment satisfies the clause (expected 2^k / (2^k - 1) tries)
+        bool satisfied = false;
+        while (!satisfied) {
+            for (int i = 0; i < k; i++) {
+                int var = abs(literals[i]);
+                satisfied |= ((literals[i] > 0) == (info.planted[var - 1] == 1));
+            }
+            if (!satisfied) {
+                for (int i = 0; i < k; i++) {
+                    literals[i] = rng.coin() ? abs(literals[i]) : -abs(literals[i]);
+                }
+            }
+        }
+        sink.addClause(literals.data(), k);
+    }
+    return info;
+}
+
+GeneratedInstance RandomCNFGenerator::knownCount(ClauseSink& sink, KnownCountFamily family, int numComponents, int componentSize, int freeVariables, uint64_t seed) {
+    if (numComponents < 0 || componentSize <= 0 || freeVariables < 0) {
+        throw runtime_error("Known-count instances need a positive component size and non-negative counts");
+    }
+    bool randomComponents = (family == KnownCountFamily::RANDOM_COMPONENTS || family == KnownCountFamily::MIXED);
+    if (randomComponents && componentSize > MAX_RANDOM_COMPONENT_SIZE) {
+        throw runtime_error("Random components are limited to " + to_string(MAX_RANDOM_COMPONENT_SIZE) + " variables");
+    }
+
+    // lay out the components first so the totals are known before the first clause is emitted
+    const KnownCountFamily cycle[3] = {KnownCountFamily::XOR_CHAINS, KnownCountFamily::EXACTLY_ONE, KnownCountFamily::RANDOM_COMPONENTS};
+    vector<Component> components;
+    components.reserve(numComponents);
+    GeneratedInstance info;
+    info.numVariables = freeVariables;
+    for (int i = 0; i < numComponents; i++) {
+        components.push_back(describeComponent(family == KnownCountFamily::MIXED ? cycle[i % 3] : family, componentSize));
+        info.numVariables += components.back().numVariables;
+        info.numClauses += components.back().numClauses;
+    }
+    if (info.numVariables == 0) {
+        throw runtime_error("Known-count instance has no variables");
+    }
+
+    // shuffle variable ids so components are spread over the whole range
+    FastRandom rng(seed);
+    vector<int> ids(info.numVariables);
+    for (int i = 0; i < info.numVariables; i++) {
+        ids[i] = i + 1;
+    }
+    for (int i = info.numVariables - 1; i > 0; i--) {
+        swap(ids[i], ids[rng.below(i + 1)]);
+    }
+
+    // the count is the product over components times 2^freeVariables - odd parts multiply, powers of two add up
+    uint64_t oddPart = 1;
+    int exponent = freeVariables;
+    bool fits = true;
+    info.countKnown = true;
+    info.log2Count = freeVariables;
+    auto multiplyCount = [&](uint64_t count) {
+        info.log2Count += log2(static_cast<double>(count));
+        while ((count & 1) == 0) {
+            count >>= 1;
+            exponent++;
+        }
+        if (oddPart > UINT64_MAX / count) {
+            fits = false;
+        } else {
+            oddPart *= count;
+        }
+    };
+
+    sink.begin(info.numVariables, info.numClauses);
+    int base = 0;
+    Literal lits[3];
+    for (const Component& comp : components) {
+        // local 0-indexed variable v with a sign -> literal of the shuffled id
+        auto lit = [&](int v, bool positive) { return positive ? ids[base + v] : -ids[base + v]; };
+        int m = comp.size;
+
+        if (comp.family == KnownCountFamily::XOR_CHAINS) {
+            bool parity = rng.coin();
+            if (m == 1) {
+                lits[0] = lit(0, parity);
+                sink.addClause(lits, 1);
+            } else {
+                // chain variable j (0-indexed) is local variable m + j; "last" is the value XORed with the final x
+                int last = 0;
+                for (int j = 0; j + 2 < m; j++) {
+                    int a = m + j;
+                    int x = (j == 0) ? 0 : last;
+                    int y = j + 1;
+                    // a = x ^ y
+                    lits[0] = lit(a, false); lits[1] = lit(x, true); lits[2] = lit(y, true); sink.addClause(lits, 3);
+                    lits[0] = lit(a, false); lits[1] = lit(x, false); lits[2] = lit(y, false); sink.addClause(lits, 3);
+                    lits[0] = lit(a, true); lits[1] = lit(x, false); lits[2] = lit(y, true); sink.addClause(lits, 3);
+                    lits[0] = lit(a, true); lits[1] = lit(x, true); lits[2] = lit(y, false); sink.addClause(lits, 3);
+                    last = a;
+                }
+                // last ^ x(m-1) = parity
+                int x = last;
+                int y = m - 1;
+                lits[0] = lit(x, true); lits[1] = lit(y, parity); sink.addClause(lits, 2);
+                lits[0] = lit(x, false); lits[1] = lit(y, !parity); sink.addClause(lits, 2);
+            }
+            multiplyCount(1ULL << (m - 1));
+        } else if (comp.family == KnownCountFamily::EXACTLY_ONE) {
+            vector<Literal> atLeastOne(m);
+            for (int v = 0; v < m; v++) {
+                atLeastOne[v] = lit(v, true);
+            }
+            sink.addClause(atLeastOne.data(), m);
+            for (int v = 0; v < m; v++) {
+                for (int w = v + 1; w < m; w++) {
+                    lits[0] = lit(v, false);
+                    lits[1] = lit(w, false);
+                    sink.addClause(lits, 2);
+                }
+            }
+            multiplyCount(m);
+        } else {
+            // draw random 3-CNF components until one has models - counted by enumeration over its m variables
+            int k = min(3, m);
+            vector<Literal> clauses(comp.numClauses * k);
+            vector<uint32_t> pos(comp.numClauses);
+            vector<uint32_t> neg(comp.numClauses);
+            uint64_t count = 0;
+            while (count == 0) {
+                for (uint64_t c = 0; c < comp.numClauses; c++) {
+                    randomClause(rng, m, k, &clauses[c * k]);
+                    pos[c] = 0;
+                    neg[c] = 0;
+                    for (int i = 0; i < k; i++) {
+                        Literal l = clauses[c * k + i];
+                        (l > 0 ? pos[c] : neg[c]) |= 1U << (abs(l) - 1);
+                    }
+                }
+                count = countSmall(m, pos, neg);
+            }
+            for (uint64_t c = 0; c < comp.numClauses; c++) {
+                for (int i = 0; i < k; i++) {
+                    Literal l = clauses[c * k + i];
+                    lits[i] = lit(abs(l) - 1, l > 0);
+                }
+                sink.addClause(lits, k);
+            }
+            multiplyCount(count);
+        }
+        base += comp.numVariables;
+    }
+
+    if (fits) {
+        info.count = ModelCount(oddPart, exponent);
+    }
+    return info;
+}
+
+unique_ptr<CNFFormula> RandomCNFGenerator::randomKSAT(int numVariables, int k, double ratio, uint64_t seed) {
+    auto formula = make_unique<CNFFormula>();
+    FormulaSink sink(*formula);
+    randomKSAT(sink, numVariables, k, ratio, seed);
+    return formula;
+}
+
+unique_ptr<CNFFormula> RandomCNFGenerator::plantedKSAT(int numVariables, int k, double ratio, uint64_t seed) {
+    auto formula = make_unique<CNFFormula>();
+    FormulaSink sink(*formula);
+    plantedKSAT(sink, numVariables, k, ratio, seed);
+    return formula;
+}
+
+unique_ptr<CNFFormula> RandomCNFGenerator::knownCount(KnownCountFamily family, int numComponents, int componentSize, int freeVariables, uint64_t seed, GeneratedInstance& info) {
+    auto formula = make_unique<CNFFormula>();
+    FormulaSink sink(*formula);
+    info = knownCount(sink, family, numComponents, componentSize, freeVariables, seed);
+    return formula;
+}
@@ -0,0 +1,100 @@
+// Source file for the worker thread pool
+
+#include "utils/thread_pool.h"
+#include "utils/trace.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int numThreads) : nextGroup(NO_GROUP + 1), stopping(false) {
+    if (numThreads <= 0) {
+        numThreads = hardwareThreads();
+    }
+    workers.reserve(numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::hardwareThreads() {
+    unsigned int count = thread::hardware_concurrency();
+    return (count == 0) ? 1 : static_cast<int>(count);
+}
+
+void ThreadPool::enqueue(function<void()> task, uint64_t group) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        tasks.push_back({move(task), group});
+    }
+    available.notify_one();
+    if (group != NO_GROUP) {
+        progress.notify_all();
+    }
+}
+
+bool ThreadPool::hasTask(uint64_t group) const {
+    for (const auto& task : tasks) {
+        if (task.group == group) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::runPendingTask(uint64_t group) {
+    QueuedTask task;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        auto it = tasks.begin();
+        while (it != tasks.end() && it->group != group) {
+            ++it;
+        }
+        if (group == NO_GROUP || it == tasks.end()) {
+            return false;
+        }
+        task = move(*it);
+        tasks.erase(it);
+    }
+    runTask(task);
+    return true;
+}
+
+// every finished task may be the one an await is sleeping on - taking the lock orders
+// the wakeup after an await that has just found its future not ready
+void ThreadPool::runTask(QueuedTask& task) {
+    task.run();
+    {
+        lock_guard<mutex> lock(queueMutex);
+    }
+    progress.notify_all();
+}
+
+void ThreadPool::workerLoop(int index) {
+    if (TraceRecorder::isEnabled()) {
+        TraceRecorder::setThreadName("worker " + to_string(index));
+    }
+
+    while (true) {
+        QueuedTask task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            available.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;  // stopping and drained
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        runTask(task);
+    }
+}
@@ -0,0 +1,124 @@
+// Source file for performance timing utilities
+
+#include "utils/timer.h"
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+void PhaseStats::clear() {
+    for (int i = 0; i < NUM_PHASES; i++) {
+        phaseNanos[i] = 0;
+        phaseCalls[i] = 0;
+        for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+            hardware[i][e] = 0;
+        }
+    }
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        counters[i] = 0;
+    }
+}
+
+void PhaseStats::merge(const PhaseStats& other) {
+    for (int i = 0; i < NUM_PHASES; i++) {
+        phaseNanos[i] += other.phaseNanos[i];
+        phaseCalls[i] += other.phaseCalls[i];
+        for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+            hardware[i][e] += other.hardware[i][e];
+        }
+    }
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        counters[i] += other.counters[i];
+    }
+}
+
+PhaseStats PhaseStats::since(const PhaseStats& earlier) const {
+    PhaseStats diff;
+    for (int i = 0; i < NUM_PHASES; i++) {
+        diff.phaseNanos[i] = phaseNanos[i] - earlier.phaseNanos[i];
+        diff.phaseCalls[i] = phaseCalls[i] - earlier.phaseCalls[i];
+        for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+            diff.hardware[i][e] = hardware[i][e] - earlier.hardware[i][e];
+        }
+    }
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        diff.counters[i] = counters[i] - earlier.counters[i];
+    }
+    return diff;
+}
+
+string PhaseStats::toJSON() const {
+    ostringstream out;
+    out << "{\"phases\": {";
+    for (int i = 0; i < NUM_PHASES; i++) {
+        if (i > 0) {
+            out << ", ";
+        }
+        out << "\"" << Stats::phaseName(static_cast<Phase>(i)) << "\": {\"seconds\": "
+            << fixed << setprecision(9) << phaseNanos[i] * 1e-9
+            << ", \"calls\": " << phaseCalls[i];
+        
+        // hardware counters, with IPC and misses per 1000 instructions
+        uint64_t cycles = hardware[i][static_cast<int>(HardwareEvent::CYCLES)];
+        uint64_t instructions = hardware[i][static_cast<int>(HardwareEvent::INSTRUCTIONS)];
+        if (cycles > 0) {
+            for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+                out << ", \"" << PerfCounters::eventName(static_cast<HardwareEvent>(e)) << "\": " << hardware[i][e];
+            }
+            out << setprecision(4) << ", \"ipc\": " << static_cast<double>(instructions) / cycles;
+            if (instructions > 0) {
+                double perKilo = 1000.0 / instructions;
+                out << ", \"l1d_mpki\": " << hardware[i][static_cast<int>(HardwareEvent::L1D_READ_MISSES)] * perKilo
+                    << ", \"llc_mpki\": " << hardware[i][static_cast<int>(HardwareEvent::LLC_MISSES)] * perKilo
+                    << ", \"branch_mpki\": " << hardware[i][static_cast<int>(HardwareEvent::BRANCH_MISSES)] * perKilo;
+            }
+        }
+        out << "}";
+    }
+    out << "}, \"counters\": {";
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (i > 0) {
+            out << ", ";
+        }
+        out << "\"" << Stats::counterName(static_cast<Counter>(i)) << "\": " << counters[i];
+    }
+    out << "}}";
+    return out.str();
+}
+
+PhaseStats& Stats::local() {
+    thread_local PhaseStats stats;
+    return stats;
+}
+
+const char* Stats::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::PARSE: return "parse";
+        case Phase::HASH_GENERATION: return "hash_generation";
+        case Phase::GAUSSIAN_ELIMINATION: return "gaussian_elimination";
+        case Phase::SIMPLIFICATION: return "simplification";
+        case Phase::CELL_COUNTING: return "cell_counting";
+        case Phase::EXACT_COUNTING: return "exact_counting";
+        case Phase::SAT_SOLVING: return "sat_solving";
+        default: return "unknown";
+    }
+}
+
+const char* Stats::counterName(Counter counter) {
+    switch (counter) {
+        case Counter::SOLVER_CALLS: return "solver_calls";
+        case Counter::PROPAGATIONS: return "propagations";
+        case Counter::CONFLICTS: return "conflicts";
+        case Counter::DECISIONS: return "decisions";
+        case Counter::RESTARTS: return "restarts";
+        case Counter::MODELS_ENUMERATED: return "models_enumerated";
+        case Counter::TRUTH_TABLE_CELLS: return "truth_table_cells";
+        case Counter::EXACT_CELLS: return "exact_cells";
+        case Counter::BINARY_PROPAGATIONS: return "binary_propagations";
+        case Counter::FAILED_LITERALS: return "failed_literals";
+        case Counter::REUSED_CELLS: return "reused_cells";
+        case Counter::SHARED_CLAUSES_EXPORTED: return "shared_clauses_exported";
+        case Counter::SHARED_CLAUSES_IMPORTED: return "shared_clauses_imported";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,178 @@
+// Source file for trace-event recording
+
+#include "utils/trace.h"
+#include "utils/logger.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t TRACE_CHUNK_EVENTS = 4096;
+
+// all timestamps are relative to the first use of the recorder
+chrono::steady_clock::time_point traceEpoch() {
+    static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    return epoch;
+}
+
+atomic<int> nextThreadId(1);
+
+void writeEscaped(ostringstream& out, const string& text) {
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            out << '\\';
+        }
+        out << ch;
+    }
+}
+
+}
+
+atomic<bool> TraceRecorder::enabled(false);
+atomic<TraceRecorder::ThreadBuffer*> TraceRecorder::buffers(nullptr);
+
+// Fixed block of events - only the owning thread writes, size is published after the event is complete
+struct TraceRecorder::Chunk {
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+    atomic<uint32_t> size;
+    atomic<Chunk*> next;
+
+    Chunk() : size(0), next(nullptr) {}
+};
+
+struct TraceRecorder::ThreadBuffer {
+    int threadId;
+    string threadName;
+    Chunk* head;
+    Chunk* tail;
+    ThreadBuffer* nextBuffer;   // registry link
+
+    ThreadBuffer() : threadId(nextThreadId.fetch_add(1)), head(new Chunk()), tail(head), nextBuffer(nullptr) {}
+
+    void append(const TraceEvent& event) {
+        uint32_t size = tail->size.load(memory_order_relaxed);
+        if (size == TRACE_CHUNK_EVENTS) {
+            Chunk* chunk = new Chunk();
+            tail->next.store(chunk, memory_order_release);
+            tail = chunk;
+            size = 0;
+        }
+        tail->events[size] = event;
+        tail->size.store(size + 1, memory_order_release);
+    }
+};
+
+TraceRecorder::ThreadBuffer& TraceRecorder::local() {
+    // registered on first use and never freed - the events outlive the thread until they are written out
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        buffer = new ThreadBuffer();
+        ThreadBuffer* head = buffers.load(memory_order_relaxed);
+        do {
+            buffer->nextBuffer = head;
+        } while (!buffers.compare_exchange_weak(head, buffer, memory_order_release, memory_order_relaxed));
+    }
+    return *buffer;
+}
+
+void TraceRecorder::enable() {
+    traceEpoch();
+    enabled.store(true, memory_order_relaxed);
+}
+
+void TraceRecorder::disable() {
+    enabled.store(false, memory_order_relaxed);
+}
+
+void TraceRecorder::setThreadName(const string& name) {
+    local().threadName = name;
+}
+
+uint64_t TraceRecorder::now() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - traceEpoch()).count();
+}
+
+void TraceRecorder::recordSpan(const char* name, const char* category, uint64_t startNanos, uint64_t durationNanos, const char* argName, int64_t arg) {
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.argName = argName;
+    event.arg = arg;
+    event.startNanos = startNanos;
+    event.durationNanos = durationNanos;
+    event.type = 'X';
+    local().append(event);
+}
+
+void TraceRecorder::recordInstant(const char* name, const char* category, const char* argName, int64_t arg) {
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.argName = argName;
+    event.arg = arg;
+    event.startNanos = now();
+    event.durationNanos = 0;
+    event.type = 'i';
+    local().append(event);
+}
+
+size_t TraceRecorder::eventCount() {
+    size_t count = 0;
+    for (ThreadBuffer* buffer = buffers.load(memory_order_acquire); buffer != nullptr; buffer = buffer->nextBuffer) {
+        for (Chunk* chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(memory_order_acquire)) {
+            count += chunk->size.load(memory_order_acquire);
+        }
+    }
+    return count;
+}
+
+string TraceRecorder::toJSON() {
+    ostringstream out;
+    out << fixed << setprecision(3);
+    out << "{\"traceEvents\": [";
+    bool first = true;
+
+    for (ThreadBuffer* buffer = buffers.load(memory_order_acquire); buffer != nullptr; buffer = buffer->nextBuffer) {
+        // track label
+        if (!first) {
+            out << ",";
+        }
+        first = false;
+        out << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadId << ", \"args\": {\"name\": \"";
+        if (buffer->threadName.empty()) {
+            out << "thread " << buffer->threadId;
+        } else {
+            writeEscaped(out, buffer->threadName);
+        }
+        out << "\"}}";
+
+        // timestamps are in microseconds
+        for (Chunk* chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(memory_order_acquire)) {
+            uint32_t size = chunk->size.load(memory_order_acquire);
+            for (uint32_t i = 0; i < size; i++) {
+                const TraceEvent& event = chunk->events[i];
+                out << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+                    << "\", \"ph\": \"" << event.type << "\", \"pid\": 1, \"tid\": " << buffer->threadId
+                    << ", \"ts\": " << event.startNanos / 1000.0;
+                if (event.type == 'X') {
+                    out << ", \"dur\": " << event.durationNanos / 1000.0;
+                } else {
+                    out << ", \"s\": \"t\"";
+                }
+                if (event.argName != nullptr) {
+                    out << ", \"args\": {\"" << event.argName << "\": " << event.arg << "}";
+                }
+                out << "}";
+            }
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ms\"}";
+    return out.str();
+}
+
+bool TraceRecorder::writeJSON(const string& path) {
+    return Logger::writeJSON(path, toJSON());
+}
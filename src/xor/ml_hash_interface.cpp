@@ -1,2 +1,219 @@
-// Interface to the machine learning model for hash generation
-// Connects C++ solver to Python ML model for guided XOR hash creation
+// Source file for ML hash interface
+
+#include "xor/ml_hash_interface.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const char* const MAGIC = "amc-hash-model";
+const int VERSION = 1;
+
+// next number of the model - throws if there is none
+double readNumber(istream& in, const char* what) {
+    string token;
+    if (!(in >> token)) {
+        throw runtime_error(string("missing ") + what);
+    }
+    size_t used = 0;
+    double value = 0;
+    try {
+        value = stod(token, &used);
+    } catch (const logic_error&) {
+        used = 0;
+    }
+    if (used != token.size() || !isfinite(value)) {
+        throw runtime_error(string("bad ") + what + " '" + token + "'");
+    }
+    return value;
+}
+
+int readCount(istream& in, const char* what) {
+    double value = readNumber(in, what);
+    if (value < 1 || value != floor(value) || value > (1 << 20)) {
+        throw runtime_error(string("bad ") + what);
+    }
+    return static_cast<int>(value);
+}
+
+}
+
+MLHashModel::MLHashModel(const string& path) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot open hash model " + path);
+    }
+    // comment lines dropped, the rest read as one stream of tokens
+    string text;
+    string line;
+    while (getline(file, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first != string::npos && line[first] != '#') {
+            text += line;
+            text += '\n';
+        }
+    }
+
+    try {
+        istringstream in(text);
+        string magic, featuresField;
+        int version = 0;
+        if (!(in >> magic >> version >> featuresField) || magic != MAGIC || version != VERSION) {
+            throw runtime_error("not a hash model file");
+        }
+        if (featuresField != "features=" + to_string(NUM_FEATURES)) {
+            throw runtime_error("expected features=" + to_string(NUM_FEATURES) + ", got " + featuresField);
+        }
+
+        int width = NUM_FEATURES;
+        string kind;
+        while (in >> kind) {
+            if (kind == "normalize") {
+                if (!layers.empty() || !mean.empty()) {
+                    throw runtime_error("normalize has to come once, before the layers");
+                }
+                mean.resize(NUM_FEATURES);
+                scale.resize(NUM_FEATURES);
+                for (double& m : mean) {
+                    m = readNumber(in, "feature mean");
+                }
+                for (double& s : scale) {
+                    s = readNumber(in, "feature scale");
+                    if (s == 0) {
+                        throw runtime_error("feature scale 0");
+                    }
+                }
+            } else if (kind == "layer") {
+                Layer layer;
+                layer.inputs = readCount(in, "layer inputs");
+                layer.outputs = readCount(in, "layer outputs");
+                string activation;
+                in >> activation;
+                if (activation == "relu") {
+                    layer.activation = Activation::RELU;
+                } else if (activation == "sigmoid") {
+                    layer.activation = Activation::SIGMOID;
+                } else if (activation == "identity") {
+                    layer.activation = Activation::IDENTITY;
+                } else {
+                    throw runtime_error("unknown activation '" + activation + "'");
+                }
+                if (layer.inputs != width) {
+                    throw runtime_error("layer " + to_string(layers.size() + 1) + " takes " + to_string(layer.inputs) +
+                                        " inputs, the layer before gives " + to_string(width));
+                }
+                layer.weights.resize(static_cast<size_t>(layer.inputs) * layer.outputs);
+                layer.bias.resize(layer.outputs);
+                for (int j = 0; j < layer.outputs; j++) {
+                    for (int i = 0; i < layer.inputs; i++) {
+                        layer.weights[static_cast<size_t>(j) * layer.inputs + i] = readNumber(in, "weight");
+                    }
+                    layer.bias[j] = readNumber(in, "bias");
+                }
+                width = layer.outputs;
+                layers.push_back(move(layer));
+            } else {
+                throw runtime_error("unexpected '" + kind + "'");
+            }
+        }
+        if (layers.empty() || width != 1) {
+            throw runtime_error("the last layer has to have a single output");
+        }
+    } catch (const runtime_error& e) {
+        throw runtime_error("Hash model " + path + ": " + e.what());
+    }
+}
+
+vector<double> MLHashModel::variableFeatures(const CNFFormula& formula) {
+    int numVariables = formula.numVariables;
+    // per variable, summed over its occurrences
+    vector<double> occurrences(numVariables + 1, 0);
+    vector<double> positive(numVariables + 1, 0);
+    vector<double> binary(numVariables + 1, 0);
+    vector<double> inverseLength(numVariables + 1, 0);
+    vector<double> neighbours(numVariables + 1, 0);
+    for (const auto& clause : formula.clauses) {
+        size_t length = clause.literals.size();
+        for (Literal lit : clause.literals) {
+            int var = abs(lit);
+            occurrences[var] += 1;
+            positive[var] += (lit > 0);
+            binary[var] += (length == 2);
+            inverseLength[var] += 1.0 / length;
+            neighbours[var] += length - 1;
+        }
+    }
+
+    double mostOccurrences = max(1.0, *max_element(occurrences.begin(), occurrences.end()));
+    double variablesFeature = log1p(numVariables);
+    double ratioFeature = log1p(static_cast<double>(formula.clauses.size()) / max(1, numVariables));
+    vector<double> features(static_cast<size_t>(numVariables) * NUM_FEATURES);
+    for (int var = 1; var <= numVariables; var++) {
+        double* row = features.data() + static_cast<size_t>(var - 1) * NUM_FEATURES;
+        double count = occurrences[var];
+        row[0] = log1p(count);
+        row[1] = (count > 0) ? positive[var] / count : 0.5;
+        row[2] = (count > 0) ? binary[var] / count : 0;
+        row[3] = (count > 0) ? inverseLength[var] / count : 0;
+        row[4] = log1p(neighbours[var]);
+        row[5] = count / mostOccurrences;
+        row[6] = variablesFeature;
+        row[7] = ratioFeature;
+    }
+    return features;
+}
+
+vector<double> MLHashModel::predict(const vector<double>& features, int count) const {
+    if (features.size() != static_cast<size_t>(count) * NUM_FEATURES) {
+        throw runtime_error("MLHashModel::predict: expected " + to_string(count) + " rows of " + to_string(NUM_FEATURES) + " features");
+    }
+    vector<double> current = features;
+    if (!mean.empty()) {
+        for (size_t k = 0; k < current.size(); k++) {
+            current[k] = (current[k] - mean[k % NUM_FEATURES]) / scale[k % NUM_FEATURES];
+        }
+    }
+
+    // a layer at a time over every row - its weights stay in cache for the whole batch
+    vector<double> next;
+    for (const Layer& layer : layers) {
+        next.resize(static_cast<size_t>(count) * layer.outputs);
+        for (int r = 0; r < count; r++) {
+            const double* in = current.data() + static_cast<size_t>(r) * layer.inputs;
+            double* out = next.data() + static_cast<size_t>(r) * layer.outputs;
+            for (int j = 0; j < layer.outputs; j++) {
+                const double* w = layer.weights.data() + static_cast<size_t>(j) * layer.inputs;
+                double sum = layer.bias[j];
+                for (int i = 0; i < layer.inputs; i++) {
+                    sum += w[i] * in[i];
+                }
+                switch (layer.activation) {
+                    case Activation::RELU:
+                        sum = max(0.0, sum);
+                        break;
+                    case Activation::SIGMOID:
+                        sum = 1.0 / (1.0 + exp(-sum));
+                        break;
+                    case Activation::IDENTITY:
+                        break;
+                }
+                out[j] = sum;
+            }
+        }
+        current.swap(next);
+    }
+
+    for (double& p : current) {
+        p = min(1.0, max(0.0, p));
+    }
+    return current;
+}
+
+vector<double> MLHashModel::predictDensities(const CNFFormula& formula) const {
+    return predict(variableFeatures(formula), formula.numVariables);
+}
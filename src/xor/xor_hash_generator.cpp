@@ -1,8 +1,12 @@
 // Source file for XOR hash generator implementation
 
 #include "xor/xor_hash_generator.h"
+#include "utils/timer.h"
+#include "utils/reusable_storage.h"
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <mutex>
 
 using namespace std;
 
@@ -13,31 +17,130 @@ void XORHashGenerator::setSeed(unsigned int seed) {
     rng.seed(seed);
 }
 
+uint64_t XORHashGenerator::drawSeed() {
+    // runs of a batch start on several threads at once
+    static mutex seedMutex;
+    lock_guard<mutex> lock(seedMutex);
+    uint64_t high = rng();
+    return (high << 32) | rng();
+}
+
 XORConstraint XORHashGenerator::generateSparseXOR(int numVariables, double density) {
+    return generateSparseXOR(numVariables, density, rng);
+}
+
+vector<XORConstraint> XORHashGenerator::generateXORFamily(int numVariables, int numXORs, double density) {
+    return generateXORFamily(numVariables, numXORs, density, rng);
+}
+
+XORConstraint XORHashGenerator::generateSparseXOR(int numVariables, double density, mt19937& generator) {
     XORConstraint xor_constraint;
+    generateSparseXOR(numVariables, density, generator, xor_constraint);
+    return xor_constraint;
+}
+
+vector<XORConstraint> XORHashGenerator::generateXORFamily(int numVariables, int numXORs, double density, mt19937& generator) {
+    vector<XORConstraint> xors;
+    vector<XORConstraint> spare;
+    generateXORFamily(numVariables, numXORs, density, generator, xors, spare);
+    return xors;
+}
+
+void XORHashGenerator::generateSparseXOR(int numVariables, double density, mt19937& generator, XORConstraint& constraint) {
+    constraint.variables.clear();
     uniform_real_distribution<double> dist(0.0, 1.0);
     
     // add to XOR constraint with probability = density
     for (int i = 1; i <= numVariables; ++i) {
-        if (dist(rng) < density) {
-            xor_constraint.variables.push_back(i);
+        if (dist(generator) < density) {
+            constraint.variables.push_back(i);
         }
     }
     
     // randomly assign value
     uniform_int_distribution<int> value(0, 1);
-    xor_constraint.value = value(rng);
-    
+    constraint.value = value(generator);
+}
+
+void XORHashGenerator::generateXORFamily(int numVariables, int numXORs, double density, mt19937& generator,
+                                         vector<XORConstraint>& xors, vector<XORConstraint>& spare) {
+    AMC_TIME_PHASE(Phase::HASH_GENERATION);
+    resizeReusing(xors, numXORs, spare);
+    for (auto& constraint : xors) {
+        generateSparseXOR(numVariables, density, generator, constraint);
+    }
+}
+
+XORConstraint XORHashGenerator::generateSparseXOR(const VariableSampler& sampler, mt19937& generator) {
+    XORConstraint xor_constraint;
+    generateSparseXOR(sampler, generator, xor_constraint);
     return xor_constraint;
 }
 
-vector<XORConstraint> XORHashGenerator::generateXORFamily(int numVariables, int numXORs, double density) {
-    vector<XORConstraint> xors;
-    xors.reserve(numXORs);
-    
-    for (int i = 0; i < numXORs; ++i) {
-        xors.push_back(generateSparseXOR(numVariables, density));
+void XORHashGenerator::generateSparseXOR(const VariableSampler& sampler, mt19937& generator, XORConstraint& constraint) {
+    sampler.sample(generator, constraint.variables);
+    uniform_int_distribution<int> value(0, 1);
+    constraint.value = value(generator);
+}
+
+void XORHashGenerator::generateXORFamily(const VariableSampler& sampler, int numXORs, mt19937& generator,
+                                         vector<XORConstraint>& xors, vector<XORConstraint>& spare) {
+    AMC_TIME_PHASE(Phase::HASH_GENERATION);
+    resizeReusing(xors, numXORs, spare);
+    for (auto& constraint : xors) {
+        generateSparseXOR(sampler, generator, constraint);
     }
-    
-    return xors;
+}
+
+VariableSampler::VariableSampler(const vector<double>& probabilities) :
+    variableCount(probabilities.size()),
+    expected(0) {
+    vector<Bucket> byRate(MAX_BUCKETS);
+    for (int k = 0; k < MAX_BUCKETS; k++) {
+        byRate[k].rate = ldexp(1.0, -k);
+        byRate[k].logMiss = log1p(-byRate[k].rate);
+    }
+    for (int var = 1; var <= variableCount; var++) {
+        double p = min(1.0, max(0.0, probabilities[var - 1]));
+        if (!(p > 0)) {
+            continue;
+        }
+        // p = m * 2^e with m in [1/2, 1) - so p < 2^e, and 2^e is the bucket's rate
+        int e = 0;
+        frexp(p, &e);
+        int k = min(MAX_BUCKETS - 1, max(0, -e));
+        byRate[k].variables.push_back(var);
+        byRate[k].keep.push_back(p / byRate[k].rate);
+        expected += p;
+    }
+    for (auto& bucket : byRate) {
+        if (!bucket.variables.empty()) {
+            buckets.push_back(move(bucket));
+        }
+    }
+}
+
+void VariableSampler::sample(mt19937& generator, vector<int>& variables) const {
+    variables.clear();
+    uniform_real_distribution<double> dist(0.0, 1.0);
+    for (const auto& bucket : buckets) {
+        double size = bucket.variables.size();
+        // position of the next variable the walk lands on - each one is landed on with probability rate
+        double position = -1;
+        while (true) {
+            double skip = 0;
+            if (bucket.rate < 1) {
+                skip = floor(log(1.0 - dist(generator)) / bucket.logMiss);
+            }
+            position += 1 + skip;
+            if (position >= size) {
+                break;
+            }
+            size_t index = static_cast<size_t>(position);
+            if (bucket.keep[index] >= 1 || dist(generator) < bucket.keep[index]) {
+                variables.push_back(bucket.variables[index]);
+            }
+        }
+    }
+    sort(variables.begin(), variables.end());
 }
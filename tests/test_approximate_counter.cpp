@@ -0,0 +1,312 @@
+// Test suite for ApproximateCounter trials
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "solver/learned_clause_pool.h"
+#include "utils/random_cnf_generator.h"
+#include "utils/timer.h"
+
+using namespace std;
+
+// Helper - 16 independent (a OR b) pairs over 32 variables: 3^16 models
+CNFFormula pairsFormula() {
+    CNFFormula formula(32, 16);
+    for (int i = 0; i < 16; i++) {
+        formula.addClause({2 * i + 1, 2 * i + 2});
+    }
+    return formula;
+}
+
+//
+// cell counting tests
+//
+
+void testCells_largeCellsReturnQuickly() {
+    // the cells at the first XOR counts have thousands of models but few enough variables for the exact counter -
+    // it has to give up once they pass the threshold instead of spending its whole decision budget on each
+    // (that took seconds per cell, the trials now take well under one)
+    CNFFormula formula = pairsFormula();
+    Timer timer;
+    for (int i = 0; i < 3; i++) {
+        mt19937 rng = ApproximateCounter::trialGenerator(7, i);
+        TrialResult result = ApproximateCounter::singleTrial(formula, 0.5, 50, rng);
+        assert(result.satisfiable);
+        assert(result.cellCount > 0 && result.cellCount <= 50);
+        assert(result.numXORs > 10);
+    }
+    assert(timer.elapsedSeconds() < 5.0);
+}
+
+// orchestrator
+void testCells() {
+    cout << "Testing cell counting..." << endl;
+    testCells_largeCellsReturnQuickly();
+    cout << "  All cell counting tests passed!" << endl;
+}
+
+//
+// solver snapshot tests
+//
+
+// a trial whose cells start from the snapshot finds the same cells as one loading every cell from scratch
+void checkSameTrial(const CNFFormula& formula, uint64_t seed, int trial, HashFamily family, LearnedClausePool* pool) {
+    SolverSnapshot snapshot(formula, pool);
+    SolveLimits cloned;
+    cloned.snapshot = &snapshot;
+    cloned.sharedClauses = pool;
+    mt19937 rng = ApproximateCounter::trialGenerator(seed, trial);
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.4, 12, rng, cloned, 0, family);
+    mt19937 reference = ApproximateCounter::trialGenerator(seed, trial);
+    TrialResult expected = ApproximateCounter::singleTrial(formula, 0.4, 12, reference, SolveLimits(), 0, family);
+    assert(result.satisfiable == expected.satisfiable);
+    assert(result.numXORs == expected.numXORs);
+    assert(result.cellCount == expected.cellCount);
+}
+
+void testSnapshot_sameCells() {
+    for (int i = 0; i < 12; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(24, 3, 70.0 / 24, 31 + i);
+        checkSameTrial(formula, 9, i, HashFamily::INDEPENDENT, nullptr);
+        checkSameTrial(formula, 9, i, HashFamily::NESTED, nullptr);
+    }
+}
+
+void testSnapshot_sameCellsWithPool() {
+    for (int i = 0; i < 12; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(24, 3, 80.0 / 24, 37 + i);
+        LearnedClausePool pool(formula);
+        checkSameTrial(formula, 4, i, HashFamily::INDEPENDENT, &pool);
+    }
+}
+
+void testSnapshot_unsatisfiable() {
+    CNFFormula formula(5, 3);
+    formula.addClause({1, 2});
+    formula.addClause({-1});
+    formula.addClause({-2});
+    SolverSnapshot snapshot(formula);
+    assert(snapshot.numVariables() == 5);
+    assert(snapshot.unsatisfiable());
+    SolveLimits limits;
+    limits.snapshot = &snapshot;
+    mt19937 rng = ApproximateCounter::trialGenerator(2, 0);
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.5, 10, rng, limits);
+    assert(!result.satisfiable && !result.aborted);
+}
+
+void testSnapshot_builtFrom() {
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(30, 3, 2.0, 41);
+    CNFFormula copy = formula;
+    SolverSnapshot snapshot(formula);
+    assert(snapshot.builtFrom(formula));
+    assert(!snapshot.builtFrom(copy));
+
+    // trials of the formula itself start their cells from it
+    SolveLimits limits;
+    limits.snapshot = &snapshot;
+    mt19937 cloned = ApproximateCounter::trialGenerator(6, 0);
+    mt19937 reference = ApproximateCounter::trialGenerator(6, 0);
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.4, 12, cloned, limits);
+    TrialResult expected = ApproximateCounter::singleTrial(copy, 0.4, 12, reference, SolveLimits());
+    assert(result.numXORs == expected.numXORs && result.cellCount == expected.cellCount);
+}
+
+void testSnapshot_sameEstimateOnThreads() {
+    // every trial builds its cells from the run's one snapshot - the estimate does not depend on the thread count
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(30, 3, 3.0, 41);
+    CountingOptions options;
+    options.maxTrials = 6;
+    options.threshold = 16;
+    options.density = 0.4;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.seed = 11;
+    options.numThreads = 1;
+    ApproximationResult single = ApproximateCounter::approximateCount(formula, options);
+    options.numThreads = 3;
+    ApproximationResult threaded = ApproximateCounter::approximateCount(formula, options);
+    assert(single.successfulTrials == 6);
+    assert(single.log2Estimate == threaded.log2Estimate);
+}
+
+void testSnapshot_preparedFormula() {
+    // runs over a prepared formula reuse its preprocessing, snapshot and pool - the estimate is the one of a plain run
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(30, 3, 3.0, 43);
+    CountingOptions options;
+    options.maxTrials = 6;
+    options.threshold = 16;
+    options.density = 0.4;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.renumberVariables = true;
+    options.seed = 12;
+    unique_ptr<PreparedFormula> prepared = ApproximateCounter::prepare(formula, options);
+    assert(!prepared->unsatisfiable());
+    assert(prepared->formula().getNumVariables() == 30);
+    ApproximationResult plain = ApproximateCounter::approximateCount(formula, options);
+    assert(plain.successfulTrials == 6);
+    for (int run = 0; run < 2; run++) {
+        ApproximationResult result = ApproximateCounter::approximateCount(*prepared, options);
+        assert(result.successfulTrials == 6);
+        assert(result.log2Estimate == plain.log2Estimate);
+    }
+
+    // probing finds no models - nothing is loaded and the count is zero
+    CNFFormula contradiction(2, 4);
+    contradiction.addClause({1, 2});
+    contradiction.addClause({1, -2});
+    contradiction.addClause({-1, 2});
+    contradiction.addClause({-1, -2});
+    prepared = ApproximateCounter::prepare(contradiction, options);
+    assert(prepared->unsatisfiable());
+    ApproximationResult result = ApproximateCounter::approximateCount(*prepared, options);
+    assert(result.exact && result.estimatedCount == 0);
+}
+
+// orchestrator
+void testSnapshot() {
+    cout << "Testing solver snapshots..." << endl;
+    testSnapshot_sameCells();
+    testSnapshot_sameCellsWithPool();
+    testSnapshot_unsatisfiable();
+    testSnapshot_builtFrom();
+    testSnapshot_sameEstimateOnThreads();
+    testSnapshot_preparedFormula();
+    cout << "  All solver snapshot tests passed!" << endl;
+}
+
+//
+// nested hash family tests
+//
+
+void testNested_searchOrderDoesNotMatter() {
+    // the XORs of a nested family do not depend on where the search starts
+    CNFFormula formula = pairsFormula();
+    for (int trial = 0; trial < 3; trial++) {
+        mt19937 rng = ApproximateCounter::trialGenerator(77, trial);
+        TrialResult reference = ApproximateCounter::singleTrial(formula, 0.3, 20, rng, SolveLimits(), 0, HashFamily::NESTED);
+        assert(reference.satisfiable && !reference.aborted);
+        for (int start : {1, 12, 40}) {
+            mt19937 hinted = ApproximateCounter::trialGenerator(77, trial);
+            TrialResult result = ApproximateCounter::singleTrial(formula, 0.3, 20, hinted, SolveLimits(), start, HashFamily::NESTED);
+            assert(result.numXORs == reference.numXORs);
+            assert(result.cellCount == reference.cellCount);
+        }
+    }
+}
+
+void testNested_cellWithinThreshold() {
+    CNFFormula formula = pairsFormula();
+    for (int trial = 0; trial < 4; trial++) {
+        mt19937 rng = ApproximateCounter::trialGenerator(5, trial);
+        TrialResult result = ApproximateCounter::singleTrial(formula, 0.5, 20, rng, SolveLimits(), 0, HashFamily::NESTED);
+        assert(result.satisfiable);
+        assert(result.numXORs > 0);
+        assert(result.cellCount <= 30);
+    }
+}
+
+void testNested_unsatisfiable() {
+    CNFFormula formula(4, 2);
+    formula.addClause({1});
+    formula.addClause({-1});
+    mt19937 rng = ApproximateCounter::trialGenerator(1, 0);
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.5, 20, rng, SolveLimits(), 3, HashFamily::NESTED);
+    assert(!result.satisfiable && !result.aborted);
+    assert(result.numXORs == 0);
+}
+
+void testNested_estimate() {
+    CountingOptions options;
+    options.maxTrials = 9;
+    options.threshold = 40;
+    options.density = 0.5;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.seed = 3;
+    options.hashFamily = HashFamily::NESTED;
+    ApproximationResult result = ApproximateCounter::approximateCount(pairsFormula(), options);
+    assert(result.successfulTrials == 9);
+    assert(fabs(result.log2Estimate - 16 * log2(3.0)) < 2.0);
+}
+
+void testNested_sampler() {
+    // XORs from a sampler are drawn the same way whatever order the search probes the counts in
+    CNFFormula formula = pairsFormula();
+    VariableSampler sampler(vector<double>(32, 0.4));
+    SolveLimits limits;
+    limits.sampler = &sampler;
+    mt19937 rng = ApproximateCounter::trialGenerator(8, 0);
+    TrialResult reference = ApproximateCounter::singleTrial(formula, 0.1, 20, rng, limits, 0, HashFamily::NESTED);
+    mt19937 hinted = ApproximateCounter::trialGenerator(8, 0);
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.1, 20, hinted, limits, reference.numXORs + 2, HashFamily::NESTED);
+    assert(result.numXORs == reference.numXORs && result.cellCount == reference.cellCount);
+}
+
+// orchestrator
+void testNested() {
+    cout << "Testing nested hash families..." << endl;
+    testNested_searchOrderDoesNotMatter();
+    testNested_cellWithinThreshold();
+    testNested_unsatisfiable();
+    testNested_estimate();
+    testNested_sampler();
+    cout << "  All nested hash family tests passed!" << endl;
+}
+
+//
+// hash model tests
+//
+
+const string MODEL = "test_approximate_counter_tmp_model.txt";
+
+void testHashModel_estimate() {
+    // a model predicting 0.5 for every variable - the trials hash with it instead of density
+    {
+        ofstream out(MODEL, ios::trunc);
+        out << "amc-hash-model 1 features=8\nlayer 8 1 identity\n0 0 0 0 0 0 0 0 0.5\n";
+    }
+    CountingOptions options;
+    options.maxTrials = 9;
+    options.threshold = 40;
+    options.density = 0.01;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.seed = 3;
+    options.hashFamily = HashFamily::NESTED;
+    options.hashModel = make_shared<MLHashModel>(MODEL);
+    remove(MODEL.c_str());
+    ApproximationResult result = ApproximateCounter::approximateCount(pairsFormula(), options);
+    assert(result.successfulTrials == 9);
+    assert(fabs(result.log2Estimate - 16 * log2(3.0)) < 2.0);
+}
+
+// orchestrator
+void testHashModel() {
+    cout << "Testing hash model..." << endl;
+    testHashModel_estimate();
+    cout << "  All hash model tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Approximate Counter Tests..." << endl;
+
+    testCells();
+    testSnapshot();
+    testNested();
+    testHashModel();
+
+    cout << "**All Approximate Counter tests passed!" << endl;
+
+    return 0;
+}
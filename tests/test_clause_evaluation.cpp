@@ -0,0 +1,197 @@
+// Test suite for batch clause evaluation
+
+#include <iostream>
+#include <cassert>
+#include <random>
+#include "cnf/cnf_parser.h"
+#include "cnf/cnf_structure.h"
+#include "cnf/clause_evaluation.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+//
+// AssignmentBatch tests
+//
+
+void testAssignmentBatch() {
+    cout << "Testing AssignmentBatch..." << endl;
+    AssignmentBatch batch(3, 70);
+    assert(batch.numWords == 2);
+    batch.setAssignment(65, {1, 0, 1});
+    assert(batch.getValue(65, 1));
+    assert(!batch.getValue(65, 2));
+    assert(batch.getValue(65, 3));
+    batch.setValue(65, 1, false);
+    assert(!batch.getValue(65, 1));
+    assert(!batch.getValue(64, 3));
+    cout << "  All AssignmentBatch tests passed!" << endl;
+}
+
+//
+// evaluate tests
+//
+
+void testEvaluate_smallFormula() {
+    auto formula = CNFParser::parseString(
+        "p cnf 2 2\n"
+        "1 2 0\n"
+        "-1 0\n");
+    AssignmentBatch batch(2, 4);
+    batch.setAssignment(0, {0, 0});
+    batch.setAssignment(1, {0, 1});
+    batch.setAssignment(2, {1, 0});
+    batch.setAssignment(3, {1, 1});
+    auto satisfied = formula->isSatisfiedBatch(batch);
+    assert(satisfied.size() == 1);
+    assert(satisfied[0] == 0x2);
+}
+
+void testEvaluate_noClauses() {
+    CNFFormula formula(2, 0);
+    AssignmentBatch batch(2, 3);
+    auto satisfied = formula.isSatisfiedBatch(batch);
+    assert(satisfied[0] == 0x7);
+}
+
+void testEvaluate_allKernelsMatchScalarCheck() {
+    mt19937 rng(99);
+    uniform_int_distribution<int> bit(0, 1);
+    EvaluationKernel kernels[] = {EvaluationKernel::SCALAR, EvaluationKernel::AVX2, EvaluationKernel::AVX512};
+
+    for (int trial = 0; trial < 20; trial++) {
+        int numVars = 5 + trial;
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(numVars, 1 + trial % 3, static_cast<double>(3 + trial) / numVars, 99 + trial);
+        FlatClauses flat = ClauseEvaluator::flatten(formula);
+
+        // odd batch sizes exercise the SIMD tails
+        int numAssignments = 64 * (trial + 1) + trial * 7;
+        AssignmentBatch batch(numVars, numAssignments);
+        vector<vector<int>> assignments(numAssignments, vector<int>(numVars));
+        for (int i = 0; i < numAssignments; i++) {
+            for (int v = 0; v < numVars; v++) {
+                assignments[i][v] = bit(rng);
+            }
+            batch.setAssignment(i, assignments[i]);
+        }
+
+        for (EvaluationKernel kernel : kernels) {
+            auto satisfied = ClauseEvaluator::evaluate(flat, batch, kernel);
+            for (int i = 0; i < numAssignments; i++) {
+                bool expected = formula.isSatisfied(assignments[i]);
+                assert(((satisfied[i / 64] >> (i % 64)) & 1) == expected);
+            }
+            for (int i = numAssignments; i < 64 * batch.numWords; i++) {
+                assert(((satisfied[i / 64] >> (i % 64)) & 1) == 0);
+            }
+        }
+    }
+}
+
+void testEvaluate_shortBatch() {
+    // batches over fewer variables than the formula - missing variables are false in every kernel
+    mt19937 rng(13);
+    uniform_int_distribution<int> bit(0, 1);
+    EvaluationKernel kernels[] = {EvaluationKernel::SCALAR, EvaluationKernel::AVX2, EvaluationKernel::AVX512};
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(40, 2, 0.75, 13);
+    formula.addClause({-39, 40});
+    FlatClauses flat = ClauseEvaluator::flatten(formula);
+    assert(flat.maxVariable == 40);
+
+    for (int numVars : {0, 1, 10, 38, 39}) {
+        int numAssignments = 600;
+        AssignmentBatch batch(numVars, numAssignments);
+        vector<vector<int>> assignments(numAssignments, vector<int>(numVars));
+        for (int i = 0; i < numAssignments; i++) {
+            for (int v = 0; v < numVars; v++) {
+                assignments[i][v] = bit(rng);
+            }
+            batch.setAssignment(i, assignments[i]);
+        }
+        for (EvaluationKernel kernel : kernels) {
+            auto satisfied = ClauseEvaluator::evaluate(flat, batch, kernel);
+            assert(satisfied.size() == static_cast<size_t>(batch.numWords));
+            for (int i = 0; i < numAssignments; i++) {
+                bool expected = formula.isSatisfied(assignments[i]);
+                assert(((satisfied[i / 64] >> (i % 64)) & 1) == expected);
+            }
+        }
+    }
+
+    // -3 alone is false without variable 3, not true
+    CNFFormula negative(3, 1);
+    negative.addClause({-3});
+    AssignmentBatch batch(2, 4);
+    assert(negative.isSatisfiedBatch(batch)[0] == 0);
+}
+
+// orchestrator
+void testEvaluate() {
+    cout << "Testing evaluate (best kernel: " << ClauseEvaluator::kernelName(ClauseEvaluator::detectKernel()) << ")..." << endl;
+    testEvaluate_smallFormula();
+    testEvaluate_noClauses();
+    testEvaluate_allKernelsMatchScalarCheck();
+    testEvaluate_shortBatch();
+    cout << "  All evaluate tests passed!" << endl;
+}
+
+//
+// filterParity tests
+//
+
+void testFilterParity() {
+    cout << "Testing filterParity..." << endl;
+    mt19937 rng(9);
+    int numVars = 12;
+    int numAssignments = 150;
+    AssignmentBatch batch(numVars, numAssignments);
+    vector<vector<int>> assignments(numAssignments, vector<int>(numVars));
+    for (int i = 0; i < numAssignments; i++) {
+        for (int v = 0; v < numVars; v++) {
+            assignments[i][v] = rng() & 1;
+        }
+        batch.setAssignment(i, assignments[i]);
+    }
+
+    vector<int> variables = {2, 5, 11};
+    for (bool value : {false, true}) {
+        vector<uint64_t> satisfied(batch.numWords, ~0ULL);
+        ClauseEvaluator::filterParity(variables, value, batch, satisfied.data());
+        for (int i = 0; i < numAssignments; i++) {
+            int parity = assignments[i][1] ^ assignments[i][4] ^ assignments[i][10];
+            assert(((satisfied[i / 64] >> (i % 64)) & 1) == (parity == (value ? 1 : 0)));
+        }
+    }
+
+    // variables past the batch are false and leave the parity alone
+    vector<int> withMissing = {2, 5, 11, 13, 40};
+    vector<uint64_t> expected(batch.numWords, ~0ULL);
+    vector<uint64_t> missing(batch.numWords, ~0ULL);
+    ClauseEvaluator::filterParity(variables, true, batch, expected.data());
+    ClauseEvaluator::filterParity(withMissing, true, batch, missing.data());
+    assert(missing == expected);
+
+    // cleared bits stay cleared
+    vector<uint64_t> none(batch.numWords, 0);
+    ClauseEvaluator::filterParity(variables, true, batch, none.data());
+    for (uint64_t word : none) {
+        assert(word == 0);
+    }
+    cout << "  All filterParity tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Clause Evaluation Tests..." << endl;
+    
+    testAssignmentBatch();
+    testEvaluate();
+    testFilterParity();
+    
+    cout << "**All Clause Evaluation tests passed!" << endl;
+    
+    return 0;
+}
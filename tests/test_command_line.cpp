@@ -0,0 +1,138 @@
+// Test suite for CommandLine class
+
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "utils/command_line.h"
+
+using namespace std;
+
+// Helper - parse a list of arguments (argv[0] is added)
+CommandLineOptions parseArgs(vector<string> args) {
+    args.insert(args.begin(), "amc");
+    vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    return CommandLine::parse(static_cast<int>(argv.size()), argv.data());
+}
+
+bool parseThrows(const vector<string>& args) {
+    try {
+        parseArgs(args);
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+//
+// parse tests
+//
+
+void testParse_defaults() {
+    CommandLineOptions options = parseArgs({});
+    assert(options.interactive());
+    assert(options.format == OutputFormat::TEXT);
+    assert(options.counting.numThreads == 1);
+    assert(options.counting.seed == 0);
+    assert(options.counting.earlyTermination);
+    assert(options.counting.probeFailedLiterals);
+    assert(!options.counting.renumberVariables);
+    assert(options.counting.hashFamily == HashFamily::INDEPENDENT);
+    assert(options.counting.shareLearnedClauses);
+}
+
+void testParse_counting() {
+    CommandLineOptions options = parseArgs({"--trials", "12", "--density", "0.25", "--threshold", "40", "--seed", "99",
+                                            "--threads", "0", "--timeout", "2.5", "--trial-timeout", "0.5", "--max-conflicts", "1000",
+                                            "--format", "json", "--no-early-stop", "--no-probe", "--renumber", "--nested-hash",
+                                            "--no-share-clauses", "--hash-model", "model.txt", "a.cnf"});
+    assert(options.counting.maxTrials == 12);
+    assert(options.counting.density == 0.25);
+    assert(options.counting.threshold == 40);
+    assert(options.counting.seed == 99);
+    assert(options.counting.numThreads == 0);
+    assert(options.counting.timeoutSeconds == 2.5);
+    assert(options.counting.trialTimeoutSeconds == 0.5);
+    assert(options.counting.maxConflictsPerSolve == 1000);
+    assert(!options.counting.earlyTermination);
+    assert(!options.counting.probeFailedLiterals);
+    assert(options.counting.renumberVariables);
+    assert(options.counting.hashFamily == HashFamily::NESTED);
+    assert(!options.counting.shareLearnedClauses);
+    assert(options.hashModelPath == "model.txt");
+    assert(options.format == OutputFormat::JSON);
+    assert(options.inputs.size() == 1 && options.inputs[0] == "a.cnf");
+    assert(!options.interactive());
+}
+
+void testParse_errors() {
+    assert(parseThrows({"--bogus"}));
+    assert(parseThrows({"--trials"}));
+    assert(parseThrows({"--trials", "ten"}));
+    assert(parseThrows({"--trials", "-1"}));
+    assert(parseThrows({"--density", "0"}));
+    assert(parseThrows({"--epsilon", "0"}));
+    assert(parseThrows({"--epsilon", "-0.5"}));
+    assert(parseThrows({"--delta", "0"}));
+    assert(parseThrows({"--delta", "-0.1"}));
+    assert(parseThrows({"--delta", "1"}));
+    assert(parseThrows({"--trial-timeout", "-2"}));
+    assert(parseThrows({"--format", "xml"}));
+}
+
+void testParse() {
+    cout << "Testing parse..." << endl;
+    testParse_defaults();
+    testParse_counting();
+    testParse_errors();
+    cout << "  All parse tests passed!" << endl;
+}
+
+//
+// collectInputs tests
+//
+
+void testCollectInputs() {
+    cout << "Testing collectInputs..." << endl;
+    namespace fs = std::filesystem;
+    string dir = "test_command_line_tmp";
+    fs::create_directory(dir);
+    ofstream(dir + "/b.cnf") << "p cnf 1 1\n1 0\n";
+    ofstream(dir + "/a.cnf") << "p cnf 1 1\n1 0\n";
+    ofstream(dir + "/notes.txt") << "not a formula\n";
+    ofstream(dir + "/list.txt") << "# comment\n\n  x.cnf  \ny.cnf\n";
+
+    CommandLineOptions options = parseArgs({"first.cnf", dir, "--list", dir + "/list.txt"});
+    vector<string> files = CommandLine::collectInputs(options);
+    // files in argument order, directories sorted, then the list
+    assert(files.size() == 5);
+    assert(files[0] == "first.cnf");
+    assert(fs::path(files[1]).filename() == "a.cnf");
+    assert(fs::path(files[2]).filename() == "b.cnf");
+    assert(files[3] == "x.cnf");
+    assert(files[4] == "y.cnf");
+
+    fs::remove_all(dir);
+    cout << "  All collectInputs tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Command Line Tests..." << endl;
+
+    testParse();
+    testCollectInputs();
+
+    cout << "**All Command Line tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Test suite for the count server and its formula cache
+
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <cstring>
+#include "server/count_server.h"
+#include "server/formula_cache.h"
+
+using namespace std;
+
+const string SMALL = "p cnf 3 2\n1 2 0\n-1 3 0\n";     // 4 models
+const string OTHER = "p cnf 2 1\n1 2 0\n";             // 3 models
+const string THIRD = "p cnf 2 1\n-1 -2 0\n";           // 3 models
+
+//
+// FormulaCache tests
+//
+
+void testCache_hitAndMiss() {
+    FormulaCache cache(4, 1000);
+    bool cached = true;
+    auto first = cache.get(SMALL, cached);
+    assert(!cached);
+    assert(first->formula->getNumVariables() == 3);
+    assert(first->exactCompleted && first->exactCount.saturated() == 4);
+    assert(first->prepared && !first->prepared->unsatisfiable());
+    assert(first->prepared->formula().getNumVariables() == 3);
+
+    auto second = cache.get(SMALL, cached);
+    assert(cached);
+    assert(second.get() == first.get());
+
+    FormulaCacheStats stats = cache.stats();
+    assert(stats.hits == 1 && stats.misses == 1 && stats.entries == 1);
+    assert(stats.literals == 4);
+}
+
+void testCache_evictsLeastRecentlyUsed() {
+    FormulaCache cache(2, 1000);
+    bool cached = false;
+    cache.get(SMALL, cached);
+    cache.get(OTHER, cached);
+    cache.get(SMALL, cached);      // SMALL is now the most recent
+    cache.get(THIRD, cached);      // evicts OTHER
+    assert(cache.stats().evictions == 1);
+
+    cache.get(SMALL, cached);
+    assert(cached);
+    cache.get(OTHER, cached);
+    assert(!cached);
+}
+
+void testCache_literalBudget() {
+    FormulaCache cache(10, 5);
+    bool cached = false;
+    cache.get(SMALL, cached);      // 4 literals
+    cache.get(OTHER, cached);      // 2 more - over the budget, SMALL goes
+    assert(cache.stats().entries == 1);
+    assert(cache.stats().literals == 2);
+}
+
+// Helper - every text collides
+uint64_t constantHash(const string&) {
+    return 7;
+}
+
+void testCache_hashCollision() {
+    // a text with the hash of a cached one is not answered from the cache - it replaces the entry
+    FormulaCache cache(4, 1000, CountingOptions(), constantHash);
+    bool cached = false;
+    auto small = cache.get(SMALL, cached);
+    auto other = cache.get(OTHER, cached);
+    assert(!cached);
+    assert(other->exactCount.saturated() == 3 && other->formula->getNumVariables() == 2);
+    assert(cache.stats().entries == 1 && cache.stats().literals == 2);
+
+    other = cache.get(OTHER, cached);
+    assert(cached);
+    small = cache.get(SMALL, cached);
+    assert(!cached);
+    assert(small->exactCount.saturated() == 4);
+}
+
+void testCache_parseError() {
+    FormulaCache cache(4, 1000);
+    bool cached = false;
+    bool threw = false;
+    try {
+        cache.get("not dimacs", cached);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(cache.stats().entries == 0);
+}
+
+void testFormulaCache() {
+    cout << "Testing FormulaCache..." << endl;
+    testCache_hitAndMiss();
+    testCache_evictsLeastRecentlyUsed();
+    testCache_literalBudget();
+    testCache_hashCollision();
+    testCache_parseError();
+    cout << "  All FormulaCache tests passed!" << endl;
+}
+
+//
+// CountServer tests
+//
+
+// Helper - connect, send the request and read the given number of answer lines
+string exchange(const string& socketPath, const string& request, int lines) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    // the server thread may still be starting up
+    for (int attempt = 0; connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0; attempt++) {
+        assert(attempt < 100);
+        usleep(20000);
+    }
+    assert(write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size()));
+
+    string answer;
+    char ch;
+    while (lines > 0 && read(fd, &ch, 1) == 1) {
+        answer += ch;
+        if (ch == '\n') {
+            lines--;
+        }
+    }
+    close(fd);
+    return answer;
+}
+
+bool contains(const string& text, const string& part) {
+    return text.find(part) != string::npos;
+}
+
+void testServer() {
+    cout << "Testing CountServer..." << endl;
+    ServerOptions options;
+    options.socketPath = "test_count_server_tmp.sock";
+    options.numThreads = 2;
+    CountServer server(options);
+    server.start();
+    thread serverThread([&]() { server.run(); });
+
+    // inline formula, then the same one again from the cache - pipelined on one connection
+    string request = "COUNT id=a bytes=" + to_string(SMALL.size()) + "\n" + SMALL
+                   + "COUNT id=b bytes=" + to_string(SMALL.size()) + " seed=3\n" + SMALL;
+    string answer = exchange(options.socketPath, request, 2);
+    assert(contains(answer, "\"id\": \"a\""));
+    assert(contains(answer, "\"id\": \"b\""));
+    assert(contains(answer, "\"estimate\": \"4\""));
+    assert(contains(answer, "\"cached\": true"));
+
+    // errors are answered, not fatal
+    answer = exchange(options.socketPath, "COUNT id=c path=/nonexistent.cnf\nCOUNT id=d bytes=5 trials=x\nabcdehello\n", 3);
+    assert(contains(answer, "\"id\": \"c\", \"error\""));
+    assert(contains(answer, "invalid value for trials"));
+    assert(contains(answer, "unknown request: hello"));
+    answer = exchange(options.socketPath, "COUNT id=e bytes=5 epsilon=0\nabcdeCOUNT id=f bytes=5 delta=-1\nabcde", 2);
+    assert(contains(answer, "\"id\": \"e\", \"error\": \"epsilon must be positive"));
+    assert(contains(answer, "\"id\": \"f\", \"error\": \"delta must be in (0, 1)"));
+
+    answer = exchange(options.socketPath, "STATS\n", 1);
+    assert(contains(answer, "\"hits\": 1"));
+    assert(contains(answer, "\"misses\": 1"));
+
+    server.stop();
+    serverThread.join();
+    cout << "  All CountServer tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Count Server Tests..." << endl;
+
+    testFormulaCache();
+    testServer();
+
+    cout << "**All Count Server tests passed!" << endl;
+
+    return 0;
+}
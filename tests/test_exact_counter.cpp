@@ -0,0 +1,260 @@
+// Test suite for ExactCounter class
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include "cnf/cnf_parser.h"
+#include "cnf/cnf_structure.h"
+#include "solver/exact_counter.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+// Helper - count models by trying every assignment
+uint64_t bruteForceCount(const CNFFormula& formula) {
+    uint64_t count = 0;
+    int n = formula.numVariables;
+    vector<int> assignment(n);
+    for (uint64_t bits = 0; bits < (1ULL << n); bits++) {
+        for (int i = 0; i < n; i++) {
+            assignment[i] = (bits >> i) & 1;
+        }
+        if (formula.isSatisfied(assignment)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+//
+// count tests
+//
+
+void testCount_emptyFormula() {
+    CNFFormula formula(5, 0);
+    auto result = ExactCounter::count(formula);
+    assert(result.completed);
+    assert(result.count == 1);
+    assert(result.freeVariables == 5);
+    assert(result.modelCount().saturated() == 32);
+}
+
+void testCount_unsatisfiable() {
+    auto formula = CNFParser::parseString(
+        "p cnf 2 4\n"
+        "1 2 0\n"
+        "-1 2 0\n"
+        "1 -2 0\n"
+        "-1 -2 0\n");
+    auto result = ExactCounter::count(*formula);
+    assert(result.completed);
+    assert(result.count == 0);
+}
+
+void testCount_unitClauses() {
+    auto formula = CNFParser::parseString(
+        "p cnf 3 2\n"
+        "1 0\n"
+        "-2 3 0\n");
+    auto result = ExactCounter::count(*formula);
+    assert(result.completed);
+    assert(result.modelCount().saturated() == 3);
+}
+
+void testCount_tautologyAndDuplicates() {
+    auto formula = CNFParser::parseString(
+        "p cnf 2 2\n"
+        "1 -1 0\n"
+        "2 2 0\n");
+    auto result = ExactCounter::count(*formula);
+    assert(result.completed);
+    assert(result.modelCount().saturated() == 2);
+}
+
+void testCount_disjointComponents() {
+    // 20 independent copies of (a OR b) -> 3^20 models, needs decomposition to finish quickly
+    CNFFormula formula(40, 20);
+    for (int i = 0; i < 20; i++) {
+        formula.addClause({2 * i + 1, 2 * i + 2});
+    }
+    auto result = ExactCounter::count(formula, 1000);
+    assert(result.completed);
+    assert(result.count == 3486784401ULL);
+    assert(result.components >= 20);
+}
+
+void testCount_matchesBruteForce() {
+    for (int trial = 0; trial < 200; trial++) {
+        int numVars = 4 + trial % 11;
+        int numClauses = 1 + trial % 40;
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(numVars, 1 + trial % 4, static_cast<double>(numClauses) / numVars, 12345 + trial);
+        auto result = ExactCounter::count(formula);
+        assert(result.completed);
+        assert(result.modelCount().saturated() == bruteForceCount(formula));
+    }
+}
+
+void testCount_decisionBudget() {
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(60, 3, 2.5, 7);
+    auto result = ExactCounter::count(formula, 2);
+    assert(!result.completed);
+}
+
+void testCount_cancelled() {
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(60, 3, 2.5, 7);
+    CancellationToken parent;
+    CancellationToken token(&parent);
+    parent.cancel();
+    auto result = ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, &token);
+    assert(!result.completed);
+    assert(!result.overflow);
+}
+
+void testCount_modelLimit() {
+    // far more than 60 models - the counter stops long before its decision budget runs out
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(60, 3, 2.5, 7);
+    auto result = ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, nullptr, 60);
+    assert(!result.completed);
+    assert(result.exceeded);
+    assert(!result.overflow);
+    assert(result.decisions < 1000);
+}
+
+void testCount_modelLimitNotReached() {
+    // counts (over the constrained variables) at or below the limit come out exact
+    for (int round = 0; round < 20; round++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(10, 3, 4.0, 19 + round);
+        uint64_t expected = ExactCounter::count(formula).count;
+        auto result = ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, nullptr, expected);
+        assert(result.completed && !result.exceeded);
+        assert(result.modelCount().saturated() == bruteForceCount(formula));
+        if (expected > 0) {
+            assert(ExactCounter::count(formula, EXACT_COUNT_MAX_DECISIONS, nullptr, expected - 1).exceeded);
+        }
+    }
+}
+
+void testCount_freeVariablesDoNotOverflow() {
+    CNFFormula formula(200, 1);
+    formula.addClause({1, 2});
+    auto result = ExactCounter::count(formula);
+    assert(result.completed);
+    assert(result.count == 3);
+    assert(result.freeVariables == 198);
+}
+
+void testCount_overflow() {
+    // 45 independent copies of (a OR b) -> 3^45 > 2^64 models over the constrained variables
+    CNFFormula formula(90, 45);
+    for (int i = 0; i < 45; i++) {
+        formula.addClause({2 * i + 1, 2 * i + 2});
+    }
+    auto result = ExactCounter::count(formula);
+    assert(!result.completed);
+    assert(result.overflow);
+}
+
+// orchestrator
+void testCount() {
+    cout << "Testing count..." << endl;
+    testCount_emptyFormula();
+    testCount_unsatisfiable();
+    testCount_unitClauses();
+    testCount_tautologyAndDuplicates();
+    testCount_disjointComponents();
+    testCount_matchesBruteForce();
+    testCount_decisionBudget();
+    testCount_cancelled();
+    testCount_modelLimit();
+    testCount_modelLimitNotReached();
+    testCount_freeVariablesDoNotOverflow();
+    testCount_overflow();
+    cout << "  All count tests passed!" << endl;
+}
+
+//
+// enumerate tests
+//
+
+void testEnumerate_matchesBruteForce() {
+    for (int i = 0; i < 100; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(10, 3, 2.5, 21 + i);
+        vector<vector<int>> models;
+        assert(ExactCounter::enumerate(formula, 10, 1024, models));
+        assert(models.size() == bruteForceCount(formula));
+        for (const auto& model : models) {
+            assert(formula.isSatisfied(model));
+        }
+        sort(models.begin(), models.end());
+        assert(unique(models.begin(), models.end()) == models.end());
+    }
+}
+
+void testEnumerate_projection() {
+    // x3 = x1 AND x2 - determined by x1 and x2, so projecting it away keeps one model per (x1, x2)
+    CNFFormula formula(3, 3);
+    formula.addClause({-3, 1});
+    formula.addClause({-3, 2});
+    formula.addClause({3, -1, -2});
+    vector<vector<int>> models;
+    assert(ExactCounter::enumerate(formula, 2, 10, models));
+    assert(models.size() == 4);
+    for (const auto& model : models) {
+        assert(model.size() == 2);
+    }
+}
+
+void testEnumerate_limits() {
+    CNFFormula formula(8, 1);
+    formula.addClause({1, 2});
+    vector<vector<int>> models;
+    assert(ExactCounter::enumerate(formula, 8, 192, models));
+    assert(models.size() == 192);
+    assert(!ExactCounter::enumerate(formula, 8, 191, models));
+
+    CNFFormula unsatisfiable(2, 2);
+    unsatisfiable.addClause({1});
+    unsatisfiable.addClause({-1});
+    assert(ExactCounter::enumerate(unsatisfiable, 2, 10, models));
+    assert(models.empty());
+}
+
+// orchestrator
+void testEnumerate() {
+    cout << "Testing enumerate..." << endl;
+    testEnumerate_matchesBruteForce();
+    testEnumerate_projection();
+    testEnumerate_limits();
+    cout << "  All enumerate tests passed!" << endl;
+}
+
+//
+// fitsBudget tests
+//
+
+void testFitsBudget() {
+    cout << "Testing fitsBudget..." << endl;
+    CNFFormula formula(100, 2);
+    formula.addClause({1, 2, 3});
+    formula.addClause({-3, 4});
+    assert(ExactCounter::fitsBudget(formula, 4, 2));
+    assert(!ExactCounter::fitsBudget(formula, 3, 2));
+    assert(!ExactCounter::fitsBudget(formula, 4, 1));
+    cout << "  All fitsBudget tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Exact Counter Tests..." << endl;
+    
+    testCount();
+    testEnumerate();
+    testFitsBudget();
+    
+    cout << "**All Exact Counter tests passed!" << endl;
+    
+    return 0;
+}
@@ -1,2 +1,172 @@
 // Unit tests for Gaussian elimination
-// Validates correctness of parallel matrix reduction on GPU
+// Solves XOR systems and checks that the cell they cut out of a formula has the right models
+
+#include <iostream>
+#include <cassert>
+#include <random>
+#include "cnf/cnf_structure.h"
+#include "solver/partial_assignment.h"
+#include "solver/cnf_simplifier.h"
+
+using namespace std;
+
+// Helper - whether the assignment (entry v - 1 for variable v) satisfies every XOR
+bool satisfiesXORs(const vector<XORConstraint>& xors, const vector<int>& assignment) {
+    for (const auto& constraint : xors) {
+        int parity = 0;
+        for (int var : constraint.variables) {
+            parity ^= assignment[var - 1];
+        }
+        if (parity != (constraint.value ? 1 : 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helper - models of the formula that satisfy the XORs, by trying every assignment
+uint64_t bruteForceCell(const CNFFormula& formula, const vector<XORConstraint>& xors) {
+    uint64_t count = 0;
+    vector<int> assignment(formula.numVariables);
+    for (uint64_t mask = 0; mask < (1ULL << formula.numVariables); mask++) {
+        for (int i = 0; i < formula.numVariables; i++) {
+            assignment[i] = (mask >> i) & 1;
+        }
+        if (formula.isSatisfied(assignment) && satisfiesXORs(xors, assignment)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Helper - models of the cell applyXORSolution builds, auxiliary variables included
+uint64_t simplifiedCell(const CNFFormula& formula, const vector<XORConstraint>& xors) {
+    XORSolutionResult solution = PartialAssignment::solveXORSystem(xors, formula.numVariables);
+    SimplificationResult cell = CNFSimplifier::applyXORSolution(formula, solution);
+    if (cell.isUnsatisfiable) {
+        return 0;
+    }
+    return bruteForceCell(cell.simplified, {});
+}
+
+//
+// solveXORSystem tests
+//
+
+void testSolve_singleVariableRows() {
+    // x1 = 1, x2 XOR x1 = 1 -> x1 = 1, x2 = 0
+    vector<XORConstraint> xors(2);
+    xors[0].variables = {1};
+    xors[0].value = true;
+    xors[1].variables = {1, 2};
+    xors[1].value = true;
+    XORSolutionResult result = PartialAssignment::solveXORSystem(xors, 3);
+    assert(result.satisfiable);
+    vector<pair<int, int>> fixed = {{1, 1}, {2, 0}};
+    assert(result.assignment == fixed);
+    assert(result.constraints.empty());
+    assert(result.freeVariables == vector<int>({3}));
+}
+
+void testSolve_pivotRowKeepsFreeVariables() {
+    // x1 XOR x2 = 1, x2 XOR x3 = 0 reduce to x1 XOR x3 = 1, x2 XOR x3 = 0 - no variable is fixed
+    vector<XORConstraint> xors(2);
+    xors[0].variables = {1, 2};
+    xors[0].value = true;
+    xors[1].variables = {2, 3};
+    xors[1].value = false;
+    XORSolutionResult result = PartialAssignment::solveXORSystem(xors, 4);
+    assert(result.satisfiable);
+    assert(result.assignment.empty());
+    assert(result.constraints.size() == 2);
+    assert(result.constraints[0].variables == vector<int>({1, 3}) && result.constraints[0].value);
+    assert(result.constraints[1].variables == vector<int>({2, 3}) && !result.constraints[1].value);
+    assert(result.freeVariables == vector<int>({3, 4}));
+}
+
+void testSolve_contradiction() {
+    vector<XORConstraint> xors(2);
+    xors[0].variables = {1, 2};
+    xors[0].value = true;
+    xors[1].variables = {1, 2};
+    xors[1].value = false;
+    assert(!PartialAssignment::solveXORSystem(xors, 2).satisfiable);
+}
+
+// orchestrator
+void testSolve() {
+    cout << "Testing solveXORSystem..." << endl;
+    testSolve_singleVariableRows();
+    testSolve_pivotRowKeepsFreeVariables();
+    testSolve_contradiction();
+    cout << "  All solveXORSystem tests passed!" << endl;
+}
+
+//
+// cell tests
+//
+
+void testCell_pivotRowKeepsFreeVariables() {
+    // (x1 OR x3) over 4 variables, cut by x1 XOR x2 = 1 - x1 depends on x2, it is not fixed to 1
+    CNFFormula formula(4, 1);
+    formula.addClause({1, 3});
+    vector<XORConstraint> xors(1);
+    xors[0].variables = {1, 2};
+    xors[0].value = true;
+    assert(bruteForceCell(formula, xors) == 6);
+    assert(simplifiedCell(formula, xors) == 6);
+}
+
+void testCell_fixedVariablesAreNotFree() {
+    // x1 = 1 satisfies the only clause - x1 must still count once, not twice
+    CNFFormula formula(3, 1);
+    formula.addClause({1, 2});
+    vector<XORConstraint> xors(1);
+    xors[0].variables = {1};
+    xors[0].value = true;
+    assert(simplifiedCell(formula, xors) == 4);
+}
+
+void testCell_matchesBruteForce() {
+    mt19937 rng(17);
+    uniform_int_distribution<int> varDist(1, 8);
+    uniform_int_distribution<int> signDist(0, 1);
+    for (int round = 0; round < 200; round++) {
+        CNFFormula formula(8, 10);
+        for (int i = 0; i < 10; i++) {
+            Clause clause;
+            for (int j = 0; j < 3; j++) {
+                int var = varDist(rng);
+                clause.addLiteral(signDist(rng) ? var : -var);
+            }
+            formula.addClause(clause);
+        }
+        vector<XORConstraint> xors = XORHashGenerator::generateXORFamily(8, 1 + round % 4, 0.5);
+        assert(simplifiedCell(formula, xors) == bruteForceCell(formula, xors));
+    }
+}
+
+// orchestrator
+void testCell() {
+    cout << "Testing XOR cells..." << endl;
+    testCell_pivotRowKeepsFreeVariables();
+    testCell_fixedVariablesAreNotFree();
+    testCell_matchesBruteForce();
+    cout << "  All XOR cell tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Gaussian Elimination Tests..." << endl;
+
+    XORHashGenerator::setSeed(5);
+    testSolve();
+    testCell();
+
+    cout << "**All Gaussian Elimination tests passed!" << endl;
+
+    return 0;
+}
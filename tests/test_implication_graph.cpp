@@ -0,0 +1,169 @@
+// Test suite for ImplicationGraph class
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include "cnf/cnf_structure.h"
+#include "solver/exact_counter.h"
+#include "solver/implication_graph.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+// Helper - random formula mixing binary and ternary clauses
+CNFFormula randomMixedFormula(int numVars, double binaryRatio, double ternaryRatio, uint64_t seed) {
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(numVars, 2, binaryRatio, seed);
+    auto ternary = RandomCNFGenerator::randomKSAT(numVars, 3, ternaryRatio, seed + 1);
+    for (const Clause& clause : ternary->clauses) {
+        formula.addClause(clause);
+    }
+    formula.numClauses = static_cast<int>(formula.clauses.size());
+    return formula;
+}
+
+bool contains(const vector<Literal>& lits, Literal lit) {
+    return find(lits.begin(), lits.end(), lit) != lits.end();
+}
+
+//
+// fromFormula tests
+//
+
+void testFromFormula_binaryClausesOnly() {
+    CNFFormula formula(4, 4);
+    formula.addClause({1, 2});
+    formula.addClause({-3, 4});
+    formula.addClause({1, 2, 3});      // ternary - ignored
+    formula.addClause({3, -3});        // tautology - ignored
+    ImplicationGraph graph = ImplicationGraph::fromFormula(formula);
+    assert(graph.numVariables() == 4);
+    assert(graph.numEdges() == 4);
+    assert(contains(graph.implied(-1), 2));
+    assert(contains(graph.implied(-2), 1));
+    assert(contains(graph.implied(3), 4));
+    assert(contains(graph.implied(-4), -3));
+    assert(graph.implied(1).empty());
+}
+
+void testFromFormula_duplicateLiterals() {
+    CNFFormula formula(2, 1);
+    formula.addClause({1, 2, 2});
+    ImplicationGraph graph = ImplicationGraph::fromFormula(formula);
+    assert(graph.numEdges() == 2);
+}
+
+void testIndex() {
+    assert(ImplicationGraph::index(1) == 0);
+    assert(ImplicationGraph::index(-1) == 1);
+    assert(ImplicationGraph::index(5) == 8);
+    assert(ImplicationGraph::index(-5) == 9);
+}
+
+// orchestrator
+void testFromFormula() {
+    cout << "Testing fromFormula..." << endl;
+    testFromFormula_binaryClausesOnly();
+    testFromFormula_duplicateLiterals();
+    testIndex();
+    cout << "  All fromFormula tests passed!" << endl;
+}
+
+//
+// probeFailedLiterals tests
+//
+
+void testProbe_findsUnits() {
+    // 1 -> 2, 1 -> -2: 1 fails, so -1 holds - and (-1 -> 3) makes 3 hold as well
+    CNFFormula formula(3, 3);
+    formula.addClause({-1, 2});
+    formula.addClause({-1, -2});
+    formula.addClause({1, 3});
+    ProbeResult probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals();
+    assert(!probe.unsatisfiable);
+    assert(!probe.exhausted);
+    assert(probe.failedLiterals == 1);
+    assert(contains(probe.units, -1));
+    assert(contains(probe.units, 3));
+    assert(probe.units.size() == 2);
+}
+
+void testProbe_nothingToFind() {
+    CNFFormula formula(4, 2);
+    formula.addClause({1, 2});
+    formula.addClause({3, 4});
+    ProbeResult probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals();
+    assert(probe.failedLiterals == 0);
+    assert(probe.units.empty());
+    assert(!probe.unsatisfiable);
+}
+
+void testProbe_unsatisfiable() {
+    // 1 <-> 2 and 1 <-> -2
+    CNFFormula formula(2, 4);
+    formula.addClause({-1, 2});
+    formula.addClause({1, -2});
+    formula.addClause({-1, -2});
+    formula.addClause({1, 2});
+    ProbeResult probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals();
+    assert(probe.unsatisfiable);
+}
+
+void testProbe_stepBudget() {
+    // a long chain - probing its head alone walks past the budget
+    CNFFormula formula(50, 49);
+    for (int v = 1; v < 50; v++) {
+        formula.addClause({-v, v + 1});
+    }
+    ProbeResult probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals(10);
+    assert(probe.exhausted);
+    probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals();
+    assert(!probe.exhausted);
+}
+
+void testProbe_preservesCount() {
+    int withUnits = 0;
+    for (int i = 0; i < 200; i++) {
+        // 14 binary and 10 ternary clauses over 12 variables
+        CNFFormula formula = randomMixedFormula(12, 14.0 / 12, 10.0 / 12, 42 + 2 * i);
+        ExactCountResult before = ExactCounter::count(formula);
+        ProbeResult probe = ImplicationGraph::fromFormula(formula).probeFailedLiterals();
+        if (probe.unsatisfiable) {
+            assert(before.completed && before.modelCount().log2() < 0);
+            continue;
+        }
+        if (!probe.units.empty()) {
+            withUnits++;
+        }
+        ExactCountResult after = ExactCounter::count(ImplicationGraph::withProbedUnits(formula, probe));
+        assert(before.completed && after.completed);
+        assert(before.modelCount().log2() == after.modelCount().log2());
+    }
+    // the formulas are dense enough in binaries for probing to have something to do
+    assert(withUnits > 0);
+}
+
+// orchestrator
+void testProbe() {
+    cout << "Testing probeFailedLiterals..." << endl;
+    testProbe_findsUnits();
+    testProbe_nothingToFind();
+    testProbe_unsatisfiable();
+    testProbe_stepBudget();
+    testProbe_preservesCount();
+    cout << "  All probeFailedLiterals tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Implication Graph Tests..." << endl;
+
+    testFromFormula();
+    testProbe();
+
+    cout << "**All Implication Graph tests passed!" << endl;
+
+    return 0;
+}
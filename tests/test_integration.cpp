@@ -1,2 +1,196 @@
 // End-to-end integration tests
 // Tests the complete pipeline from CNF input to approximate count output
+
+#include <iostream>
+#include <cassert>
+#include <future>
+#include <thread>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "utils/thread_pool.h"
+
+using namespace std;
+
+// Helper - ties variables first..numVars to variable 1, so they are constrained without adding models
+void tieToFirst(CNFFormula& formula, int first) {
+    for (int var = first; var <= formula.numVariables; var++) {
+        formula.addClause({var, -1});
+        formula.addClause({-var, 1});
+    }
+}
+
+//
+// trial tests
+//
+
+// cells with more constrained variables than the exact counter takes are enumerated with the CDCL solver
+void testTrial_satisfiableCellTerminates() {
+    // exactly one model - the old solver learned the conflicting clause itself and never finished on it
+    CNFFormula formula(300, 21);
+    formula.addClause({2, 3, -5});
+    formula.addClause({5, -1, -2});
+    formula.addClause({1, 5, 2});
+    formula.addClause({4, 3, 5});
+    formula.addClause({2, -3, 6});
+    formula.addClause({-1, 8, -5});
+    formula.addClause({7, 8, 1});
+    formula.addClause({6, 3, -4});
+    formula.addClause({-5, -8, -1});
+    formula.addClause({-2, -4, 6});
+    formula.addClause({-7, 3, -2});
+    formula.addClause({-7, -4, -1});
+    formula.addClause({-6, -3, -5});
+    formula.addClause({4, 3, -5});
+    formula.addClause({4, 6, 8});
+    formula.addClause({-2, 4, -5});
+    formula.addClause({-6, 3, -5});
+    formula.addClause({-6, 5, -3});
+    formula.addClause({-7, -8, 1});
+    formula.addClause({-1, 7, 5});
+    formula.addClause({-3, 7, 5});
+    tieToFirst(formula, 9);
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.1, 50);
+    assert(result.satisfiable);
+    assert(result.numXORs == 0);
+    assert(result.cellCount == 1);
+}
+
+void testTrial_cellCountedExactly() {
+    // (x1 OR x2 OR x3) with every other variable fixed - 7 models, some of which flipping one bit at a time visits twice
+    CNFFormula formula(300, 298);
+    formula.addClause({1, 2, 3});
+    for (int var = 4; var <= 300; var++) {
+        formula.addClause({-var});
+    }
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.1, 50);
+    assert(result.satisfiable);
+    assert(result.numXORs == 0);
+    assert(result.cellCount == 7);
+}
+
+void testTrial_freeVariablesScaleTheCell() {
+    // variables in no clause double every model of the constrained ones
+    CNFFormula formula(304, 298);
+    formula.addClause({1, 2, 3});
+    for (int var = 4; var <= 300; var++) {
+        formula.addClause({-var});
+    }
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.1, 200);
+    assert(result.satisfiable);
+    assert(result.numXORs == 0);
+    assert(result.cellCount == 7 * 16);
+}
+
+// orchestrator
+void testTrial() {
+    cout << "Testing trials..." << endl;
+    testTrial_satisfiableCellTerminates();
+    testTrial_cellCountedExactly();
+    testTrial_freeVariablesScaleTheCell();
+    cout << "  All trial tests passed!" << endl;
+}
+
+//
+// threading tests
+//
+
+// Helper - (a OR b) over variable pairs: 3^numPairs models
+CNFFormula pairsFormula(int numPairs) {
+    CNFFormula formula(2 * numPairs, numPairs);
+    for (int i = 0; i < numPairs; i++) {
+        formula.addClause({2 * i + 1, 2 * i + 2});
+    }
+    return formula;
+}
+
+void testThreads_seededTrialsRepeat() {
+    CNFFormula formula = pairsFormula(10);
+    mt19937 first = ApproximateCounter::trialGenerator(42, 3);
+    mt19937 second = ApproximateCounter::trialGenerator(42, 3);
+    TrialResult a = ApproximateCounter::singleTrial(formula, 0.5, 20, first);
+    TrialResult b = ApproximateCounter::singleTrial(formula, 0.5, 20, second);
+    assert(a.numXORs == b.numXORs && a.cellCount == b.cellCount);
+    // neighbouring streams differ
+    assert(ApproximateCounter::trialGenerator(42, 3)() != ApproximateCounter::trialGenerator(42, 4)());
+}
+
+void testThreads_seededEstimateIndependentOfThreads() {
+    CNFFormula formula = pairsFormula(10);
+    CountingOptions options;
+    options.maxTrials = 9;
+    options.threshold = 20;
+    options.density = 0.5;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.seed = 1234;
+    ApproximationResult single = ApproximateCounter::approximateCount(formula, options);
+    options.numThreads = 4;
+    ApproximationResult threaded = ApproximateCounter::approximateCount(formula, options);
+    ThreadPool pool(3);
+    options.pool = &pool;
+    ApproximationResult pooled = ApproximateCounter::approximateCount(formula, options);
+
+    assert(!single.exact && single.successfulTrials == 9);
+    for (const ApproximationResult* other : {&threaded, &pooled}) {
+        assert(other->trialCounts.size() == single.trialCounts.size());
+        for (size_t i = 0; i < single.trialCounts.size(); i++) {
+            assert(other->trialCounts[i].log2() == single.trialCounts[i].log2());
+        }
+        assert(other->estimatedCount == single.estimatedCount);
+    }
+}
+
+void testThreads_nestedAwait() {
+    // tasks that wait for tasks they submitted finish even with a single worker
+    ThreadPool pool(1);
+    auto outer = pool.submit([&pool]() {
+        uint64_t group = pool.newGroup();
+        auto inner = pool.submit([]() { return 20; }, group);
+        return pool.await(inner, group) + 1;
+    });
+    assert(pool.await(outer) == 21);
+}
+
+void testThreads_awaitHelpsOwnGroupOnly() {
+    ThreadPool pool(1);
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    auto blocker = pool.submit([released]() { released.wait(); });
+
+    // the worker is busy - the waiting thread runs its own group's task, and not the other one queued before it
+    uint64_t mine = pool.newGroup();
+    uint64_t other = pool.newGroup();
+    auto foreign = pool.submit([]() { return this_thread::get_id(); }, other);
+    auto own = pool.submit([]() { return this_thread::get_id(); }, mine);
+    assert(pool.await(own, mine) == this_thread::get_id());
+    assert(foreign.wait_for(chrono::milliseconds(50)) == future_status::timeout);
+
+    release.set_value();
+    pool.await(blocker);
+    assert(pool.await(foreign) != this_thread::get_id());
+}
+
+// orchestrator
+void testThreads() {
+    cout << "Testing threads..." << endl;
+    testThreads_seededTrialsRepeat();
+    testThreads_seededEstimateIndependentOfThreads();
+    testThreads_nestedAwait();
+    testThreads_awaitHelpsOwnGroupOnly();
+    cout << "  All threads tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Integration Tests..." << endl;
+
+    testTrial();
+    testThreads();
+
+    cout << "**All Integration tests passed!" << endl;
+
+    return 0;
+}
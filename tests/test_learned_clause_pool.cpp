@@ -0,0 +1,229 @@
+// Test suite for LearnedClausePool class
+
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <thread>
+#include "cnf/cnf_structure.h"
+#include "solver/learned_clause_pool.h"
+#include "solver/approximate_counter.h"
+#include "solver/cnf_simplifier.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+// Helper - the formula with random XORs over its variables encoded as clauses
+CNFFormula withRandomXORs(mt19937& rng, const CNFFormula& formula, int numXORs) {
+    CNFFormula cell = formula;
+    uniform_int_distribution<int> signDist(0, 1);
+    for (int i = 0; i < numXORs; i++) {
+        XORConstraint constraint;
+        for (int var = 1; var <= formula.numVariables; var++) {
+            if (signDist(rng)) {
+                constraint.variables.push_back(var);
+            }
+        }
+        constraint.value = signDist(rng);
+        CNFSimplifier::encodeXOR(cell, constraint);
+    }
+    cell.numClauses = cell.clauses.size();
+    return cell;
+}
+
+// Helper - whether the clause holds in every model of the formula (by brute force)
+bool impliedByFormula(const CNFFormula& formula, const vector<Literal>& clause) {
+    vector<int> assignment(formula.numVariables);
+    for (uint32_t bits = 0; bits < (1u << formula.numVariables); bits++) {
+        for (int v = 0; v < formula.numVariables; v++) {
+            assignment[v] = (bits >> v) & 1;
+        }
+        if (!formula.isSatisfied(assignment)) {
+            continue;
+        }
+        bool satisfied = false;
+        for (Literal lit : clause) {
+            satisfied = satisfied || (assignment[abs(lit) - 1] == (lit > 0 ? 1 : 0));
+        }
+        if (!satisfied) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// pool tests
+//
+
+void testPool_formulaClauses() {
+    CNFFormula formula(4, 2);
+    formula.addClause({3, -1, 2, 2});
+    formula.addClause({-4});
+    LearnedClausePool pool(formula);
+    assert(pool.numVariables() == 4);
+    assert(pool.isFormulaClause({-1, 2, 3}));
+    assert(pool.isFormulaClause({-4}));
+    assert(!pool.isFormulaClause({-1, 2}));
+    assert(!pool.isFormulaClause({4}));
+}
+
+void testPool_addAndGet() {
+    CNFFormula formula(4, 0);
+    LearnedClausePool pool(formula, 2);
+    assert(pool.capacity() == 2);
+    Literal first[] = {1, -2};
+    Literal second[] = {3};
+    assert(pool.add(first, 2));
+    assert(pool.add(second, 1));
+    assert(!pool.add(first, 2));    // full
+    assert(pool.size() == 2);
+    vector<Literal> lits;
+    assert(pool.get(0, lits) && lits == vector<Literal>({1, -2}));
+    assert(pool.get(1, lits) && lits == vector<Literal>({3}));
+}
+
+void testPool_tooLong() {
+    CNFFormula formula(SHARED_CLAUSE_MAX_LITERALS + 1, 0);
+    LearnedClausePool pool(formula);
+    vector<Literal> lits;
+    for (int v = 1; v <= SHARED_CLAUSE_MAX_LITERALS + 1; v++) {
+        lits.push_back(v);
+    }
+    assert(!pool.add(lits.data(), lits.size()));
+    assert(pool.add(lits.data(), SHARED_CLAUSE_MAX_LITERALS));
+    assert(pool.size() == 1);
+}
+
+void testPool_defaultCapacity() {
+    CNFFormula small(3, 0);
+    assert(LearnedClausePool(small).capacity() == SHARED_CLAUSES_MIN_CAPACITY);
+    auto large = RandomCNFGenerator::randomKSAT(100, 3, 30.0, 1);
+    assert(LearnedClausePool(*large).capacity() == 3000);
+}
+
+void testPool_concurrentAdds() {
+    CNFFormula formula(8, 0);
+    LearnedClausePool pool(formula, 1000);
+    vector<thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&pool, t]() {
+            for (int i = 0; i < 400; i++) {
+                Literal lits[] = {t + 1, -(t + 5)};
+                pool.add(lits, 2);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    // every slot was handed out once and holds a complete clause
+    assert(pool.size() == 1000);
+    vector<Literal> lits;
+    for (size_t i = 0; i < pool.size(); i++) {
+        assert(pool.get(i, lits));
+        assert(lits.size() == 2 && lits[1] == -(lits[0] + 4));
+    }
+}
+
+// orchestrator
+void testPool() {
+    cout << "Testing pool..." << endl;
+    testPool_formulaClauses();
+    testPool_addAndGet();
+    testPool_tooLong();
+    testPool_defaultCapacity();
+    testPool_concurrentAdds();
+    cout << "  All pool tests passed!" << endl;
+}
+
+//
+// sharing between SAT calls
+//
+
+void testSharing_exportedClausesHoldInFormula() {
+    mt19937 rng(17);
+    size_t exported = 0;
+    for (int i = 0; i < 30; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(14, 3, 58.0 / 14, 17 + i);
+        LearnedClausePool pool(formula);
+        SolveLimits limits;
+        limits.sharedClauses = &pool;
+        for (int cell = 0; cell < 4; cell++) {
+            CNFFormula constrained = withRandomXORs(rng, formula, 2);
+            vector<int> assignment;
+            ApproximateCounter::solveSAT(constrained, assignment, limits);
+        }
+        // clauses learned through the XORs would cut models of the formula
+        vector<Literal> lits;
+        for (size_t c = 0; c < pool.size(); c++) {
+            assert(pool.get(c, lits));
+            assert(impliedByFormula(formula, lits));
+        }
+        exported += pool.size();
+    }
+    assert(exported > 0);
+}
+
+void testSharing_sameAnswers() {
+    mt19937 rng(23);
+    for (int i = 0; i < 30; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(14, 3, 60.0 / 14, 23 + i);
+        LearnedClausePool pool(formula);
+        SolveLimits limits;
+        limits.sharedClauses = &pool;
+        for (int cell = 0; cell < 4; cell++) {
+            CNFFormula constrained = withRandomXORs(rng, formula, 3);
+            vector<int> shared;
+            vector<int> alone;
+            SolveStatus withPool = ApproximateCounter::solveSAT(constrained, shared, limits);
+            SolveStatus withoutPool = ApproximateCounter::solveSAT(constrained, alone, SolveLimits());
+            assert(withPool == withoutPool);
+            if (withPool == SolveStatus::SATISFIABLE) {
+                shared.resize(constrained.numVariables);
+                assert(constrained.isSatisfied(shared));
+            }
+        }
+    }
+}
+
+void testSharing_fixedValuesTaint() {
+    // with x1 fixed false, (x2) follows from (x1 OR x2) - but not from the formula alone
+    CNFFormula formula(3, 3);
+    formula.addClause({1, 2});
+    formula.addClause({-2, 3});
+    formula.addClause({-2, -3, 1});
+    LearnedClausePool pool(formula);
+    SolveLimits limits;
+    limits.sharedClauses = &pool;
+    vector<int> assignment = {0, -1, -1};
+    assert(ApproximateCounter::solveSAT(formula, assignment, limits) == SolveStatus::UNSATISFIABLE);
+    vector<Literal> lits;
+    for (size_t c = 0; c < pool.size(); c++) {
+        assert(pool.get(c, lits));
+        assert(impliedByFormula(formula, lits));
+    }
+}
+
+// orchestrator
+void testSharing() {
+    cout << "Testing sharing..." << endl;
+    testSharing_exportedClausesHoldInFormula();
+    testSharing_sameAnswers();
+    testSharing_fixedValuesTaint();
+    cout << "  All sharing tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Learned Clause Pool Tests..." << endl;
+
+    testPool();
+    testSharing();
+
+    cout << "**All Learned Clause Pool tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Test suite for MLHashModel inference
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "cnf/cnf_structure.h"
+#include "xor/ml_hash_interface.h"
+
+using namespace std;
+
+const string MODEL = "test_ml_hash_interface_tmp.txt";
+
+// Helper - write the model file
+void writeModel(const string& text) {
+    ofstream out(MODEL, ios::trunc);
+    out << text;
+}
+
+// Helper - whether loading the model file is refused
+bool refused(const string& text) {
+    writeModel(text);
+    try {
+        MLHashModel model(MODEL);
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Helper - (1 2 3) (-1 2) (-3 4) over 5 variables, variable 5 in no clause
+CNFFormula smallFormula() {
+    CNFFormula formula(5, 3);
+    formula.addClause({1, 2, 3});
+    formula.addClause({-1, 2});
+    formula.addClause({-3, 4});
+    return formula;
+}
+
+//
+// feature tests
+//
+
+void testFeatures_values() {
+    vector<double> features = MLHashModel::variableFeatures(smallFormula());
+    const int F = MLHashModel::NUM_FEATURES;
+    assert(features.size() == 5 * F);
+    // variable 1: in (1 2 3) and (-1 2)
+    const double* x1 = features.data();
+    assert(fabs(x1[0] - log1p(2)) < 1e-12);
+    assert(fabs(x1[1] - 0.5) < 1e-12);
+    assert(fabs(x1[2] - 0.5) < 1e-12);
+    assert(fabs(x1[3] - (1.0 / 3 + 1.0 / 2) / 2) < 1e-12);
+    assert(fabs(x1[4] - log1p(3)) < 1e-12);
+    assert(fabs(x1[5] - 1.0) < 1e-12);
+    // variable 4: once, positive, in a binary clause, half as often as the most frequent
+    const double* x4 = features.data() + 3 * F;
+    assert(x4[1] == 1.0 && x4[2] == 1.0 && fabs(x4[5] - 0.5) < 1e-12);
+    // variable 5: in no clause
+    const double* x5 = features.data() + 4 * F;
+    assert(x5[0] == 0 && x5[1] == 0.5 && x5[5] == 0);
+    // formula features are the same on every row
+    for (int v = 0; v < 5; v++) {
+        assert(fabs(features[v * F + 6] - log1p(5)) < 1e-12);
+        assert(fabs(features[v * F + 7] - log1p(3.0 / 5)) < 1e-12);
+    }
+}
+
+// orchestrator
+void testFeatures() {
+    cout << "Testing features..." << endl;
+    testFeatures_values();
+    cout << "  All features tests passed!" << endl;
+}
+
+//
+// model tests
+//
+
+void testModel_linear() {
+    // density = 0.1 + 0.2 * log(1 + occurrences)
+    writeModel("# exported for the test\n"
+               "amc-hash-model 1 features=8\n"
+               "layer 8 1 identity\n"
+               "0.2 0 0 0 0 0 0 0 0.1\n");
+    MLHashModel model(MODEL);
+    assert(model.numLayers() == 1);
+    vector<double> densities = model.predictDensities(smallFormula());
+    assert(densities.size() == 5);
+    assert(fabs(densities[0] - (0.1 + 0.2 * log1p(2))) < 1e-12);
+    assert(fabs(densities[3] - (0.1 + 0.2 * log1p(1))) < 1e-12);
+    assert(fabs(densities[4] - 0.1) < 1e-12);
+}
+
+void testModel_hiddenLayer() {
+    // normalized occurrence fraction -> relu(x, -x) -> sigmoid(a - b), clamped output
+    writeModel("amc-hash-model 1 features=8\n"
+               "normalize 0 0 0 0 0 0.5 0 0  1 1 1 1 1 0.5 1 1\n"
+               "layer 8 2 relu\n"
+               "0 0 0 0 0 1 0 0 0\n"
+               "0 0 0 0 0 -1 0 0 0\n"
+               "layer 2 1 sigmoid\n"
+               "1 -1 0\n");
+    MLHashModel model(MODEL);
+    assert(model.numLayers() == 2);
+    vector<double> densities = model.predictDensities(smallFormula());
+    // occurrence fractions 1, 1, 1, 0.5, 0 normalize to 1, 1, 1, 0, -1
+    double expected[] = {1, 1, 1, 0, -1};
+    for (int v = 0; v < 5; v++) {
+        assert(fabs(densities[v] - 1.0 / (1.0 + exp(-expected[v]))) < 1e-12);
+    }
+}
+
+void testModel_batchMatchesSingleRows() {
+    writeModel("amc-hash-model 1 features=8\n"
+               "layer 8 3 relu\n"
+               "0.1 -0.2 0.3 0.4 -0.5 0.6 0.01 0.02 0.1\n"
+               "-0.3 0.2 0.1 -0.4 0.5 0.1 0.03 -0.02 0.2\n"
+               "0.2 0.2 -0.1 0.1 0.1 -0.6 0.01 0.01 -0.1\n"
+               "layer 3 1 sigmoid\n"
+               "0.5 -0.7 0.9 -1.2\n");
+    MLHashModel model(MODEL);
+    CNFFormula formula = smallFormula();
+    vector<double> features = MLHashModel::variableFeatures(formula);
+    vector<double> batch = model.predict(features, formula.numVariables);
+    const int F = MLHashModel::NUM_FEATURES;
+    for (int v = 0; v < formula.numVariables; v++) {
+        vector<double> row(features.begin() + v * F, features.begin() + (v + 1) * F);
+        vector<double> single = model.predict(row, 1);
+        assert(single.size() == 1 && single[0] == batch[v]);
+        assert(batch[v] > 0 && batch[v] < 1);
+    }
+}
+
+void testModel_refused() {
+    const string layer = "layer 8 1 identity\n0 0 0 0 0 0 0 0 0.1\n";
+    assert(refused("amc-checkpoint 1 features=8\n" + layer));
+    assert(refused("amc-hash-model 2 features=8\n" + layer));
+    assert(refused("amc-hash-model 1 features=7\n" + layer));
+    assert(refused("amc-hash-model 1 features=8\n"));
+    assert(refused("amc-hash-model 1 features=8\nlayer 8 1 identity\n0 0 0 0 0 0 0 0\n"));
+    assert(refused("amc-hash-model 1 features=8\nlayer 8 1 softmax\n0 0 0 0 0 0 0 0 0.1\n"));
+    assert(refused("amc-hash-model 1 features=8\nlayer 8 1 identity\n0 0 0 x 0 0 0 0 0.1\n"));
+    assert(refused("amc-hash-model 1 features=8\nlayer 7 1 identity\n0 0 0 0 0 0 0 0.1\n"));
+    assert(refused("amc-hash-model 1 features=8\nlayer 8 2 identity\n0 0 0 0 0 0 0 0 0\n0 0 0 0 0 0 0 0 0\n"));
+    assert(refused("amc-hash-model 1 features=8\nnormalize 0 0 0 0 0 0 0 0 1 1 1 0 1 1 1 1\n" + layer));
+    remove(MODEL.c_str());
+    bool missing = false;
+    try {
+        MLHashModel model(MODEL);
+    } catch (const runtime_error&) {
+        missing = true;
+    }
+    assert(missing);
+}
+
+// orchestrator
+void testModel() {
+    cout << "Testing model..." << endl;
+    testModel_linear();
+    testModel_hiddenLayer();
+    testModel_batchMatchesSingleRows();
+    testModel_refused();
+    cout << "  All model tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running ML Hash Interface Tests..." << endl;
+
+    testFeatures();
+    testModel();
+
+    remove(MODEL.c_str());
+    cout << "**All ML Hash Interface tests passed!" << endl;
+
+    return 0;
+}
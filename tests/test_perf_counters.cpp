@@ -0,0 +1,145 @@
+// Test suite for hardware performance counters
+
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <string>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "utils/perf_counters.h"
+#include "utils/timer.h"
+
+using namespace std;
+
+// Helper - variables 1..chain all equal, the rest free - cells too big for the exact counters go to the CDCL solver
+CNFFormula chainFormula(int numVars, int chain) {
+    CNFFormula formula(numVars, 2 * (chain - 1));
+    for (int v = 1; v < chain; v++) {
+        formula.addClause({-v, v + 1});
+        formula.addClause({v, -(v + 1)});
+    }
+    return formula;
+}
+
+// Helper - some work the counters can see
+uint64_t busyWork(int iterations) {
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < iterations; i++) {
+        sum = sum + static_cast<uint64_t>(i) * i;
+    }
+    return sum;
+}
+
+// Helper - sample with every event at value and the given times
+HardwareSample sample(uint64_t value, uint64_t enabled, uint64_t running) {
+    HardwareSample s;
+    for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+        s.values[e] = value * (e + 1);
+    }
+    s.timeEnabled = enabled;
+    s.timeRunning = running;
+    return s;
+}
+
+//
+// difference tests
+//
+
+void testDifference() {
+    cout << "Testing difference..." << endl;
+    uint64_t counts[NUM_HARDWARE_EVENTS];
+
+    // on the PMU the whole time - raw counts
+    PerfCounters::difference(sample(100, 1000, 1000), sample(400, 2000, 2000), counts);
+    for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+        assert(counts[e] == 300u * (e + 1));
+    }
+
+    // multiplexed - counted for a quarter of the interval, scaled up by 4
+    PerfCounters::difference(sample(100, 1000, 500), sample(400, 5000, 1500), counts);
+    for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+        assert(counts[e] == 1200u * (e + 1));
+    }
+
+    // never scheduled in between
+    PerfCounters::difference(sample(100, 1000, 500), sample(100, 3000, 500), counts);
+    for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+        assert(counts[e] == 0);
+    }
+    cout << "  All difference tests passed!" << endl;
+}
+
+//
+// live counter tests
+//
+
+void testLive() {
+    cout << "Testing live counters..." << endl;
+    if (!PerfCounters::enable()) {
+        cout << "  perf_event_open unavailable - skipped" << endl;
+        return;
+    }
+
+    HardwareSample start;
+    HardwareSample end;
+    assert(PerfCounters::read(start));
+    busyWork(1000000);
+    assert(PerfCounters::read(end));
+    assert(end.timeRunning <= end.timeEnabled);
+    assert(end.timeEnabled >= start.timeEnabled);
+    uint64_t counts[NUM_HARDWARE_EVENTS];
+    PerfCounters::difference(start, end, counts);
+    assert(counts[static_cast<int>(HardwareEvent::CYCLES)] > 0);
+
+    // only the coarse phases read the counters
+    PhaseStats before = Stats::local();
+    {
+        ScopedPhaseTimer coarse(Phase::CELL_COUNTING);
+        busyWork(1000000);
+    }
+    {
+        ScopedPhaseTimer fine(Phase::HASH_GENERATION);
+        busyWork(1000000);
+    }
+    PhaseStats diff = Stats::local().since(before);
+    assert(diff.hardwareCount(Phase::CELL_COUNTING, HardwareEvent::CYCLES) > 0);
+    assert(diff.hardwareCount(Phase::HASH_GENERATION, HardwareEvent::CYCLES) == 0);
+    assert(diff.phaseCalls[static_cast<int>(Phase::HASH_GENERATION)] == 1);
+
+    // a trial whose cells go to the CDCL solver reports elimination and SAT calls with their rates
+    before = Stats::local();
+    mt19937 rng = ApproximateCounter::trialGenerator(3, 0);
+    TrialResult trial = ApproximateCounter::singleTrial(chainFormula(300, 290), 0.5, 16, rng, SolveLimits());
+    assert(trial.satisfiable && trial.numXORs > 0);
+    diff = Stats::local().since(before);
+    for (Phase phase : {Phase::GAUSSIAN_ELIMINATION, Phase::SAT_SOLVING}) {
+        assert(diff.phaseCalls[static_cast<int>(phase)] > 0);
+        assert(diff.hardwareCount(phase, HardwareEvent::CYCLES) > 0);
+        assert(diff.hardwareCount(phase, HardwareEvent::INSTRUCTIONS) > 0);
+    }
+    string json = diff.toJSON();
+    for (const char* phase : {"\"gaussian_elimination\"", "\"sat_solving\""}) {
+        size_t at = json.find(phase);
+        assert(at != string::npos);
+        size_t end = json.find('}', at);
+        assert(json.find("\"ipc\"", at) < end && json.find("\"branch_mpki\"", at) < end);
+    }
+
+    PerfCounters::disable();
+    cout << "  All live counter tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Perf Counters Tests..." << endl;
+
+    testDifference();
+    testLive();
+
+    cout << "**All Perf Counters tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Test suite for RandomCNFGenerator class
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include "cnf/cnf_parser.h"
+#include "cnf/cnf_structure.h"
+#include "solver/exact_counter.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+// Helper - same clauses in the same order
+bool sameFormula(const CNFFormula& a, const CNFFormula& b) {
+    if (a.numVariables != b.numVariables || a.clauses.size() != b.clauses.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.clauses.size(); i++) {
+        if (a.clauses[i].literals != b.clauses[i].literals) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// random k-SAT tests
+//
+
+void testRandomKSAT_shape() {
+    auto formula = RandomCNFGenerator::randomKSAT(100, 3, 4.26, 1);
+    assert(formula->numVariables == 100);
+    assert(formula->clauses.size() == 426);
+    for (const auto& clause : formula->clauses) {
+        assert(clause.size() == 3);
+        for (Literal lit : clause.literals) {
+            assert(lit != 0 && abs(lit) <= 100);
+        }
+        // distinct variables
+        assert(abs(clause.literals[0]) != abs(clause.literals[1]));
+        assert(abs(clause.literals[0]) != abs(clause.literals[2]));
+        assert(abs(clause.literals[1]) != abs(clause.literals[2]));
+    }
+}
+
+void testRandomKSAT_deterministic() {
+    auto a = RandomCNFGenerator::randomKSAT(50, 3, 3.0, 42);
+    auto b = RandomCNFGenerator::randomKSAT(50, 3, 3.0, 42);
+    auto c = RandomCNFGenerator::randomKSAT(50, 3, 3.0, 43);
+    assert(sameFormula(*a, *b));
+    assert(!sameFormula(*a, *c));
+}
+
+void testRandomKSAT_invalid() {
+    bool threw = false;
+    try {
+        RandomCNFGenerator::randomKSAT(2, 3, 1.0, 1);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void testRandomKSAT() {
+    cout << "Testing randomKSAT..." << endl;
+    testRandomKSAT_shape();
+    testRandomKSAT_deterministic();
+    testRandomKSAT_invalid();
+    cout << "  All randomKSAT tests passed!" << endl;
+}
+
+//
+// planted instance tests
+//
+
+void testPlanted() {
+    cout << "Testing plantedKSAT..." << endl;
+    for (uint64_t seed = 0; seed < 5; seed++) {
+        CNFFormula formula;
+        FormulaSink sink(formula);
+        GeneratedInstance info = RandomCNFGenerator::plantedKSAT(sink, 200, 3, 6.0, seed);
+        assert(formula.clauses.size() == 1200);
+        assert(info.planted.size() == 200);
+        // well above the threshold, yet the hidden assignment satisfies everything
+        assert(formula.isSatisfied(info.planted));
+    }
+    cout << "  All plantedKSAT tests passed!" << endl;
+}
+
+//
+// known-count tests
+//
+
+void testKnownCount_family(KnownCountFamily family, int components, int size, int freeVars) {
+    for (uint64_t seed = 0; seed < 4; seed++) {
+        GeneratedInstance info;
+        auto formula = RandomCNFGenerator::knownCount(family, components, size, freeVars, seed, info);
+        assert(info.countKnown);
+        assert(formula->numVariables == info.numVariables);
+        assert(formula->clauses.size() == info.numClauses);
+
+        ExactCountResult exact = ExactCounter::count(*formula);
+        assert(exact.completed);
+        ModelCount counted = exact.modelCount();
+        assert(counted.saturated() == info.count.saturated());
+        assert(fabs(counted.log2() - info.log2Count) < 1e-9);
+    }
+}
+
+void testKnownCount() {
+    cout << "Testing knownCount..." << endl;
+    testKnownCount_family(KnownCountFamily::XOR_CHAINS, 3, 5, 2);
+    testKnownCount_family(KnownCountFamily::XOR_CHAINS, 4, 1, 0);
+    testKnownCount_family(KnownCountFamily::XOR_CHAINS, 4, 2, 0);
+    testKnownCount_family(KnownCountFamily::EXACTLY_ONE, 4, 5, 1);
+    testKnownCount_family(KnownCountFamily::RANDOM_COMPONENTS, 3, 8, 0);
+    testKnownCount_family(KnownCountFamily::MIXED, 6, 6, 3);
+
+    // counts past 2^64 stay exact as cellCount * 2^exponent
+    GeneratedInstance info;
+    RandomCNFGenerator::knownCount(KnownCountFamily::XOR_CHAINS, 10, 10, 0, 7, info);
+    assert(info.count.cellCount == 1 && info.count.exponent == 90);
+    assert(fabs(info.log2Count - 90.0) < 1e-9);
+    cout << "  All knownCount tests passed!" << endl;
+}
+
+//
+// DIMACS output tests
+//
+
+void testDimacsRoundTrip() {
+    cout << "Testing DIMACS output..." << endl;
+    string path = "test_random_cnf_generator_tmp.cnf";
+    {
+        DimacsFileSink sink(path);
+        RandomCNFGenerator::randomKSAT(sink, 300, 4, 5.0, 9);
+        sink.close();
+    }
+    auto parsed = CNFParser::parseFile(path);
+    auto direct = RandomCNFGenerator::randomKSAT(300, 4, 5.0, 9);
+    assert(sameFormula(*parsed, *direct));
+    remove(path.c_str());
+    cout << "  All DIMACS output tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Random CNF Generator Tests..." << endl;
+
+    testRandomKSAT();
+    testPlanted();
+    testKnownCount();
+    testDimacsRoundTrip();
+
+    cout << "**All Random CNF Generator tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+// Test suite for sharded counting - workers are forked processes sharing a directory with the coordinator
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cnf/cnf_parser.h"
+#include "solver/sharded_counter.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const string FORMULA_PATH = "test_sharded_counter_tmp.cnf";
+const string QUEUE_DIR = "test_sharded_counter_tmp";
+const string SLOW_FORMULA_PATH = "test_sharded_counter_slow_tmp.cnf";
+
+// Helper - 10 independent (a OR b) pairs: 3^10 = 59049 models
+void writeFormula() {
+    ofstream out(FORMULA_PATH);
+    out << "p cnf 20 10\n";
+    for (int i = 0; i < 10; i++) {
+        out << 2 * i + 1 << " " << 2 * i + 2 << " 0\n";
+    }
+}
+
+CountingOptions testOptions() {
+    CountingOptions options;
+    options.maxTrials = 7;
+    options.threshold = 20;
+    options.density = 0.5;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.seed = 11;
+    return options;
+}
+
+// Helper - fork a process running a worker, after waiting the given time
+pid_t startWorker(int delayMilliseconds) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        usleep(delayMilliseconds * 1000);
+        ShardedCounter::work(QUEUE_DIR);
+        _exit(0);
+    }
+    return pid;
+}
+
+// Helper - fork a worker with the given heartbeat, exiting with the number of trials it ran
+pid_t startCountingWorker(double heartbeatSeconds) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        _exit(ShardedCounter::work(QUEUE_DIR, nullptr, heartbeatSeconds));
+    }
+    return pid;
+}
+
+// Helper - a worker that claims the first descriptor it sees and dies without a result
+pid_t startDeadWorker() {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        for (int attempt = 0; attempt < 500; attempt++) {
+            error_code error;
+            for (const auto& entry : fs::directory_iterator(QUEUE_DIR + "/queue", error)) {
+                string name = entry.path().filename().string();
+                if (name[0] == '.') {
+                    continue;
+                }
+                fs::rename(entry.path(), QUEUE_DIR + "/claimed/" + name + ".dead", error);
+                if (!error) {
+                    _exit(0);
+                }
+            }
+            usleep(5000);
+        }
+        _exit(1);
+    }
+    return pid;
+}
+
+int waitFor(pid_t pid) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+size_t countFiles(const string& directory) {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().filename().string()[0] != '.') {
+            count++;
+        }
+    }
+    return count;
+}
+
+//
+// coordinate / work tests
+//
+
+void testSharded_workersShareTheTrials() {
+    fs::remove_all(QUEUE_DIR);
+    vector<pid_t> workers;
+    for (int i = 0; i < 3; i++) {
+        workers.push_back(startWorker(0));
+    }
+    auto formula = CNFParser::parseFile(FORMULA_PATH);
+    ApproximationResult result = ShardedCounter::coordinate(*formula, FORMULA_PATH, QUEUE_DIR, testOptions());
+    for (pid_t pid : workers) {
+        assert(waitFor(pid) == 0);
+    }
+
+    assert(result.totalTrials == 7);
+    assert(result.successfulTrials == 7);
+    assert(!result.partial);
+    assert(fabs(result.log2Estimate - log2(59049.0)) < 3.0);
+    assert(fs::exists(QUEUE_DIR + "/done"));
+    assert(countFiles(QUEUE_DIR + "/results") == 7);
+    assert(countFiles(QUEUE_DIR + "/queue") == 0);
+
+    // a second coordinator on the same directory is refused
+    bool threw = false;
+    try {
+        ShardedCounter::coordinate(*formula, FORMULA_PATH, QUEUE_DIR, testOptions());
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // a worker arriving after the run leaves at once
+    assert(ShardedCounter::work(QUEUE_DIR) == 0);
+}
+
+void testSharded_resultDoesNotDependOnWorkers() {
+    auto formula = CNFParser::parseFile(FORMULA_PATH);
+    vector<ApproximationResult> results;
+    for (int numWorkers : {1, 2}) {
+        fs::remove_all(QUEUE_DIR);
+        vector<pid_t> workers;
+        for (int i = 0; i < numWorkers; i++) {
+            workers.push_back(startWorker(0));
+        }
+        results.push_back(ShardedCounter::coordinate(*formula, FORMULA_PATH, QUEUE_DIR, testOptions()));
+        for (pid_t pid : workers) {
+            waitFor(pid);
+        }
+    }
+    assert(results[0].log2Estimate == results[1].log2Estimate);
+    assert(results[0].trialCounts.size() == results[1].trialCounts.size());
+    for (size_t i = 0; i < results[0].trialCounts.size(); i++) {
+        assert(results[0].trialCounts[i].log2() == results[1].trialCounts[i].log2());
+    }
+}
+
+void testSharded_reclaimsTrialsOfDeadWorkers() {
+    fs::remove_all(QUEUE_DIR);
+    pid_t dead = startDeadWorker();
+    pid_t worker = startWorker(300);    // starts once the dead worker has taken the first trial
+    auto formula = CNFParser::parseFile(FORMULA_PATH);
+    ApproximationResult result = ShardedCounter::coordinate(*formula, FORMULA_PATH, QUEUE_DIR, testOptions(), 0.2);
+    assert(waitFor(dead) == 0);
+    assert(waitFor(worker) == 0);
+    assert(result.totalTrials == 7);
+    assert(countFiles(QUEUE_DIR + "/claimed") == 0);
+}
+
+void testSharded_longTrialsKeepTheirClaims() {
+    // trials take longer than the reclaim time - the heartbeats keep them from being handed out twice
+    {
+        DimacsFileSink sink(SLOW_FORMULA_PATH);
+        RandomCNFGenerator::randomKSAT(sink, 40, 3, 2.5, 5);
+        sink.close();
+    }
+    fs::remove_all(QUEUE_DIR);
+    vector<pid_t> workers;
+    for (int i = 0; i < 2; i++) {
+        workers.push_back(startCountingWorker(0.02));
+    }
+    auto formula = CNFParser::parseFile(SLOW_FORMULA_PATH);
+    CountingOptions options = testOptions();
+    options.maxTrials = 3;
+    options.threshold = 30;
+    ApproximationResult result = ShardedCounter::coordinate(*formula, SLOW_FORMULA_PATH, QUEUE_DIR, options, 0.2);
+    int trialsRun = 0;
+    for (pid_t pid : workers) {
+        trialsRun += waitFor(pid);
+    }
+    assert(result.totalTrials == 3);
+    assert(trialsRun == 3);
+    fs::remove(SLOW_FORMULA_PATH);
+}
+
+void testSharded_timeout() {
+    fs::remove_all(QUEUE_DIR);
+    CountingOptions options = testOptions();
+    options.timeoutSeconds = 0.2;
+    auto formula = CNFParser::parseFile(FORMULA_PATH);
+    // no workers at all
+    ApproximationResult result = ShardedCounter::coordinate(*formula, FORMULA_PATH, QUEUE_DIR, options);
+    assert(result.partial && result.timedOut);
+    assert(result.totalTrials == 0);
+    assert(countFiles(QUEUE_DIR + "/queue") == 0);
+}
+
+// orchestrator
+void testSharded() {
+    cout << "Testing ShardedCounter..." << endl;
+    writeFormula();
+    testSharded_workersShareTheTrials();
+    testSharded_resultDoesNotDependOnWorkers();
+    testSharded_reclaimsTrialsOfDeadWorkers();
+    testSharded_longTrialsKeepTheirClaims();
+    testSharded_timeout();
+    fs::remove_all(QUEUE_DIR);
+    fs::remove(FORMULA_PATH);
+    cout << "  All ShardedCounter tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Sharded Counter Tests..." << endl;
+
+    testSharded();
+
+    cout << "**All Sharded Counter tests passed!" << endl;
+
+    return 0;
+}
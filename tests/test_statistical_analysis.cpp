@@ -0,0 +1,95 @@
+// Test suite for StatisticalAnalysis class
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include "solver/statistical_analysis.h"
+
+using namespace std;
+
+//
+// parameter tests
+//
+
+void testParameters() {
+    cout << "Testing requiredIterations and cellThreshold..." << endl;
+    // ApproxMC reference values
+    assert(StatisticalAnalysis::requiredIterations(0.2) == 67);
+    assert(StatisticalAnalysis::requiredIterations(0.05) == 101);
+    assert(StatisticalAnalysis::cellThreshold(0.8) == 72);
+    assert(StatisticalAnalysis::requiredIterations(0.1) > StatisticalAnalysis::requiredIterations(0.2));
+    assert(StatisticalAnalysis::cellThreshold(0.5) > StatisticalAnalysis::cellThreshold(0.8));
+    cout << "  All parameter tests passed!" << endl;
+}
+
+//
+// medianConfidenceInterval tests
+//
+
+void testInterval_tooFewSamples() {
+    // 3 samples: P(all above or all below the median) = 1/4 > delta
+    auto interval = StatisticalAnalysis::medianConfidenceInterval({1.0, 2.0, 3.0}, 0.2);
+    assert(!interval.valid);
+}
+
+void testInterval_minMaxForSmallSample() {
+    // 4 samples: [min, max] covers the median with probability 1 - 2/16
+    auto interval = StatisticalAnalysis::medianConfidenceInterval({4.0, 1.0, 3.0, 2.0}, 0.2);
+    assert(interval.valid);
+    assert(interval.log2Lower == 1.0);
+    assert(interval.log2Upper == 4.0);
+    assert(fabs(interval.confidence - 0.875) < 1e-9);
+}
+
+void testInterval_narrowsWithMoreSamples() {
+    vector<double> samples;
+    for (int i = 0; i < 60; i++) {
+        samples.push_back(i);
+    }
+    auto interval = StatisticalAnalysis::medianConfidenceInterval(samples, 0.2);
+    assert(interval.valid);
+    assert(interval.confidence >= 0.8);
+    assert(interval.log2Lower > 20.0 && interval.log2Upper < 40.0);
+}
+
+// orchestrator
+void testMedianConfidenceInterval() {
+    cout << "Testing medianConfidenceInterval..." << endl;
+    testInterval_tooFewSamples();
+    testInterval_minMaxForSmallSample();
+    testInterval_narrowsWithMoreSamples();
+    cout << "  All medianConfidenceInterval tests passed!" << endl;
+}
+
+//
+// withinTolerance tests
+//
+
+void testWithinTolerance() {
+    cout << "Testing withinTolerance..." << endl;
+    ConfidenceInterval interval;
+    interval.valid = true;
+    interval.log2Lower = 9.5;
+    interval.log2Upper = 10.5;
+    assert(StatisticalAnalysis::withinTolerance(interval, 10.0, 0.8));
+    assert(!StatisticalAnalysis::withinTolerance(interval, 10.0, 0.2));
+    interval.valid = false;
+    assert(!StatisticalAnalysis::withinTolerance(interval, 10.0, 0.8));
+    cout << "  All withinTolerance tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Statistical Analysis Tests..." << endl;
+    
+    testParameters();
+    testMedianConfidenceInterval();
+    testWithinTolerance();
+    
+    cout << "**All Statistical Analysis tests passed!" << endl;
+    
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Test suite for phase timers and accumulated stats
+
+#include <iostream>
+#include <cassert>
+#include <string>
+#include "utils/timer.h"
+
+using namespace std;
+
+// Helper - stats with distinct values in every field, scaled by factor
+PhaseStats filledStats(uint64_t factor) {
+    PhaseStats stats;
+    for (int i = 0; i < NUM_PHASES; i++) {
+        stats.phaseNanos[i] = factor * (1000 + i);
+        stats.phaseCalls[i] = factor * (i + 1);
+        for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+            stats.hardware[i][e] = factor * (10 * i + e);
+        }
+    }
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        stats.counters[i] = factor * (i + 7);
+    }
+    return stats;
+}
+
+// Helper - whether every field of a equals the same field of b
+bool sameStats(const PhaseStats& a, const PhaseStats& b) {
+    for (int i = 0; i < NUM_PHASES; i++) {
+        if (a.phaseNanos[i] != b.phaseNanos[i] || a.phaseCalls[i] != b.phaseCalls[i]) {
+            return false;
+        }
+        for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+            if (a.hardware[i][e] != b.hardware[i][e]) {
+                return false;
+            }
+        }
+    }
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (a.counters[i] != b.counters[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// PhaseStats tests
+//
+
+void testPhaseStats_merge() {
+    PhaseStats total = filledStats(1);
+    total.merge(filledStats(2));
+    assert(sameStats(total, filledStats(3)));
+
+    // merging an empty accumulator changes nothing
+    total.merge(PhaseStats());
+    assert(sameStats(total, filledStats(3)));
+}
+
+void testPhaseStats_since() {
+    assert(sameStats(filledStats(5).since(filledStats(2)), filledStats(3)));
+    assert(sameStats(filledStats(4).since(filledStats(4)), PhaseStats()));
+
+    // only the work done after the snapshot
+    PhaseStats before = Stats::local();
+    {
+        AMC_TIME_PHASE(Phase::HASH_GENERATION);
+        AMC_COUNT(Counter::CONFLICTS);
+        AMC_COUNT_N(Counter::PROPAGATIONS, 12);
+    }
+    PhaseStats diff = Stats::local().since(before);
+#ifdef AMC_ENABLE_STATS
+    assert(diff.phaseCalls[static_cast<int>(Phase::HASH_GENERATION)] == 1);
+    assert(diff.counter(Counter::CONFLICTS) == 1);
+    assert(diff.counter(Counter::PROPAGATIONS) == 12);
+#endif
+    assert(diff.phaseCalls[static_cast<int>(Phase::PARSE)] == 0);
+    assert(diff.counter(Counter::DECISIONS) == 0);
+}
+
+void testPhaseStats_toJSON() {
+    PhaseStats stats;
+    stats.phaseNanos[static_cast<int>(Phase::PARSE)] = 1500000000;
+    stats.phaseCalls[static_cast<int>(Phase::PARSE)] = 2;
+    stats.counters[static_cast<int>(Counter::CONFLICTS)] = 42;
+    string json = stats.toJSON();
+    assert(json.find("\"parse\": {\"seconds\": 1.500000000, \"calls\": 2}") != string::npos);
+    assert(json.find("\"sat_solving\": {\"seconds\": 0.000000000, \"calls\": 0}") != string::npos);
+    assert(json.find("\"conflicts\": 42") != string::npos);
+    assert(json.find("\"ipc\"") == string::npos);
+
+    // every phase and counter is named, braces balance
+    for (int i = 0; i < NUM_PHASES; i++) {
+        assert(json.find(string("\"") + Stats::phaseName(static_cast<Phase>(i)) + "\"") != string::npos);
+    }
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        assert(json.find(string("\"") + Stats::counterName(static_cast<Counter>(i)) + "\"") != string::npos);
+    }
+    int depth = 0;
+    for (char c : json) {
+        depth += (c == '{') - (c == '}');
+        assert(depth >= 0);
+    }
+    assert(depth == 0 && json.front() == '{' && json.back() == '}');
+
+    // hardware counts of a phase come with the derived rates
+    int p = static_cast<int>(Phase::CELL_COUNTING);
+    stats.hardware[p][static_cast<int>(HardwareEvent::CYCLES)] = 2000;
+    stats.hardware[p][static_cast<int>(HardwareEvent::INSTRUCTIONS)] = 3000;
+    stats.hardware[p][static_cast<int>(HardwareEvent::BRANCH_MISSES)] = 30;
+    json = stats.toJSON();
+    assert(json.find("\"cycles\": 2000") != string::npos);
+    assert(json.find("\"ipc\": 1.5000") != string::npos);
+    assert(json.find("\"branch_mpki\": 10.0000") != string::npos);
+}
+
+// orchestrator
+void testPhaseStats() {
+    cout << "Testing PhaseStats..." << endl;
+    testPhaseStats_merge();
+    testPhaseStats_since();
+    testPhaseStats_toJSON();
+    cout << "  All PhaseStats tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Timer Tests..." << endl;
+
+    testPhaseStats();
+
+    cout << "**All Timer tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+// Test suite for trace-event recording
+
+#include <iostream>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/trace.h"
+
+using namespace std;
+
+// Minimal JSON value - enough to read the trace back
+struct JSONValue {
+    char type;      // 'o'bject, 'a'rray, 's'tring, 'n'umber, 'b'oolean, 'z' null
+    string text;
+    double number;
+    map<string, JSONValue> members;
+    vector<JSONValue> items;
+
+    JSONValue() : type('z'), number(0) {}
+
+    const JSONValue& operator[](const string& key) const {
+        static const JSONValue missing;
+        auto it = members.find(key);
+        return (it == members.end()) ? missing : it->second;
+    }
+};
+
+// Helper - recursive descent parser, false on any syntax error
+class JSONReader {
+public:
+    explicit JSONReader(const string& t) : text(t), pos(0) {}
+
+    bool parse(JSONValue& value) {
+        return parseValue(value) && (skipSpace(), pos == text.size());
+    }
+
+private:
+    const string& text;
+    size_t pos;
+
+    void skipSpace() {
+        while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+    }
+
+    bool expect(char ch) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == ch) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(string& out) {
+        if (!expect('"')) {
+            return false;
+        }
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\') {
+                pos++;
+                if (pos == text.size()) {
+                    return false;
+                }
+            }
+            out += text[pos++];
+        }
+        return expect('"');
+    }
+
+    bool parseValue(JSONValue& value) {
+        skipSpace();
+        if (pos == text.size()) {
+            return false;
+        }
+        char ch = text[pos];
+        if (ch == '{') {
+            value.type = 'o';
+            pos++;
+            if (expect('}')) {
+                return true;
+            }
+            do {
+                string key;
+                JSONValue member;
+                if (!parseString(key) || !expect(':') || !parseValue(member)) {
+                    return false;
+                }
+                value.members[key] = member;
+            } while (expect(','));
+            return expect('}');
+        }
+        if (ch == '[') {
+            value.type = 'a';
+            pos++;
+            if (expect(']')) {
+                return true;
+            }
+            do {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back())) {
+                    return false;
+                }
+            } while (expect(','));
+            return expect(']');
+        }
+        if (ch == '"') {
+            value.type = 's';
+            return parseString(value.text);
+        }
+        for (const char* word : {"true", "false", "null"}) {
+            if (text.compare(pos, string(word).size(), word) == 0) {
+                value.type = (word[0] == 'n') ? 'z' : 'b';
+                value.number = (word[0] == 't') ? 1 : 0;
+                pos += string(word).size();
+                return true;
+            }
+        }
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        value.type = 'n';
+        value.number = strtod(start, &end);
+        if (end == start) {
+            return false;
+        }
+        pos += end - start;
+        return true;
+    }
+};
+
+// Helper - records spans (one nested in another) and an instant on a named thread
+void recordOnThread(const string& threadName, const char* outer, const char* inner, int spans) {
+    TraceRecorder::setThreadName(threadName);
+    for (int i = 0; i < spans; i++) {
+        ScopedTraceSpan span(outer, "test", "index", i);
+        {
+            ScopedTraceSpan nested(inner, "test");
+        }
+        TraceRecorder::recordInstant("tick", "test");
+    }
+}
+
+//
+// toJSON tests
+//
+
+void testToJSON_twoThreads() {
+    TraceRecorder::enable();
+    const int spans = 50;
+    // enough events on one thread to span several chunks
+    thread first(recordOnThread, "trace first", "first_outer", "first_inner", spans);
+    thread second(recordOnThread, "trace second", "second_outer", "second_inner", 3000);
+    first.join();
+    second.join();
+    TraceRecorder::disable();
+
+    JSONValue trace;
+    string json = TraceRecorder::toJSON();
+    assert(JSONReader(json).parse(trace));
+    assert(trace.type == 'o' && trace["displayTimeUnit"].text == "ms");
+    const JSONValue& events = trace["traceEvents"];
+    assert(events.type == 'a');
+
+    // thread names by tid, and the tids each event name was recorded on
+    map<int, string> trackNames;
+    map<string, set<int>> tidsOf;
+    map<string, int> counts;
+    for (const JSONValue& event : events.items) {
+        const string& ph = event["ph"].text;
+        int tid = static_cast<int>(event["tid"].number);
+        assert(event["pid"].number == 1 && event["tid"].type == 'n');
+        if (ph == "M") {
+            assert(event["name"].text == "thread_name");
+            assert(trackNames.count(tid) == 0);
+            trackNames[tid] = event["args"]["name"].text;
+            continue;
+        }
+        // complete events carry their duration, instants their scope - no unmatched B/E pairs
+        assert(ph == "X" || ph == "i");
+        assert(event["ts"].type == 'n' && event["ts"].number >= 0);
+        if (ph == "X") {
+            assert(event["dur"].type == 'n' && event["dur"].number >= 0);
+        } else {
+            assert(event["s"].text == "t");
+        }
+        tidsOf[event["name"].text].insert(tid);
+        counts[event["name"].text]++;
+    }
+
+    assert(counts["first_outer"] == spans && counts["first_inner"] == spans);
+    assert(counts["second_outer"] == 3000 && counts["second_inner"] == 3000);
+    assert(counts["tick"] == spans + 3000);
+    for (const char* name : {"first_outer", "first_inner", "second_outer", "second_inner"}) {
+        assert(tidsOf[name].size() == 1);
+    }
+    int firstTid = *tidsOf["first_outer"].begin();
+    int secondTid = *tidsOf["second_outer"].begin();
+    assert(firstTid != secondTid);
+    assert(*tidsOf["first_inner"].begin() == firstTid && *tidsOf["second_inner"].begin() == secondTid);
+    assert(trackNames[firstTid] == "trace first" && trackNames[secondTid] == "trace second");
+    assert(tidsOf["tick"] == set<int>({firstTid, secondTid}));
+
+    // the arguments come through
+    for (const JSONValue& event : events.items) {
+        if (event["name"].text == "first_outer") {
+            assert(event["args"]["index"].type == 'n');
+        }
+    }
+}
+
+void testToJSON_nestedSpansInside() {
+    // each inner span lies within the outer span recorded around it on the same thread
+    JSONValue trace;
+    assert(JSONReader(TraceRecorder::toJSON()).parse(trace));
+    vector<const JSONValue*> outer;
+    vector<const JSONValue*> inner;
+    for (const JSONValue& event : trace["traceEvents"].items) {
+        if (event["name"].text == "first_outer") {
+            outer.push_back(&event);
+        } else if (event["name"].text == "first_inner") {
+            inner.push_back(&event);
+        }
+    }
+    assert(outer.size() == inner.size());
+    for (size_t i = 0; i < inner.size(); i++) {
+        // the inner span ends first, so the i-th inner span is the one inside the i-th outer span
+        double outerStart = (*outer[i])["ts"].number;
+        double outerEnd = outerStart + (*outer[i])["dur"].number;
+        double innerStart = (*inner[i])["ts"].number;
+        double innerEnd = innerStart + (*inner[i])["dur"].number;
+        // timestamps are printed to the nanosecond
+        assert(innerStart >= outerStart - 1e-3 && innerEnd <= outerEnd + 1e-3);
+    }
+}
+
+// orchestrator
+void testToJSON() {
+    cout << "Testing toJSON..." << endl;
+    testToJSON_twoThreads();
+    testToJSON_nestedSpansInside();
+    cout << "  All toJSON tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Trace Tests..." << endl;
+
+    testToJSON();
+
+    cout << "**All Trace tests passed!" << endl;
+
+    return 0;
+}
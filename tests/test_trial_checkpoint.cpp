@@ -0,0 +1,207 @@
+// Test suite for TrialCheckpoint and resumed counting runs
+
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cnf/cnf_structure.h"
+#include "solver/approximate_counter.h"
+#include "solver/trial_checkpoint.h"
+
+using namespace std;
+
+const string CHECKPOINT = "test_trial_checkpoint_tmp.txt";
+
+// Helper - 24 variables, a few binary clauses, so every trial needs some XORs
+CNFFormula testFormula() {
+    CNFFormula formula(24, 6);
+    for (int i = 0; i < 6; i++) {
+        formula.addClause({2 * i + 1, -(2 * i + 2)});
+    }
+    return formula;
+}
+
+CountingOptions testOptions() {
+    CountingOptions options;
+    options.maxTrials = 9;
+    options.threshold = 20;
+    options.earlyTermination = false;
+    options.exactFallback = false;
+    options.seed = 1234;
+    return options;
+}
+
+vector<string> readLines(const string& path) {
+    ifstream in(path);
+    vector<string> lines;
+    string line;
+    while (getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+bool sameResult(const ApproximationResult& a, const ApproximationResult& b) {
+    if (a.trialCounts.size() != b.trialCounts.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.trialCounts.size(); i++) {
+        if (a.trialCounts[i].log2() != b.trialCounts[i].log2()) {
+            return false;
+        }
+    }
+    return a.estimatedCount == b.estimatedCount && a.log2Estimate == b.log2Estimate && a.successfulTrials == b.successfulTrials
+        && a.totalTrials == b.totalTrials && a.interval.log2Lower == b.interval.log2Lower && a.interval.log2Upper == b.interval.log2Upper;
+}
+
+//
+// resume tests
+//
+
+void testResume_recordsEveryTrial() {
+    remove(CHECKPOINT.c_str());
+    CountingOptions options = testOptions();
+    ApproximationResult plain = ApproximateCounter::approximateCount(testFormula(), options);
+
+    options.checkpointPath = CHECKPOINT;
+    ApproximationResult recorded = ApproximateCounter::approximateCount(testFormula(), options);
+    assert(sameResult(plain, recorded));
+
+    vector<string> lines = readLines(CHECKPOINT);
+    assert(lines.size() == 10);
+    assert(lines[0].compare(0, 14, "amc-checkpoint") == 0);
+    assert(lines[0].find("seed=1234") != string::npos);
+    assert(lines[1].compare(0, 8, "trial 0 ") == 0);
+}
+
+void testResume_matchesUninterruptedRun() {
+    CountingOptions options = testOptions();
+    ApproximationResult plain = ApproximateCounter::approximateCount(testFormula(), options);
+
+    // a run that got through four trials, then died halfway through writing the fifth
+    vector<string> lines = readLines(CHECKPOINT);
+    {
+        ofstream out(CHECKPOINT, ios::trunc);
+        for (int i = 0; i < 5; i++) {
+            out << lines[i] << "\n";
+        }
+        out << "trial 4 1";
+    }
+
+    // the seed comes from the checkpoint
+    options.seed = 0;
+    options.checkpointPath = CHECKPOINT;
+    options.numThreads = 2;
+    ApproximationResult resumed = ApproximateCounter::approximateCount(testFormula(), options);
+    assert(sameResult(plain, resumed));
+    assert(readLines(CHECKPOINT) == lines);
+
+    // nothing left to do - every trial is replayed
+    TrialCheckpoint checkpoint(CHECKPOINT, testFormula(), options.density, options.threshold, 0);
+    assert(checkpoint.seed() == 1234);
+    assert(checkpoint.recordedCount() == 9);
+    TrialResult trial;
+    assert(checkpoint.recorded(8, trial));
+    assert(!checkpoint.recorded(9, trial));
+}
+
+bool checkpointThrows(const CNFFormula& formula, double density, int threshold, uint64_t seed) {
+    try {
+        TrialCheckpoint checkpoint(CHECKPOINT, formula, density, threshold, seed);
+    } catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void testResume_rejectsOtherRuns() {
+    CountingOptions options = testOptions();
+    CNFFormula other = testFormula();
+    other.addClause({3, 4});
+    assert(checkpointThrows(other, options.density, options.threshold, 0));
+    assert(checkpointThrows(testFormula(), 0.2, options.threshold, 0));
+    assert(checkpointThrows(testFormula(), options.density, 30, 0));
+    assert(checkpointThrows(testFormula(), options.density, options.threshold, 99));
+    assert(!checkpointThrows(testFormula(), options.density, options.threshold, 1234));
+
+    {
+        ofstream out(CHECKPOINT, ios::trunc);
+        out << "not a checkpoint\n";
+    }
+    assert(checkpointThrows(testFormula(), options.density, options.threshold, 0));
+    remove(CHECKPOINT.c_str());
+}
+
+void testResume_nestedHashes() {
+    remove(CHECKPOINT.c_str());
+    CountingOptions options = testOptions();
+    options.hashFamily = HashFamily::NESTED;
+    ApproximationResult plain = ApproximateCounter::approximateCount(testFormula(), options);
+
+    options.checkpointPath = CHECKPOINT;
+    ApproximateCounter::approximateCount(testFormula(), options);
+    vector<string> lines = readLines(CHECKPOINT);
+    assert(lines[0].find("nested=1") != string::npos);
+    {
+        ofstream out(CHECKPOINT, ios::trunc);
+        for (int i = 0; i < 4; i++) {
+            out << lines[i] << "\n";
+        }
+    }
+    ApproximationResult resumed = ApproximateCounter::approximateCount(testFormula(), options);
+    assert(sameResult(plain, resumed));
+
+    // the trials of one family are no trials of the other
+    assert(checkpointThrows(testFormula(), options.density, options.threshold, 0));
+    remove(CHECKPOINT.c_str());
+}
+
+void testResume_densities() {
+    remove(CHECKPOINT.c_str());
+    CountingOptions options = testOptions();
+    TrialCheckpoint(CHECKPOINT, testFormula(), options.density, options.threshold, options.seed, HashFamily::INDEPENDENT, 77);
+    assert(readLines(CHECKPOINT)[0].find(" densities=77") != string::npos);
+    TrialCheckpoint reopened(CHECKPOINT, testFormula(), options.density, options.threshold, options.seed, HashFamily::INDEPENDENT, 77);
+    assert(reopened.seed() == options.seed);
+
+    // trials drawn with per-variable probabilities are no trials of the single density, or of other probabilities
+    assert(checkpointThrows(testFormula(), options.density, options.threshold, 0));
+    bool refused = false;
+    try {
+        TrialCheckpoint other(CHECKPOINT, testFormula(), options.density, options.threshold, options.seed, HashFamily::INDEPENDENT, 78);
+    } catch (const runtime_error&) {
+        refused = true;
+    }
+    assert(refused);
+    assert(TrialCheckpoint::densitiesHash({0.1, 0.2}) != TrialCheckpoint::densitiesHash({0.2, 0.1}));
+    assert(TrialCheckpoint::densitiesHash({}) != 0);
+    remove(CHECKPOINT.c_str());
+}
+
+// orchestrator
+void testResume() {
+    cout << "Testing checkpoint resume..." << endl;
+    testResume_recordsEveryTrial();
+    testResume_matchesUninterruptedRun();
+    testResume_rejectsOtherRuns();
+    testResume_nestedHashes();
+    testResume_densities();
+    cout << "  All checkpoint resume tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Trial Checkpoint Tests..." << endl;
+
+    testResume();
+
+    cout << "**All Trial Checkpoint tests passed!" << endl;
+
+    return 0;
+}
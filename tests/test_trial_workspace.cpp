@@ -0,0 +1,172 @@
+// Test suite for the reusable buffers of the XOR search
+
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include "cnf/cnf_structure.h"
+#include "xor/xor_hash_generator.h"
+#include "solver/partial_assignment.h"
+#include "solver/cnf_simplifier.h"
+#include "solver/approximate_counter.h"
+
+using namespace std;
+
+// every heap allocation of the program goes through this, and every delete goes back to free()
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+// GCC pairs the free() with the builtin operator new once these are inlined and warns, but both sides are replaced here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+#pragma GCC diagnostic pop
+
+// Helper - variables 1..chain all equal, the rest free: 2^(numVars - chain + 1) models
+// the chain keeps every cell above the exact counter's variable budget, so cells go to the CDCL solver
+CNFFormula chainFormula(int numVars, int chain) {
+    CNFFormula formula(numVars, 2 * (chain - 1));
+    for (int v = 1; v < chain; v++) {
+        formula.addClause({-v, v + 1});
+        formula.addClause({v, -(v + 1)});
+    }
+    return formula;
+}
+
+//
+// building block tests
+//
+
+void testBuffers_sameSolution() {
+    mt19937 rng(5);
+    EliminationBuffers buffers;
+    XORSolutionResult inPlace;
+    for (int i = 0; i < 50; i++) {
+        int numVars = 5 + i * 3;
+        vector<XORConstraint> xors = XORHashGenerator::generateXORFamily(numVars, 1 + i % 12, 0.3, rng);
+        XORSolutionResult expected = PartialAssignment::solveXORSystem(xors, numVars);
+        PartialAssignment::solveXORSystem(xors, numVars, inPlace, buffers);
+        assert(inPlace.satisfiable == expected.satisfiable);
+        if (expected.satisfiable) {
+            assert(inPlace.assignment == expected.assignment);
+            assert(inPlace.freeVariables == expected.freeVariables);
+        }
+    }
+}
+
+void testBuffers_noAllocations() {
+    CNFFormula formula = chainFormula(120, 100);
+    vector<XORConstraint> xors;
+    vector<XORConstraint> spareXORs;
+    XORSolutionResult solution;
+    EliminationBuffers elimination;
+    SimplificationResult cell;
+    SimplificationBuffers simplification;
+    // a step after every other: buffers grow to what the largest needs, then stay
+    auto steps = [&](uint32_t seed) {
+        mt19937 rng(seed);
+        for (int numXORs = 0; numXORs < 10; numXORs++) {
+            XORHashGenerator::generateXORFamily(formula.numVariables, numXORs, 0.3, rng, xors, spareXORs);
+            PartialAssignment::solveXORSystem(xors, formula.numVariables, solution, elimination);
+            if (solution.satisfiable) {
+                CNFSimplifier::applyXORSolution(formula, solution, cell, simplification);
+            }
+        }
+    };
+    steps(11);
+    steps(11);    // the spare lists themselves settle on the second pass
+    size_t before = allocations;
+    steps(11);
+    assert(allocations == before);
+}
+
+// orchestrator
+void testBuffers() {
+    cout << "Testing buffers..." << endl;
+    testBuffers_sameSolution();
+    testBuffers_noAllocations();
+    cout << "  All buffers tests passed!" << endl;
+}
+
+//
+// trial tests
+//
+
+void testTrial_noAllocations() {
+    CNFFormula formula = chainFormula(300, 290);
+    SolverSnapshot snapshot(formula);
+    SolveLimits limits;
+    limits.snapshot = &snapshot;
+    mt19937 rng = ApproximateCounter::trialGenerator(3, 0);
+    TrialResult warmUp = ApproximateCounter::singleTrial(formula, 0.5, 16, rng, limits);
+    assert(warmUp.satisfiable && !warmUp.aborted && warmUp.numXORs > 0);
+    rng = ApproximateCounter::trialGenerator(3, 0);
+    ApproximateCounter::singleTrial(formula, 0.5, 16, rng, limits);
+    // the same trial again finds every buffer at the size it needs
+    rng = ApproximateCounter::trialGenerator(3, 0);
+    size_t before = allocations;
+    TrialResult result = ApproximateCounter::singleTrial(formula, 0.5, 16, rng, limits);
+    assert(allocations == before);
+    assert(result.numXORs == warmUp.numXORs && result.cellCount == warmUp.cellCount);
+}
+
+void testTrial_sameCount() {
+    // a workspace left behind by a larger formula does not leak into a smaller one
+    CNFFormula large = chainFormula(300, 290);
+    CNFFormula small = chainFormula(280, 270);
+    SolverSnapshot largeSnapshot(large);
+    SolverSnapshot smallSnapshot(small);
+    SolveLimits largeLimits;
+    largeLimits.snapshot = &largeSnapshot;
+    SolveLimits smallLimits;
+    smallLimits.snapshot = &smallSnapshot;
+    for (int trial = 0; trial < 4; trial++) {
+        mt19937 rng = ApproximateCounter::trialGenerator(9, trial);
+        ApproximateCounter::singleTrial(large, 0.5, 16, rng, largeLimits);
+        rng = ApproximateCounter::trialGenerator(9, trial);
+        TrialResult result = ApproximateCounter::singleTrial(small, 0.5, 16, rng, smallLimits);
+        mt19937 reference = ApproximateCounter::trialGenerator(9, trial);
+        TrialResult expected = ApproximateCounter::singleTrial(small, 0.5, 16, reference, SolveLimits());
+        assert(result.satisfiable == expected.satisfiable);
+        assert(result.numXORs == expected.numXORs);
+        assert(result.cellCount == expected.cellCount);
+    }
+}
+
+// orchestrator
+void testTrial() {
+    cout << "Testing trial..." << endl;
+    testTrial_noAllocations();
+    testTrial_sameCount();
+    cout << "  All trial tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Trial Workspace Tests..." << endl;
+
+    testBuffers();
+    testTrial();
+
+    cout << "**All Trial Workspace tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Test suite for TruthTableCounter class
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include "cnf/cnf_structure.h"
+#include "solver/truth_table_counter.h"
+#include "solver/exact_counter.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+//
+// countModels tests
+//
+
+void testCountModels_fewVariables() {
+    // (x1 OR x2) over 3 variables -> 3 * 2 models
+    CNFFormula formula(3, 1);
+    formula.addClause({1, 2});
+    ModelCount count;
+    assert(TruthTableCounter::countModels(formula, count));
+    assert(count.saturated() == 6);
+}
+
+void testCountModels_unsatisfiable() {
+    CNFFormula formula(1, 2);
+    formula.addClause({1});
+    formula.addClause({-1});
+    ModelCount count(1, 0);
+    assert(TruthTableCounter::countModels(formula, count));
+    assert(count.isZero());
+}
+
+void testCountModels_tooManyVariables() {
+    CNFFormula formula(30, 1);
+    formula.addClause({1, 2, 3, 4, 5});
+    ModelCount count;
+    assert(!TruthTableCounter::countModels(formula, count, 4));
+}
+
+void testCountModels_largeCountKeepsExponent() {
+    CNFFormula formula(80, 1);
+    formula.addClause({1, 2});
+    ModelCount count;
+    assert(TruthTableCounter::countModels(formula, count));
+    assert(count.cellCount == 3);
+    assert(count.exponent == 78);
+    assert(count.saturated() == UINT64_MAX);
+}
+
+void testCountModels_matchesExactCounter() {
+    for (int trial = 0; trial < 100; trial++) {
+        int numVars = 2 + trial % 22;
+        int k = min(1 + trial % 4, numVars);
+        double ratio = static_cast<double>(1 + trial % 60) / numVars;
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(numVars, k, ratio, 2024 + trial);
+        ModelCount count;
+        assert(TruthTableCounter::countModels(formula, count));
+        auto exact = ExactCounter::count(formula);
+        assert(exact.completed);
+        assert(count.saturated() == exact.modelCount().saturated());
+    }
+}
+
+// orchestrator
+void testCountModels() {
+    cout << "Testing countModels..." << endl;
+    testCountModels_fewVariables();
+    testCountModels_unsatisfiable();
+    testCountModels_tooManyVariables();
+    testCountModels_largeCountKeepsExponent();
+    testCountModels_matchesExactCounter();
+    cout << "  All countModels tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Truth Table Counter Tests..." << endl;
+    
+    testCountModels();
+    
+    cout << "**All Truth Table Counter tests passed!" << endl;
+    
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Test suite for VariableOrder class
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include "cnf/cnf_structure.h"
+#include "cnf/variable_order.h"
+#include "solver/exact_counter.h"
+#include "utils/random_cnf_generator.h"
+
+using namespace std;
+
+// Helper - a chain of binary clauses (x1 OR x2), (x2 OR x3), ... with its variables shuffled
+CNFFormula scrambledChain(mt19937& rng, int numVars) {
+    vector<int> ids(numVars);
+    for (int i = 0; i < numVars; i++) {
+        ids[i] = i + 1;
+    }
+    shuffle(ids.begin(), ids.end(), rng);
+    CNFFormula formula(numVars, numVars - 1);
+    for (int i = 0; i + 1 < numVars; i++) {
+        formula.addClause({ids[i], ids[i + 1]});
+    }
+    return formula;
+}
+
+bool isPermutation(const VariableOrder& order) {
+    int n = order.numVariables();
+    vector<char> seen(n + 1, 0);
+    for (int var = 1; var <= n; var++) {
+        int id = order.renumbered(var);
+        if (id < 1 || id > n || seen[id] || order.original(id) != var) {
+            return false;
+        }
+        seen[id] = 1;
+    }
+    return true;
+}
+
+//
+// cuthillMcKee tests
+//
+
+void testCuthillMcKee_permutation() {
+    for (int i = 0; i < 20; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(30, 3, 40.0 / 30, 3 + i);
+        VariableOrder order = VariableOrder::cuthillMcKee(formula);
+        assert(order.numVariables() == 30);
+        assert(isPermutation(order));
+    }
+}
+
+void testCuthillMcKee_unusedVariablesLast() {
+    CNFFormula formula(5, 1);
+    formula.addClause({4, -2});
+    VariableOrder order = VariableOrder::cuthillMcKee(formula);
+    assert(isPermutation(order));
+    assert(order.renumbered(2) <= 2 && order.renumbered(4) <= 2);
+    assert(order.renumbered(1) == 3);
+    assert(order.renumbered(3) == 4);
+    assert(order.renumbered(5) == 5);
+}
+
+void testCuthillMcKee_chainBecomesBanded() {
+    mt19937 rng(7);
+    CNFFormula formula = scrambledChain(rng, 200);
+    CNFFormula renumbered = VariableOrder::cuthillMcKee(formula).apply(formula);
+    // a path is numbered end to end - every clause joins consecutive ids
+    assert(VariableOrder::clauseSpan(renumbered) == 199);
+    assert(VariableOrder::clauseSpan(formula) > 199);
+}
+
+void testCuthillMcKee_deterministic() {
+    CNFFormula formula = *RandomCNFGenerator::randomKSAT(40, 3, 2.0, 5);
+    VariableOrder a = VariableOrder::cuthillMcKee(formula);
+    VariableOrder b = VariableOrder::cuthillMcKee(formula);
+    for (int var = 1; var <= 40; var++) {
+        assert(a.renumbered(var) == b.renumbered(var));
+    }
+}
+
+// orchestrator
+void testCuthillMcKee() {
+    cout << "Testing cuthillMcKee..." << endl;
+    testCuthillMcKee_permutation();
+    testCuthillMcKee_unusedVariablesLast();
+    testCuthillMcKee_chainBecomesBanded();
+    testCuthillMcKee_deterministic();
+    cout << "  All cuthillMcKee tests passed!" << endl;
+}
+
+//
+// apply / originalAssignment tests
+//
+
+void testApply_literals() {
+    CNFFormula formula(3, 2);
+    formula.addClause({1, -3});
+    formula.addClause({-2});
+    VariableOrder order = VariableOrder::cuthillMcKee(formula);
+    CNFFormula renumbered = order.apply(formula);
+    assert(renumbered.numVariables == 3);
+    assert(renumbered.clauses.size() == 2);
+    for (size_t c = 0; c < formula.clauses.size(); c++) {
+        for (size_t j = 0; j < formula.clauses[c].size(); j++) {
+            Literal lit = renumbered.clauses[c].literals[j];
+            assert(lit == order.renumberLiteral(formula.clauses[c].literals[j]));
+            assert(order.originalLiteral(lit) == formula.clauses[c].literals[j]);
+        }
+    }
+}
+
+void testApply_preservesCount() {
+    for (int i = 0; i < 50; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(14, 3, 30.0 / 14, 11 + i);
+        CNFFormula renumbered = VariableOrder::cuthillMcKee(formula).apply(formula);
+        ExactCountResult before = ExactCounter::count(formula);
+        ExactCountResult after = ExactCounter::count(renumbered);
+        assert(before.completed && after.completed);
+        assert(before.modelCount().log2() == after.modelCount().log2());
+    }
+}
+
+void testOriginalAssignment_mapsModels() {
+    for (int i = 0; i < 20; i++) {
+        CNFFormula formula = *RandomCNFGenerator::randomKSAT(12, 3, 20.0 / 12, 13 + i);
+        VariableOrder order = VariableOrder::cuthillMcKee(formula);
+        CNFFormula renumbered = order.apply(formula);
+        // every model of the renumbered formula is a model of the original once mapped back
+        vector<int> assignment(12);
+        for (uint32_t bits = 0; bits < (1u << 12); bits++) {
+            for (int v = 0; v < 12; v++) {
+                assignment[v] = (bits >> v) & 1;
+            }
+            assert(renumbered.isSatisfied(assignment) == formula.isSatisfied(order.originalAssignment(assignment)));
+        }
+    }
+}
+
+// orchestrator
+void testApply() {
+    cout << "Testing apply..." << endl;
+    testApply_literals();
+    testApply_preservesCount();
+    testOriginalAssignment_mapsModels();
+    cout << "  All apply tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running Variable Order Tests..." << endl;
+
+    testCuthillMcKee();
+    testApply();
+
+    cout << "**All Variable Order tests passed!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Test suite for XOR hash generation with per-variable probabilities
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include "xor/xor_hash_generator.h"
+
+using namespace std;
+
+// Helper - how often each variable is drawn over the given number of XORs (entry v - 1 for variable v)
+vector<double> inclusionRates(const VariableSampler& sampler, int draws, uint32_t seed) {
+    mt19937 rng(seed);
+    vector<int> counts(sampler.numVariables(), 0);
+    XORConstraint constraint;
+    for (int i = 0; i < draws; i++) {
+        XORHashGenerator::generateSparseXOR(sampler, rng, constraint);
+        for (int var : constraint.variables) {
+            counts[var - 1]++;
+        }
+    }
+    vector<double> rates(counts.begin(), counts.end());
+    for (double& rate : rates) {
+        rate /= draws;
+    }
+    return rates;
+}
+
+//
+// sampler tests
+//
+
+void testSampler_inclusionRates() {
+    // every bucket, both ends, and probabilities exactly on a bucket boundary
+    vector<double> probabilities = {1.0, 0.0, 0.5, 0.3, 0.25, 0.7, 0.01, 0.125, 0.9, 1e-6, 0.05, 0.6};
+    for (int i = 0; i < 200; i++) {
+        probabilities.push_back(0.02);
+    }
+    VariableSampler sampler(probabilities);
+    assert(sampler.numVariables() == (int)probabilities.size());
+    double expected = 0;
+    for (double p : probabilities) {
+        expected += p;
+    }
+    assert(fabs(sampler.expectedLength() - expected) < 1e-9);
+
+    const int draws = 40000;
+    vector<double> rates = inclusionRates(sampler, draws, 7);
+    for (size_t v = 0; v < probabilities.size(); v++) {
+        double p = probabilities[v];
+        // five standard deviations
+        assert(fabs(rates[v] - p) <= 5 * sqrt(p * (1 - p) / draws) + 1e-12);
+    }
+    assert(rates[0] == 1.0);
+    assert(rates[1] == 0.0);
+}
+
+void testSampler_sortedAndDistinct() {
+    mt19937 setup(3);
+    uniform_real_distribution<double> dist(0.0, 1.0);
+    vector<double> probabilities(500);
+    for (double& p : probabilities) {
+        p = pow(dist(setup), 3);
+    }
+    VariableSampler sampler(probabilities);
+    mt19937 rng(11);
+    for (int i = 0; i < 200; i++) {
+        XORConstraint constraint = XORHashGenerator::generateSparseXOR(sampler, rng);
+        for (size_t k = 0; k < constraint.variables.size(); k++) {
+            assert(constraint.variables[k] >= 1 && constraint.variables[k] <= 500);
+            assert(k == 0 || constraint.variables[k - 1] < constraint.variables[k]);
+        }
+    }
+}
+
+void testSampler_clamped() {
+    VariableSampler sampler({-0.5, 2.0, NAN});
+    assert(sampler.expectedLength() == 1.0);
+    mt19937 rng(1);
+    for (int i = 0; i < 20; i++) {
+        assert(XORHashGenerator::generateSparseXOR(sampler, rng).variables == vector<int>({2}));
+    }
+}
+
+void testSampler_lengthMatchesDensity() {
+    // the same probability for every variable draws XORs as long as generateSparseXOR with that density
+    const int numVariables = 400;
+    const int draws = 4000;
+    VariableSampler sampler(vector<double>(numVariables, 0.1));
+    mt19937 rng(5);
+    double weightedLength = 0;
+    double uniformLength = 0;
+    for (int i = 0; i < draws; i++) {
+        weightedLength += XORHashGenerator::generateSparseXOR(sampler, rng).size();
+        uniformLength += XORHashGenerator::generateSparseXOR(numVariables, 0.1, rng).size();
+    }
+    // 40 on average, standard deviation 6 per XOR
+    assert(fabs(weightedLength / draws - 40) < 0.5);
+    assert(fabs(uniformLength / draws - 40) < 0.5);
+}
+
+void testSampler_family() {
+    VariableSampler sampler(vector<double>(50, 0.2));
+    mt19937 rng(9);
+    vector<XORConstraint> xors;
+    vector<XORConstraint> spare;
+    XORHashGenerator::generateXORFamily(sampler, 6, rng, xors, spare);
+    assert(xors.size() == 6);
+    XORHashGenerator::generateXORFamily(sampler, 2, rng, xors, spare);
+    assert(xors.size() == 2 && spare.size() == 4);
+
+    // the family is the XORs generateSparseXOR draws one after another
+    mt19937 first(21);
+    mt19937 second(21);
+    XORHashGenerator::generateXORFamily(sampler, 5, first, xors, spare);
+    for (const auto& constraint : xors) {
+        XORConstraint single = XORHashGenerator::generateSparseXOR(sampler, second);
+        assert(constraint.variables == single.variables && constraint.value == single.value);
+    }
+}
+
+void testSampler_sharedAcrossThreads() {
+    vector<double> probabilities(300);
+    for (size_t v = 0; v < probabilities.size(); v++) {
+        probabilities[v] = 0.01 + 0.3 * (v % 7) / 7;
+    }
+    const VariableSampler sampler(probabilities);
+    // each thread draws from its own generator - the results are those of the same draws on one thread
+    vector<vector<XORConstraint>> drawn(4);
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&sampler, &drawn, t]() {
+            mt19937 rng(100 + t);
+            for (int i = 0; i < 500; i++) {
+                drawn[t].push_back(XORHashGenerator::generateSparseXOR(sampler, rng));
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (int t = 0; t < 4; t++) {
+        mt19937 rng(100 + t);
+        for (int i = 0; i < 500; i++) {
+            XORConstraint expected = XORHashGenerator::generateSparseXOR(sampler, rng);
+            assert(drawn[t][i].variables == expected.variables && drawn[t][i].value == expected.value);
+        }
+    }
+}
+
+// orchestrator
+void testSampler() {
+    cout << "Testing variable sampler..." << endl;
+    testSampler_inclusionRates();
+    testSampler_sortedAndDistinct();
+    testSampler_clamped();
+    testSampler_lengthMatchesDensity();
+    testSampler_family();
+    testSampler_sharedAcrossThreads();
+    cout << "  All variable sampler tests passed!" << endl;
+}
+
+//
+// Main test runner
+//
+
+int main() {
+    cout << "**Running XOR Hash Generator Tests..." << endl;
+
+    testSampler();
+
+    cout << "**All XOR Hash Generator tests passed!" << endl;
+
+    return 0;
+}